@@ -11,7 +11,9 @@ LOCAL_MODULE := ting
 SRC_BASE_DIR := 
 
 LOCAL_SRC_FILES :=
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/ArchiveFile.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/BufferFile.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/CachedFile.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/File.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/FSFile.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/fs/MemoryFile.cpp
@@ -19,13 +21,16 @@ LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/MsgThread.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Queue.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Semaphore.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/mt/Thread.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/BatchResolver.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/HostNameResolver.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/IPAddress.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/IPPrefix.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/Lib.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/Socket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/TCPServerSocket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/TCPSocket.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/net/UDPSocket.cpp
+LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/RingBuffer.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/timer.cpp
 LOCAL_SRC_FILES += $(SRC_BASE_DIR)ting/WaitSet.cpp
 
@@ -0,0 +1,464 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Dynamically sized set of bits.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "types.hpp"
+#include "util.hpp"
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Set of bits of size given at run time.
+ * The BitSet provides the same kind of interface as ting::Flags, but the number of bits is
+ * specified at run time. It is intended for things like free slot maps and sets of active
+ * connection IDs.
+ * Bits are stored in 64 bit words, searching for set or clear bits is done a word at a time
+ * and whole-set AND/OR/XOR/AND-NOT operations process two words at a time with SSE2 when available.
+ * Unused bits of the last storage word are always kept cleared.
+ *
+ * Example of ID allocator:
+ * @code
+ * ting::BitSet usedIds(0x10000);
+ * 
+ * size_t id = usedIds.FindNextClear(0);
+ * if(id == usedIds.Size()){
+ *     //all IDs are in use
+ * }
+ * usedIds.Set(id);
+ * @endcode
+ */
+class BitSet{
+public:
+	/**
+	 * @brief Type of storage word.
+	 */
+	typedef std::uint64_t word_t;
+	
+private:
+	static const size_t DWordBits = sizeof(word_t) * 8;
+	
+	std::vector<word_t> words;
+	size_t size = 0;
+	
+	static size_t NumWordsFor(size_t numBits)NOEXCEPT{
+		return (numBits + DWordBits - 1) / DWordBits;
+	}
+	
+	//mask of bits of the last word which are in use
+	word_t LastWordMask()const NOEXCEPT{
+		return this->size % DWordBits == 0 ? word_t(-1) : (word_t(1) << (this->size % DWordBits)) - 1;
+	}
+	
+	void ClearUnusedBits()NOEXCEPT{
+		if(this->words.size() != 0){
+			this->words.back() &= this->LastWordMask();
+		}
+	}
+	
+	//Find first word which after applying 'invert' mask has a bit set starting from given bit index.
+	size_t FindNext(size_t from, word_t invert)const NOEXCEPT{
+		if(from >= this->size){
+			return this->size;
+		}
+		size_t i = from / DWordBits;
+		word_t w = (this->words[i] ^ invert) & (word_t(-1) << (from % DWordBits));
+		for(;;){
+			if(w != 0){
+				size_t ret = i * DWordBits + ting::util::CountTrailingZeros64(w);
+				return ret < this->size ? ret : this->size;
+			}
+			if(++i == this->words.size()){
+				return this->size;
+			}
+			w = this->words[i] ^ invert;
+		}
+	}
+	
+	template <class T_Op> void Apply(const BitSet& b, T_Op op)NOEXCEPT{
+		ASSERT_INFO(this->size == b.size, "BitSet: sizes of operands differ")
+		word_t* d = this->words.data();
+		const word_t* s = b.words.data();
+		size_t n = this->words.size();
+		size_t i = 0;
+#if defined(M_UTIL_SSE2)
+		for(; i + 2 <= n; i += 2){
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + i));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), op(a, c));
+		}
+#endif
+		for(; i != n; ++i){
+			d[i] = op(d[i], s[i]);
+		}
+	}
+	
+	struct And{
+		word_t operator()(word_t a, word_t b)const NOEXCEPT{
+			return a & b;
+		}
+#if defined(M_UTIL_SSE2)
+		__m128i operator()(__m128i a, __m128i b)const NOEXCEPT{
+			return _mm_and_si128(a, b);
+		}
+#endif
+	};
+	
+	struct Or{
+		word_t operator()(word_t a, word_t b)const NOEXCEPT{
+			return a | b;
+		}
+#if defined(M_UTIL_SSE2)
+		__m128i operator()(__m128i a, __m128i b)const NOEXCEPT{
+			return _mm_or_si128(a, b);
+		}
+#endif
+	};
+	
+	struct Xor{
+		word_t operator()(word_t a, word_t b)const NOEXCEPT{
+			return a ^ b;
+		}
+#if defined(M_UTIL_SSE2)
+		__m128i operator()(__m128i a, __m128i b)const NOEXCEPT{
+			return _mm_xor_si128(a, b);
+		}
+#endif
+	};
+	
+	struct AndNot{
+		word_t operator()(word_t a, word_t b)const NOEXCEPT{
+			return a & ~b;
+		}
+#if defined(M_UTIL_SSE2)
+		__m128i operator()(__m128i a, __m128i b)const NOEXCEPT{
+			return _mm_andnot_si128(b, a);
+		}
+#endif
+	};
+	
+public:
+	/**
+	 * @brief Constructor.
+	 * @param size - number of bits in the set.
+	 * @param initialValueOfAllBits - value to initialize all bits to.
+	 */
+	explicit BitSet(size_t size = 0, bool initialValueOfAllBits = false) :
+			words(NumWordsFor(size), initialValueOfAllBits ? word_t(-1) : 0),
+			size(size)
+	{
+		this->ClearUnusedBits();
+	}
+	
+	/**
+	 * @brief Number of bits in the set.
+	 * @return Number of bits in the set.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->size;
+	}
+	
+	/**
+	 * @brief Change number of bits in the set.
+	 * @param size - new number of bits.
+	 * @param value - value to initialize added bits to.
+	 */
+	void Resize(size_t size, bool value = false){
+		size_t oldSize = this->size;
+		if(size > oldSize && value && oldSize % DWordBits != 0){
+			this->words.back() |= ~this->LastWordMask();
+		}
+		this->words.resize(NumWordsFor(size), value ? word_t(-1) : 0);
+		this->size = size;
+		this->ClearUnusedBits();
+	}
+	
+	/**
+	 * @brief Get value of i'th bit.
+	 * @param i - index of the bit, must be less than Size().
+	 * @return value of the bit.
+	 */
+	bool Get(size_t i)const NOEXCEPT{
+		ASSERT(i < this->size)
+		return (this->words[i / DWordBits] & (word_t(1) << (i % DWordBits))) != 0;
+	}
+	
+	/**
+	 * @brief Set value of i'th bit.
+	 * @param i - index of the bit, must be less than Size().
+	 * @param value - value to set.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& SetTo(size_t i, bool value)NOEXCEPT{
+		ASSERT(i < this->size)
+		if(value){
+			this->words[i / DWordBits] |= (word_t(1) << (i % DWordBits));
+		}else{
+			this->words[i / DWordBits] &= ~(word_t(1) << (i % DWordBits));
+		}
+		return *this;
+	}
+	
+	/**
+	 * @brief Set i'th bit.
+	 * @param i - index of the bit, must be less than Size().
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& Set(size_t i)NOEXCEPT{
+		return this->SetTo(i, true);
+	}
+	
+	/**
+	 * @brief Clear i'th bit.
+	 * @param i - index of the bit, must be less than Size().
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& Clear(size_t i)NOEXCEPT{
+		return this->SetTo(i, false);
+	}
+	
+	/**
+	 * @brief Set all bits to given value.
+	 * @param value - value to set all bits to.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& SetAllTo(bool value)NOEXCEPT{
+		for(auto& w : this->words){
+			w = value ? word_t(-1) : 0;
+		}
+		this->ClearUnusedBits();
+		return *this;
+	}
+	
+	/**
+	 * @brief Check if all bits are cleared.
+	 * @return true if all bits are cleared.
+	 */
+	bool IsAllClear()const NOEXCEPT{
+		word_t acc = 0;
+		for(auto w : this->words){
+			acc |= w;
+		}
+		return acc == 0;
+	}
+	
+	/**
+	 * @brief Check if all bits are set.
+	 * @return true if all bits are set.
+	 */
+	bool IsAllSet()const NOEXCEPT{
+		return this->NumSet() == this->size;
+	}
+	
+	/**
+	 * @brief Count set bits.
+	 * @return number of bits which are set.
+	 */
+	size_t NumSet()const NOEXCEPT{
+		size_t ret = 0;
+		for(auto w : this->words){
+			ret += ting::util::PopCount64(w);
+		}
+		return ret;
+	}
+	
+	/**
+	 * @brief Count set bits before given index.
+	 * @param i - index, must not exceed Size().
+	 * @return number of set bits with index less than i.
+	 */
+	size_t Rank(size_t i)const NOEXCEPT{
+		ASSERT(i <= this->size)
+		size_t ret = 0;
+		size_t n = i / DWordBits;
+		for(size_t j = 0; j != n; ++j){
+			ret += ting::util::PopCount64(this->words[j]);
+		}
+		if(i % DWordBits != 0){
+			ret += ting::util::PopCount64(this->words[n] & ((word_t(1) << (i % DWordBits)) - 1));
+		}
+		return ret;
+	}
+	
+	/**
+	 * @brief Find n'th set bit.
+	 * Inverse of Rank(), i.e. Rank(Select(n)) == n.
+	 * @param n - zero based number of the set bit to find.
+	 * @return index of the n'th set bit, or Size() if there are not enough set bits.
+	 */
+	size_t Select(size_t n)const NOEXCEPT{
+		for(size_t i = 0; i != this->words.size(); ++i){
+			word_t w = this->words[i];
+			size_t c = ting::util::PopCount64(w);
+			if(n >= c){
+				n -= c;
+				continue;
+			}
+#if defined(__BMI2__)
+			w = _pdep_u64(word_t(1) << n, w);
+#else
+			for(; n != 0; --n){
+				w &= w - 1;
+			}
+#endif
+			return i * DWordBits + ting::util::CountTrailingZeros64(w);
+		}
+		return this->size;
+	}
+	
+	/**
+	 * @brief Find first set bit starting from given index.
+	 * @param from - index to start search from.
+	 * @return index of the first set bit which is not less than 'from', or Size() if there is no such bit.
+	 */
+	size_t FindNextSet(size_t from = 0)const NOEXCEPT{
+		return this->FindNext(from, 0);
+	}
+	
+	/**
+	 * @brief Find first cleared bit starting from given index.
+	 * @param from - index to start search from.
+	 * @return index of the first cleared bit which is not less than 'from', or Size() if there is no such bit.
+	 */
+	size_t FindNextClear(size_t from = 0)const NOEXCEPT{
+		return this->FindNext(from, word_t(-1));
+	}
+	
+	/**
+	 * @brief Call function for each set bit.
+	 * Bits are visited in ascending order.
+	 * @param func - function to call, takes index of the bit as argument.
+	 */
+	template <class T_Func> void ForEachSet(T_Func func)const{
+		for(size_t i = 0; i != this->words.size(); ++i){
+			for(word_t w = this->words[i]; w != 0; w &= w - 1){
+				func(i * DWordBits + ting::util::CountTrailingZeros64(w));
+			}
+		}
+	}
+	
+	/**
+	 * @brief Inverts all the bits.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& Invert()NOEXCEPT{
+		for(auto& w : this->words){
+			w = ~w;
+		}
+		this->ClearUnusedBits();
+		return *this;
+	}
+	
+	/**
+	 * @brief Operator assignment AND.
+	 * @param b - bit set to perform AND operation with, must be of the same size.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& operator&=(const BitSet& b)NOEXCEPT{
+		this->Apply(b, And());
+		return *this;
+	}
+	
+	/**
+	 * @brief Operator assignment OR.
+	 * @param b - bit set to perform OR operation with, must be of the same size.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& operator|=(const BitSet& b)NOEXCEPT{
+		this->Apply(b, Or());
+		return *this;
+	}
+	
+	/**
+	 * @brief Operator assignment XOR.
+	 * @param b - bit set to perform XOR operation with, must be of the same size.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& operator^=(const BitSet& b)NOEXCEPT{
+		this->Apply(b, Xor());
+		return *this;
+	}
+	
+	/**
+	 * @brief Clear bits which are set in another bit set.
+	 * @param b - bit set of the same size, bits set in it are cleared in this BitSet.
+	 * @return Reference to this BitSet.
+	 */
+	BitSet& ClearAllOf(const BitSet& b)NOEXCEPT{
+		this->Apply(b, AndNot());
+		return *this;
+	}
+	
+	BitSet operator&(const BitSet& b)const{
+		return BitSet(*this).operator&=(b);
+	}
+	
+	BitSet operator|(const BitSet& b)const{
+		return BitSet(*this).operator|=(b);
+	}
+	
+	BitSet operator^(const BitSet& b)const{
+		return BitSet(*this).operator^=(b);
+	}
+	
+	BitSet operator~()const{
+		return BitSet(*this).Invert();
+	}
+	
+	bool operator==(const BitSet& b)const NOEXCEPT{
+		return this->size == b.size && this->words == b.words;
+	}
+	
+	bool operator!=(const BitSet& b)const NOEXCEPT{
+		return !this->operator==(b);
+	}
+	
+#ifdef DEBUG
+	friend std::ostream& operator<<(std::ostream& s, const BitSet& bs){
+		s << "(";
+		for(size_t i = 0; i != bs.Size(); ++i){
+			s << (bs.Get(i) ? "1" : "0");
+		}
+		s << ")";
+		return s;
+	}
+#endif
+};
+
+
+
+}//~namespace
@@ -34,12 +34,15 @@ THE SOFTWARE. */
 
 #include <array>
 #include <vector>
+#include <iterator>
+#include <type_traits>
 
 #ifdef DEBUG
 #	include <iostream>
 #endif
 
-#include "util.hpp"
+#include "config.hpp"
+#include "types.hpp"
 #include "debug.hpp"
 
 
@@ -0,0 +1,626 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Binary serialization streams over Buffer.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+
+#include "debug.hpp"
+#include "Buffer.hpp"
+#include "util.hpp"
+#include "Exc.hpp"
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Binary data writer.
+ * Writes fixed width integers, floating point values, varints and length-prefixed blobs
+ * into a memory buffer. Each Put*() method checks that there is enough space left in the buffer
+ * and throws BufferWriter::Exc otherwise.
+ * For records of known size the bounds can be checked only once by reserving the whole record
+ * with Reserve() and then writing its fields through the returned BufferWriter::Record object,
+ * which only checks bounds in debug build.
+ *
+ * @code
+ * std::array<std::uint8_t, 0x100> buf;
+ * ting::BufferWriter w(buf);
+ * {
+ *     auto r = w.Reserve(6);
+ *     r.Put16BE(id);
+ *     r.Put32BE(value);
+ * }
+ * w.PutBlob8(name);
+ * socket.Send(w.Written());
+ * @endcode
+ */
+class BufferWriter{
+	ting::Buffer<std::uint8_t> buf;
+	size_t pos = 0;
+
+public:
+	/**
+	 * @brief Exception thrown when there is not enough space in the buffer.
+	 */
+	class Exc : public ting::Exc{
+	public:
+		Exc(const std::string& message) :
+				ting::Exc(message)
+		{}
+	};
+
+	/**
+	 * @brief Reserved region of the buffer.
+	 * Writes data to the region of the buffer previously reserved with BufferWriter::Reserve().
+	 * Bounds are only checked in debug build, so the total size of data written through
+	 * this object should not exceed the reserved size.
+	 */
+	class Record{
+		friend class BufferWriter;
+
+		std::uint8_t* p;
+		std::uint8_t* end;
+
+		Record(std::uint8_t* p, size_t size)NOEXCEPT :
+				p(p),
+				end(p + size)
+		{}
+
+		std::uint8_t* Advance(size_t numBytes)NOEXCEPT{
+			ASSERT_INFO(numBytes <= size_t(this->end - this->p), "BufferWriter::Record: writing past the reserved region")
+			std::uint8_t* ret = this->p;
+			this->p += numBytes;
+			return ret;
+		}
+
+	public:
+		/**
+		 * @brief Get number of bytes left in the record.
+		 * @return number of reserved bytes which are not yet written.
+		 */
+		size_t NumLeft()const NOEXCEPT{
+			return this->end - this->p;
+		}
+
+		void Put8(std::uint8_t value)NOEXCEPT{
+			*this->Advance(1) = value;
+		}
+
+		void Put16LE(std::uint16_t value)NOEXCEPT{
+			ting::util::Serialize16LE(value, this->Advance(2));
+		}
+
+		void Put16BE(std::uint16_t value)NOEXCEPT{
+			ting::util::Serialize16BE(value, this->Advance(2));
+		}
+
+		void Put32LE(std::uint32_t value)NOEXCEPT{
+			ting::util::Serialize32LE(value, this->Advance(4));
+		}
+
+		void Put32BE(std::uint32_t value)NOEXCEPT{
+			ting::util::Serialize32BE(value, this->Advance(4));
+		}
+
+		void Put64LE(std::uint64_t value)NOEXCEPT{
+			ting::util::Serialize64LE(value, this->Advance(8));
+		}
+
+		void Put64BE(std::uint64_t value)NOEXCEPT{
+			ting::util::Serialize64BE(value, this->Advance(8));
+		}
+
+		void PutFloatLE(float value)NOEXCEPT{
+			ting::util::SerializeFloatLE(value, this->Advance(4));
+		}
+
+		void PutFloatBE(float value)NOEXCEPT{
+			ting::util::SerializeFloatBE(value, this->Advance(4));
+		}
+
+		void PutDoubleLE(double value)NOEXCEPT{
+			ting::util::SerializeDoubleLE(value, this->Advance(8));
+		}
+
+		void PutDoubleBE(double value)NOEXCEPT{
+			ting::util::SerializeDoubleBE(value, this->Advance(8));
+		}
+
+		/**
+		 * @brief Write unsigned LEB128 varint.
+		 * Reserved region should have at least ting::util::VarintSize(value) bytes left.
+		 * @param value - value to write.
+		 */
+		void PutVarint(std::uint64_t value)NOEXCEPT{
+			ASSERT_INFO(ting::util::VarintSize(value) <= this->NumLeft(), "BufferWriter::Record: writing past the reserved region")
+			this->p += ting::util::SerializeVarint(value, this->p);
+		}
+
+		/**
+		 * @brief Write raw bytes.
+		 * @param bytes - bytes to write.
+		 */
+		void PutBytes(ting::Buffer<const std::uint8_t> bytes)NOEXCEPT{
+			if(bytes.size() == 0){
+				return;
+			}
+			memcpy(this->Advance(bytes.size()), bytes.begin(), bytes.size());
+		}
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param buf - buffer to write data to.
+	 */
+	BufferWriter(ting::Buffer<std::uint8_t> buf)NOEXCEPT :
+			buf(buf)
+	{}
+
+	/**
+	 * @brief Get number of bytes written.
+	 * @return number of bytes written so far.
+	 */
+	size_t NumWritten()const NOEXCEPT{
+		return this->pos;
+	}
+
+	/**
+	 * @brief Get number of bytes left in the buffer.
+	 * @return number of bytes which can still be written.
+	 */
+	size_t NumLeft()const NOEXCEPT{
+		return this->buf.size() - this->pos;
+	}
+
+	/**
+	 * @brief Get written data.
+	 * @return Buffer pointing to the part of the buffer which has been written so far.
+	 */
+	ting::Buffer<std::uint8_t> Written()NOEXCEPT{
+		return ting::Buffer<std::uint8_t>(this->buf.begin(), this->pos);
+	}
+
+	/**
+	 * @brief Reserve region for a record of known size.
+	 * Checks bounds once for the whole record.
+	 * @param numBytes - size of the record in bytes.
+	 * @return Record object to write the record fields through.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer.
+	 */
+	Record Reserve(size_t numBytes){
+		if(numBytes > this->NumLeft()){
+			throw Exc("BufferWriter::Reserve(): not enough space left in the buffer");
+		}
+		Record ret(this->buf.begin() + this->pos, numBytes);
+		this->pos += numBytes;
+		return ret;
+	}
+
+	void Put8(std::uint8_t value){
+		this->Reserve(1).Put8(value);
+	}
+
+	void Put16LE(std::uint16_t value){
+		this->Reserve(2).Put16LE(value);
+	}
+
+	void Put16BE(std::uint16_t value){
+		this->Reserve(2).Put16BE(value);
+	}
+
+	void Put32LE(std::uint32_t value){
+		this->Reserve(4).Put32LE(value);
+	}
+
+	void Put32BE(std::uint32_t value){
+		this->Reserve(4).Put32BE(value);
+	}
+
+	void Put64LE(std::uint64_t value){
+		this->Reserve(8).Put64LE(value);
+	}
+
+	void Put64BE(std::uint64_t value){
+		this->Reserve(8).Put64BE(value);
+	}
+
+	void PutFloatLE(float value){
+		this->Reserve(4).PutFloatLE(value);
+	}
+
+	void PutFloatBE(float value){
+		this->Reserve(4).PutFloatBE(value);
+	}
+
+	void PutDoubleLE(double value){
+		this->Reserve(8).PutDoubleLE(value);
+	}
+
+	void PutDoubleBE(double value){
+		this->Reserve(8).PutDoubleBE(value);
+	}
+
+	/**
+	 * @brief Write unsigned LEB128 varint.
+	 * @param value - value to write.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer.
+	 */
+	void PutVarint(std::uint64_t value){
+		this->Reserve(ting::util::VarintSize(value)).PutVarint(value);
+	}
+
+	/**
+	 * @brief Write signed value as zigzag encoded LEB128 varint.
+	 * @param value - value to write.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer.
+	 */
+	void PutSignedVarint(std::int64_t value){
+		this->PutVarint(ting::util::ZigZagEncode64(value));
+	}
+
+	/**
+	 * @brief Write raw bytes.
+	 * @param bytes - bytes to write.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer.
+	 */
+	void PutBytes(ting::Buffer<const std::uint8_t> bytes){
+		this->Reserve(bytes.size()).PutBytes(bytes);
+	}
+
+	/**
+	 * @brief Write blob prefixed with 8 bit length.
+	 * @param bytes - blob to write, must not be longer than 255 bytes.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer or blob is too long.
+	 */
+	void PutBlob8(ting::Buffer<const std::uint8_t> bytes){
+		if(bytes.size() > 0xff){
+			throw Exc("BufferWriter::PutBlob8(): blob is too long");
+		}
+		auto r = this->Reserve(1 + bytes.size());
+		r.Put8(std::uint8_t(bytes.size()));
+		r.PutBytes(bytes);
+	}
+
+	/**
+	 * @brief Write blob prefixed with 16 bit big-endian length.
+	 * @param bytes - blob to write, must not be longer than 65535 bytes.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer or blob is too long.
+	 */
+	void PutBlob16BE(ting::Buffer<const std::uint8_t> bytes){
+		if(bytes.size() > 0xffff){
+			throw Exc("BufferWriter::PutBlob16BE(): blob is too long");
+		}
+		auto r = this->Reserve(2 + bytes.size());
+		r.Put16BE(std::uint16_t(bytes.size()));
+		r.PutBytes(bytes);
+	}
+
+	/**
+	 * @brief Write blob prefixed with varint length.
+	 * @param bytes - blob to write.
+	 * @throw BufferWriter::Exc - if there is not enough space left in the buffer.
+	 */
+	void PutBlobVarint(ting::Buffer<const std::uint8_t> bytes){
+		auto r = this->Reserve(ting::util::VarintSize(bytes.size()) + bytes.size());
+		r.PutVarint(bytes.size());
+		r.PutBytes(bytes);
+	}
+};
+
+
+
+/**
+ * @brief Binary data reader.
+ * Reads fixed width integers, floating point values, varints and length-prefixed blobs
+ * from a memory buffer. Each Get*() method checks that there is enough data left in the buffer
+ * and throws BufferReader::Exc otherwise.
+ * For records of known size the bounds can be checked only once by taking the whole record
+ * with Take() and then reading its fields through the returned BufferReader::Record object,
+ * which only checks bounds in debug build.
+ * Blobs are returned as Buffer objects pointing into the source buffer, no data is copied.
+ */
+class BufferReader{
+	ting::Buffer<const std::uint8_t> buf;
+	size_t pos = 0;
+
+public:
+	/**
+	 * @brief Exception thrown when there is not enough data in the buffer or data is malformed.
+	 */
+	class Exc : public ting::Exc{
+	public:
+		Exc(const std::string& message) :
+				ting::Exc(message)
+		{}
+	};
+
+	/**
+	 * @brief Taken region of the buffer.
+	 * Reads data from the region of the buffer previously taken with BufferReader::Take().
+	 * Bounds are only checked in debug build, so the total size of data read through
+	 * this object should not exceed the taken size.
+	 */
+	class Record{
+		friend class BufferReader;
+
+		const std::uint8_t* p;
+		const std::uint8_t* end;
+
+		Record(const std::uint8_t* p, size_t size)NOEXCEPT :
+				p(p),
+				end(p + size)
+		{}
+
+		const std::uint8_t* Advance(size_t numBytes)NOEXCEPT{
+			ASSERT_INFO(numBytes <= size_t(this->end - this->p), "BufferReader::Record: reading past the taken region")
+			const std::uint8_t* ret = this->p;
+			this->p += numBytes;
+			return ret;
+		}
+
+	public:
+		/**
+		 * @brief Get number of bytes left in the record.
+		 * @return number of taken bytes which are not yet read.
+		 */
+		size_t NumLeft()const NOEXCEPT{
+			return this->end - this->p;
+		}
+
+		std::uint8_t Get8()NOEXCEPT{
+			return *this->Advance(1);
+		}
+
+		std::uint16_t Get16LE()NOEXCEPT{
+			return ting::util::Deserialize16LE(this->Advance(2));
+		}
+
+		std::uint16_t Get16BE()NOEXCEPT{
+			return ting::util::Deserialize16BE(this->Advance(2));
+		}
+
+		std::uint32_t Get32LE()NOEXCEPT{
+			return ting::util::Deserialize32LE(this->Advance(4));
+		}
+
+		std::uint32_t Get32BE()NOEXCEPT{
+			return ting::util::Deserialize32BE(this->Advance(4));
+		}
+
+		std::uint64_t Get64LE()NOEXCEPT{
+			return ting::util::Deserialize64LE(this->Advance(8));
+		}
+
+		std::uint64_t Get64BE()NOEXCEPT{
+			return ting::util::Deserialize64BE(this->Advance(8));
+		}
+
+		float GetFloatLE()NOEXCEPT{
+			return ting::util::DeserializeFloatLE(this->Advance(4));
+		}
+
+		float GetFloatBE()NOEXCEPT{
+			return ting::util::DeserializeFloatBE(this->Advance(4));
+		}
+
+		double GetDoubleLE()NOEXCEPT{
+			return ting::util::DeserializeDoubleLE(this->Advance(8));
+		}
+
+		double GetDoubleBE()NOEXCEPT{
+			return ting::util::DeserializeDoubleBE(this->Advance(8));
+		}
+
+		/**
+		 * @brief Get raw bytes.
+		 * @param numBytes - number of bytes to get.
+		 * @return Buffer pointing to the bytes in the source buffer.
+		 */
+		ting::Buffer<const std::uint8_t> GetBytes(size_t numBytes)NOEXCEPT{
+			return ting::Buffer<const std::uint8_t>(this->Advance(numBytes), numBytes);
+		}
+
+		/**
+		 * @brief Skip bytes.
+		 * @param numBytes - number of bytes to skip.
+		 */
+		void Skip(size_t numBytes)NOEXCEPT{
+			this->Advance(numBytes);
+		}
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param buf - buffer to read data from.
+	 */
+	BufferReader(ting::Buffer<const std::uint8_t> buf)NOEXCEPT :
+			buf(buf)
+	{}
+
+	/**
+	 * @brief Get number of bytes read.
+	 * @return number of bytes read so far.
+	 */
+	size_t NumRead()const NOEXCEPT{
+		return this->pos;
+	}
+
+	/**
+	 * @brief Get number of bytes left in the buffer.
+	 * @return number of bytes which can still be read.
+	 */
+	size_t NumLeft()const NOEXCEPT{
+		return this->buf.size() - this->pos;
+	}
+
+	/**
+	 * @brief Take region for a record of known size.
+	 * Checks bounds once for the whole record.
+	 * @param numBytes - size of the record in bytes.
+	 * @return Record object to read the record fields through.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	Record Take(size_t numBytes){
+		if(numBytes > this->NumLeft()){
+			throw Exc("BufferReader::Take(): not enough data left in the buffer");
+		}
+		Record ret(this->buf.begin() + this->pos, numBytes);
+		this->pos += numBytes;
+		return ret;
+	}
+
+	std::uint8_t Get8(){
+		return this->Take(1).Get8();
+	}
+
+	std::uint16_t Get16LE(){
+		return this->Take(2).Get16LE();
+	}
+
+	std::uint16_t Get16BE(){
+		return this->Take(2).Get16BE();
+	}
+
+	std::uint32_t Get32LE(){
+		return this->Take(4).Get32LE();
+	}
+
+	std::uint32_t Get32BE(){
+		return this->Take(4).Get32BE();
+	}
+
+	std::uint64_t Get64LE(){
+		return this->Take(8).Get64LE();
+	}
+
+	std::uint64_t Get64BE(){
+		return this->Take(8).Get64BE();
+	}
+
+	float GetFloatLE(){
+		return this->Take(4).GetFloatLE();
+	}
+
+	float GetFloatBE(){
+		return this->Take(4).GetFloatBE();
+	}
+
+	double GetDoubleLE(){
+		return this->Take(8).GetDoubleLE();
+	}
+
+	double GetDoubleBE(){
+		return this->Take(8).GetDoubleBE();
+	}
+
+	/**
+	 * @brief Read unsigned LEB128 varint.
+	 * @return decoded value.
+	 * @throw BufferReader::Exc - if varint is truncated or malformed.
+	 */
+	std::uint64_t GetVarint(){
+		std::uint64_t ret;
+		size_t len = ting::util::DeserializeVarint64(
+				ting::Buffer<const std::uint8_t>(this->buf.begin() + this->pos, this->NumLeft()),
+				ret
+			);
+		if(len == 0){
+			throw Exc("BufferReader::GetVarint(): varint is truncated or malformed");
+		}
+		this->pos += len;
+		return ret;
+	}
+
+	/**
+	 * @brief Read zigzag encoded signed LEB128 varint.
+	 * @return decoded value.
+	 * @throw BufferReader::Exc - if varint is truncated or malformed.
+	 */
+	std::int64_t GetSignedVarint(){
+		return ting::util::ZigZagDecode64(this->GetVarint());
+	}
+
+	/**
+	 * @brief Get raw bytes.
+	 * @param numBytes - number of bytes to get.
+	 * @return Buffer pointing to the bytes in the source buffer.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	ting::Buffer<const std::uint8_t> GetBytes(size_t numBytes){
+		return this->Take(numBytes).GetBytes(numBytes);
+	}
+
+	/**
+	 * @brief Skip bytes.
+	 * @param numBytes - number of bytes to skip.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	void Skip(size_t numBytes){
+		this->Take(numBytes);
+	}
+
+	/**
+	 * @brief Read blob prefixed with 8 bit length.
+	 * @return Buffer pointing to the blob in the source buffer.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	ting::Buffer<const std::uint8_t> GetBlob8(){
+		return this->GetBytes(this->Get8());
+	}
+
+	/**
+	 * @brief Read blob prefixed with 16 bit big-endian length.
+	 * @return Buffer pointing to the blob in the source buffer.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	ting::Buffer<const std::uint8_t> GetBlob16BE(){
+		return this->GetBytes(this->Get16BE());
+	}
+
+	/**
+	 * @brief Read blob prefixed with varint length.
+	 * @return Buffer pointing to the blob in the source buffer.
+	 * @throw BufferReader::Exc - if there is not enough data left in the buffer.
+	 */
+	ting::Buffer<const std::uint8_t> GetBlobVarint(){
+		std::uint64_t size = this->GetVarint();
+		if(size > this->NumLeft()){
+			throw Exc("BufferReader::GetBlobVarint(): not enough data left in the buffer");
+		}
+		return this->GetBytes(size_t(size));
+	}
+};
+
+
+
+}//~namespace
@@ -39,8 +39,6 @@ THE SOFTWARE. */
 
 namespace ting{
 
-//TODO: rewrite using C++11
-
 /**
  * @brief class representing a set of flags.
  * If you define an enumeration according to the following rules:
@@ -75,14 +73,51 @@ namespace ting{
  * }
  * 
  * @endcode
+ * 
+ * Flags are stored in 64 bit words, whole-set operations process a word at a time
+ * and are written as branchless loops over fixed number of words, so that compilers can vectorize them.
  */
 template <class T_Enum> class Flags{
 public:
 	typedef typename ting::UnsignedTypeForSize<sizeof(T_Enum)>::Type index_t;
 	
+	/**
+	 * @brief Type of storage word.
+	 */
+	typedef std::uint64_t word_t;
+	
 private:
-	std::uint8_t flags[index_t(T_Enum::ENUM_SIZE) / 8 + 1];
-
+	static const size_t DWordBits = sizeof(word_t) * 8;
+	
+	static const size_t DNumWords = (size_t(T_Enum::ENUM_SIZE) + DWordBits - 1) / DWordBits == 0 ?
+			1 : (size_t(T_Enum::ENUM_SIZE) + DWordBits - 1) / DWordBits;
+	
+	//NOTE: unused bits of the last word are always kept cleared
+	word_t words[DNumWords];
+	
+	//mask of bits of i'th word which correspond to flags
+	static constexpr word_t WordMask(size_t i)NOEXCEPT{
+		return i != DNumWords - 1 || size_t(T_Enum::ENUM_SIZE) % DWordBits == 0 ?
+				(size_t(T_Enum::ENUM_SIZE) == 0 ? 0 : word_t(-1)) :
+				(word_t(1) << (size_t(T_Enum::ENUM_SIZE) % DWordBits)) - 1;
+	}
+	
+	static constexpr word_t WordOf(size_t i)NOEXCEPT{
+		return 0;
+	}
+	
+	template <class... T> static constexpr word_t WordOf(size_t i, T_Enum flag, T... rest)NOEXCEPT{
+		return (size_t(flag) / DWordBits == i ? word_t(1) << (size_t(flag) % DWordBits) : 0) | WordOf(i, rest...);
+	}
+	
+	template <size_t... I> constexpr Flags(bool value, ting::util::IndexSequence<I...>)NOEXCEPT :
+			words{(value ? WordMask(I) : 0)...}
+	{}
+	
+	template <size_t... I, class... T> constexpr Flags(ting::util::IndexSequence<I...>, T_Enum first, T... rest)NOEXCEPT :
+			words{WordOf(I, first, rest...)...}
+	{}
+	
 public:
 
 
@@ -91,15 +126,29 @@ public:
 	 * Creates a Flags with all flags initialized to a given value.
 	 * @param initialValueOfAllFlags - value to initialize all flags to.
 	 */
-	Flags(bool initialValueOfAllFlags = false){
-		this->SetAllTo(initialValueOfAllFlags);
-	}
+	constexpr Flags(bool initialValueOfAllFlags = false)NOEXCEPT :
+			Flags(initialValueOfAllFlags, ting::util::MakeIndexSequence<DNumWords>())
+	{}
+	
+	/**
+	 * @brief Constructor.
+	 * Creates a Flags with given flags set and all other flags cleared.
+	 * The object can be constructed at compile time, e.g.
+	 * @code
+	 * constexpr ting::Flags<MyEnum> DAdminFlags(MyEnum::READ, MyEnum::WRITE, MyEnum::DELETE);
+	 * @endcode
+	 * @param first - flag to set.
+	 * @param rest - other flags to set.
+	 */
+	template <class... T> constexpr Flags(T_Enum first, T... rest)NOEXCEPT :
+			Flags(ting::util::MakeIndexSequence<DNumWords>(), first, rest...)
+	{}
 
 	/**
 	 * @brief Size of the flag set.
 	 * @return Number of flags in this flag set.
 	 */
-	index_t Size()const NOEXCEPT{
+	constexpr index_t Size()const NOEXCEPT{
 		return index_t(T_Enum::ENUM_SIZE);
 	}
 
@@ -111,7 +160,7 @@ public:
 	 */
 	bool Get(T_Enum flag)const NOEXCEPT{
 		ASSERT(flag < T_Enum::ENUM_SIZE)
-		return (this->flags[index_t(flag) / 8] & (1 << (index_t(flag) % 8))) != 0;
+		return (this->words[size_t(flag) / DWordBits] & (word_t(1) << (size_t(flag) % DWordBits))) != 0;
 	}
 
 	/**
@@ -135,9 +184,9 @@ public:
 	Flags& SetTo(T_Enum flag, bool value)NOEXCEPT{
 		ASSERT(flag < T_Enum::ENUM_SIZE)
 		if(value){
-			this->flags[index_t(flag) / 8] |= (1 << (index_t(flag) % 8));
+			this->words[size_t(flag) / DWordBits] |= (word_t(1) << (size_t(flag) % DWordBits));
 		}else{
-			this->flags[index_t(flag) / 8] &= (~(1 << (index_t(flag) % 8)));
+			this->words[size_t(flag) / DWordBits] &= ~(word_t(1) << (size_t(flag) % DWordBits));
 		}
 		return *this;
 	}
@@ -201,7 +250,9 @@ public:
 	 * @return Reference to this Flags.
 	 */
 	Flags& SetAllTo(bool value)NOEXCEPT{
-		memset(this->flags, value ? std::uint8_t(-1) : 0, sizeof(this->flags));
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->words[i] = value ? WordMask(i) : 0;
+		}
 		return *this;
 	}
 
@@ -211,18 +262,11 @@ public:
 	 * @return false otherwise.
 	 */
 	bool IsAllClear()const NOEXCEPT{
-		ASSERT(sizeof(this->flags) > 0)
-		for(size_t i = 0; i != sizeof(this->flags) - 1; ++i){
-			if(this->flags[i] != 0){
-				return false;
-			}
+		word_t acc = 0;
+		for(size_t i = 0; i != DNumWords; ++i){
+			acc |= this->words[i];
 		}
-		for(index_t i = (this->Size() / 8) * 8; i != this->Size(); ++i){
-			if(this->Get(i)){
-				return false;
-			}
-		}
-		return true;
+		return acc == 0;
 	}
 
 	/**
@@ -231,18 +275,67 @@ public:
 	 * @return false otherwise.
 	 */
 	bool IsAllSet()const NOEXCEPT{
-		ASSERT(sizeof(this->flags) > 0)
-		for(size_t i = 0; i != sizeof(this->flags) - 1; ++i){
-			if(this->flags[i] != std::uint8_t(-1)){
-				return false;
+		word_t acc = 0;
+		for(size_t i = 0; i != DNumWords; ++i){
+			acc |= this->words[i] ^ WordMask(i);
+		}
+		return acc == 0;
+	}
+
+	/**
+	 * @brief Count set flags.
+	 * @return number of flags which are set.
+	 */
+	index_t NumSet()const NOEXCEPT{
+		size_t ret = 0;
+		for(size_t i = 0; i != DNumWords; ++i){
+			ret += ting::util::PopCount64(this->words[i]);
+		}
+		return index_t(ret);
+	}
+
+	/**
+	 * @brief Find first set flag starting from given index.
+	 * @param from - index to start search from.
+	 * @return index of the first set flag which is not less than 'from', or Size() if there is no such flag.
+	 */
+	index_t FindNextSet(index_t from = 0)const NOEXCEPT{
+		size_t i = size_t(from) / DWordBits;
+		if(i >= DNumWords){
+			return this->Size();
+		}
+		
+		word_t w = this->words[i] & (word_t(-1) << (size_t(from) % DWordBits));
+		for(;;){
+			if(w != 0){
+				return index_t(i * DWordBits + ting::util::CountTrailingZeros64(w));
 			}
+			if(++i == DNumWords){
+				return this->Size();
+			}
+			w = this->words[i];
 		}
-		for(index_t i = (this->Size() / 8) * 8; i != this->Size(); ++i){
-			if(!this->Get(i)){
-				return false;
+	}
+
+	/**
+	 * @brief Find first set flag.
+	 * @return index of the first set flag, or Size() if all flags are cleared.
+	 */
+	index_t FindFirstSet()const NOEXCEPT{
+		return this->FindNextSet(0);
+	}
+
+	/**
+	 * @brief Call function for each set flag.
+	 * Flags are visited in ascending order.
+	 * @param func - function to call, takes T_Enum as argument.
+	 */
+	template <class T_Func> void ForEachSet(T_Func func)const{
+		for(size_t i = 0; i != DNumWords; ++i){
+			for(word_t w = this->words[i]; w != 0; w &= w - 1){
+				func(T_Enum(i * DWordBits + ting::util::CountTrailingZeros64(w)));
 			}
 		}
-		return true;
 	}
 
 	/**
@@ -250,8 +343,8 @@ public:
 	 * @return Reference to this Flags.
 	 */
 	Flags& Invert()NOEXCEPT{
-		for(size_t i = 0; i != sizeof(this->flags); ++i){
-			this->flags[i] = ~this->flags[i];
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->words[i] = ~this->words[i] & WordMask(i);
 		}
 		return *this;
 	}
@@ -270,8 +363,8 @@ public:
      * @return Reference to this Flags.
      */
 	Flags& operator&=(const Flags& f)NOEXCEPT{
-		for(size_t i = 0; i != sizeof(this->flags); ++i){
-			this->flags[i] &= f.flags[i];
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->words[i] &= f.words[i];
 		}
 		return *this;
 	}
@@ -291,8 +384,8 @@ public:
      * @return Reference to this Flags.
      */
 	Flags& operator|=(const Flags& f)NOEXCEPT{
-		for(size_t i = 0; i != sizeof(this->flags); ++i){
-			this->flags[i] |= f.flags[i];
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->words[i] |= f.words[i];
 		}
 		return *this;
 	}
@@ -312,8 +405,8 @@ public:
      * @return Reference to this Flags.
      */
 	Flags& operator^=(const Flags& f)NOEXCEPT{
-		for(size_t i = 0; i != sizeof(this->flags); ++i){
-			this->flags[i] ^= f.flags[i];
+		for(size_t i = 0; i != DNumWords; ++i){
+			this->words[i] ^= f.words[i];
 		}
 		return *this;
 	}
@@ -327,6 +420,32 @@ public:
 		return Flags(*this).operator^=(f);
 	}
 	
+	/**
+	 * @brief Check if all flags of given set are set in this set.
+	 * Typical use is permission check.
+	 * @param f - flags to check.
+	 * @return true if every flag set in 'f' is also set in this Flags.
+	 */
+	bool IsAllSetOf(const Flags& f)const NOEXCEPT{
+		word_t acc = 0;
+		for(size_t i = 0; i != DNumWords; ++i){
+			acc |= f.words[i] & ~this->words[i];
+		}
+		return acc == 0;
+	}
+	
+	bool operator==(const Flags& f)const NOEXCEPT{
+		word_t acc = 0;
+		for(size_t i = 0; i != DNumWords; ++i){
+			acc |= this->words[i] ^ f.words[i];
+		}
+		return acc == 0;
+	}
+	
+	bool operator!=(const Flags& f)const NOEXCEPT{
+		return !this->operator==(f);
+	}
+	
 #ifdef DEBUG
 	friend std::ostream& operator<<(std::ostream& s, const Flags& fs){
 		s << "(";
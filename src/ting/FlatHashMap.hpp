@@ -0,0 +1,363 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Open addressing hash map.
+ */
+
+#pragma once
+
+#include <memory>
+#include <functional>
+#include <utility>
+
+#include "config.hpp"
+#include "debug.hpp"
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Open addressing hash map.
+ * Keys and values are stored in one flat array, collisions are resolved by linear probing.
+ * Each slot has a control byte which holds 7 bits of the key hash, so that most probes of
+ * non-matching slots do not touch the keys at all. Removal shifts subsequent entries back,
+ * so there are no tombstones and lookup performance does not degrade after many removals.
+ * Capacity is always a power of two and the map grows when it becomes 3/4 full.
+ *
+ * The hash value is multiplied by a constant before use, so that hash functions returning the key as is,
+ * like std::hash for integers, still spread the keys over the table.
+ *
+ * Pointers to the values are invalidated by insertion and removal of other entries.
+ * @param K - key type, should be default constructible and movable.
+ * @param V - value type, should be default constructible and movable.
+ * @param H - hash function.
+ * @param E - key equality function.
+ */
+template <class K, class V, class H = std::hash<K>, class E = std::equal_to<K>> class FlatHashMap{
+	struct Entry{
+		K key;
+		V value;
+	};
+	
+	//0 for empty slot, 0x80 | 7 bits of hash for occupied slot
+	std::unique_ptr<std::uint8_t[]> ctrl;
+	std::unique_ptr<Entry[]> entries;
+	
+	size_t capacity = 0;
+	unsigned capacityLog2 = 0;
+	size_t size = 0;
+	
+	H hasher;
+	E equal;
+	
+	static const size_t DMinCapacity = 16;
+	
+	std::uint64_t Mix(const K& key)const{
+		return std::uint64_t(this->hasher(key)) * 0x9e3779b97f4a7c15ULL;
+	}
+	
+	size_t Index(std::uint64_t m)const NOEXCEPT{
+		//higher bits of the product are better mixed
+		return size_t(m >> (64 - this->capacityLog2));
+	}
+	
+	static std::uint8_t Tag(std::uint64_t m)NOEXCEPT{
+		return std::uint8_t(0x80 | (m & 0x7f));
+	}
+	
+	size_t Next(size_t i)const NOEXCEPT{
+		return (i + 1) & (this->capacity - 1);
+	}
+	
+	//returns slot index of the key, or capacity if not found
+	size_t FindSlot(const K& key)const{
+		if(this->size == 0){
+			return this->capacity;
+		}
+		
+		std::uint64_t m = this->Mix(key);
+		std::uint8_t tag = Tag(m);
+		
+		//there is always at least one empty slot, so the loop ends
+		for(size_t i = this->Index(m);; i = this->Next(i)){
+			std::uint8_t c = this->ctrl[i];
+			if(c == 0){
+				return this->capacity;
+			}
+			if(c == tag && this->equal(this->entries[i].key, key)){
+				return i;
+			}
+		}
+	}
+	
+	//NOTE: the key should not be in the map and there should be free space.
+	Entry& InsertNew(std::uint64_t m, K&& key){
+		size_t i = this->Index(m);
+		for(; this->ctrl[i] != 0; i = this->Next(i)){}
+		this->ctrl[i] = Tag(m);
+		Entry& e = this->entries[i];
+		e.key = std::move(key);
+		++this->size;
+		return e;
+	}
+	
+	void Rehash(size_t newCapacity){
+		ASSERT(newCapacity >= DMinCapacity)
+		ASSERT((newCapacity & (newCapacity - 1)) == 0)
+		
+		std::unique_ptr<std::uint8_t[]> oldCtrl(new std::uint8_t[newCapacity]());
+		std::unique_ptr<Entry[]> oldEntries(new Entry[newCapacity]);
+		size_t oldCapacity = this->capacity;
+		
+		oldCtrl.swap(this->ctrl);
+		oldEntries.swap(this->entries);
+		
+		this->capacity = newCapacity;
+		for(this->capacityLog2 = 0; (size_t(1) << this->capacityLog2) != newCapacity; ++this->capacityLog2){}
+		this->size = 0;
+		
+		for(size_t i = 0; i != oldCapacity; ++i){
+			if(oldCtrl[i] == 0){
+				continue;
+			}
+			Entry& e = oldEntries[i];
+			this->InsertNew(this->Mix(e.key), std::move(e.key)).value = std::move(e.value);
+		}
+	}
+	
+	//remove entry at slot i, shifting back subsequent entries
+	void RemoveSlot(size_t i){
+		ASSERT(this->ctrl[i] != 0)
+		for(size_t j = this->Next(i); this->ctrl[j] != 0; j = this->Next(j)){
+			size_t home = this->Index(this->Mix(this->entries[j].key));
+			
+			//move the entry to the hole if its home slot is not between the hole and the entry
+			if(((j - home) & (this->capacity - 1)) >= ((j - i) & (this->capacity - 1))){
+				this->ctrl[i] = this->ctrl[j];
+				this->entries[i] = std::move(this->entries[j]);
+				i = j;
+			}
+		}
+		this->ctrl[i] = 0;
+		this->entries[i] = Entry();
+		--this->size;
+	}
+	
+public:
+	/**
+	 * @brief Create empty map.
+	 * @param expectedSize - number of entries to reserve space for, no memory is allocated if 0.
+	 */
+	FlatHashMap(size_t expectedSize = 0){
+		this->Reserve(expectedSize);
+	}
+	
+	FlatHashMap(const FlatHashMap&) = delete;
+	FlatHashMap& operator=(const FlatHashMap&) = delete;
+	
+	/**
+	 * @brief Get number of entries.
+	 * @return number of entries in the map.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->size;
+	}
+	
+	bool IsEmpty()const NOEXCEPT{
+		return this->size == 0;
+	}
+	
+	/**
+	 * @brief Get number of slots.
+	 * @return number of slots in the table, power of two or 0.
+	 */
+	size_t Capacity()const NOEXCEPT{
+		return this->capacity;
+	}
+	
+	/**
+	 * @brief Reserve space.
+	 * After this call the given number of entries can be added without growing the table.
+	 * @param numEntries - number of entries to reserve space for.
+	 */
+	void Reserve(size_t numEntries){
+		if(numEntries == 0){
+			return;
+		}
+		size_t c = DMinCapacity;
+		for(; c - c / 4 < numEntries; c <<= 1){}
+		if(c > this->capacity){
+			this->Rehash(c);
+		}
+	}
+	
+	/**
+	 * @brief Remove all entries.
+	 * Capacity is not changed.
+	 */
+	void Clear(){
+		for(size_t i = 0; i != this->capacity; ++i){
+			if(this->ctrl[i] != 0){
+				this->ctrl[i] = 0;
+				this->entries[i] = Entry();
+			}
+		}
+		this->size = 0;
+	}
+	
+	/**
+	 * @brief Find value by key.
+	 * @param key - key to find.
+	 * @return pointer to the value.
+	 * @return nullptr if there is no such key in the map.
+	 */
+	const V* Find(const K& key)const{
+		size_t i = this->FindSlot(key);
+		if(i == this->capacity){
+			return nullptr;
+		}
+		return &this->entries[i].value;
+	}
+	
+	V* Find(const K& key){
+		return const_cast<V*>(static_cast<const FlatHashMap*>(this)->Find(key));
+	}
+	
+	/**
+	 * @brief Check if the key is in the map.
+	 * @param key - key to check.
+	 * @return true if there is such key in the map.
+	 */
+	bool Contains(const K& key)const{
+		return this->FindSlot(key) != this->capacity;
+	}
+	
+	/**
+	 * @brief Get value by key, adding new entry if there is no such key.
+	 * @param key - key to find.
+	 * @return reference to the found value or to the default constructed value of the new entry.
+	 */
+	V& operator[](K key){
+		size_t i = this->FindSlot(key);
+		if(i != this->capacity){
+			return this->entries[i].value;
+		}
+		
+		this->Reserve(this->size + 1);
+		return this->InsertNew(this->Mix(key), std::move(key)).value;
+	}
+	
+	/**
+	 * @brief Add entry or replace value of existing entry.
+	 * @param key - key.
+	 * @param value - value.
+	 * @return true if new entry was added.
+	 * @return false if value of existing entry was replaced.
+	 */
+	bool Insert(K key, V value){
+		size_t i = this->FindSlot(key);
+		if(i != this->capacity){
+			this->entries[i].value = std::move(value);
+			return false;
+		}
+		
+		this->Reserve(this->size + 1);
+		this->InsertNew(this->Mix(key), std::move(key)).value = std::move(value);
+		return true;
+	}
+	
+	/**
+	 * @brief Remove entry.
+	 * @param key - key of the entry to remove.
+	 * @return true if the entry was removed.
+	 * @return false if there is no such key in the map.
+	 */
+	bool Remove(const K& key){
+		size_t i = this->FindSlot(key);
+		if(i == this->capacity){
+			return false;
+		}
+		this->RemoveSlot(i);
+		return true;
+	}
+	
+	/**
+	 * @brief Remove entries satisfying the predicate.
+	 * Every entry is visited exactly once.
+	 * @param pred - function object taking (const K& key, V& value) and returning true if the entry should be removed.
+	 * @return number of removed entries.
+	 */
+	template <class P> size_t RemoveIf(P pred){
+		if(this->size == 0){
+			return 0;
+		}
+		
+		//Start right after an empty slot. Entries following it have their home slots after it as well,
+		//so shifting entries back on removal never moves unvisited entries before the current slot.
+		size_t start = 0;
+		for(; this->ctrl[start] != 0; ++start){}
+		
+		size_t ret = 0;
+		for(size_t n = 1, i = this->Next(start); n != this->capacity;){
+			if(this->ctrl[i] != 0 && pred(static_cast<const K&>(this->entries[i].key), this->entries[i].value)){
+				this->RemoveSlot(i);
+				++ret;
+				continue;//some other entry might have been moved to this slot
+			}
+			++n;
+			i = this->Next(i);
+		}
+		return ret;
+	}
+	
+	/**
+	 * @brief Call function for every entry.
+	 * The entries are visited in no particular order.
+	 * @param f - function object taking (const K& key, V& value).
+	 */
+	template <class F> void ForEach(F f){
+		for(size_t i = 0; i != this->capacity; ++i){
+			if(this->ctrl[i] != 0){
+				f(static_cast<const K&>(this->entries[i].key), this->entries[i].value);
+			}
+		}
+	}
+	
+	template <class F> void ForEach(F f)const{
+		for(size_t i = 0; i != this->capacity; ++i){
+			if(this->ctrl[i] != 0){
+				f(this->entries[i].key, static_cast<const V&>(this->entries[i].value));
+			}
+		}
+	}
+};
+
+
+
+}//~namespace
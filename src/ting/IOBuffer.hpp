@@ -0,0 +1,246 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Pooled reference counted I/O buffer.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "debug.hpp"
+#include "types.hpp"
+#include "Buffer.hpp"
+#include "PoolStored.hpp"
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Pooled reference counted I/O buffer.
+ * A fixed capacity memory block allocated from memory pool, together with the number of valid bytes in it.
+ * Copying an IOBuffer object does not copy the data, it only increments the atomic reference counter,
+ * so the buffer can be cheaply passed to other threads, e.g. captured by value in a message
+ * pushed to ting::mt::MsgThread.
+ * When the last reference is dropped the memory block is put to the cache of the current thread,
+ * so that subsequent IOBuffer::New() calls in that thread take the block without locking the pool.
+ * Blocks which do not fit into the per-thread cache are returned to the memory pool.
+ *
+ * Typical receive path:
+ * @code
+ * auto b = ting::IOBuffer<>::New();
+ * b.SetSize(socket.Recv(b.Buf()));
+ * workerThread.PushMessage([b](){
+ *     Process(b.View());
+ * });
+ * @endcode
+ *
+ * Note, that the data is shared between copies, it should not be modified once the buffer has been passed to other threads.
+ * @param capacity_bytes - capacity of the buffer in bytes.
+ * @param num_blocks_in_chunk - number of blocks in one memory pool chunk.
+ */
+template <std::uint32_t capacity_bytes = 2048, unsigned num_blocks_in_chunk = 32> class IOBuffer{
+	struct Block{
+		std::atomic<std::uint32_t> refCount;
+		std::uint32_t size;
+		std::uint8_t data[capacity_bytes];
+	};
+
+	typedef StaticMemoryPool<sizeof(Block), num_blocks_in_chunk> T_Pool;
+
+	//per-thread cache of free blocks
+	class Cache{
+		static const unsigned DMaxBlocks = 16;
+
+		Block* blocks[DMaxBlocks];
+		unsigned numBlocks = 0;
+
+	public:
+		~Cache()NOEXCEPT{
+			for(unsigned i = 0; i != this->numBlocks; ++i){
+				T_Pool::Free_ts(this->blocks[i]);
+			}
+		}
+
+		Block* Get(){
+			if(this->numBlocks != 0){
+				return this->blocks[--this->numBlocks];
+			}
+			return reinterpret_cast<Block*>(T_Pool::Alloc_ts());
+		}
+
+		void Put(Block* b)NOEXCEPT{
+			if(this->numBlocks != DMaxBlocks){
+				this->blocks[this->numBlocks++] = b;
+				return;
+			}
+			T_Pool::Free_ts(b);
+		}
+
+		static Cache& Inst(){
+			static thread_local Cache instance;
+			return instance;
+		}
+	};
+
+	Block* block = nullptr;
+
+	explicit IOBuffer(Block* block)NOEXCEPT :
+			block(block)
+	{}
+
+	void Release()NOEXCEPT{
+		if(!this->block){
+			return;
+		}
+		if(this->block->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1){
+			this->block->~Block();
+			Cache::Inst().Put(this->block);
+		}
+		this->block = nullptr;
+	}
+
+public:
+	/**
+	 * @brief Capacity of the buffer.
+	 */
+	static const std::uint32_t DCapacity = capacity_bytes;
+
+	/**
+	 * @brief Create an empty IOBuffer object.
+	 * The object does not refer to any memory block.
+	 */
+	IOBuffer()NOEXCEPT{}
+
+	IOBuffer(const IOBuffer& b)NOEXCEPT :
+			block(b.block)
+	{
+		if(this->block){
+			this->block->refCount.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	IOBuffer(IOBuffer&& b)NOEXCEPT :
+			block(b.block)
+	{
+		b.block = nullptr;
+	}
+
+	IOBuffer& operator=(IOBuffer b)NOEXCEPT{
+		std::swap(this->block, b.block);
+		return *this;
+	}
+
+	~IOBuffer()NOEXCEPT{
+		this->Release();
+	}
+
+	/**
+	 * @brief Allocate new buffer.
+	 * Takes memory block from the per-thread cache or from the memory pool.
+	 * @return IOBuffer with reference count of 1 and size of 0.
+	 */
+	static IOBuffer New(){
+		Block* b = Cache::Inst().Get();
+		new(b) Block;//default initialization, the data is not zeroed
+		b->refCount.store(1, std::memory_order_relaxed);
+		b->size = 0;
+		return IOBuffer(b);
+	}
+
+	/**
+	 * @brief Drop the reference to the memory block.
+	 */
+	void Reset()NOEXCEPT{
+		this->Release();
+	}
+
+	/**
+	 * @brief Check if the object refers to a memory block.
+	 * @return true if refers to a memory block.
+	 */
+	explicit operator bool()const NOEXCEPT{
+		return this->block != nullptr;
+	}
+
+	/**
+	 * @brief Get number of IOBuffer objects referring to the same memory block.
+	 * @return reference count, 0 if this object is empty.
+	 */
+	std::uint32_t UseCount()const NOEXCEPT{
+		return this->block ? this->block->refCount.load(std::memory_order_relaxed) : 0;
+	}
+
+	/**
+	 * @brief Get whole memory block.
+	 * Use it to fill the buffer, then call SetSize().
+	 * @return Buffer spanning whole capacity of the memory block.
+	 */
+	ting::Buffer<std::uint8_t> Buf()NOEXCEPT{
+		ASSERT(this->block)
+		return ting::Buffer<std::uint8_t>(this->block->data, capacity_bytes);
+	}
+
+	/**
+	 * @brief Get valid data.
+	 * @return Buffer spanning first Size() bytes of the memory block.
+	 */
+	ting::Buffer<const std::uint8_t> View()const NOEXCEPT{
+		ASSERT(this->block)
+		return ting::Buffer<const std::uint8_t>(this->block->data, this->block->size);
+	}
+
+	operator ting::Buffer<const std::uint8_t>()const NOEXCEPT{
+		return this->View();
+	}
+
+	/**
+	 * @brief Get number of valid bytes.
+	 * @return number of valid bytes in the buffer.
+	 */
+	size_t Size()const NOEXCEPT{
+		ASSERT(this->block)
+		return this->block->size;
+	}
+
+	/**
+	 * @brief Set number of valid bytes.
+	 * @param size - number of valid bytes, must not exceed capacity.
+	 */
+	void SetSize(size_t size)NOEXCEPT{
+		ASSERT(this->block)
+		ASSERT(size <= capacity_bytes)
+		this->block->size = std::uint32_t(size);
+	}
+};
+
+
+
+}//~namespace
@@ -0,0 +1,269 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Intrusive reference counting.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <type_traits>
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "types.hpp"
+
+
+
+namespace ting{
+
+template <class T> class Ref;
+
+
+
+namespace impl{
+
+template <bool thread_safe> struct RefCounter;
+
+template <> struct RefCounter<true>{
+	std::atomic<std::uint32_t> count;
+	
+	RefCounter()NOEXCEPT :
+			count(0)
+	{}
+	
+	void Inc()NOEXCEPT{
+		this->count.fetch_add(1, std::memory_order_relaxed);
+	}
+	
+	//returns true if the counter has dropped to 0
+	bool Dec()NOEXCEPT{
+		return this->count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	}
+	
+	std::uint32_t Get()const NOEXCEPT{
+		return this->count.load(std::memory_order_relaxed);
+	}
+};
+
+template <> struct RefCounter<false>{
+	std::uint32_t count = 0;
+	
+	void Inc()NOEXCEPT{
+		++this->count;
+	}
+	
+	bool Dec()NOEXCEPT{
+		return --this->count == 0;
+	}
+	
+	std::uint32_t Get()const NOEXCEPT{
+		return this->count;
+	}
+};
+
+}//~namespace
+
+
+
+/**
+ * @brief Base class for intrusively reference counted objects.
+ * Reference counter is stored inside of the object itself, so, unlike with std::shared_ptr
+ * created from raw pointer, there is only one memory allocation per object and the counter
+ * is in the same cache line as the beginning of the object.
+ * Objects are managed by ting::Ref smart pointers and are created with ting::MakeRef().
+ * Since the counter is inside of the object, a Ref can be constructed right from 'this' pointer,
+ * there is no need for something like shared_from_this().
+ *
+ * Non thread-safe variant uses plain integer counter and can be used for objects which never
+ * leave the thread which has created them.
+ *
+ * To store objects in memory pool derive the class from ting::PoolStored as well:
+ * @code
+ * class Connection : public ting::RefCounted<>, public ting::PoolStored<Connection, 64>{
+ *     ...
+ * };
+ * 
+ * ting::Ref<Connection> c = ting::MakeRef<Connection>();
+ * @endcode
+ * @param thread_safe - if true, the reference counter is atomic.
+ */
+template <bool thread_safe = true> class RefCounted{
+	template <class T> friend class Ref;
+	
+	mutable impl::RefCounter<thread_safe> refCount;
+	
+	void IncRef()const NOEXCEPT{
+		this->refCount.Inc();
+	}
+	
+	void DecRef()const NOEXCEPT{
+		if(this->refCount.Dec()){
+			delete this;
+		}
+	}
+	
+protected:
+	RefCounted()NOEXCEPT{}
+	
+	//reference counter is not copied
+	RefCounted(const RefCounted&)NOEXCEPT{}
+	
+	RefCounted& operator=(const RefCounted&)NOEXCEPT{
+		return *this;
+	}
+	
+public:
+	/**
+	 * @brief Get number of references to this object.
+	 * @return current value of the reference counter.
+	 */
+	std::uint32_t RefCount()const NOEXCEPT{
+		return this->refCount.Get();
+	}
+	
+	virtual ~RefCounted()NOEXCEPT{}
+};
+
+
+
+/**
+ * @brief Smart pointer to intrusively reference counted object.
+ * @param T - type of the object, must be derived from ting::RefCounted.
+ */
+template <class T> class Ref{
+	template <class TT> friend class Ref;
+	
+	T* p = nullptr;
+	
+public:
+	Ref()NOEXCEPT{}
+	
+	Ref(std::nullptr_t)NOEXCEPT{}
+	
+	/**
+	 * @brief Construct from raw pointer.
+	 * Increments reference counter of the object, so it is safe to create a Ref from 'this'
+	 * inside of the object's member function as long as the object is owned by some other Ref.
+	 * @param p - pointer to the object.
+	 */
+	explicit Ref(T* p)NOEXCEPT :
+			p(p)
+	{
+		if(this->p){
+			this->p->IncRef();
+		}
+	}
+	
+	Ref(const Ref& r)NOEXCEPT :
+			Ref(r.p)
+	{}
+	
+	Ref(Ref&& r)NOEXCEPT :
+			p(r.p)
+	{
+		r.p = nullptr;
+	}
+	
+	//only implicit conversions, e.g. to base class, are allowed, use DynamicCast() for casting to derived class
+	template <class TT, class = typename std::enable_if<std::is_convertible<TT*, T*>::value>::type> Ref(const Ref<TT>& r)NOEXCEPT :
+			Ref(r.p)
+	{}
+	
+	template <class TT, class = typename std::enable_if<std::is_convertible<TT*, T*>::value>::type> Ref(Ref<TT>&& r)NOEXCEPT :
+			p(r.p)
+	{
+		r.p = nullptr;
+	}
+	
+	~Ref()NOEXCEPT{
+		if(this->p){
+			this->p->DecRef();
+		}
+	}
+	
+	Ref& operator=(Ref r)NOEXCEPT{
+		std::swap(this->p, r.p);
+		return *this;
+	}
+	
+	/**
+	 * @brief Drop the reference.
+	 */
+	void Reset()NOEXCEPT{
+		Ref().operator=(std::move(*this));
+	}
+	
+	T* Get()const NOEXCEPT{
+		return this->p;
+	}
+	
+	T* operator->()const NOEXCEPT{
+		ASSERT(this->p)
+		return this->p;
+	}
+	
+	T& operator*()const NOEXCEPT{
+		ASSERT(this->p)
+		return *this->p;
+	}
+	
+	explicit operator bool()const NOEXCEPT{
+		return this->p != nullptr;
+	}
+	
+	template <class TT> bool operator==(const Ref<TT>& r)const NOEXCEPT{
+		return this->p == r.p;
+	}
+	
+	template <class TT> bool operator!=(const Ref<TT>& r)const NOEXCEPT{
+		return this->p != r.p;
+	}
+	
+	/**
+	 * @brief Cast to Ref of derived class.
+	 * @return Ref pointing to the same object if the object is of type TT, empty Ref otherwise.
+	 */
+	template <class TT> Ref<TT> DynamicCast()const NOEXCEPT{
+		return Ref<TT>(dynamic_cast<TT*>(this->p));
+	}
+};
+
+
+
+/**
+ * @brief Function to construct new RefCounted objects.
+ * @param args - arguments of object class constructor.
+ * @return Ref pointing to a newly created object.
+ */
+template <class T, class... Args> Ref<T> MakeRef(Args&&... args){
+	return Ref<T>(new T(std::forward<Args>(args)...));
+}
+
+
+
+}//~namespace
@@ -0,0 +1,186 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+#include "config.hpp"
+
+#if M_OS == M_OS_LINUX
+#	include <sys/mman.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#	include <stdlib.h>
+#endif
+
+#include <cstring>
+#include <algorithm>
+
+#include "RingBuffer.hpp"
+#include "util.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace{
+
+size_t RoundUpToPowerOfTwo(size_t v){
+	size_t ret = 1;
+	for(; ret < v; ret <<= 1){
+		if(ret > (size_t(-1) >> 1)){
+			throw RingBuffer::Exc("RingBuffer: requested capacity is too big");
+		}
+	}
+	return ret;
+}
+
+
+
+#if M_OS == M_OS_LINUX
+
+int CreateSharedMemoryFile(){
+#	if defined(SYS_memfd_create)
+	{
+		int fd = int(syscall(SYS_memfd_create, "ting_RingBuffer", 0));
+		if(fd >= 0){
+			return fd;
+		}
+	}
+#	endif
+
+	//memfd is not supported by the kernel, use temporary file in shared memory file system
+	char name[] = "/dev/shm/ting_RingBuffer_XXXXXX";
+	int fd = mkstemp(name);
+	if(fd >= 0){
+		unlink(name);
+	}
+	return fd;
+}
+
+
+
+//Map the same memory twice into adjacent address ranges.
+//Returns nullptr if mirrored mapping could not be created.
+std::uint8_t* CreateMirroredMapping(size_t size){
+	int fd = CreateSharedMemoryFile();
+	if(fd < 0){
+		return nullptr;
+	}
+	ting::util::ScopeExit fdCloser([fd](){
+		close(fd);
+	});
+
+	if(ftruncate(fd, off_t(size)) != 0){
+		return nullptr;
+	}
+
+	//reserve address range for both mappings
+	void* addr = mmap(nullptr, 2 * size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(addr == MAP_FAILED){
+		return nullptr;
+	}
+	std::uint8_t* p = reinterpret_cast<std::uint8_t*>(addr);
+
+	if(
+			mmap(p, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != p ||
+			mmap(p + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != p + size
+		)
+	{
+		munmap(addr, 2 * size);
+		return nullptr;
+	}
+
+	return p;
+}
+
+#endif
+
+}//~namespace
+
+
+
+RingBuffer::RingBuffer(size_t capacity, bool mirrored){
+	if(capacity == 0){
+		throw Exc("RingBuffer: capacity must be greater than 0");
+	}
+
+#if M_OS == M_OS_LINUX
+	if(mirrored){
+		//mapping granularity is memory page, page size is a power of two
+		this->capacity = RoundUpToPowerOfTwo(std::max(capacity, size_t(sysconf(_SC_PAGESIZE))));
+		this->buf = CreateMirroredMapping(this->capacity);
+		if(this->buf){
+			this->isMirrored = true;
+			return;
+		}
+	}
+#endif
+
+	this->capacity = RoundUpToPowerOfTwo(capacity);
+	this->buf = new std::uint8_t[this->capacity];
+}
+
+
+
+RingBuffer::~RingBuffer()NOEXCEPT{
+#if M_OS == M_OS_LINUX
+	if(this->isMirrored){
+		munmap(this->buf, 2 * this->capacity);
+		return;
+	}
+#endif
+	delete[] this->buf;
+}
+
+
+
+size_t RingBuffer::Write(ting::Buffer<const std::uint8_t> data)NOEXCEPT{
+	size_t ret = 0;
+	for(auto& s : this->WritableSpans()){
+		size_t n = std::min(s.size(), data.size() - ret);
+		if(n == 0){
+			break;
+		}
+		memcpy(s.begin(), data.begin() + ret, n);
+		ret += n;
+	}
+	this->Commit(ret);
+	return ret;
+}
+
+
+
+size_t RingBuffer::Read(ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	size_t ret = 0;
+	for(auto& s : this->ReadableSpans()){
+		size_t n = std::min(s.size(), out.size() - ret);
+		if(n == 0){
+			break;
+		}
+		memcpy(out.begin() + ret, s.begin(), n);
+		ret += n;
+	}
+	this->Consume(ret);
+	return ret;
+}
@@ -0,0 +1,231 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ * @brief Byte ring buffer.
+ */
+
+#pragma once
+
+#include <array>
+
+#include "config.hpp"
+#include "debug.hpp"
+#include "Buffer.hpp"
+#include "Exc.hpp"
+
+
+
+namespace ting{
+
+
+
+/**
+ * @brief Owning byte ring buffer.
+ * The capacity of the buffer is always a power of two. Readable and writable regions
+ * of the buffer are exposed as Buffer spans, so that data can be received into and sent
+ * from the ring buffer directly, without intermediate copying and without moving
+ * partially consumed data to the beginning of the buffer.
+ * Typical usage is to write data into the span returned by WritableSpan() and then call Commit(),
+ * and to read data from the span returned by ReadableSpan() and then call Consume().
+ *
+ * When the readable or writable region wraps around the end of the memory block it is
+ * represented by two spans. On Linux the buffer can be created mirrored, in which case the memory
+ * block is mapped twice into adjacent virtual address ranges, so the region right after the end
+ * of the buffer is the beginning of the buffer again and the readable and writable regions are
+ * always contiguous, i.e. the second span is always empty.
+ */
+class RingBuffer{
+	std::uint8_t* buf;
+	size_t capacity;
+	bool isMirrored = false;
+
+	//free-running positions, actual index in the buffer is (pos & (capacity - 1))
+	size_t readPos = 0;
+	size_t writePos = 0;
+
+public:
+	/**
+	 * @brief Basic exception class.
+	 */
+	class Exc : public ting::Exc{
+	public:
+		Exc(const std::string& message) :
+				ting::Exc(message)
+		{}
+	};
+
+	/**
+	 * @brief Constructor.
+	 * @param capacity - minimal capacity of the buffer in bytes, actual capacity is rounded up to the
+	 *                   nearest power of two. For mirrored buffer it is also rounded up to the memory page size.
+	 * @param mirrored - whether to create mirrored buffer. If mirrored mapping is not supported
+	 *                   by the system then ordinary buffer is created, use IsMirrored() to check.
+	 */
+	RingBuffer(size_t capacity, bool mirrored = false);
+
+	RingBuffer(const RingBuffer&) = delete;
+	RingBuffer& operator=(const RingBuffer&) = delete;
+
+	~RingBuffer()NOEXCEPT;
+
+	/**
+	 * @brief Get capacity of the buffer.
+	 * @return capacity of the buffer in bytes, power of two.
+	 */
+	size_t Capacity()const NOEXCEPT{
+		return this->capacity;
+	}
+
+	/**
+	 * @brief Check if the buffer is mirrored.
+	 * @return true if readable and writable regions of the buffer are always contiguous.
+	 */
+	bool IsMirrored()const NOEXCEPT{
+		return this->isMirrored;
+	}
+
+	/**
+	 * @brief Get number of bytes available for reading.
+	 * @return number of bytes in the buffer.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->writePos - this->readPos;
+	}
+
+	/**
+	 * @brief Get number of bytes available for writing.
+	 * @return number of free bytes in the buffer.
+	 */
+	size_t NumFree()const NOEXCEPT{
+		return this->capacity - this->Size();
+	}
+
+	bool IsEmpty()const NOEXCEPT{
+		return this->Size() == 0;
+	}
+
+	bool IsFull()const NOEXCEPT{
+		return this->Size() == this->capacity;
+	}
+
+	/**
+	 * @brief Get first contiguous part of readable region.
+	 * @return span of the readable data which starts at current read position.
+	 */
+	ting::Buffer<const std::uint8_t> ReadableSpan()const NOEXCEPT{
+		size_t start = this->readPos & (this->capacity - 1);
+		size_t size = this->Size();
+		if(!this->isMirrored && size > this->capacity - start){
+			size = this->capacity - start;
+		}
+		return ting::Buffer<const std::uint8_t>(this->buf + start, size);
+	}
+
+	/**
+	 * @brief Get readable region.
+	 * @return two spans which together hold all readable data, second span is empty if region does not wrap.
+	 */
+	std::array<ting::Buffer<const std::uint8_t>, 2> ReadableSpans()const NOEXCEPT{
+		auto first = this->ReadableSpan();
+		std::array<ting::Buffer<const std::uint8_t>, 2> ret = {{
+				first,
+				ting::Buffer<const std::uint8_t>(this->buf, this->Size() - first.size())
+			}};
+		return ret;
+	}
+
+	/**
+	 * @brief Get first contiguous part of writable region.
+	 * @return span of the free space which starts at current write position.
+	 */
+	ting::Buffer<std::uint8_t> WritableSpan()NOEXCEPT{
+		size_t start = this->writePos & (this->capacity - 1);
+		size_t size = this->NumFree();
+		if(!this->isMirrored && size > this->capacity - start){
+			size = this->capacity - start;
+		}
+		return ting::Buffer<std::uint8_t>(this->buf + start, size);
+	}
+
+	/**
+	 * @brief Get writable region.
+	 * @return two spans which together hold all free space, second span is empty if region does not wrap.
+	 */
+	std::array<ting::Buffer<std::uint8_t>, 2> WritableSpans()NOEXCEPT{
+		auto first = this->WritableSpan();
+		std::array<ting::Buffer<std::uint8_t>, 2> ret = {{
+				first,
+				ting::Buffer<std::uint8_t>(this->buf, this->NumFree() - first.size())
+			}};
+		return ret;
+	}
+
+	/**
+	 * @brief Mark bytes as written.
+	 * Call this after writing data to the writable region.
+	 * @param numBytes - number of bytes written, must not exceed NumFree().
+	 */
+	void Commit(size_t numBytes)NOEXCEPT{
+		ASSERT(numBytes <= this->NumFree())
+		this->writePos += numBytes;
+	}
+
+	/**
+	 * @brief Mark bytes as read.
+	 * Call this after reading data from the readable region.
+	 * @param numBytes - number of bytes read, must not exceed Size().
+	 */
+	void Consume(size_t numBytes)NOEXCEPT{
+		ASSERT(numBytes <= this->Size())
+		this->readPos += numBytes;
+	}
+
+	/**
+	 * @brief Remove all data from the buffer.
+	 */
+	void Clear()NOEXCEPT{
+		this->readPos = 0;
+		this->writePos = 0;
+	}
+
+	/**
+	 * @brief Copy data into the buffer.
+	 * @param data - data to copy.
+	 * @return number of bytes copied, which is less than data size if there is not enough free space.
+	 */
+	size_t Write(ting::Buffer<const std::uint8_t> data)NOEXCEPT;
+
+	/**
+	 * @brief Copy data out of the buffer.
+	 * @param out - buffer to copy data to.
+	 * @return number of bytes copied, which is less than out size if there is not enough data.
+	 */
+	size_t Read(ting::Buffer<std::uint8_t> out)NOEXCEPT;
+};
+
+
+
+}//~namespace
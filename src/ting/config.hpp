@@ -188,3 +188,35 @@ THE SOFTWARE. */
 #	define M_OS M_OS_UNKNOWN
 #	define M_OS_NAME M_OS_NAME_UNKNOWN
 #endif
+
+
+
+//====================================================|
+//            Byte order definitions                  |
+//                                                    |
+
+#define M_BYTE_ORDER_UNKNOWN                          0
+#define M_BYTE_ORDER_LITTLE_ENDIAN                    1
+#define M_BYTE_ORDER_BIG_ENDIAN                       2
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#	define M_BYTE_ORDER M_BYTE_ORDER_LITTLE_ENDIAN
+#elif defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#	define M_BYTE_ORDER M_BYTE_ORDER_BIG_ENDIAN
+#elif M_COMPILER == M_COMPILER_MSVC //all platforms supported by MSVC are little-endian
+#	define M_BYTE_ORDER M_BYTE_ORDER_LITTLE_ENDIAN
+#else
+#	define M_BYTE_ORDER M_BYTE_ORDER_UNKNOWN
+#endif
+
+
+
+//====================================================|
+//            Language features                       |
+//                                                    |
+
+#if M_COMPILER == M_COMPILER_MSVC
+#	define NOEXCEPT throw()
+#else
+#	define NOEXCEPT noexcept
+#endif
@@ -0,0 +1,371 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+#include "../config.hpp"
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+#include <unordered_map>
+#include <set>
+#include <algorithm>
+
+#include "ArchiveFile.hpp"
+#include "FSFile.hpp"
+#include "../util.hpp"
+
+
+
+using namespace ting::fs;
+
+
+
+namespace{
+const std::uint32_t DEndOfCentralDirSignature = 0x06054b50;
+const std::uint32_t DCentralDirHeaderSignature = 0x02014b50;
+const std::uint32_t DLocalHeaderSignature = 0x04034b50;
+
+const size_t DEndOfCentralDirSize = 22;
+const size_t DCentralDirHeaderSize = 46;
+const size_t DLocalHeaderSize = 30;
+const size_t DMaxCommentSize = 0xffff;
+
+const std::uint16_t DMethodStored = 0;
+}
+
+
+
+struct ArchiveFile::Index{
+	struct Entry{
+		size_t offset;//offset of the entry data from the archive beginning
+		size_t size;
+		std::uint16_t method;
+	};
+
+	std::unordered_map<std::string, Entry> entries;
+
+	ting::Buffer<const std::uint8_t> archive;
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+	void* mapping = nullptr;
+	size_t mappingSize = 0;
+#else
+	std::vector<std::uint8_t> contents;
+#endif
+
+	Index(const Index&) = delete;
+	Index& operator=(const Index&) = delete;
+
+	Index(const std::string& archivePath){
+		this->Map(archivePath);
+		try{
+			this->Parse();
+		}catch(...){
+			this->Unmap();
+			throw;
+		}
+	}
+
+	~Index()NOEXCEPT{
+		this->Unmap();
+	}
+
+private:
+	void Map(const std::string& archivePath){
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+		int fd = open(archivePath.c_str(), O_RDONLY);
+		if(fd < 0){
+			throw File::Exc(std::string("ArchiveFile: could not open archive ") + archivePath);
+		}
+		ting::util::ScopeExit fdCloser([fd](){
+			close(fd);
+		});
+
+		struct stat st;
+		if(fstat(fd, &st) != 0){
+			throw File::Exc("ArchiveFile: fstat() failed");
+		}
+
+		if(st.st_size == 0){
+			return;//empty file, will fail to parse
+		}
+
+		this->mappingSize = size_t(st.st_size);
+		this->mapping = mmap(nullptr, this->mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(this->mapping == MAP_FAILED){
+			this->mapping = nullptr;
+			throw File::Exc("ArchiveFile: mmap() failed");
+		}
+		this->archive = ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(this->mapping), this->mappingSize);
+#else
+		this->contents = FSFile(archivePath).LoadWholeFileIntoMemory();
+		this->archive = this->contents;
+#endif
+	}
+
+	void Unmap()NOEXCEPT{
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+		if(this->mapping){
+			munmap(this->mapping, this->mappingSize);
+			this->mapping = nullptr;
+		}
+#endif
+	}
+
+	const std::uint8_t* FindEndOfCentralDir()const{
+		if(this->archive.size() < DEndOfCentralDirSize){
+			return nullptr;
+		}
+
+		//end of central directory record is followed by variable length comment, search backwards
+		const std::uint8_t* lowest = this->archive.begin();
+		if(this->archive.size() > DEndOfCentralDirSize + DMaxCommentSize){
+			lowest = this->archive.end() - (DEndOfCentralDirSize + DMaxCommentSize);
+		}
+
+		for(const std::uint8_t* p = this->archive.end() - DEndOfCentralDirSize;; --p){
+			if(ting::util::Deserialize32LE(p) == DEndOfCentralDirSignature){
+				return p;
+			}
+			if(p == lowest){
+				break;
+			}
+		}
+		return nullptr;
+	}
+
+	void Parse(){
+		const std::uint8_t* eocd = this->FindEndOfCentralDir();
+		if(!eocd){
+			throw File::Exc("ArchiveFile: end of central directory record not found, not a zip archive");
+		}
+
+		size_t numEntries = ting::util::Deserialize16LE(eocd + 10);
+		size_t cdSize = ting::util::Deserialize32LE(eocd + 12);
+		size_t cdOffset = ting::util::Deserialize32LE(eocd + 16);
+
+		if(cdOffset > this->archive.size() || cdSize > this->archive.size() - cdOffset){
+			throw File::Exc("ArchiveFile: central directory is out of archive bounds");
+		}
+
+		this->entries.reserve(numEntries);
+
+		const std::uint8_t* p = this->archive.begin() + cdOffset;
+		const std::uint8_t* cdEnd = p + cdSize;
+
+		for(size_t i = 0; i != numEntries; ++i){
+			if(size_t(cdEnd - p) < DCentralDirHeaderSize || ting::util::Deserialize32LE(p) != DCentralDirHeaderSignature){
+				throw File::Exc("ArchiveFile: malformed central directory header");
+			}
+
+			Entry e;
+			e.method = ting::util::Deserialize16LE(p + 10);
+			size_t compressedSize = ting::util::Deserialize32LE(p + 20);
+			e.size = ting::util::Deserialize32LE(p + 24);
+			size_t nameLen = ting::util::Deserialize16LE(p + 28);
+			size_t extraLen = ting::util::Deserialize16LE(p + 30);
+			size_t commentLen = ting::util::Deserialize16LE(p + 32);
+			size_t localHeaderOffset = ting::util::Deserialize32LE(p + 42);
+
+			size_t headerSize = DCentralDirHeaderSize + nameLen + extraLen + commentLen;
+			if(size_t(cdEnd - p) < headerSize){
+				throw File::Exc("ArchiveFile: central directory header is out of bounds");
+			}
+
+			std::string name(reinterpret_cast<const char*>(p + DCentralDirHeaderSize), nameLen);
+
+			p += headerSize;
+
+			//local header has its own name and extra field lengths, which may differ from central directory ones
+			if(localHeaderOffset > this->archive.size() || this->archive.size() - localHeaderOffset < DLocalHeaderSize){
+				throw File::Exc("ArchiveFile: local header is out of archive bounds");
+			}
+			const std::uint8_t* lh = this->archive.begin() + localHeaderOffset;
+			if(ting::util::Deserialize32LE(lh) != DLocalHeaderSignature){
+				throw File::Exc("ArchiveFile: malformed local header");
+			}
+			e.offset = localHeaderOffset + DLocalHeaderSize + ting::util::Deserialize16LE(lh + 26) + ting::util::Deserialize16LE(lh + 28);
+
+			if(e.offset > this->archive.size() || compressedSize > this->archive.size() - e.offset){
+				throw File::Exc("ArchiveFile: entry data is out of archive bounds");
+			}
+
+			if(e.method != DMethodStored){
+				e.size = compressedSize;
+			}else if(e.size != compressedSize){
+				throw File::Exc("ArchiveFile: stored entry sizes mismatch");
+			}
+
+			this->entries[std::move(name)] = e;
+		}
+	}
+};
+
+
+
+ArchiveFile::ArchiveFile(const std::string& archivePath, const std::string& pathName) :
+		File(pathName),
+		index(std::make_shared<Index>(archivePath))
+{}
+
+
+
+size_t ArchiveFile::NumEntries()const NOEXCEPT{
+	return this->index->entries.size();
+}
+
+
+
+//override
+void ArchiveFile::OpenInternal(E_Mode mode){
+	if(mode != E_Mode::READ){
+		throw File::Exc("ArchiveFile: archive is read-only");
+	}
+
+	if(this->IsDir()){
+		throw File::Exc("path refers to a directory, directories can't be opened");
+	}
+
+	auto i = this->index->entries.find(this->Path());
+	if(i == this->index->entries.end()){
+		throw File::Exc(std::string("ArchiveFile: no such entry in archive: ") + this->Path());
+	}
+
+	if(i->second.method != DMethodStored){
+		throw File::Exc("ArchiveFile: compressed entries are not supported");
+	}
+
+	this->data = ting::Buffer<const std::uint8_t>(this->index->archive.begin() + i->second.offset, i->second.size);
+	this->idx = 0;
+}
+
+
+
+//override
+void ArchiveFile::CloseInternal()const NOEXCEPT{
+	this->data = ting::Buffer<const std::uint8_t>();
+}
+
+
+
+//override
+size_t ArchiveFile::ReadInternal(ting::Buffer<std::uint8_t> buf)const{
+	ASSERT(this->idx <= this->data.size())
+	size_t numBytesRead = std::min(buf.size(), this->data.size() - this->idx);
+	memcpy(buf.begin(), this->data.begin() + this->idx, numBytesRead);
+	this->idx += numBytesRead;
+	return numBytesRead;
+}
+
+
+
+//override
+size_t ArchiveFile::SeekForwardInternal(size_t numBytesToSeek)const{
+	ASSERT(this->idx <= this->data.size())
+	numBytesToSeek = std::min(this->data.size() - this->idx, numBytesToSeek);
+	this->idx += numBytesToSeek;
+	return numBytesToSeek;
+}
+
+
+
+//override
+size_t ArchiveFile::SeekBackwardInternal(size_t numBytesToSeek)const{
+	ASSERT(this->idx <= this->data.size())
+	numBytesToSeek = std::min(this->idx, numBytesToSeek);
+	this->idx -= numBytesToSeek;
+	return numBytesToSeek;
+}
+
+
+
+//override
+void ArchiveFile::RewindInternal()const{
+	this->idx = 0;
+}
+
+
+
+//override
+bool ArchiveFile::Exists()const{
+	if(this->IsOpened()){
+		return true;
+	}
+
+	if(!this->IsDir()){
+		return this->index->entries.find(this->Path()) != this->index->entries.end();
+	}
+
+	//directory may not have its own entry in the archive, check if any entry lies under it
+	for(auto& e : this->index->entries){
+		if(e.first.compare(0, this->Path().size(), this->Path()) == 0){
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+//override
+std::vector<std::string> ArchiveFile::ListDirContents(size_t maxEntries)const{
+	if(!this->IsDir() && this->Path().size() != 0){
+		throw File::Exc("ArchiveFile::ListDirContents(): this is not a directory");
+	}
+
+	//NOTE: intermediate directories may have no entries of their own, so collect them from entry names
+	std::set<std::string> names;
+	for(auto& e : this->index->entries){
+		if(e.first.size() <= this->Path().size() || e.first.compare(0, this->Path().size(), this->Path()) != 0){
+			continue;
+		}
+
+		size_t slashPos = e.first.find('/', this->Path().size());
+		if(slashPos == std::string::npos){
+			names.insert(e.first.substr(this->Path().size()));
+		}else{
+			names.insert(e.first.substr(this->Path().size(), slashPos + 1 - this->Path().size()));
+		}
+	}
+
+	std::vector<std::string> files;
+	for(auto& n : names){
+		files.push_back(n);
+		if(files.size() == maxEntries){
+			break;
+		}
+	}
+	return files;
+}
+
+
+
+//override
+std::unique_ptr<File> ArchiveFile::Spawn(){
+	return std::unique_ptr<File>(new ArchiveFile(this->index, std::string()));
+}
@@ -0,0 +1,142 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @file Read-only File implementation over a zip archive.
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "File.hpp"
+
+
+
+namespace ting{
+namespace fs{
+
+
+
+/**
+ * @brief Zip archive file system.
+ * Read-only implementation of File interface which represents contents of a zip archive.
+ * The archive is mapped into memory and its central directory is indexed only once, when
+ * the first ArchiveFile object is constructed. All the objects obtained via Spawn() share
+ * that index, so opening files inside of the archive does not involve any system calls.
+ * Only stored (uncompressed) entries can be opened, attempt to open a compressed entry
+ * will result in exception.
+ * Spawned objects can be used from different threads simultaneously.
+ */
+class ArchiveFile : public File{
+public:
+	struct Index;
+
+private:
+	std::shared_ptr<const Index> index;
+
+	mutable ting::Buffer<const std::uint8_t> data;//data of the opened entry
+	mutable size_t idx;
+
+	ArchiveFile(std::shared_ptr<const Index> index, const std::string& pathName) :
+			File(pathName),
+			index(std::move(index))
+	{}
+
+public:
+	ArchiveFile(const ArchiveFile&) = delete;
+	ArchiveFile& operator=(const ArchiveFile&) = delete;
+
+	/**
+	 * @brief Constructor.
+	 * Maps the archive file into memory and builds the index of its entries.
+	 * @param archivePath - path to the zip archive in native file system.
+	 * @param pathName - initial path to set passed to File constructor.
+	 * @throw File::Exc - if archive could not be opened or it is not a valid zip archive.
+	 */
+	ArchiveFile(const std::string& archivePath, const std::string& pathName = std::string());
+
+	/**
+	 * @brief Destructor.
+	 * This destructor calls the Close() method.
+	 */
+	virtual ~ArchiveFile()NOEXCEPT{
+		this->Close();
+	}
+
+	/**
+	 * @brief Create new instance managed by auto-pointer.
+	 * @param archivePath - path to the zip archive in native file system.
+	 * @param pathName - path to a file within the archive.
+	 * @return Auto-pointer holding a new ArchiveFile instance.
+	 */
+	static std::unique_ptr<ArchiveFile> New(const std::string& archivePath, const std::string& pathName = std::string()){
+		return std::unique_ptr<ArchiveFile>(new ArchiveFile(archivePath, pathName));
+	}
+
+	/**
+	 * @brief Get number of entries in the archive.
+	 * @return number of file and directory entries in the archive.
+	 */
+	size_t NumEntries()const NOEXCEPT;
+
+	/**
+	 * @brief Get data of the opened file.
+	 * Returns a view into the memory mapped archive, no data is copied.
+	 * The returned buffer remains valid as long as this object, or any object spawned from it, is alive.
+	 * @return Buffer holding whole contents of the opened file.
+	 * @throw IllegalStateExc - if file is not opened.
+	 */
+	ting::Buffer<const std::uint8_t> Data()const{
+		if(!this->IsOpened()){
+			throw File::IllegalStateExc("ArchiveFile::Data(): file is not opened");
+		}
+		return this->data;
+	}
+
+	bool Exists()const override;
+
+	std::vector<std::string> ListDirContents(size_t maxEntries = 0)const override;
+
+	std::unique_ptr<File> Spawn()override;
+
+protected:
+	void OpenInternal(E_Mode mode)override;
+
+	void CloseInternal()const NOEXCEPT override;
+
+	size_t ReadInternal(ting::Buffer<std::uint8_t> buf)const override;
+
+	size_t SeekForwardInternal(size_t numBytesToSeek)const override;
+
+	size_t SeekBackwardInternal(size_t numBytesToSeek)const override;
+
+	void RewindInternal()const override;
+};
+
+
+
+}//~namespace
+}//~namespace
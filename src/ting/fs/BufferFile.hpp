@@ -67,8 +67,14 @@ public:
 	
 	~BufferFile()NOEXCEPT override{}
 
+	/**
+	 * @brief Create another BufferFile over the same memory buffer.
+	 * Spawned file has its own read/write position and open/close state.
+	 * Since the memory buffer is not owned, writes through either of the files are visible to the other one.
+	 * @return Newly spawned BufferFile object.
+	 */
 	virtual std::unique_ptr<File> Spawn()override{
-		throw File::Exc("BufferFile::Spawn(): spawning is not supported.");
+		return std::unique_ptr<File>(new BufferFile(this->data));
 	}
 
 protected:
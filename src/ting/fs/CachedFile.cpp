@@ -0,0 +1,307 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+#include "../config.hpp"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <algorithm>
+
+#include "CachedFile.hpp"
+#include "FSFile.hpp"
+
+
+
+using namespace ting::fs;
+
+
+
+namespace{
+
+typedef FSFile::Stamp Stamp;
+
+
+
+//returns invalid stamp for files which are not in native file system
+Stamp GetStamp(const File& f){
+	if(!dynamic_cast<const FSFile*>(&f)){
+		return Stamp();
+	}
+	return FSFile::GetStamp(f.Path());
+}
+
+
+
+class Cache{
+	struct Entry{
+		std::string path;
+		Stamp stamp;
+		std::shared_ptr<const std::vector<std::uint8_t>> data;
+	};
+
+	//most recently used entries go first
+	std::list<Entry> lru;
+
+	std::unordered_map<std::string, decltype(lru)::iterator> map;
+
+	size_t budget = 64 * 1024 * 1024;
+
+	CachedFile::Stats stats = {0, 0, 0, 0, 0};
+
+	void Remove(decltype(lru)::iterator i){
+		ASSERT(this->stats.numBytes >= i->data->size())
+		this->stats.numBytes -= i->data->size();
+		this->map.erase(i->path);
+		this->lru.erase(i);
+	}
+
+	void EvictToFit(size_t numBytes){
+		while(this->lru.size() != 0 && this->budget - numBytes < this->stats.numBytes){
+			this->Remove(std::prev(this->lru.end()));
+			++this->stats.evictions;
+		}
+	}
+
+public:
+	std::mutex mutex;
+
+	static Cache& Inst(){
+		static Cache instance;
+		return instance;
+	}
+
+	size_t Budget()const NOEXCEPT{
+		return this->budget;
+	}
+
+	void SetBudget(size_t maxBytes){
+		this->budget = maxBytes;
+		this->EvictToFit(0);
+	}
+
+	std::shared_ptr<const std::vector<std::uint8_t>> Get(const std::string& path, const Stamp& stamp){
+		auto i = this->map.find(path);
+		if(i == this->map.end()){
+			++this->stats.misses;
+			return nullptr;
+		}
+
+		if(!(i->second->stamp == stamp)){
+			this->Remove(i->second);
+			++this->stats.misses;
+			return nullptr;
+		}
+
+		this->lru.splice(this->lru.begin(), this->lru, i->second);
+		++this->stats.hits;
+		return i->second->data;
+	}
+
+	void Put(const std::string& path, const Stamp& stamp, std::shared_ptr<const std::vector<std::uint8_t>> data){
+		this->Invalidate(path);
+
+		if(data->size() > this->budget){
+			return;
+		}
+
+		this->EvictToFit(data->size());
+
+		Entry e;
+		e.path = path;
+		e.stamp = stamp;
+		e.data = std::move(data);
+		this->stats.numBytes += e.data->size();
+		this->lru.push_front(std::move(e));
+		this->map[path] = this->lru.begin();
+	}
+
+	void Invalidate(const std::string& path){
+		auto i = this->map.find(path);
+		if(i == this->map.end()){
+			return;
+		}
+		this->Remove(i->second);
+	}
+
+	void Clear(){
+		this->map.clear();
+		this->lru.clear();
+		this->stats.numBytes = 0;
+	}
+
+	CachedFile::Stats Stats()const NOEXCEPT{
+		CachedFile::Stats ret = this->stats;
+		ret.numEntries = this->lru.size();
+		return ret;
+	}
+};
+
+}//~namespace
+
+
+
+//static
+void CachedFile::SetCacheBudget(size_t maxBytes){
+	std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+	Cache::Inst().SetBudget(maxBytes);
+}
+
+
+
+//static
+CachedFile::Stats CachedFile::CacheStats(){
+	std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+	return Cache::Inst().Stats();
+}
+
+
+
+//static
+void CachedFile::ClearCache(){
+	std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+	Cache::Inst().Clear();
+}
+
+
+
+//static
+void CachedFile::Invalidate(const std::string& path){
+	std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+	Cache::Inst().Invalidate(path);
+}
+
+
+
+//override
+void CachedFile::OpenInternal(E_Mode mode){
+	if(mode != E_Mode::READ){
+		Invalidate(this->Path());
+		this->baseFile->Open(mode);
+		return;
+	}
+
+	Stamp stamp = GetStamp(*this->baseFile);
+
+	size_t budget;
+	{
+		std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+		this->data = Cache::Inst().Get(this->Path(), stamp);
+		budget = Cache::Inst().Budget();
+	}
+
+	if(this->data){
+		this->idx = 0;
+		return;
+	}
+
+	if(stamp.isValid && stamp.size > budget){
+		this->baseFile->Open(mode);
+		return;
+	}
+
+	//load one byte more than budget to find out if the file fits into the cache
+	auto d = std::make_shared<std::vector<std::uint8_t>>(
+			this->baseFile->LoadWholeFileIntoMemory(budget == size_t(-1) ? budget : budget + 1)
+		);
+	if(d->size() > budget){
+		this->baseFile->Open(mode);
+		return;
+	}
+
+	{
+		std::lock_guard<decltype(Cache::mutex)> lock(Cache::Inst().mutex);
+		Cache::Inst().Put(this->Path(), stamp, d);
+	}
+	this->data = std::move(d);
+	this->idx = 0;
+}
+
+
+
+//override
+void CachedFile::CloseInternal()const NOEXCEPT{
+	if(this->data){
+		this->data.reset();
+		return;
+	}
+	if(this->ioMode != E_Mode::READ){
+		//file might have been modified while cache entry was being loaded by other CachedFile object
+		try{
+			Invalidate(this->Path());
+		}catch(...){}
+	}
+	this->baseFile->Close();
+}
+
+
+
+//override
+size_t CachedFile::ReadInternal(ting::Buffer<std::uint8_t> buf)const{
+	if(!this->data){
+		return this->baseFile->Read(buf);
+	}
+	ASSERT(this->idx <= this->data->size())
+	size_t numBytesRead = std::min(buf.size(), this->data->size() - this->idx);
+	memcpy(buf.begin(), this->data->data() + this->idx, numBytesRead);
+	this->idx += numBytesRead;
+	return numBytesRead;
+}
+
+
+
+//override
+size_t CachedFile::SeekForwardInternal(size_t numBytesToSeek)const{
+	if(!this->data){
+		return this->baseFile->SeekForward(numBytesToSeek);
+	}
+	ASSERT(this->idx <= this->data->size())
+	numBytesToSeek = std::min(this->data->size() - this->idx, numBytesToSeek);
+	this->idx += numBytesToSeek;
+	return numBytesToSeek;
+}
+
+
+
+//override
+size_t CachedFile::SeekBackwardInternal(size_t numBytesToSeek)const{
+	if(!this->data){
+		return this->baseFile->SeekBackward(numBytesToSeek);
+	}
+	ASSERT(this->idx <= this->data->size())
+	numBytesToSeek = std::min(this->idx, numBytesToSeek);
+	this->idx -= numBytesToSeek;
+	return numBytesToSeek;
+}
+
+
+
+//override
+void CachedFile::RewindInternal()const{
+	if(!this->data){
+		this->baseFile->Rewind();
+		return;
+	}
+	this->idx = 0;
+}
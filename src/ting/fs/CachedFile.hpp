@@ -0,0 +1,165 @@
+/* The MIT License:
+
+Copyright (c) 2009-2014 Ivan Gagis
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+/**
+ * @file File wrapper caching file contents in memory.
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "File.hpp"
+
+
+
+namespace ting{
+namespace fs{
+
+
+
+/**
+ * @brief File wrapper which caches file contents in memory.
+ * When opened for reading, the whole file is loaded into a process-wide LRU cache
+ * and subsequent openings of the same path are served from the cache without touching the
+ * wrapped File. The cache is keyed by path, so all CachedFile objects should wrap files from
+ * the same file system, i.e. if root directory is needed then wrap the CachedFile into RootDirFile,
+ * not vice versa.
+ * If the wrapped file is FSFile then cached entries are validated against file size and
+ * modification time on each opening, which costs one stat() call.
+ * Files which are bigger than the cache budget are not cached and are read through the wrapped File.
+ * Opening the file for writing bypasses the cache and invalidates the cached entry.
+ */
+class CachedFile : public File{
+	std::unique_ptr<File> baseFile;
+
+	mutable std::shared_ptr<const std::vector<std::uint8_t>> data;//cached data of the opened file, null if not served from cache
+	mutable size_t idx;
+
+public:
+	/**
+	 * @brief Cache statistics.
+	 */
+	struct Stats{
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+		size_t numEntries;
+		size_t numBytes;//total size of cached data
+	};
+
+	/**
+	 * @param baseFile - a File to wrap.
+	 */
+	CachedFile(std::unique_ptr<File> baseFile) :
+			baseFile(std::move(baseFile))
+	{
+		if(!this->baseFile){
+			throw File::Exc("CachedFile(): passed in base file pointer is null");
+		}
+		this->File::SetPathInternal(this->baseFile->Path());
+	}
+
+	static std::unique_ptr<CachedFile> New(std::unique_ptr<File> baseFile){
+		return std::unique_ptr<CachedFile>(new CachedFile(std::move(baseFile)));
+	}
+
+	CachedFile(const CachedFile&) = delete;
+	CachedFile& operator=(const CachedFile&) = delete;
+
+	virtual ~CachedFile()NOEXCEPT{
+		this->Close();
+	}
+
+	/**
+	 * @brief Set size limit of the cache.
+	 * Least recently used entries are evicted to fit the new limit.
+	 * Default limit is 64 megabytes.
+	 * @param maxBytes - maximum total size of cached file data in bytes.
+	 */
+	static void SetCacheBudget(size_t maxBytes);
+
+	/**
+	 * @brief Get cache statistics.
+	 * @return current statistics of the process-wide cache.
+	 */
+	static Stats CacheStats();
+
+	/**
+	 * @brief Remove all entries from the cache.
+	 * Statistics counters are not reset.
+	 */
+	static void ClearCache();
+
+	/**
+	 * @brief Remove cached entry for the given path.
+	 * @param path - path of the file to remove from cache.
+	 */
+	static void Invalidate(const std::string& path);
+
+private:
+	void SetPathInternal(const std::string& pathName)const override{
+		this->File::SetPathInternal(pathName);
+		this->baseFile->SetPath(pathName);
+	}
+
+	void OpenInternal(E_Mode mode)override;
+
+	void CloseInternal()const NOEXCEPT override;
+
+	std::vector<std::string> ListDirContents(size_t maxEntries = 0)const override{
+		return this->baseFile->ListDirContents(maxEntries);
+	}
+
+	size_t ReadInternal(ting::Buffer<std::uint8_t> buf)const override;
+
+	size_t WriteInternal(ting::Buffer<const std::uint8_t> buf)override{
+		return this->baseFile->Write(buf);
+	}
+
+	size_t SeekForwardInternal(size_t numBytesToSeek)const override;
+
+	size_t SeekBackwardInternal(size_t numBytesToSeek)const override;
+
+	void RewindInternal()const override;
+
+	void MakeDir()override{
+		this->baseFile->MakeDir();
+	}
+
+	bool Exists()const override{
+		return this->baseFile->Exists();
+	}
+
+	std::unique_ptr<File> Spawn()override{
+		return New(this->baseFile->Spawn());
+	}
+};
+
+
+
+}//~namespace
+}//~namespace
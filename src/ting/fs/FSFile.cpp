@@ -26,10 +26,14 @@ THE SOFTWARE. */
 
 #if M_OS == M_OS_WINDOWS
 #	include "../windows.hpp"
+#	include <io.h>
+#	include <sys/types.h>
+#	include <sys/stat.h>
 
 #elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
 #	include <dirent.h>
 #	include <sys/stat.h>
+#	include <unistd.h>
 #	include <cerrno>
 
 #endif
@@ -40,6 +44,8 @@ THE SOFTWARE. */
 
 #include "FSFile.hpp"
 #include "../util.hpp"
+#include "../mt/Thread.hpp"
+#include "../mt/Semaphore.hpp"
 
 
 
@@ -47,6 +53,43 @@ using namespace ting::fs;
 
 
 
+class FSFile::SyncThread : public ting::mt::Thread{
+	FSFile& file;
+	std::uint32_t intervalMillis;
+	
+public:
+	ting::mt::Semaphore stopSema;
+	
+	SyncThread(FSFile& file, std::uint32_t intervalMillis) :
+			file(file),
+			intervalMillis(intervalMillis)
+	{}
+	
+	void Run()override{
+		while(!this->stopSema.Wait(this->intervalMillis)){
+			try{
+				this->file.Sync();
+			}catch(ting::Exc& e){
+				TRACE(<< "FSFile::SyncThread::Run(): Sync() failed: " << e.What() << std::endl)
+			}
+		}
+	}
+};
+
+
+
+FSFile::FSFile(const std::string& pathName) :
+		File(pathName)
+{}
+
+
+
+FSFile::~FSFile()NOEXCEPT{
+	this->Close();
+}
+
+
+
 //override
 void FSFile::OpenInternal(E_Mode mode){
 	if(this->IsDir()){
@@ -90,15 +133,143 @@ void FSFile::OpenInternal(E_Mode mode){
 void FSFile::CloseInternal()const NOEXCEPT{
 	ASSERT(this->handle)
 
+	const_cast<FSFile*>(this)->StopPeriodicSync();
+	
+	try{
+		this->WriteOutBuffer();
+	}catch(File::Exc&){
+		//ignore, nothing can be done
+		TRACE(<< "FSFile::CloseInternal(): failed to write out the buffered data" << std::endl)
+		this->writeBufFill = 0;
+	}
+
 	fclose(this->handle);
 	this->handle = 0;
 }
 
 
 
+void FSFile::WriteOutBuffer()const{
+	ASSERT(this->handle)
+	if(this->writeBufFill == 0){
+		return;
+	}
+	ASSERT(this->writeBufFill <= this->writeBuf.size())
+	size_t bytesWritten = fwrite(&*this->writeBuf.begin(), 1, this->writeBufFill, this->handle);
+	if(bytesWritten != this->writeBufFill){
+		//keep not written data in the buffer
+		memmove(&*this->writeBuf.begin(), &this->writeBuf[bytesWritten], this->writeBufFill - bytesWritten);
+		this->writeBufFill -= bytesWritten;
+		throw File::Exc("fwrite error");
+	}
+	this->writeBufFill = 0;
+}
+
+
+
+void FSFile::SetWriteBufferSize(size_t size){
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	if(this->IsOpened()){
+		this->WriteOutBuffer();
+	}
+	ASSERT(this->writeBufFill == 0)
+	this->writeBuf.resize(size);
+	this->writeBuf.shrink_to_fit();
+}
+
+
+
+void FSFile::Flush(){
+	if(!this->IsOpened()){
+		throw File::IllegalStateExc("Flush(): file is not opened");
+	}
+	
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->FlushLocked();
+}
+
+
+
+void FSFile::FlushLocked(){
+	ASSERT(this->handle)
+	this->WriteOutBuffer();
+	if(fflush(this->handle) != 0){
+		throw File::Exc("fflush() failed");
+	}
+}
+
+
+
+void FSFile::Sync(){
+	if(!this->IsOpened()){
+		throw File::IllegalStateExc("Sync(): file is not opened");
+	}
+	
+	int fd;
+	{
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		this->FlushLocked();
+#if M_OS == M_OS_WINDOWS
+		fd = _fileno(this->handle);
+#else
+		fd = fileno(this->handle);
+#endif
+	}
+	
+	//NOTE: the mutex is not held while the OS writes the data to the storage device, which may take long,
+	//      so that Write() calls are not blocked by the periodic sync thread for that time.
+	//      File descriptor stays valid, because CloseInternal() stops the periodic sync thread before closing the file.
+#if M_OS == M_OS_LINUX
+	if(fdatasync(fd) != 0){
+		throw File::Exc("fdatasync() failed");
+	}
+#elif M_OS == M_OS_MACOSX
+	if(fsync(fd) != 0){
+		throw File::Exc("fsync() failed");
+	}
+#elif M_OS == M_OS_WINDOWS
+	if(_commit(fd) != 0){
+		throw File::Exc("_commit() failed");
+	}
+#else
+#	error "FSFile::Sync(): not implemented for this OS"
+#endif
+}
+
+
+
+void FSFile::StartPeriodicSync(std::uint32_t intervalMillis){
+	if(!this->IsOpened()){
+		throw File::IllegalStateExc("StartPeriodicSync(): file is not opened");
+	}
+	if(this->ioMode != E_Mode::WRITE){
+		throw File::IllegalStateExc("StartPeriodicSync(): file is not opened for writing");
+	}
+	
+	this->StopPeriodicSync();
+	
+	this->syncThread = std::unique_ptr<SyncThread>(new SyncThread(*this, intervalMillis));
+	this->syncThread->Start();
+}
+
+
+
+void FSFile::StopPeriodicSync()NOEXCEPT{
+	if(!this->syncThread){
+		return;
+	}
+	this->syncThread->stopSema.Signal();
+	this->syncThread->Join();
+	this->syncThread.reset();
+}
+
+
+
 //override
 size_t FSFile::ReadInternal(ting::Buffer<std::uint8_t> buf)const{
 	ASSERT(this->handle)
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->WriteOutBuffer();
 	size_t numBytesRead = fread(buf.begin(), 1, buf.size(), this->handle);
 	if(numBytesRead != buf.size()){//something happened
 		if(!feof(this->handle)){
@@ -113,6 +284,25 @@ size_t FSFile::ReadInternal(ting::Buffer<std::uint8_t> buf)const{
 //override
 size_t FSFile::WriteInternal(ting::Buffer<const std::uint8_t> buf){
 	ASSERT(this->handle)
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	
+	if(this->writeBuf.size() != 0){
+		ASSERT(this->writeBufFill <= this->writeBuf.size())
+		if(buf.size() > this->writeBuf.size() - this->writeBufFill){
+			this->WriteOutBuffer();
+		}
+		
+		ASSERT(this->writeBufFill <= this->writeBuf.size())
+		if(buf.size() <= this->writeBuf.size() - this->writeBufFill){
+			memcpy(&this->writeBuf[this->writeBufFill], buf.begin(), buf.size());
+			this->writeBufFill += buf.size();
+			return buf.size();
+		}
+		
+		//buffer is empty and the data does not fit into it, write directly
+		ASSERT(this->writeBufFill == 0)
+	}
+	
 	size_t bytesWritten = fwrite(buf.begin(), 1, buf.size(), this->handle);
 	if(bytesWritten != buf.size()){//something bad has happened
 		throw File::Exc("fwrite error");
@@ -126,6 +316,8 @@ size_t FSFile::WriteInternal(ting::Buffer<const std::uint8_t> buf){
 //override
 size_t FSFile::SeekBackwardInternal(size_t numBytesToSeek)const{
 	ASSERT(this->handle)
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->WriteOutBuffer();
 	
 	//NOTE: fseek() accepts 'long int' as offset argument which is signed and can be
 	//      less than size_t value passed as argument to this function.
@@ -172,6 +364,8 @@ void FSFile::RewindInternal()const{
 	}
 
 	ASSERT(this->handle)
+	std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+	this->WriteOutBuffer();
 	if(fseek(this->handle, 0, SEEK_SET) != 0){
 		throw File::Exc("fseek() failed");
 	}
@@ -232,6 +426,34 @@ void FSFile::MakeDir(){
 
 
 
+//static
+FSFile::Stamp FSFile::GetStamp(const std::string& path)NOEXCEPT{
+	Stamp ret;
+	
+#if M_OS == M_OS_WINDOWS
+	struct _stat64 st;
+	if(_stat64(path.c_str(), &st) != 0){
+		return ret;
+	}
+#else
+	struct stat st;
+	if(stat(path.c_str(), &st) != 0){
+		return ret;
+	}
+#	if M_OS == M_OS_MACOSX
+	ret.mtimeNsec = st.st_mtimespec.tv_nsec;
+#	elif M_OS == M_OS_LINUX
+	ret.mtimeNsec = st.st_mtim.tv_nsec;
+#	endif
+#endif
+	ret.mtimeSec = st.st_mtime;
+	ret.size = std::uint64_t(st.st_size);
+	ret.isValid = true;
+	return ret;
+}
+
+
+
 //static
 std::string FSFile::GetHomeDir(){
 	std::string ret;
@@ -30,7 +30,10 @@ THE SOFTWARE. */
 #pragma once
 
 #include <cstdio>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "../debug.hpp"
 #include "File.hpp"
@@ -50,6 +53,19 @@ namespace fs{
 class FSFile : public File{
 	mutable FILE* handle = nullptr;
 
+	//protects the handle and write buffer, needed because of periodic sync thread
+	mutable std::mutex mutex;
+
+	mutable std::vector<std::uint8_t> writeBuf;
+	mutable size_t writeBufFill = 0;
+
+	class SyncThread;
+	mutable std::unique_ptr<SyncThread> syncThread;
+
+	//NOTE: calls to these functions should be protected by mutex.
+	void WriteOutBuffer()const;
+	void FlushLocked();
+
 protected:
 	void OpenInternal(E_Mode mode)override;
 
@@ -76,17 +92,66 @@ public:
 	 * the root directory and the path returned by Path() method. 
      * @param pathName - initial path to set passed to File constructor.
      */
-	FSFile(const std::string& pathName = std::string()) :
-			File(pathName)
-	{}
+	FSFile(const std::string& pathName = std::string());
 	
 	/**
 	 * @brief Destructor.
 	 * This destructor calls the Close() method.
 	 */
-	virtual ~FSFile()NOEXCEPT{
-		this->Close();
-	}	
+	virtual ~FSFile()NOEXCEPT;
+	
+	/**
+	 * @brief Set size of the write buffer.
+	 * By default, the write buffer is not used and each Write() goes directly to
+	 * the C library stream. If the write buffer is set, then data passed to Write()
+	 * is accumulated in the buffer and written out in one chunk when the buffer is full,
+	 * or when Flush(), Sync() or Close() is called. Writes which are bigger than the buffer
+	 * go directly to the stream.
+	 * If the file is opened, then the buffered data is flushed before resizing the buffer.
+	 * @param size - size of the write buffer in bytes. 0 disables the buffering.
+	 */
+	void SetWriteBufferSize(size_t size);
+	
+	/**
+	 * @brief Get size of the write buffer.
+	 * @return size of the write buffer in bytes, 0 means the buffering is disabled.
+	 */
+	size_t WriteBufferSize()const NOEXCEPT{
+		return this->writeBuf.size();
+	}
+	
+	/**
+	 * @brief Flush written data to the OS.
+	 * Writes out the contents of the write buffer and flushes the C library stream.
+	 * Data is not guaranteed to be on the storage device after this call, use Sync() for that.
+	 * @throw IllegalStateExc - if file is not opened.
+	 */
+	void Flush();
+	
+	/**
+	 * @brief Flush written data to the storage device.
+	 * Does Flush() and then asks the OS to write the file data to the storage device
+	 * (fdatasync() on Linux). Returns when the data is on the device.
+	 * @throw IllegalStateExc - if file is not opened.
+	 */
+	void Sync();
+	
+	/**
+	 * @brief Start periodic synchronization.
+	 * Starts a background thread which calls Sync() with the given interval until the file
+	 * is closed or StopPeriodicSync() is called. This bounds the amount of data which can be
+	 * lost in case of crash to what was written within the interval.
+	 * @param intervalMillis - interval between synchronizations in milliseconds.
+	 * @throw IllegalStateExc - if file is not opened or not opened for writing.
+	 */
+	void StartPeriodicSync(std::uint32_t intervalMillis);
+	
+	/**
+	 * @brief Stop periodic synchronization.
+	 * Stops the thread started by StartPeriodicSync(). It is safe to call this method
+	 * if periodic synchronization is not running.
+	 */
+	void StopPeriodicSync()NOEXCEPT;
 	
 	bool Exists()const override;
 	
@@ -99,6 +164,36 @@ public:
      * @return Absolute path to the user's home directory.
      */
 	static std::string GetHomeDir();
+	
+	/**
+	 * @brief Size and modification time of a file.
+	 * Used to detect changes of a file without reading it.
+	 */
+	struct Stamp{
+		/**
+		 * @brief False if the file does not exist or its attributes could not be obtained.
+		 */
+		bool isValid = false;
+		std::uint64_t size = 0;
+		std::int64_t mtimeSec = 0;
+		std::int64_t mtimeNsec = 0;
+		
+		bool operator==(const Stamp& s)const NOEXCEPT{
+			return this->isValid == s.isValid && this->size == s.size && this->mtimeSec == s.mtimeSec && this->mtimeNsec == s.mtimeNsec;
+		}
+		
+		bool operator!=(const Stamp& s)const NOEXCEPT{
+			return !this->operator==(s);
+		}
+	};
+	
+	/**
+	 * @brief Get size and modification time of a file.
+	 * Costs one stat() call. Modification time has nanosecond resolution on Linux and Mac OS X.
+	 * @param path - path to the file.
+	 * @return stamp of the file, invalid stamp if the file does not exist.
+	 */
+	static Stamp GetStamp(const std::string& path)NOEXCEPT;
 
 
 
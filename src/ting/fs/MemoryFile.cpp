@@ -20,30 +20,66 @@ void MemoryFile::OpenInternal(E_Mode mode){
 
 
 
+std::vector<std::uint8_t>& MemoryFile::WritableData(){
+	//NOTE: shared data is always copied, even if nobody else references it anymore, because
+	//      reference count is not reliable when the data is shared with other threads and
+	//      the data passed in as const may not be modified.
+	if(!this->ownData){
+		ASSERT(this->sharedData)
+		this->ownData = std::make_shared<std::vector<std::uint8_t>>(*this->sharedData);
+		this->sharedData.reset();
+	}
+	return *this->ownData;
+}
+
+
+
+std::vector<std::uint8_t> MemoryFile::ResetData(){
+	if(this->IsOpened()){
+		throw IllegalStateExc("MemoryFile::ResetData(): could not reset data while file is opened");
+	}
+	
+	std::vector<std::uint8_t> ret;
+	if(this->ownData){
+		ret = std::move(*this->ownData);
+		this->ownData->clear();
+	}else{
+		ret = *this->sharedData;
+		this->ownData = std::make_shared<std::vector<std::uint8_t>>();
+		this->sharedData.reset();
+	}
+	return ret;
+}
+
+
+
 size_t MemoryFile::ReadInternal(ting::Buffer<std::uint8_t> buf)const{
-	ASSERT(this->idx <= this->data.size())
-	size_t numBytesRead = std::min(buf.SizeInBytes(), this->data.size() - this->idx);
-	memcpy(buf.begin(), &this->data[idx], numBytesRead);
+	const auto& data = this->Data();
+	ASSERT(this->idx <= data.size())
+	size_t numBytesRead = std::min(buf.SizeInBytes(), data.size() - this->idx);
+	memcpy(buf.begin(), data.data() + this->idx, numBytesRead);
 	this->idx += numBytesRead;
-	ASSERT(this->idx <= this->data.size())
+	ASSERT(this->idx <= data.size())
 	return numBytesRead;
 }
 
 
 
 size_t MemoryFile::WriteInternal(ting::Buffer<const std::uint8_t> buf){
-	ASSERT(this->idx <= this->data.size())
+	auto& data = this->WritableData();
+	
+	ASSERT(this->idx <= data.size())
 	
-	size_t numBytesTillEOF = this->data.size() - this->idx;
+	size_t numBytesTillEOF = data.size() - this->idx;
 	if(numBytesTillEOF < buf.SizeInBytes()){
 		size_t numBytesToGrow = buf.SizeInBytes() - numBytesTillEOF;
-		this->data.resize(this->data.size() + numBytesToGrow);
+		data.resize(data.size() + numBytesToGrow);
 	}
 	
-	size_t numBytesWritten = std::min(buf.SizeInBytes(), this->data.size() - this->idx);
-	memcpy(&this->data[this->idx], buf.begin(), numBytesWritten);
+	size_t numBytesWritten = std::min(buf.SizeInBytes(), data.size() - this->idx);
+	memcpy(data.data() + this->idx, buf.begin(), numBytesWritten);
 	this->idx += numBytesWritten;
-	ASSERT(this->idx <= this->data.size())
+	ASSERT(this->idx <= data.size())
 	return numBytesWritten;
 }
 
@@ -51,10 +87,10 @@ size_t MemoryFile::WriteInternal(ting::Buffer<const std::uint8_t> buf){
 
 //override
 size_t MemoryFile::SeekForwardInternal(size_t numBytesToSeek)const{
-	ASSERT(this->idx <= this->data.size())
-	numBytesToSeek = std::min(this->data.size() - this->idx, numBytesToSeek);
+	ASSERT(this->idx <= this->Size())
+	numBytesToSeek = std::min(this->Size() - this->idx, numBytesToSeek);
 	this->idx += numBytesToSeek;
-	ASSERT(this->idx <= this->data.size())
+	ASSERT(this->idx <= this->Size())
 	return numBytesToSeek;
 }
 
@@ -62,10 +98,10 @@ size_t MemoryFile::SeekForwardInternal(size_t numBytesToSeek)const{
 
 //override
 size_t MemoryFile::SeekBackwardInternal(size_t numBytesToSeek)const{
-	ASSERT(this->idx <= this->data.size())
+	ASSERT(this->idx <= this->Size())
 	numBytesToSeek = std::min(this->idx, numBytesToSeek);
 	this->idx -= numBytesToSeek;
-	ASSERT(this->idx <= this->data.size())
+	ASSERT(this->idx <= this->Size())
 	return numBytesToSeek;
 }
 
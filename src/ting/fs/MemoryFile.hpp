@@ -33,6 +33,7 @@ THE SOFTWARE. */
 #include "../util.hpp"
 
 #include <vector>
+#include <memory>
 
 
 
@@ -42,6 +43,12 @@ namespace fs{
 /**
  * @brief Memory file.
  * Class representing a file stored in memory. Supports reading, writing, seeking backwards and forward, rewinding.
+ * The file data is reference counted and can be shared between several MemoryFile objects,
+ * see Spawn() and SharedData(). Each object has its own read/write position. Shared data is
+ * never modified, it is copied when one of the objects writes to the file (copy-on-write), so
+ * objects which are only read from share one copy of the data.
+ * The MemoryFile object itself is not thread-safe, but different objects sharing the data
+ * can be used from different threads.
  */
 class MemoryFile : public File{
 	
@@ -51,15 +58,53 @@ class MemoryFile : public File{
 	MemoryFile& operator=(MemoryFile&&) = delete;
 	
 private:
-	std::vector<std::uint8_t> data;
+	//Data owned exclusively by this object, it can be modified in place.
+	//If null, then the data is in 'sharedData'.
+	mutable std::shared_ptr<std::vector<std::uint8_t>> ownData;
+	
+	//Data which may be referenced by others, it is never modified.
+	mutable std::shared_ptr<const std::vector<std::uint8_t>> sharedData;
+	
 	mutable size_t idx;
 	
+	const std::vector<std::uint8_t>& Data()const NOEXCEPT{
+		return this->ownData ? *this->ownData : *this->sharedData;
+	}
+	
+	//make sure the data is not shared with other objects before modifying it
+	std::vector<std::uint8_t>& WritableData();
+	
 public:
 	/**
 	 * @brief Constructor.
 	 * Creates empty memory file.
      */
-	MemoryFile(){}
+	MemoryFile() :
+			ownData(std::make_shared<std::vector<std::uint8_t>>())
+	{}
+	
+	/**
+	 * @brief Constructor.
+	 * Creates memory file holding given data.
+	 * @param data - data of the file.
+	 */
+	MemoryFile(std::vector<std::uint8_t>&& data) :
+			ownData(std::make_shared<std::vector<std::uint8_t>>(std::move(data)))
+	{}
+	
+	/**
+	 * @brief Constructor.
+	 * Creates memory file sharing given data. The data will not be modified,
+	 * writing to the file will make a private copy of the data first.
+	 * @param data - data of the file.
+	 */
+	MemoryFile(std::shared_ptr<const std::vector<std::uint8_t>> data) :
+			sharedData(std::move(data))
+	{
+		if(!this->sharedData){
+			throw File::Exc("MemoryFile(): passed in data pointer is null");
+		}
+	}
 	
 	virtual ~MemoryFile()NOEXCEPT{}
 
@@ -67,13 +112,32 @@ public:
 	 * @brief Current file size.
      * @return current size of the file.
      */
-	size_t Size(){
-		return this->data.size();
+	size_t Size()const NOEXCEPT{
+		return this->Data().size();
 	}
 	
+	/**
+	 * @brief Get shared file data.
+	 * Returns reference counted pointer to the file data. The data is not copied.
+	 * Subsequent writes to this file will not affect the returned data,
+	 * the next write will make a private copy of the data.
+	 * @return Pointer to the file data.
+	 */
+	std::shared_ptr<const std::vector<std::uint8_t>> SharedData()const NOEXCEPT{
+		if(this->ownData){
+			this->sharedData = std::move(this->ownData);
+		}
+		return this->sharedData;
+	}
 
+	/**
+	 * @brief Create another MemoryFile sharing the data with this one.
+	 * Spawned file has its own read/write position and open/close state.
+	 * The data is shared until either of the files is written to.
+	 * @return Newly spawned MemoryFile object.
+	 */
 	virtual std::unique_ptr<File> Spawn()override{
-		return std::unique_ptr<File>(new MemoryFile);
+		return std::unique_ptr<File>(new MemoryFile(this->SharedData()));
 	}
 
 	
@@ -82,12 +146,7 @@ public:
 	 * After this operation the file becomes empty.
      * @return Data previously held by this file.
      */
-	decltype(data) ResetData(){
-		if(this->IsOpened()){
-			throw IllegalStateExc("MemoryFile::ResetData(): could not reset data while file is opened");
-		}
-		return std::move(this->data);
-	}
+	std::vector<std::uint8_t> ResetData();
 	
 protected:
 	void OpenInternal(E_Mode mode)override;
@@ -0,0 +1,309 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+#include <sstream>
+#include <cstring>
+#include <chrono>
+
+#include "BatchResolver.hpp"
+
+#if M_OS == M_OS_LINUX
+#	include <sys/eventfd.h>
+#endif
+
+
+
+using namespace ting::net;
+
+
+
+BatchResolver::BatchResolver(
+		std::vector<std::string> hostNames,
+		std::uint32_t timeoutMillis,
+		const ting::net::IPAddress& dnsIP,
+		HostNameResolver::E_Mode mode
+	) :
+		hostNames(std::move(hostNames)),
+		entries(new Entry[this->hostNames.size()]),
+		timeoutMillis(timeoutMillis),
+		dnsIP(dnsIP),
+		mode(mode)
+{
+#if M_OS == M_OS_WINDOWS
+	this->eventForWaitable = CreateEvent(
+			NULL, //security attributes
+			TRUE, //manual-reset
+			FALSE, //not signalled initially
+			NULL //no name
+		);
+	if(this->eventForWaitable == NULL){
+		throw ting::Exc("BatchResolver::BatchResolver(): could not create event (Win32) for implementing Waitable");
+	}
+#elif M_OS == M_OS_MACOSX
+	if(::pipe(&this->pipeEnds[0]) < 0){
+		std::stringstream ss;
+		ss << "BatchResolver::BatchResolver(): could not create pipe (*nix) for implementing Waitable,"
+				<< " error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#elif M_OS == M_OS_LINUX
+	this->eventFD = eventfd(0, EFD_NONBLOCK);
+	if(this->eventFD < 0){
+		std::stringstream ss;
+		ss << "BatchResolver::BatchResolver(): could not create eventfd (linux) for implementing Waitable,"
+				<< " error code = " << errno << ": " << strerror(errno);
+		throw ting::Exc(ss.str().c_str());
+	}
+#else
+#	error "Unsupported OS"
+#endif
+	
+	for(size_t i = 0; i != this->Size(); ++i){
+		this->entries[i].batch = this;
+	}
+	
+	if(this->Size() == 0){
+		this->Signal();
+		return;
+	}
+	
+	this->StartLookups();
+}
+
+
+
+BatchResolver::~BatchResolver()NOEXCEPT{
+	{
+		std::unique_lock<decltype(this->mutex)> lock(this->mutex);
+		
+		//do not start any more lookups
+		this->nextToStart = this->Size();
+		
+		//Wait for the thread which is starting lookups, if any, so that
+		//no lookup is started after it has been canceled below.
+		while(this->isStarting){
+			this->cond.wait(lock);
+		}
+	}
+	
+	//Cancel_ts() also waits for the completion callback if it is being called
+	for(size_t i = 0; i != this->Size(); ++i){
+		this->entries[i].Cancel_ts();
+	}
+	
+#if M_OS == M_OS_WINDOWS
+	CloseHandle(this->eventForWaitable);
+#elif M_OS == M_OS_MACOSX
+	close(this->pipeEnds[0]);
+	close(this->pipeEnds[1]);
+#elif M_OS == M_OS_LINUX
+	close(this->eventFD);
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+void BatchResolver::StartLookups(){
+	std::unique_lock<decltype(this->mutex)> lock(this->mutex);
+	
+	//If some other thread is starting lookups then it will start the ones which can be started now as well.
+	//This also prevents recursion when lookup is completed synchronously from within Resolve_ts().
+	if(this->isStarting){
+		return;
+	}
+	this->isStarting = true;
+	
+	while(this->nextToStart != this->Size() && this->numInProgress != DMaxInProgress){
+		size_t i = this->nextToStart;
+		++this->nextToStart;
+		++this->numInProgress;
+		
+		lock.unlock();
+		
+		bool failed = false;
+		try{
+			this->entries[i].Resolve_ts(this->hostNames[i], this->timeoutMillis, this->dnsIP, this->mode);
+		}catch(...){
+			//e.g. the host name is too long
+			failed = true;
+		}
+		
+		lock.lock();
+		
+		if(failed){
+			this->entries[i].res.result = HostNameResolver::ERROR;
+			this->Complete(this->entries[i]);
+		}
+	}
+	
+	this->isStarting = false;
+	this->cond.notify_all();
+}
+
+
+
+void BatchResolver::Entry::OnCompletedWithRecords_ts(E_Result result, const std::vector<Record>& records)NOEXCEPT{
+	this->batch->OnEntryCompleted(*this, result, records);
+}
+
+
+
+void BatchResolver::OnEntryCompleted(Entry& e, HostNameResolver::E_Result result, const std::vector<HostNameResolver::Record>& records)NOEXCEPT{
+	{
+		std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+		e.res.result = result;
+		try{
+			e.res.records = records;
+		}catch(...){
+			e.res.result = HostNameResolver::ERROR;
+		}
+		this->Complete(e);
+	}
+	
+	try{
+		this->StartLookups();
+	}catch(...){
+		//out of memory, the remaining lookups will be started upon completion of other ones
+		ASSERT(false)
+	}
+}
+
+
+
+void BatchResolver::Complete(Entry& e)NOEXCEPT{
+	ASSERT(!e.isCompleted)
+	ASSERT(this->numInProgress != 0)
+	
+	e.isCompleted = true;
+	--this->numInProgress;
+	++this->numCompleted;
+	
+	if(this->numCompleted == this->Size()){
+		this->Signal();
+		this->cond.notify_all();
+	}
+}
+
+
+
+void BatchResolver::Signal()NOEXCEPT{
+	//NOTE: set CanRead flag before event notification/pipe write, because
+	//if do it after then some other thread which was waiting on the WaitSet
+	//may read the CanRead flag while it was not set yet.
+	//The object stays readable till its destruction, so the event is never reset.
+	this->SetCanReadFlag();
+#if M_OS == M_OS_WINDOWS
+	if(SetEvent(this->eventForWaitable) == 0){
+		ASSERT(false)
+	}
+#elif M_OS == M_OS_MACOSX
+	{
+		std::uint8_t oneByteBuf[1];
+		if(write(this->pipeEnds[1], oneByteBuf, 1) != 1){
+			ASSERT(false)
+		}
+	}
+#elif M_OS == M_OS_LINUX
+	if(eventfd_write(this->eventFD, 1) < 0){
+		ASSERT(false)
+	}
+#else
+#	error "Unsupported OS"
+#endif
+}
+
+
+
+size_t BatchResolver::NumCompleted_ts()const NOEXCEPT{
+	std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+	return this->numCompleted;
+}
+
+
+
+bool BatchResolver::IsCompleted_ts(size_t i)const NOEXCEPT{
+	ASSERT(i < this->Size())
+	std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+	return this->entries[i].isCompleted;
+}
+
+
+
+bool BatchResolver::Wait_ts(std::uint32_t timeoutMillis){
+	std::unique_lock<decltype(this->mutex)> lock(this->mutex);
+	auto isDone = [this](){
+		return this->numCompleted == this->Size();
+	};
+	if(timeoutMillis == std::uint32_t(-1)){
+		this->cond.wait(lock, isDone);
+		return true;
+	}
+	return this->cond.wait_for(lock, std::chrono::milliseconds(timeoutMillis), isDone);
+}
+
+
+
+#if M_OS == M_OS_WINDOWS
+//override
+HANDLE BatchResolver::GetHandle(){
+	return this->eventForWaitable;
+}
+
+
+
+//override
+void BatchResolver::SetWaitingEvents(std::uint32_t flagsToWaitFor){
+	//it is only possible to wait for completion, i.e. READ
+	if(flagsToWaitFor != 0 && flagsToWaitFor != ting::Waitable::READ){
+		ASSERT_INFO(false, "flagsToWaitFor = " << flagsToWaitFor)
+		throw ting::Exc("BatchResolver::SetWaitingEvents(): flagsToWaitFor should be ting::Waitable::READ or 0, other values are not allowed");
+	}
+	this->flagsMask = flagsToWaitFor;
+}
+
+
+
+//override
+bool BatchResolver::CheckSignaled(){
+	return (this->readinessFlags & this->flagsMask) != 0;
+}
+
+#elif M_OS == M_OS_MACOSX
+//override
+int BatchResolver::GetHandle(){
+	//return read end of pipe
+	return this->pipeEnds[0];
+}
+
+#elif M_OS == M_OS_LINUX
+//override
+int BatchResolver::GetHandle(){
+	return this->eventFD;
+}
+
+#else
+#	error "Unsupported OS"
+#endif
@@ -0,0 +1,244 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "../config.hpp"
+#include "../WaitSet.hpp"
+
+#include "HostNameResolver.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+/**
+ * @brief Resolve many host names at once.
+ * The lookups are started upon construction and are pipelined through the DNS lookup thread,
+ * at most 128 lookups of the batch are in progress at a time, the rest are started as the previous ones complete.
+ * The object can be used as a future: it can be waited for with Wait_ts(), or, since it is a Waitable,
+ * it can be added to a WaitSet for waiting for READ, along with other batches or sockets.
+ * The Waitable becomes readable once all the lookups of the batch have completed and stays readable.
+ * Destroying the object cancels the lookups which are still in progress.
+ * Example:
+ * @code
+ * ting::net::BatchResolver batch(names);
+ * batch.Wait_ts();
+ * for(size_t i = 0; i != batch.Size(); ++i){
+ *     if(batch[i].result == ting::net::HostNameResolver::OK){
+ *         Connect(batch[i].records.front().ip);
+ *     }
+ * }
+ * @endcode
+ */
+class BatchResolver : public ting::Waitable{
+public:
+	/**
+	 * @brief Result of one host name lookup.
+	 */
+	struct Result{
+		/**
+		 * @brief Result of the lookup.
+		 * Lookups which could not be started, e.g. because the host name is too long, have the ERROR result.
+		 */
+		HostNameResolver::E_Result result;
+
+		/**
+		 * @brief Resolved IP-addresses, empty if result is not OK.
+		 */
+		std::vector<HostNameResolver::Record> records;
+	};
+
+private:
+	class Entry : public HostNameResolver{
+	public:
+		BatchResolver* batch;
+
+		bool isCompleted = false;
+
+		Result res;
+
+		void OnCompletedWithRecords_ts(E_Result result, const std::vector<Record>& records)NOEXCEPT override;
+	};
+
+	std::vector<std::string> hostNames;
+	std::unique_ptr<Entry[]> entries;
+
+	std::uint32_t timeoutMillis;
+	ting::net::IPAddress dnsIP;
+	HostNameResolver::E_Mode mode;
+
+	mutable std::mutex mutex;
+	std::condition_variable cond;
+
+	//index of the next lookup to start
+	size_t nextToStart = 0;
+
+	size_t numInProgress = 0;
+	size_t numCompleted = 0;
+
+	//whether some thread is starting the lookups, only one thread starts lookups at a time
+	bool isStarting = false;
+
+	static const size_t DMaxInProgress = 128;
+
+	void StartLookups();
+
+	void OnEntryCompleted(Entry& e, HostNameResolver::E_Result result, const std::vector<HostNameResolver::Record>& records)NOEXCEPT;
+
+	//NOTE: call to this function should be protected by mutex.
+	void Complete(Entry& e)NOEXCEPT;
+
+	void Signal()NOEXCEPT;
+
+#if M_OS == M_OS_WINDOWS
+	HANDLE eventForWaitable;
+#elif M_OS == M_OS_MACOSX
+	int pipeEnds[2];
+#elif M_OS == M_OS_LINUX
+	int eventFD;
+#else
+#	error "Unsupported OS"
+#endif
+
+public:
+	/**
+	 * @brief Start resolving IP-addresses of the given hosts.
+	 * @param hostNames - host names to resolve.
+	 * @param timeoutMillis - timeout of each lookup in milliseconds, see HostNameResolver::Resolve_ts().
+	 * @param dnsIP - IP-address of the DNS to use, see HostNameResolver::Resolve_ts().
+	 * @param mode - address families to resolve.
+	 */
+	BatchResolver(
+			std::vector<std::string> hostNames,
+			std::uint32_t timeoutMillis = 20000,
+			const ting::net::IPAddress& dnsIP = ting::net::IPAddress(ting::net::IPAddress::Host(0), 0),
+			HostNameResolver::E_Mode mode = HostNameResolver::IPV6_OR_IPV4
+		);
+
+	BatchResolver(const BatchResolver&) = delete;
+	BatchResolver& operator=(const BatchResolver&) = delete;
+
+	/**
+	 * @brief Destructor.
+	 * Cancels the lookups which are still in progress.
+	 */
+	~BatchResolver()NOEXCEPT;
+
+	/**
+	 * @brief Get number of host names in the batch.
+	 * @return number of host names.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->hostNames.size();
+	}
+
+	/**
+	 * @brief Get host name.
+	 * @param i - index of the host name.
+	 * @return host name.
+	 */
+	const std::string& HostName(size_t i)const NOEXCEPT{
+		ASSERT(i < this->hostNames.size())
+		return this->hostNames[i];
+	}
+
+	/**
+	 * @brief Get number of completed lookups.
+	 * The method is thread-safe.
+	 * @return number of completed lookups.
+	 */
+	size_t NumCompleted_ts()const NOEXCEPT;
+
+	/**
+	 * @brief Check if the lookup has completed.
+	 * The method is thread-safe.
+	 * @param i - index of the host name.
+	 * @return true if the result of the lookup is available.
+	 */
+	bool IsCompleted_ts(size_t i)const NOEXCEPT;
+
+	/**
+	 * @brief Wait for all lookups to complete.
+	 * The method is thread-safe.
+	 * @param timeoutMillis - maximal time to wait in milliseconds.
+	 * @return true if all lookups have completed.
+	 * @return false if timeout was hit.
+	 */
+	bool Wait_ts(std::uint32_t timeoutMillis = std::uint32_t(-1));
+
+	/**
+	 * @brief Get result of the lookup.
+	 * The lookup must have completed, see IsCompleted_ts() and Wait_ts().
+	 * @param i - index of the host name.
+	 * @return result of the lookup.
+	 */
+	const Result& operator[](size_t i)const NOEXCEPT{
+		ASSERT(i < this->Size())
+		ASSERT(this->IsCompleted_ts(i))
+		return this->entries[i].res;
+	}
+
+private:
+#if M_OS == M_OS_WINDOWS
+	HANDLE GetHandle()override;
+
+	std::uint32_t flagsMask;//flags to wait for
+
+	void SetWaitingEvents(std::uint32_t flagsToWaitFor)override;
+
+	//returns true if signaled
+	bool CheckSignaled()override;
+
+#elif M_OS == M_OS_LINUX
+	int GetHandle()override;
+
+#elif M_OS == M_OS_MACOSX
+	int GetHandle()override;
+
+#else
+#	error "Unsupported OS"
+#endif
+};
+
+
+
+}//~namespace
+}//~namespace
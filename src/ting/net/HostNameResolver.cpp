@@ -24,21 +24,28 @@ THE SOFTWARE. */
 
 
 
-#include <map>
-#include <list>
+#include <deque>
+#include <random>
+#include <atomic>
+#include <unordered_map>
+#include <cstdlib>
+#include <cctype>
+#include <memory>
+#include <algorithm>
+#include <chrono>
 
 #include "HostNameResolver.hpp"
 
 #include "../config.hpp"
+#include "../BufferStream.hpp"
+#include "../BitSet.hpp"
 #include "../mt/MsgThread.hpp"
-#include "../PoolStored.hpp"
 #include "../timer.hpp"
 
-#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
-#	include "../fs/FSFile.hpp"
-#endif
+#include "../fs/FSFile.hpp"
 
 #include "UDPSocket.hpp"
+#include "TCPSocket.hpp"
 #include "Lib.hpp"
 
 
@@ -53,27 +60,60 @@ namespace{
 
 const std::uint16_t D_DNSRecordA = 1;
 const std::uint16_t D_DNSRecordAAAA = 28;
+const std::uint16_t D_DNSRecordSOA = 6;
+const std::uint16_t D_DNSRecordCNAME = 5;
+const std::uint16_t D_DNSRecordOPT = 41;
 
 
 namespace dns{
 
-//forward declaration
+//forward declarations
 struct Resolver;
+struct Query;
 
 
 
+//Parse domain name which may contain compression pointers, see RFC 1035 section 4.1.4.
+//'begin' is the beginning of the packet, pointers are offsets from it.
 //After the successful completion the 'p' points to the byte right after the host name.
-//In case of unsuccessful completion 'p' is undefined.
-std::string ParseHostNameFromDNSPacket(const std::uint8_t* & p, const std::uint8_t* end){
+//In case of unsuccessful completion empty string is returned and 'p' is undefined.
+std::string ParseHostNameFromDNSPacket(const std::uint8_t* & p, const std::uint8_t* begin, const std::uint8_t* end){
 	std::string host;
-			
+	
+	const std::uint8_t* cur = p;
+	bool jumped = false;
+	
 	for(;;){
-		if(p == end){
+		if(cur == end){
 			return "";
 		}
 
-		std::uint8_t len = *p;
-		++p;
+		std::uint8_t len = *cur;
+		
+		if((len >> 6) == 3){//two high bits set means pointer
+			if(end - cur < 2){
+				return "";
+			}
+			const std::uint8_t* target = begin + (ting::util::Deserialize16BE(cur) & 0x3fff);
+			
+			if(!jumped){
+				p = cur + 2;//name ends with the first pointer
+				jumped = true;
+			}
+			
+			//only pointers to prior occurrences are allowed, this also prevents loops
+			if(target >= cur){
+				return "";
+			}
+			cur = target;
+			continue;
+		}
+		
+		if(len > 63){//reserved label types
+			return "";
+		}
+		
+		++cur;
 
 		if(len == 0){
 			break;
@@ -83,54 +123,1079 @@ std::string ParseHostNameFromDNSPacket(const std::uint8_t* & p, const std::uint8
 			host += '.';
 		}
 
-		if(end - p < len){
+		if(end - cur < len){
 			return "";
 		}
 
-		host += std::string(reinterpret_cast<const char*>(p), size_t(len));
-		p += len;
-		ASSERT(p <= end - 1 || p == end)
+		host.append(reinterpret_cast<const char*>(cur), size_t(len));
+		cur += len;
 	}
 //			TRACE(<< "host = " << host << std::endl)
 	
+	if(!jumped){
+		p = cur;
+	}
 	return host;
 }
 
 
 
+//Domain names are case insensitive, see RFC 4343.
+bool EqualDomainNames(const std::string& a, const std::string& b)NOEXCEPT{
+	if(a.size() != b.size()){
+		return false;
+	}
+	for(size_t i = 0; i != a.size(); ++i){
+		if(std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))){
+			return false;
+		}
+	}
+	return true;
+}
+
+
+
+//Skips the domain name, which may end with compression pointer.
+//Returns false if the packet ends unexpectedly.
+bool SkipHostNameInDNSPacket(const std::uint8_t* & p, const std::uint8_t* end){
+	for(;;){
+		if(p == end){
+			return false;
+		}
+		
+		std::uint8_t len = *p;
+		
+		if((len >> 6) == 3){//two high bits set means pointer, it terminates the name
+			if(end - p < 2){
+				return false;
+			}
+			p += 2;
+			return true;
+		}
+		
+		++p;
+		
+		if(len == 0){
+			return true;
+		}
+		
+		if(end - p < len){
+			return false;
+		}
+		p += len;
+	}
+}
+
+
+
+//Process-wide cache of DNS lookup results.
+class Cache{
+public:
+	struct Value{
+		HostNameResolver::E_Result result;//OK or NO_SUCH_HOST
+		std::vector<HostNameResolver::Record> records;
+	};
+	
+private:
+	struct Key{
+		std::string hostName;
+		std::uint16_t recordType;
+		
+		bool operator==(const Key& k)const NOEXCEPT{
+			return this->recordType == k.recordType && this->hostName == k.hostName;
+		}
+	};
+	
+	struct KeyHash{
+		size_t operator()(const Key& k)const NOEXCEPT{
+			return std::hash<std::string>()(k.hostName) ^ k.recordType;
+		}
+	};
+	
+	struct Entry{
+		Value value;
+		std::uint64_t expiryMillis;
+	};
+	
+	//when number of entries reaches this value the expired entries are removed
+	static const size_t DMaxEntries = 0x10000;
+	
+	std::mutex mutex;
+	
+	std::unordered_map<Key, Entry, KeyHash> map;
+	
+	std::uint32_t minTTL = 0;
+	std::uint32_t maxTTL = 86400;
+	
+	HostNameResolver::CacheStats stats = {0, 0, 0};
+	
+	//added to the clock time, see HostNameResolver::AdvanceCacheClock_ts()
+	std::uint64_t clockOffset = 0;
+	
+	//Monotonic time in milliseconds. Unlike ting::timer::GetTicks() it does not warp around,
+	//so entries stay expired no matter how long ago they have expired.
+	std::uint64_t Now()const NOEXCEPT{
+		return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count())
+				+ this->clockOffset;
+	}
+	
+	static bool IsExpired(const Entry& e, std::uint64_t now)NOEXCEPT{
+		return e.expiryMillis <= now;
+	}
+	
+	void RemoveExpired(std::uint64_t now){
+		for(auto i = this->map.begin(); i != this->map.end();){
+			if(IsExpired(i->second, now)){
+				i = this->map.erase(i);
+			}else{
+				++i;
+			}
+		}
+	}
+	
+public:
+	static const std::uint32_t DMaxTTL = 2000000;
+	
+	static Cache& Inst(){
+		static Cache instance;
+		return instance;
+	}
+	
+	//returns true if the value is found, TTLs of the returned records are reduced to the remaining time to live
+	bool Get(const std::string& hostName, std::uint16_t recordType, Value& out){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		
+		Key key = {hostName, recordType};
+		auto i = this->map.find(key);
+		if(i == this->map.end()){
+			++this->stats.misses;
+			return false;
+		}
+		
+		std::uint64_t now = this->Now();
+		
+		if(IsExpired(i->second, now)){
+			this->map.erase(i);
+			++this->stats.misses;
+			return false;
+		}
+		
+		++this->stats.hits;
+		out = i->second.value;
+		
+		std::uint32_t remainingTTL = std::uint32_t((i->second.expiryMillis - now + 999) / 1000);
+		for(auto& r : out.records){
+			ting::util::ClampTop(r.ttl, remainingTTL);
+		}
+		return true;
+	}
+	
+	void Put(const std::string& hostName, std::uint16_t recordType, const Value& value, std::uint32_t ttl){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		
+		ting::util::ClampBottom(ttl, this->minTTL);
+		ting::util::ClampTop(ttl, this->maxTTL);
+		if(ttl == 0){
+			return;
+		}
+		
+		std::uint64_t now = this->Now();
+		
+		if(this->map.size() >= DMaxEntries){
+			this->RemoveExpired(now);
+			if(this->map.size() >= DMaxEntries){
+				return;
+			}
+		}
+		
+		Key key = {hostName, recordType};
+		Entry& e = this->map[std::move(key)];
+		e.value = value;
+		e.expiryMillis = now + std::uint64_t(ttl) * 1000;
+	}
+	
+	void SetTTLLimits(std::uint32_t minSeconds, std::uint32_t maxSeconds){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		ting::util::ClampTop(minSeconds, DMaxTTL);
+		ting::util::ClampTop(maxSeconds, DMaxTTL);
+		this->minTTL = minSeconds;
+		this->maxTTL = maxSeconds;
+	}
+	
+	void Clear(){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		this->map.clear();
+	}
+	
+	void AdvanceClock(std::uint64_t millis){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		this->clockOffset += millis;
+	}
+	
+	HostNameResolver::CacheStats Stats(){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		HostNameResolver::CacheStats ret = this->stats;
+		ret.numEntries = this->map.size();
+		return ret;
+	}
+};
+
+
+
+//Look up the result in cache. If 'fallbackToA' is true and AAAA record is cached as not existing then the lookup
+//continues with A record.
+//Returns true if the result was found in cache, otherwise 'recordType' is set to the type of the record to request from DNS.
+bool FindInCache(const std::string& hostName, std::uint16_t& recordType, bool fallbackToA, Cache::Value& out){
+	for(;;){
+		if(!Cache::Inst().Get(hostName, recordType, out)){
+			return false;
+		}
+		if(fallbackToA && out.result == HostNameResolver::NO_SUCH_HOST && recordType == D_DNSRecordAAAA){
+			recordType = D_DNSRecordA;
+			continue;
+		}
+		return true;
+	}
+}
+
+
+
+//Caching is done on best effort basis, so errors are ignored.
+void AddToCache(const std::string& hostName, std::uint16_t recordType, HostNameResolver::E_Result result, const std::vector<HostNameResolver::Record>& records, std::uint32_t ttl)NOEXCEPT{
+	if(result != HostNameResolver::OK && result != HostNameResolver::NO_SUCH_HOST){
+		return;
+	}
+	try{
+		Cache::Value value = {result, records};
+		Cache::Inst().Put(hostName, recordType, value, ttl);
+	}catch(...){}
+}
+
+
+
+std::string ToLower(const std::string& str){
+	std::string ret(str);
+	for(auto& c : ret){
+		c = char(std::tolower(static_cast<unsigned char>(c)));
+	}
+	return ret;
+}
+
+
+
+//Detects changes of the file by its size and modification time.
+//The file is checked not more often than once per DCheckIntervalMillis, so that lookups do not stat() the file each time.
+class FileWatch{
+	std::string path;
+	
+	ting::fs::FSFile::Stamp stamp;
+	
+	bool isChecked = false;
+	std::uint32_t lastCheckTicks;
+	
+public:
+	static const std::uint32_t DCheckIntervalMillis = 1000;
+	
+	FileWatch(const std::string& path) :
+			path(path)
+	{}
+	
+	const std::string& Path()const NOEXCEPT{
+		return this->path;
+	}
+	
+	void SetPath(const std::string& path){
+		this->path = path;
+		this->stamp = ting::fs::FSFile::Stamp();
+		this->isChecked = false;
+	}
+	
+	//Returns true if the file was created, modified or deleted since the previous check.
+	bool IsChanged(){
+		std::uint32_t curTicks = ting::timer::GetTicks();
+		if(this->isChecked && std::uint32_t(curTicks - this->lastCheckTicks) < DCheckIntervalMillis){
+			return false;
+		}
+		this->isChecked = true;
+		this->lastCheckTicks = curTicks;
+		
+		auto s = ting::fs::FSFile::GetStamp(this->path);
+		if(s == this->stamp){
+			return false;
+		}
+		this->stamp = s;
+		return true;
+	}
+};
+
+
+
+//In-memory index of the hosts file, see hosts(5). The index is rebuilt when the file changes.
+class HostsFile{
+	struct Entry{
+		std::vector<ting::net::IPAddress::Host> ipv6;
+		std::vector<ting::net::IPAddress::Host> ipv4;
+	};
+	
+	std::mutex mutex;
+	
+	FileWatch file;
+	
+	//lower case host name to addresses, in the order they appear in the file
+	std::unordered_map<std::string, Entry> map;
+	
+	//maximal size of the hosts file to load
+	static const size_t DMaxFileSize = 0x1000000;//16mb
+	
+	static std::string DefaultPath(){
+#if M_OS == M_OS_WINDOWS
+		const char* root = std::getenv("SystemRoot");
+		return std::string(root ? root : "C:\\Windows") + "\\System32\\drivers\\etc\\hosts";
+#else
+		return "/etc/hosts";
+#endif
+	}
+	
+	void Load(){
+		this->map.clear();
+		
+		ting::fs::FSFile f(this->file.Path());
+		std::vector<std::uint8_t> buf = f.LoadWholeFileIntoMemory(DMaxFileSize);
+		std::string content(reinterpret_cast<const char*>(buf.data()), buf.size());
+		
+		for(size_t lineStart = 0; lineStart < content.size();){
+			size_t lineEnd = content.find('\n', lineStart);
+			if(lineEnd == std::string::npos){
+				lineEnd = content.size();
+			}
+			
+			std::string line = content.substr(lineStart, lineEnd - lineStart);
+			lineStart = lineEnd + 1;
+			
+			size_t commentStart = line.find('#');
+			if(commentStart != std::string::npos){
+				line.resize(commentStart);
+			}
+			
+			const char* whitespace = " \t\r";
+			
+			size_t ipStart = line.find_first_not_of(whitespace);
+			if(ipStart == std::string::npos){
+				continue;
+			}
+			size_t ipEnd = line.find_first_of(whitespace, ipStart);
+			if(ipEnd == std::string::npos){
+				continue;//no host names
+			}
+			
+			ting::net::IPAddress::Host ip;
+			if(!ting::net::IPAddress::Host::TryParse(ting::Buffer<const char>(line.data() + ipStart, ipEnd - ipStart), ip)){
+				continue;
+			}
+			
+			for(size_t nameStart = line.find_first_not_of(whitespace, ipEnd); nameStart != std::string::npos;){
+				size_t nameEnd = line.find_first_of(whitespace, nameStart);
+				if(nameEnd == std::string::npos){
+					nameEnd = line.size();
+				}
+				
+				Entry& e = this->map[ToLower(line.substr(nameStart, nameEnd - nameStart))];
+				(ip.IsIPv4() ? e.ipv4 : e.ipv6).push_back(ip);
+				
+				nameStart = line.find_first_not_of(whitespace, nameEnd);
+			}
+		}
+	}
+	
+public:
+	HostsFile() :
+			file(DefaultPath())
+	{}
+	
+	static HostsFile& Inst(){
+		static HostsFile instance;
+		return instance;
+	}
+	
+	void SetPath(const std::string& path){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		this->file.SetPath(path.size() == 0 ? DefaultPath() : path);
+		this->map.clear();
+	}
+	
+	//Same as FindInCache(). Records of the hosts file have zero TTL.
+	//If the host name is in the file, but there are no addresses of requested family, then the result is NO_SUCH_HOST.
+	bool Find(const std::string& hostName, std::uint16_t& recordType, bool fallbackToA, Cache::Value& out){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		
+		if(this->file.IsChanged()){
+			try{
+				this->Load();
+			}catch(...){
+				this->map.clear();//file is deleted or could not be read
+			}
+		}
+		
+		if(this->map.size() == 0){
+			return false;
+		}
+		
+		auto i = this->map.find(ToLower(hostName));
+		if(i == this->map.end()){
+			return false;
+		}
+		
+		const std::vector<ting::net::IPAddress::Host>* addresses = recordType == D_DNSRecordAAAA ? &i->second.ipv6 : &i->second.ipv4;
+		if(addresses->size() == 0 && fallbackToA && recordType == D_DNSRecordAAAA){
+			recordType = D_DNSRecordA;
+			addresses = &i->second.ipv4;
+		}
+		
+		out.result = addresses->size() == 0 ? HostNameResolver::NO_SUCH_HOST : HostNameResolver::OK;
+		out.records.clear();
+		for(auto& a : *addresses){
+			HostNameResolver::Record r = {a, 0};
+			out.records.push_back(r);
+		}
+		return true;
+	}
+};
+
+
+
+std::atomic<bool> synchronousCacheHits(false);
+
+
+
+//Maximum number of name servers to use, same as MAXNS of resolv.conf.
+const unsigned DMaxNameServers = 3;
+
+
+
+//Maximum number of search domains, same as MAXDNSRCH of resolv.conf.
+const unsigned DMaxSearchDomains = 6;
+
+
+
+//Domains to append to host names which are not fully qualified, see resolv.conf(5).
+struct SearchList{
+	std::vector<std::string> domains;
+	
+	//names with at least this number of dots are tried as is first, before appending search domains
+	unsigned ndots = 1;
+	
+	void AddDomain(const std::string& domain){
+		if(this->domains.size() == DMaxSearchDomains){
+			return;
+		}
+		std::string d = domain;
+		if(d.size() != 0 && d[d.size() - 1] == '.'){
+			d.resize(d.size() - 1);
+		}
+		if(d.size() == 0 || d.size() > 253){
+			return;
+		}
+		this->domains.push_back(std::move(d));
+	}
+};
+
+
+
+//Configuration of name servers.
+struct Config{
+	std::vector<ting::net::IPAddress> nameServers;
+	
+	//time to wait for reply from one name server before trying next one, in milliseconds
+	std::uint32_t attemptTimeout = 5000;
+	
+	//number of rounds of sending request to all name servers
+	unsigned attempts = 2;
+	
+	//whether to distribute requests among name servers in round-robin manner
+	bool rotate = false;
+	
+	SearchList searchList;
+	
+	void AddNameServer(const std::string& ip){
+		if(this->nameServers.size() == DMaxNameServers){
+			return;
+		}
+		TRACE(<< "name server ip = " << ip << std::endl)
+		try{
+			this->nameServers.push_back(ting::net::IPAddress(ip.c_str(), 53));
+		}catch(...){}
+	}
+};
+
+
+
+//this mutex is used to protect the userConfig, userSearchList and systemSearchList
+std::mutex configMutex;
+
+//configuration set by HostNameResolver::SetNameServers_ts(), null if configuration from OS is used
+std::unique_ptr<Config> userConfig;
+
+//search list set by HostNameResolver::SetSearchDomains_ts(), null if search list from OS is used
+std::shared_ptr<const SearchList> userSearchList;
+
+//search list from OS configuration, null if there is none
+std::shared_ptr<const SearchList> systemSearchList;
+
+//incremented each time the userConfig is changed, lookup thread reloads configuration when it sees the change
+std::atomic<unsigned> configVersion(0);
+
+
+
+Config ReadSystemConfig(){
+	Config ret;
+	try{
+#if M_OS == M_OS_WINDOWS
+		struct WinRegKey{
+			HKEY	key;
+
+			WinRegKey(){
+				if(RegOpenKey(
+						HKEY_LOCAL_MACHINE,
+						"SYSTEM\\ControlSet001\\Services\\Tcpip\\Parameters\\Interfaces",
+						&this->key
+					) != ERROR_SUCCESS)
+				{
+					throw ting::Exc("ReadSystemConfig(): RegOpenKey() failed");
+				}
+			}
+
+			~WinRegKey(){
+				RegCloseKey(this->key);
+			}
+		} key;
+
+		std::array<char, 256> subkey;//according to MSDN docs maximum key name length is 255 chars.
+
+		for(unsigned i = 0; RegEnumKey(key.key, i, &*subkey.begin(), subkey.size()) == ERROR_SUCCESS; ++i){
+			HKEY hSub;
+			if(RegOpenKey(key.key, &*subkey.begin(), &hSub) != ERROR_SUCCESS){
+				continue;
+			}
+
+			//values are lists of IP-addresses separated by spaces or commas
+			for(const char* name : {"NameServer", "DhcpNameServer"}){
+				std::array<BYTE, 1024> value;
+
+				DWORD len = value.size() - 1;
+
+				if(RegQueryValueEx(hSub, name, 0, NULL, &*value.begin(), &len) != ERROR_SUCCESS){
+					TRACE(<< name << " reading failed " << std::endl)
+					continue;
+				}
+				value[len] = 0;
+
+				std::string str(reinterpret_cast<char*>(&*value.begin()));
+				for(size_t start = 0; start < str.size();){
+					size_t end = str.find_first_of(" ,", start);
+					if(end == std::string::npos){
+						end = str.size();
+					}
+					if(end != start){
+						ret.AddNameServer(str.substr(start, end - start));
+					}
+					start = end + 1;
+				}
+			}
+			RegCloseKey(hSub);
+		}
+
+#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+		ting::fs::FSFile f("/etc/resolv.conf");
+
+		std::vector<std::uint8_t> buf = f.LoadWholeFileIntoMemory(0xfff);//4kb max
+		
+		std::string content(reinterpret_cast<const char*>(buf.data()), buf.size());
+
+		for(size_t lineStart = 0; lineStart < content.size();){
+			size_t lineEnd = content.find('\n', lineStart);
+			if(lineEnd == std::string::npos){
+				lineEnd = content.size();
+			}
+			
+			std::string line = content.substr(lineStart, lineEnd - lineStart);
+			lineStart = lineEnd + 1;
+			
+			const std::string ns("nameserver ");
+			const std::string options("options ");
+			const std::string search("search ");
+			const std::string domain("domain ");
+			
+			if(line.compare(0, ns.size(), ns) == 0){
+				size_t ipStart = line.find_first_not_of(" \t", ns.size());
+				if(ipStart == std::string::npos){
+					continue;
+				}
+				
+				size_t ipEnd = line.find_first_not_of(":.0123456789abcdefABCDEF", ipStart);//IPv6 address may contain ':' and hex digits
+				
+				ret.AddNameServer(line.substr(ipStart, ipEnd - ipStart));
+			}else if(line.compare(0, options.size(), options) == 0){
+				for(size_t optStart = options.size(); optStart < line.size();){
+					size_t optEnd = line.find_first_of(" \t", optStart);
+					if(optEnd == std::string::npos){
+						optEnd = line.size();
+					}
+					std::string opt = line.substr(optStart, optEnd - optStart);
+					optStart = optEnd + 1;
+					
+					//limits are the same as in resolv.conf(5)
+					if(opt == "rotate"){
+						ret.rotate = true;
+					}else if(opt.compare(0, 8, "timeout:") == 0){
+						ret.attemptTimeout = std::min(unsigned(std::strtoul(opt.c_str() + 8, nullptr, 10)), 30u) * 1000;
+						ting::util::ClampBottom(ret.attemptTimeout, std::uint32_t(1000));
+					}else if(opt.compare(0, 9, "attempts:") == 0){
+						ret.attempts = std::min(unsigned(std::strtoul(opt.c_str() + 9, nullptr, 10)), 5u);
+						ting::util::ClampBottom(ret.attempts, 1u);
+					}else if(opt.compare(0, 6, "ndots:") == 0){
+						ret.searchList.ndots = std::min(unsigned(std::strtoul(opt.c_str() + 6, nullptr, 10)), 15u);
+					}
+				}
+			}else if(line.compare(0, search.size(), search) == 0 || line.compare(0, domain.size(), domain) == 0){
+				//the last of 'search' and 'domain' lines takes effect
+				ret.searchList.domains.clear();
+				
+				const char* whitespace = " \t\r";
+				for(size_t start = line.find_first_not_of(whitespace, line.find(' ')); start != std::string::npos;){
+					size_t end = line.find_first_of(whitespace, start);
+					if(end == std::string::npos){
+						end = line.size();
+					}
+					ret.searchList.AddDomain(line.substr(start, end - start));
+					start = line.find_first_not_of(whitespace, end);
+				}
+			}
+		}
+#else
+		TRACE(<< "ReadSystemConfig(): don't know how to get DNS IP on this OS" << std::endl)
+#endif
+	}catch(...){
+	}
+	return ret;
+}
+
+
+
+//Get search list for the new lookup, null if there is no search list.
+//Search list from OS configuration is re-read when resolv.conf changes.
+std::shared_ptr<const SearchList> GetSearchList(){
+	std::lock_guard<decltype(configMutex)> lock(configMutex);
+	
+	if(userSearchList){
+		return userSearchList;
+	}
+	
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
+	static FileWatch resolvConf("/etc/resolv.conf");
+	if(resolvConf.IsChanged()){
+		SearchList l = ReadSystemConfig().searchList;
+		if(l.domains.size() == 0){
+			systemSearchList.reset();
+		}else{
+			systemSearchList = std::make_shared<const SearchList>(std::move(l));
+		}
+	}
+#endif
+	
+	return systemSearchList;
+}
+
+
+
 //this mutex is used to protect the dns::thread access.
 std::mutex mutex;
 
-typedef std::multimap<std::uint32_t, Resolver*> T_ResolversTimeMap;
-typedef T_ResolversTimeMap::iterator T_ResolversTimeIter;
+//Node of intrusive circular doubly linked list. Not linked node points to itself.
+//List head is a node which is not a part of any object.
+struct ListNode{
+	ListNode* prev;
+	ListNode* next;
+	
+	ListNode()NOEXCEPT :
+			prev(this),
+			next(this)
+	{}
+	
+	ListNode(const ListNode&) = delete;
+	ListNode& operator=(const ListNode&) = delete;
+	
+	//for list head it means that the list is not empty
+	bool IsLinked()const NOEXCEPT{
+		return this->next != this;
+	}
+	
+	void Unlink()NOEXCEPT{
+		this->prev->next = this->next;
+		this->next->prev = this->prev;
+		this->prev = this;
+		this->next = this;
+	}
+	
+	//insert this node before the given one, to add the node to the end of the list pass the list head
+	void LinkBefore(ListNode* n)NOEXCEPT{
+		ASSERT(!this->IsLinked())
+		this->next = n;
+		this->prev = n->prev;
+		n->prev->next = this;
+		n->prev = this;
+	}
+};
 
-typedef std::map<std::uint16_t, Resolver*> T_IdMap;
-typedef T_IdMap::iterator T_IdIter;
 
-typedef std::list<Resolver*> T_RequestsToSendList;
-typedef T_RequestsToSendList::iterator T_RequestsToSendIter;
 
-typedef std::map<HostNameResolver*, std::unique_ptr<Resolver> > T_ResolversMap;
-typedef T_ResolversMap::iterator T_ResolversIter;
+//Timer of the resolver timeout or of the query next attempt.
+struct Timer : public ListNode{
+	std::uint64_t deadline;
+	
+	Resolver* r;
+	Query* q;//nullptr for resolver timeout
+};
 
 
 
-struct Resolver : public ting::PoolStored<Resolver, 10>{
-	HostNameResolver* hnr;
+//Hashed timer wheel. Timers are put to buckets by deadline, timers due after more than one revolution
+//of the wheel stay in their bucket until their time comes. Timers fire not later than DBucketMillis after deadline.
+//Time is in 64 bit ticks, so there is no warp around.
+class TimerWheel{
+public:
+	static const unsigned DBucketMillis = 8;
+	static const unsigned DNumBuckets = 512;
 	
-	std::string hostName; //host name to resolve
+private:
+	std::array<ListNode, DNumBuckets> buckets;
 	
-	std::uint16_t recordType; //type of DNS record to get
+	//set bits correspond to buckets which may have timers
+	ting::BitSet nonEmpty;
 	
-	T_ResolversTimeMap* timeMap;
-	T_ResolversTimeIter timeMapIter;
+	//timers which are due
+	ListNode expired;
+	
+	//index of the current time slot, previous time slots are processed
+	std::uint64_t curSlot;
+	
+public:
+	TimerWheel(std::uint64_t curTicks) :
+			nonEmpty(DNumBuckets),
+			curSlot(curTicks / DBucketMillis)
+	{}
+	
+	void Add(Timer* t, std::uint64_t deadline)NOEXCEPT{
+		t->deadline = deadline;
+		unsigned b = unsigned(std::max(deadline / DBucketMillis, this->curSlot) % DNumBuckets);
+		t->LinkBefore(&this->buckets[b]);
+		this->nonEmpty.Set(b);
+	}
+	
+	static void Remove(Timer* t)NOEXCEPT{
+		if(t->IsLinked()){
+			t->Unlink();
+		}
+	}
+	
+	//Move timers which are due to expired list.
+	void Advance(std::uint64_t curTicks)NOEXCEPT{
+		std::uint64_t slot = curTicks / DBucketMillis;
+		std::uint64_t lastSlot = std::min(slot, this->curSlot + DNumBuckets - 1);//no need to visit buckets more than once
+		for(std::uint64_t s = this->curSlot; s <= lastSlot; ++s){
+			unsigned b = unsigned(s % DNumBuckets);
+			if(!this->nonEmpty.Get(b)){
+				continue;
+			}
+			ListNode& head = this->buckets[b];
+			for(ListNode* n = head.next; n != &head;){
+				Timer* t = static_cast<Timer*>(n);
+				n = n->next;
+				if(t->deadline <= curTicks){
+					t->Unlink();
+					t->LinkBefore(&this->expired);
+				}
+			}
+			if(!head.IsLinked()){
+				this->nonEmpty.Clear(b);
+			}
+		}
+		this->curSlot = slot;
+	}
+	
+	//returns nullptr if there are no expired timers
+	Timer* PopExpired()NOEXCEPT{
+		if(!this->expired.IsLinked()){
+			return nullptr;
+		}
+		Timer* t = static_cast<Timer*>(this->expired.next);
+		t->Unlink();
+		return t;
+	}
+	
+	//Get ticks when the wheel needs to be advanced next time.
+	//Returns std::uint64_t(-1) if there are no timers.
+	std::uint64_t NextAdvanceTicks()const NOEXCEPT{
+		unsigned cur = unsigned(this->curSlot % DNumBuckets);
+		size_t b = this->nonEmpty.FindNextSet(cur);
+		if(b == DNumBuckets){
+			b = this->nonEmpty.FindNextSet(0);
+			if(b == DNumBuckets){
+				return std::uint64_t(-1);
+			}
+		}
+		std::uint64_t slot = this->curSlot + (b + DNumBuckets - cur) % DNumBuckets;
+		return (slot + 1) * DBucketMillis;//end of the time slot
+	}
+};
+
+
+
+//DNS query for one record type. Resolver can have several queries in progress.
+//Query is a node of the list of queries to send.
+struct TCPConnection;
+
+
+
+struct Query : public ListNode{
+	Resolver* r;
+	
+	std::uint16_t recordType; //type of DNS record to get
 	
 	std::uint16_t id;
-	T_IdIter idIter;
+	bool hasId = false;//whether the query is in id table
+	
+	//whether to look up the cache before sending the request
+	bool checkCache;
+	
+	//number of times the current query was sent
+	unsigned numSent;
+	
+	//bit mask of configured name servers which were sent the query in current round
+	unsigned triedServers;
+	
+	//index of configured name server to which the query was last sent, DMaxNameServers if user given server
+	unsigned lastServer;
+	
+	//ticks when the query was last sent to each of configured name servers, 0 if it was not sent
+	std::array<std::uint64_t, DMaxNameServers> sentTicks;
+	
+	//time to send the next attempt
+	Timer attemptTimer;
+	
+	//whether the name server has replied that it does not support EDNS, then the query is sent without OPT record
+	bool noEDNS;
+	
+	//connection over which the query is repeated if the UDP reply was truncated
+	TCPConnection* tcp = nullptr;
+	
+	//whether the final result of the query is known
+	bool isDone;
+	HostNameResolver::E_Result result;
+	std::vector<HostNameResolver::Record> records;
+	
+	//start new query, e.g. for different record type
+	void ResetAttempts()NOEXCEPT{
+		this->numSent = 0;
+		this->triedServers = 0;
+		this->lastServer = DMaxNameServers;
+		this->sentTicks.fill(0);
+	}
+};
+
+
+
+//Resolver objects are stored in the table of the lookup thread and reused.
+struct Resolver{
+	//index in the resolvers table
+	std::uint32_t slot;
+	
+	//whether lookup is in progress
+	bool isActive = false;
+	
+	HostNameResolver* hnr;
+	
+	std::string name; //host name as given by user, without trailing dot
+	bool isAbsolute; //whether the name was given with trailing dot, then search domains are not appended
+	
+	std::shared_ptr<const SearchList> searchList;
+	
+	unsigned nameIndex; //index of the name being resolved in the sequence of names to try
+	std::string hostName; //host name being resolved
+	
+	//whether the hosts file is to be looked up
+	bool useHostsFile;
 	
-	T_RequestsToSendIter sendIter;
+	HostNameResolver::E_Mode mode;
+	bool ipv6Supported;
 	
+	Timer timeoutTimer;
+	
+	//name server given by user, IPv4 host 0 if configured name servers are to be used
 	ting::net::IPAddress dns;
+	
+	//AAAA query goes first
+	std::array<Query, 2> queries;
+	unsigned numQueries = 0;
+	
+	void Init(
+			HostNameResolver* hnr,
+			const std::string& hostName,
+			const ting::net::IPAddress& dnsIP,
+			HostNameResolver::E_Mode mode,
+			bool ipv6Supported,
+			bool checkCache,
+			std::shared_ptr<const SearchList> searchList
+		)
+	{
+		this->isAbsolute = hostName.size() != 0 && hostName[hostName.size() - 1] == '.';
+		this->name = this->isAbsolute ? hostName.substr(0, hostName.size() - 1) : hostName;
+		this->searchList = std::move(searchList);
+		this->nameIndex = unsigned(-1);
+		this->NextName();//there is at least the name as given, it is not longer than 253 characters
+		
+		this->hnr = hnr;
+		this->dns = dnsIP;
+		this->useHostsFile = dnsIP.host.IPv4Host() == 0;//only if configured name servers are used
+		this->mode = mode;
+		this->ipv6Supported = ipv6Supported;
+		
+		this->timeoutTimer.r = this;
+		this->timeoutTimer.q = nullptr;
+		
+		this->ResetQueries(checkCache);
+	}
+	
+	//Get name to try, names are tried in the order described in resolv.conf(5).
+	//Returns false if there is no name with such index.
+	bool NameToTry(unsigned index, std::string& out)const{
+		size_t numDomains = this->isAbsolute || !this->searchList ? 0 : this->searchList->domains.size();
+		if(index > numDomains){
+			return false;
+		}
+		
+		bool asIsFirst = numDomains == 0 || unsigned(std::count(this->name.begin(), this->name.end(), '.')) >= this->searchList->ndots;
+		
+		if(index == (asIsFirst ? 0 : numDomains)){
+			out = this->name;
+		}else{
+			out = this->name + '.' + this->searchList->domains[asIsFirst ? index - 1 : index];
+		}
+		return true;
+	}
+	
+	//Switch to the next name to try.
+	//Returns false if there are no more names to try.
+	bool NextName(){
+		for(unsigned i = this->nameIndex + 1;; ++i){
+			std::string n;
+			if(!this->NameToTry(i, n)){
+				return false;
+			}
+			if(n.size() <= 253){
+				this->nameIndex = i;
+				this->hostName = std::move(n);
+				return true;
+			}
+		}
+	}
+	
+	//Start new queries, e.g. for the next name to try.
+	void ResetQueries(bool checkCache)NOEXCEPT{
+		if(!this->ipv6Supported){
+			this->numQueries = 1;
+			this->queries[0].recordType = D_DNSRecordA;
+		}else if(this->mode == HostNameResolver::IPV6_AND_IPV4){
+			this->numQueries = 2;
+			this->queries[0].recordType = D_DNSRecordAAAA;
+			this->queries[1].recordType = D_DNSRecordA;
+		}else{
+			this->numQueries = 1;
+			this->queries[0].recordType = D_DNSRecordAAAA;//start with IPv6 first
+		}
+		
+		for(unsigned k = 0; k != this->numQueries; ++k){
+			Query& q = this->queries[k];
+			q.r = this;
+			q.hasId = false;
+			q.checkCache = checkCache;
+			q.ResetAttempts();
+			q.attemptTimer.r = this;
+			q.attemptTimer.q = &q;
+			q.noEDNS = false;
+			q.isDone = false;
+			q.records.clear();
+		}
+	}
+};
+
+
+
+//Look up the result for the current name of the resolver in the hosts file and then in the cache, see FindInCache().
+bool FindLocally(const Resolver& r, std::uint16_t& recordType, Cache::Value& out){
+	bool fallbackToA = r.mode == HostNameResolver::IPV6_OR_IPV4;
+	
+	//hosts file is looked up with the name as given, before trying names with search domains
+	if(r.useHostsFile && r.nameIndex == 0 && HostsFile::Inst().Find(r.name, recordType, fallbackToA, out)){
+		return true;
+	}
+	
+	return FindInCache(r.hostName, recordType, fallbackToA, out);
+}
+
+
+
+//Combine results of all queries of the resolver.
+//Addresses of different families are interleaved, see RFC 8305.
+HostNameResolver::E_Result CombineResults(const Resolver& r, bool timedOut, std::vector<HostNameResolver::Record>& out){
+	ASSERT(out.size() == 0)
+	for(size_t i = 0;; ++i){
+		bool added = false;
+		for(unsigned k = 0; k != r.numQueries; ++k){
+			if(i < r.queries[k].records.size()){
+				out.push_back(r.queries[k].records[i]);
+				added = true;
+			}
+		}
+		if(!added){
+			break;
+		}
+	}
+	
+	if(out.size() != 0){
+		return HostNameResolver::OK;
+	}
+	
+	if(timedOut){
+		return HostNameResolver::TIMEOUT;
+	}
+	
+	//no such host only if all queries say so
+	HostNameResolver::E_Result ret = HostNameResolver::NO_SUCH_HOST;
+	for(unsigned k = 0; k != r.numQueries; ++k){
+		ASSERT(r.queries[k].isDone)
+		if(ret == HostNameResolver::NO_SUCH_HOST){
+			ret = r.queries[k].result;
+		}
+	}
+	return ret;
+}
+
+
+
+//TCP connection for repeating the query which UDP reply was truncated, see RFC 7766.
+struct TCPConnection{
+	ting::net::TCPSocket socket;
+	
+	//nullptr if the query was completed or canceled, in which case the lookup thread closes the connection
+	Query* q = nullptr;
+	
+	//request and then reply, both prefixed with 2 byte length
+	std::vector<std::uint8_t> buf;
+	
+	//number of bytes of the buffer sent or received
+	size_t numBytes;
+	
+	bool isSending;
 };
 
 
@@ -139,73 +1204,264 @@ class LookupThread : public ting::mt::MsgThread{
 	ting::net::UDPSocket socket;
 	ting::WaitSet waitSet;
 	
-	T_ResolversTimeMap resolversByTime1, resolversByTime2;
+	//UDP payload size advertised with EDNS, recommended to avoid IP fragmentation
+	static const std::uint16_t DUDPPayloadSize = 1232;
+	
+	static const std::uint16_t DTruncatedFlag = 0x200;
+	static const std::uint16_t DFormatErrorCode = 1;
+	
+	//maximal size of the request, host name is not longer than 253 characters
+	static const size_t DMaxRequestSize = 12 + 255 + 4 + 11;
+	
+	static const unsigned DMaxTCPConnections = 4;
+	std::array<TCPConnection, DMaxTCPConnections> tcpConnections;
 	
 public:
 	std::mutex mutex;//this mutex is used to protect access to members of the thread object.
 	
-	//this mutex is used to make sure that the callback has finished calling when Cancel_ts() method is called.
-	//I.e. to guarantee that after Cancel_ts() method has returned the callback will not be called anymore.
-	std::mutex completedMutex;
+	//this mutex is used to make sure that the callback has finished calling when Cancel_ts() method is called.
+	//I.e. to guarantee that after Cancel_ts() method has returned the callback will not be called anymore.
+	//It is held via shared pointer, so that Cancel_ts() can lock it after releasing dns::mutex,
+	//even if the thread object is destroyed meanwhile.
+	const std::shared_ptr<std::mutex> completedMutex = std::make_shared<std::mutex>();
+	
+	//this variable is for joining and destroying previous thread object if there was any.
+	std::unique_ptr<ting::mt::MsgThread> prevThread;
+	
+	//this is to indicate that the thread is exiting and new DNS lookup requests should be queued to
+	//a new thread.
+	volatile bool isExiting = true;//initially the thread is not running, so set to true
+	
+	//head of the list of queries to send
+	ListNode sendList;
+	
+	//Table of resolvers. Slots are reused by subsequent lookups, deque does not move its elements when growing.
+	std::deque<dns::Resolver> slots;
+	
+	//indices of inactive slots, capacity is kept not less than number of slots, so that freeing a slot does not throw
+	std::vector<std::uint32_t> freeSlots;
+	
+	//number of active slots
+	size_t numActive = 0;
+	
+	//queries by their IDs, nullptr for free IDs
+	std::vector<Query*> idTable;
+	
+	//first numFreeIds elements are the free IDs
+	std::vector<std::uint16_t> freeIds;
+	size_t numFreeIds;
+	
+	//free IDs are chosen randomly, so that they are not reused immediately and are hard to guess (RFC 5452)
+	std::minstd_rand idRandom;
+	
+	struct NameServer{
+		ting::net::IPAddress address;
+		
+		//smoothed round trip time in milliseconds
+		std::uint32_t rtt;
+	};
 	
-	//this variable is for joining and destroying previous thread object if there was any.
-	std::unique_ptr<ting::mt::MsgThread> prevThread;
+	//Accessed only from within the lookup thread, so no need to protect it with mutex.
+	std::vector<NameServer> nameServers;
+	std::uint32_t attemptTimeout;
+	unsigned attempts;
+	bool rotate;
+	unsigned rotateIndex = 0;
 	
-	//this is to indicate that the thread is exiting and new DNS lookup requests should be queued to
-	//a new thread.
-	volatile bool isExiting = true;//initially the thread is not running, so set to true
+	//round trip time assumed for name servers which have not replied yet, in milliseconds
+	static const std::uint32_t DInitialRTT = 100;
 	
-	//This variable is for detecting system clock ticks warp around.
-	//True if last call to ting::GetTicks() returned value in first half.
-	//False otherwise.
-	bool lastTicksInFirstHalf;
+	//minimal time to wait for reply before sending the query to the next name server, in milliseconds
+	static const std::uint32_t DMinAttemptDelay = 50;
 	
-	T_ResolversTimeMap* timeMap1;
-	T_ResolversTimeMap* timeMap2;
+	//maximal number of replies read from the socket per one iteration of the thread loop
+	static const unsigned DMaxRepliesPerIteration = 64;
 	
-	T_RequestsToSendList sendList;
+	//64 bit ticks, there is no warp around.
+	//NOTE: access to these variables should be protected by mutex.
+	std::uint32_t lastTicks = ting::timer::GetTicks();
+	std::uint64_t ticks = 1;//start from 1, since 0 means the request was not sent
 	
-	T_ResolversMap resolversMap;
-	T_IdMap idMap;
+	//resolver timeouts and query attempts
+	TimerWheel timers;
 	
-	ting::net::IPAddress dns;
+	void UpdateTicks(){
+		std::uint32_t curTicks = ting::timer::GetTicks();
+		this->ticks += std::uint32_t(curTicks - this->lastTicks);
+		this->lastTicks = curTicks;
+	}
 	
 	void StartSending(){
 		this->waitSet.Change(this->socket, ting::Waitable::READ_AND_WRITE);
 	}
 	
 	//NOTE: call to this function should be protected by mutex.
-	//throws HostNameResolver::TooMuchRequestsExc if all IDs are occupied.
-	std::uint16_t FindFreeId(){
-		if(this->idMap.size() == 0){
-			return 0;
+	void AddToSendList(Query* q){
+		bool wasEmpty = !this->sendList.IsLinked();
+		q->LinkBefore(&this->sendList);
+		if(wasEmpty){//if need to switch to wait for writing mode
+			this->StartSending();
 		}
-		
-		if(this->idMap.begin()->first != 0){
-			return this->idMap.begin()->first - 1;
+	}
+	
+	//maximal number of times one query is sent
+	unsigned MaxSends(const Query* q)const NOEXCEPT{
+		if(q->r->dns.host.IPv4Host() != 0){
+			return this->attempts;
 		}
+		return this->attempts * unsigned(this->nameServers.size());
+	}
+	
+	//Choose name server to send the query to. Servers are tried in order of their round trip time,
+	//each server once per round. With 'rotate' option the first server is chosen in round-robin manner.
+	unsigned ChooseNameServer(Query* q){
+		ASSERT(this->nameServers.size() != 0)
+		ASSERT(this->nameServers.size() <= DMaxNameServers)
 		
-		if((--(this->idMap.end()))->first != std::uint16_t(-1)){
-			return (--(this->idMap.end()))->first + 1;
+		unsigned allServers = (1 << this->nameServers.size()) - 1;
+		if((q->triedServers & allServers) == allServers){
+			q->triedServers = 0;//start next round
 		}
 		
-		T_IdIter i1 = this->idMap.begin();
-		T_IdIter i2 = ++this->idMap.begin();
-		for(; i2 != this->idMap.end(); ++i1, ++i2){
-			if(i2->first - i1->first > 1){
-				return i1->first + 1;
+		unsigned ret = DMaxNameServers;
+		if(q->numSent == 0 && this->rotate){
+			ret = (this->rotateIndex++) % this->nameServers.size();
+		}else{
+			for(unsigned i = 0; i != this->nameServers.size(); ++i){
+				if((q->triedServers & (1 << i)) != 0){
+					continue;
+				}
+				if(ret == DMaxNameServers || this->nameServers[i].rtt < this->nameServers[ret].rtt){
+					ret = i;
+				}
 			}
 		}
-		
-		throw HostNameResolver::TooMuchRequestsExc();
+		ASSERT(ret < this->nameServers.size())
+		q->triedServers |= (1 << ret);
+		return ret;
+	}
+	
+	//time to wait for the reply from the name server before sending the query to next one
+	std::uint32_t AttemptDelay(unsigned server)const NOEXCEPT{
+		if(server >= this->nameServers.size()){
+			return this->attemptTimeout;
+		}
+		return ting::util::ClampedRange(3 * this->nameServers[server].rtt, std::uint32_t(DMinAttemptDelay), this->attemptTimeout);
 	}
 	
+	//NOTE: call to this function should be protected by mutex.
+	void UnscheduleAttempt(Query* q)NOEXCEPT{
+		TimerWheel::Remove(&q->attemptTimer);
+	}
 	
-	//NOTE: call to this function should be protected by mutex, to make sure the request is not canceled while sending.
-	//returns true if request is sent, false otherwise.
-	bool SendRequestToDNS(const dns::Resolver* r){
-		std::array<std::uint8_t, 512> buf; //RFC 1035 limits DNS request UDP packet size to 512 bytes.
+	//update round trip time of the name server which has replied to the query
+	void UpdateRTT(Query* q, const ting::net::IPAddress& from){
+		for(unsigned i = 0; i != this->nameServers.size(); ++i){
+			if(!(this->nameServers[i].address == from)){
+				continue;
+			}
+			if(q->sentTicks[i] == 0){
+				return;
+			}
+			std::uint32_t sample = std::uint32_t(std::min(this->ticks - q->sentTicks[i], std::uint64_t(this->attemptTimeout)));
+			this->nameServers[i].rtt = (7 * this->nameServers[i].rtt + sample) / 8;
+			return;
+		}
+	}
+	
+	//version of the configuration loaded by InitDNS()
+	unsigned configVersion;
+	
+	//Called from within the lookup thread.
+	void InitDNS(){
+		Config c;
+		{
+			std::lock_guard<decltype(dns::configMutex)> lock(dns::configMutex);
+			this->configVersion = dns::configVersion;
+			if(dns::userConfig){
+				c = *dns::userConfig;
+			}
+		}
+		if(c.nameServers.size() == 0){
+			c = ReadSystemConfig();
+		}
 		
+		this->nameServers.clear();
+		for(auto& a : c.nameServers){
+			NameServer ns;
+			ns.address = a;
+			ns.rtt = DInitialRTT;
+			this->nameServers.push_back(ns);
+		}
+		this->attemptTimeout = c.attemptTimeout;
+		this->attempts = c.attempts;
+		this->rotate = c.rotate;
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//throws HostNameResolver::TooMuchRequestsExc if all IDs are occupied.
+	void AllocateId(Query* q){
+		ASSERT(!q->hasId)
+		if(this->numFreeIds == 0){
+			throw HostNameResolver::TooMuchRequestsExc();
+		}
+		size_t i = size_t(this->idRandom()) % this->numFreeIds;
+		--this->numFreeIds;
+		std::swap(this->freeIds[i], this->freeIds[this->numFreeIds]);
+		q->id = this->freeIds[this->numFreeIds];
+		ASSERT(!this->idTable[q->id])
+		this->idTable[q->id] = q;
+		q->hasId = true;
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	void FreeId(Query* q)NOEXCEPT{
+		ASSERT(q->hasId)
+		ASSERT(this->idTable[q->id] == q)
+		this->idTable[q->id] = nullptr;
+		this->freeIds[this->numFreeIds] = q->id;
+		++this->numFreeIds;
+		q->hasId = false;
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	void SetTimeout(Resolver* r, std::uint32_t timeoutMillis)NOEXCEPT{
+		TimerWheel::Remove(&r->timeoutTimer);
+		this->timers.Add(&r->timeoutTimer, this->ticks + timeoutMillis);
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//returns nullptr if the lookup of the given HostNameResolver is not in progress.
+	Resolver* FindResolver(std::uint32_t slot, HostNameResolver* hnr)NOEXCEPT{
+		if(slot >= this->slots.size()){
+			return nullptr;
+		}
+		Resolver& r = this->slots[slot];
+		if(!r.isActive || r.hnr != hnr){
+			return nullptr;
+		}
+		return &r;
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	Resolver& AllocateSlot(){
+		if(this->freeSlots.size() == 0){
+			this->freeSlots.reserve(this->slots.size() + 1);
+			this->slots.emplace_back();
+			this->slots.back().slot = std::uint32_t(this->slots.size() - 1);
+			this->freeSlots.push_back(this->slots.back().slot);
+		}
+		Resolver& r = this->slots[this->freeSlots.back()];
+		this->freeSlots.pop_back();
+		ASSERT(!r.isActive)
+		r.isActive = true;
+		++this->numActive;
+		return r;
+	}
+	
+	
+	//Compose request packet, returns its size.
+	static size_t ComposeRequest(const dns::Query* q, ting::Buffer<std::uint8_t> buf){
 		size_t packetSize =
 				2 + //ID
 				2 + //flags
@@ -213,113 +1469,148 @@ public:
 				2 + //Number of answers
 				2 + //Number of authority records
 				2 + //Number of other records
-				r->hostName.size() + 2 + //domain name
+				q->r->hostName.size() + 2 + //domain name
 				2 + //Question type
-				2   //Question class
+				2 + //Question class
+				(q->noEDNS ? 0 : 11) //OPT record
 			;
 		
 		ASSERT(packetSize <= buf.size())
 		
-		std::uint8_t* p = &*buf.begin();
-		
-		//ID
-		ting::util::Serialize16BE(r->id, p);
-		p += 2;
-		
-		//flags
-		ting::util::Serialize16BE(0x100, p);
-		p += 2;
-		
-		//Number of questions
-		ting::util::Serialize16BE(1, p);
-		p += 2;
-		
-		//Number of answers
-		ting::util::Serialize16BE(0, p);
-		p += 2;
-		
-		//Number of authority records
-		ting::util::Serialize16BE(0, p);
-		p += 2;
+		ting::BufferWriter w(buf);
 		
-		//Number of other records
-		ting::util::Serialize16BE(0, p);
-		p += 2;
+		{
+			auto h = w.Reserve(12);
+			h.Put16BE(q->id);//ID
+			h.Put16BE(0x100);//flags
+			h.Put16BE(1);//Number of questions
+			h.Put16BE(0);//Number of answers
+			h.Put16BE(0);//Number of authority records
+			h.Put16BE(q->noEDNS ? 0 : 1);//Number of other records
+		}
 		
 		//domain name
-		for(size_t dotPos = 0; dotPos < r->hostName.size();){
+		for(size_t dotPos = 0; dotPos < q->r->hostName.size();){
 			size_t oldDotPos = dotPos;
-			dotPos = r->hostName.find('.', dotPos);
+			dotPos = q->r->hostName.find('.', dotPos);
 			if(dotPos == std::string::npos){
-				dotPos = r->hostName.size();
+				dotPos = q->r->hostName.size();
 			}
 			
-			ASSERT(dotPos <= 0xff)
 			size_t labelLength = dotPos - oldDotPos;
 			ASSERT(labelLength <= 0xff)
 			
-			*p = std::uint8_t(labelLength);//save label length
-			++p;
-			//copy the label bytes
-			memcpy(p, r->hostName.c_str() + oldDotPos, labelLength);
-			p += labelLength;
+			w.PutBlob8(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(q->r->hostName.c_str() + oldDotPos), labelLength));
 			
 			++dotPos;
-			
-			ASSERT(p <= &*buf.end());
 		}
 		
-		*p = 0; //terminate labels sequence
-		++p;
+		{
+			auto qs = w.Reserve(5);
+			qs.Put8(0);//terminate labels sequence
+			qs.Put16BE(q->recordType);//Question type
+			qs.Put16BE(1);//Question class (1 means inet)
+		}
 		
-		ting::util::Serialize16BE(r->recordType, p);
-		p += 2;
+		if(!q->noEDNS){
+			//EDNS0 OPT pseudo-record advertising bigger UDP payload size, see RFC 6891
+			auto opt = w.Reserve(11);
+			opt.Put8(0);//root domain name
+			opt.Put16BE(D_DNSRecordOPT);
+			opt.Put16BE(DUDPPayloadSize);//class field holds the UDP payload size
+			opt.Put32BE(0);//extended response code, version and flags
+			opt.Put16BE(0);//no options
+		}
 		
-		//Question class (1 means inet)
-		ting::util::Serialize16BE(1, p);
-		p += 2;
+		ASSERT(w.NumWritten() == packetSize)
+		
+		return packetSize;
+	}
+	
+	//NOTE: call to this function should be protected by mutex, to make sure the request is not canceled while sending.
+	//returns true if request is sent, false otherwise.
+	bool SendRequestToDNS(const dns::Query* q, const ting::net::IPAddress& to){
+		std::array<std::uint8_t, DMaxRequestSize> buf;
 		
-		ASSERT(&*buf.begin() <= p && p <= &*buf.end());
-		ASSERT(size_t(p - &*buf.begin()) == packetSize);
+		size_t packetSize = ComposeRequest(q, buf);
 		
-		TRACE(<< "sending DNS request to " << std::hex << (r->dns.host.IPv4Host()) << std::dec << " for " << r->hostName << ", reqID = " << r->id << std::endl)
-		size_t ret = this->socket.Send(ting::Buffer<std::uint8_t>(&*buf.begin(), packetSize), r->dns);
+		TRACE(<< "sending DNS request to " << to.host.ToString() << " for " << q->r->hostName << ", reqID = " << q->id << std::endl)
+		size_t ret = this->socket.Send(ting::Buffer<std::uint8_t>(&*buf.begin(), packetSize), to);
 		
 		ASSERT(ret == packetSize || ret == 0)
 		
-//		TRACE(<< "DNS request sent, packetSize = " << packetSize << std::endl)
-//#ifdef DEBUG
-//		for(unsigned i = 0; i < packetSize; ++i){
-//			TRACE(<< int(buf[i]) << std::endl)
-//		}
-//#endif
 		return ret == packetSize;
 	}
 	
 	
 	
 	//NOTE: call to this function should be protected by mutex
-	inline void CallCallback(dns::Resolver* r, ting::net::HostNameResolver::E_Result result, IPAddress::Host ip = IPAddress::Host(0, 0, 0, 0))NOEXCEPT{
-		this->completedMutex.lock();
+	inline void CallCallback(
+			HostNameResolver* hnr,
+			ting::net::HostNameResolver::E_Result result,
+			const std::vector<ting::net::HostNameResolver::Record>& records = std::vector<ting::net::HostNameResolver::Record>()
+		)NOEXCEPT
+	{
+		this->completedMutex->lock();
 		this->mutex.unlock();
-		r->hnr->OnCompleted_ts(result, ip);
-		this->completedMutex.unlock();
+		hnr->OnCompletedWithRecords_ts(result, records);
+		this->completedMutex->unlock();
 		this->mutex.lock();
 	}
 	
 	struct ParseResult{
 		ting::net::HostNameResolver::E_Result result;
-		ting::net::IPAddress::Host host;
+		std::vector<ting::net::HostNameResolver::Record> records;
+		
+		//time in seconds during which the result can be cached
+		std::uint32_t ttl;
 		
-		ParseResult(ting::net::HostNameResolver::E_Result result, ting::net::IPAddress::Host host = ting::net::IPAddress::Host(0, 0, 0, 0)) :
+		ParseResult(ting::net::HostNameResolver::E_Result result, std::uint32_t ttl = 0) :
 				result(result),
-				host(host)
+				ttl(ttl)
 		{}
 	};
 	
+	//Find SOA record in authority section of the reply and get TTL for the negative answer from it, see RFC 2308.
+	//Returns 0 if there is no SOA record.
+	static std::uint32_t ParseNegativeTTL(const std::uint8_t* p, const std::uint8_t* end, std::uint16_t numAuthorityRecords){
+		for(std::uint16_t n = 0; n != numAuthorityRecords; ++n){
+			if(!dns::SkipHostNameInDNSPacket(p, end)){
+				return 0;
+			}
+			
+			if(end - p < 10){
+				return 0;
+			}
+			std::uint16_t type = ting::util::Deserialize16BE(p);
+			std::uint32_t ttl = ting::util::Deserialize32BE(p + 4);
+			std::uint16_t dataLen = ting::util::Deserialize16BE(p + 8);
+			p += 10;
+			
+			if(end - p < dataLen){
+				return 0;
+			}
+			
+			if(type == D_DNSRecordSOA){
+				const std::uint8_t* d = p;
+				const std::uint8_t* dataEnd = p + dataLen;
+				if(!dns::SkipHostNameInDNSPacket(d, dataEnd) || !dns::SkipHostNameInDNSPacket(d, dataEnd)){//primary name server and responsible mailbox
+					return 0;
+				}
+				if(dataEnd - d < 20){//serial, refresh, retry, expire, minimum
+					return 0;
+				}
+				return std::min(ttl, ting::util::Deserialize32BE(d + 16));
+			}
+			
+			p += dataLen;
+		}
+		return 0;
+	}
+	
 	//NOTE: call to this function should be protected by mutex
 	//This function will call the Resolver callback.
-	ParseResult ParseReplyFromDNS(dns::Resolver* r, const ting::Buffer<std::uint8_t> buf){
+	ParseResult ParseReplyFromDNS(const dns::Query* q, const ting::Buffer<const std::uint8_t> buf){
 		TRACE(<< "dns::Resolver::ParseReplyFromDNS(): enter" << std::endl)
 #ifdef DEBUG
 		for(unsigned i = 0; i < buf.size(); ++i){
@@ -342,6 +1633,8 @@ public:
 		const std::uint8_t* p = buf.begin();
 		p += 2;//skip ID
 		
+		bool nameDoesNotExist;
+		
 		{
 			std::uint16_t flags = ting::util::Deserialize16BE(p);
 			p += 2;
@@ -352,14 +1645,12 @@ public:
 			}
 			
 			//Check response code
-			if((flags & 0xf) != 0){//0 means no error condition
-				if((flags & 0xf) == 3){//name does not exist
-					return ParseResult(ting::net::HostNameResolver::NO_SUCH_HOST);
-				}else{
-					TRACE(<< "ParseReplyFromDNS(): (flags & 0xf) = " << (flags & 0xf) << std::endl)
-					return ParseResult(ting::net::HostNameResolver::DNS_ERROR);
-				}
+			//0 means no error condition, 3 means name does not exist
+			if((flags & 0xf) != 0 && (flags & 0xf) != 3){
+				TRACE(<< "ParseReplyFromDNS(): (flags & 0xf) = " << (flags & 0xf) << std::endl)
+				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);
 			}
+			nameDoesNotExist = (flags & 0xf) == 3;
 		}
 		
 		{//check number of questions
@@ -376,14 +1667,8 @@ public:
 		ASSERT(buf.begin() <= p)
 		ASSERT(p <= (buf.end() - 1) || p == buf.end())
 		
-		if(numAnswers == 0){
-			return ParseResult(ting::net::HostNameResolver::NO_SUCH_HOST);
-		}
-		
-		{
-//			std::uint16_t nscount = ting::util::Deserialize16BE(p);
-			p += 2;
-		}
+		std::uint16_t numAuthorityRecords = ting::util::Deserialize16BE(p);
+		p += 2;
 		
 		{
 //			std::uint16_t arcount = ting::util::Deserialize16BE(p);
@@ -392,21 +1677,25 @@ public:
 		
 		//parse host name
 		{
-			std::string host = dns::ParseHostNameFromDNSPacket(p, buf.end());
+			std::string host = dns::ParseHostNameFromDNSPacket(p, buf.begin(), buf.end());
 //			TRACE(<< "host = " << host << std::endl)
 			
-			if(r->hostName != host){
+			if(q->r->hostName != host){
 //				TRACE(<< "this->hostName = " << this->hostName << std::endl)
 				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//wrong host name for ID.
 			}
 		}
 		
+		if(buf.end() - p < 4){
+			return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet
+		}
+		
 		//check query type, we sent question type 1 (A query).
 		{
 			std::uint16_t type = ting::util::Deserialize16BE(p);
 			p += 2;
 			
-			if(type != r->recordType){
+			if(type != q->recordType){
 				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//wrong question type
 			}
 		}
@@ -423,26 +1712,26 @@ public:
 		
 		ASSERT(buf.Overlaps(p) || p == buf.end())
 		
+		if(nameDoesNotExist || numAnswers == 0){
+			return ParseResult(
+					ting::net::HostNameResolver::NO_SUCH_HOST,
+					ParseNegativeTTL(p, buf.end(), numAuthorityRecords)
+				);
+		}
+		
+		ParseResult ret(ting::net::HostNameResolver::OK, std::uint32_t(-1));
+		
+		//minimal TTL of the records in the chain of aliases leading to the addresses
+		std::uint32_t chainTTL = std::uint32_t(-1);
+		
+		//name which addresses are looked for, it changes when following the chain of aliases (CNAME records)
+		std::string name = q->r->hostName;
+		
 		//loop through the answers
 		for(std::uint16_t n = 0; n != numAnswers; ++n){
-			if(p == buf.end()){
-				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet
-			}
-			
-			//check if there is a domain name or a reference to the domain name
-			if(((*p) >> 6) == 0){ //check if two high bits are set
-				//skip possible domain name
-				for(; p != buf.end() && *p != 0; ++p){
-					ASSERT(buf.Overlaps(p))
-				}
-				if(p == buf.end()){
-					return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet
-				}
-				++p;
-			}else{
-				//it is a reference to the domain name.
-				//skip it
-				p += 2;
+			std::string owner = dns::ParseHostNameFromDNSPacket(p, buf.begin(), buf.end());
+			if(owner.size() == 0){
+				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet or malformed name
 			}
 			
 			if(buf.end() - p < 2){
@@ -460,7 +1749,7 @@ public:
 			if(buf.end() - p < 4){
 				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet
 			}
-//			std::uint32_t ttl = ting::util::Deserialize32(p);//time till the returned value can be cached.
+			std::uint32_t ttl = ting::util::Deserialize32BE(p);//time till the returned value can be cached.
 			p += 4;
 			
 			if(buf.end() - p < 2){
@@ -472,7 +1761,10 @@ public:
 			if(buf.end() - p < dataLen){
 				return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//unexpected end of packet
 			}
-			if(type == r->recordType){
+			
+			if(!dns::EqualDomainNames(owner, name)){
+				//record is not for the name we are looking for, skip it
+			}else if(type == q->recordType){
 				IPAddress::Host h;
 				
 				switch(type){
@@ -496,203 +1788,441 @@ public:
 							);
 						break;
 					default:
-						//we should not get here since if type is not the record type which we know then 'if(type == r->recordType)' condition will not trigger.
+						//we should not get here since if type is not the record type which we know then 'if(type == q->recordType)' condition will not trigger.
 						ASSERT(false)
 						h = IPAddress::Host(0,0,0,0);
 						break;
 				}
 				
-				TRACE(<< "host resolved: " << r->hostName << " = " << h.ToString() << std::endl)
-				return ParseResult(ting::net::HostNameResolver::OK, h);
+				TRACE(<< "host resolved: " << q->r->hostName << " = " << h.ToString() << std::endl)
+				ting::net::HostNameResolver::Record record = {h, std::min(ttl, chainTTL)};
+				ret.records.push_back(record);
+				ting::util::ClampTop(ret.ttl, record.ttl);
+			}else if(type == D_DNSRecordCNAME){
+				const std::uint8_t* d = p;
+				name = dns::ParseHostNameFromDNSPacket(d, buf.begin(), p + dataLen);
+				if(name.size() == 0){
+					return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//malformed alias
+				}
+				ting::util::ClampTop(chainTTL, ttl);
 			}
 			p += dataLen;
 		}
 		
-		return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//no answer found
+		if(ret.records.size() == 0){
+			if(name != q->r->hostName){
+				//alias has no records of requested type, see RFC 2308
+				return ParseResult(
+						ting::net::HostNameResolver::NO_SUCH_HOST,
+						std::min(chainTTL, ParseNegativeTTL(p, buf.end(), numAuthorityRecords))
+					);
+			}
+			return ParseResult(ting::net::HostNameResolver::DNS_ERROR);//no answer found
+		}
+		return ret;
 	}
 	
 	
 	
 private:
 	LookupThread() :
-			waitSet(2),
-			timeMap1(&resolversByTime1),
-			timeMap2(&resolversByTime2)
+			waitSet(2 + DMaxTCPConnections),
+			idTable(0x10000, nullptr),
+			freeIds(0x10000),
+			numFreeIds(freeIds.size()),
+			timers(ticks)
 	{
 		ASSERT_INFO(ting::net::Lib::IsCreated(), "ting::net::Lib is not initialized before doing the DNS request")
+		
+		for(size_t i = 0; i != this->freeIds.size(); ++i){
+			this->freeIds[i] = std::uint16_t(i);
+		}
+		
+		try{
+			std::random_device rd;
+			this->idRandom.seed(rd());
+		}catch(...){
+			this->idRandom.seed(this->lastTicks);
+		}
 	}
 public:
 	~LookupThread()NOEXCEPT{
-		ASSERT(this->sendList.size() == 0)
-		ASSERT(this->resolversMap.size() == 0)
-		ASSERT(this->resolversByTime1.size() == 0)
-		ASSERT(this->resolversByTime2.size() == 0)
-		ASSERT(this->idMap.size() == 0)		
+		ASSERT(!this->sendList.IsLinked())
+		ASSERT(this->numActive == 0)
+		ASSERT(this->numFreeIds == this->freeIds.size())
 	}
 	
-	//returns Ptr owning the removed resolver, returns invalid Ptr if there was
-	//no such resolver object found.
+	//Remove the resolver from all the lists and free its slot.
+	//Returns the HostNameResolver object the lookup was done for.
 	//NOTE: call to this function should be protected by mutex.
-	std::unique_ptr<dns::Resolver> RemoveResolver(HostNameResolver* resolver)NOEXCEPT{
-		std::unique_ptr<dns::Resolver> r;
-		{
-			dns::T_ResolversIter i = this->resolversMap.find(resolver);
-			if(i == this->resolversMap.end()){
-				return r;
+	HostNameResolver* RemoveResolver(dns::Resolver* r)NOEXCEPT{
+		ASSERT(r->isActive)
+		
+		for(unsigned k = 0; k != r->numQueries; ++k){
+			dns::Query& q = r->queries[k];
+			
+			//if the request was not sent yet
+			if(q.IsLinked()){
+				q.Unlink();
+			}
+			
+			if(q.hasId){
+				this->FreeId(&q);
+			}
+			
+			//the connection will be closed by the lookup thread
+			if(q.tcp){
+				q.tcp->q = nullptr;
+				q.tcp = nullptr;
+			}
+			
+			this->UnscheduleAttempt(&q);
+		}
+		
+		TimerWheel::Remove(&r->timeoutTimer);
+		
+		r->isActive = false;
+		--this->numActive;
+		ASSERT(this->freeSlots.capacity() > this->freeSlots.size())
+		this->freeSlots.push_back(r->slot);
+		
+		return r->hnr;
+	}
+	
+private:
+	//Resolution delay, time to wait for addresses of other family after addresses of one family are received, see RFC 8305.
+	static const std::uint32_t DResolutionDelay = 50;
+	
+	//NOTE: call to this function should be protected by mutex.
+	void Complete(dns::Resolver* r, bool timedOut)NOEXCEPT{
+		std::vector<HostNameResolver::Record> records;
+		HostNameResolver::E_Result result;
+		try{
+			result = dns::CombineResults(*r, timedOut, records);
+		}catch(...){
+			records.clear();
+			result = HostNameResolver::ERROR;
+		}
+		
+		//OnCompleted_ts() does not throw any exceptions, so no worries about that.
+		this->CallCallback(this->RemoveResolver(r), result, records);
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//Completes the resolver if all its queries are done.
+	void QueryDone(dns::Query* q, HostNameResolver::E_Result result, std::vector<HostNameResolver::Record>&& records)NOEXCEPT{
+		ASSERT(!q->isDone)
+		ASSERT(!q->IsLinked())
+		ASSERT(!q->tcp)
+		
+		q->isDone = true;
+		q->result = result;
+		q->records = std::move(records);
+		
+		//late replies to the query will be ignored
+		if(q->hasId){
+			this->FreeId(q);
+		}
+		this->UnscheduleAttempt(q);
+		
+		dns::Resolver* r = q->r;
+		
+		bool allDone = true;
+		bool anyFound = false;
+		for(unsigned k = 0; k != r->numQueries; ++k){
+			allDone = allDone && r->queries[k].isDone;
+			anyFound = anyFound || r->queries[k].records.size() != 0;
+		}
+		
+		if(allDone){
+			bool notFound = true;
+			for(unsigned k = 0; k != r->numQueries; ++k){
+				notFound = notFound && r->queries[k].result == HostNameResolver::NO_SUCH_HOST;
+			}
+			if(notFound && this->LookUpNextName(r)){
+				return;
+			}
+			this->Complete(r, false);
+			return;
+		}
+		
+		if(anyFound){
+			//do not wait too long for addresses of the other family
+			this->ShortenTimeout(r, DResolutionDelay);
+		}
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//Start resolving the next name with search domain appended, the lookup timeout is not restarted.
+	//Returns false if there are no more names to try.
+	bool LookUpNextName(dns::Resolver* r)NOEXCEPT{
+		try{
+			if(!r->NextName()){
+				return false;
+			}
+			TRACE(<< "trying next name: " << r->hostName << std::endl)
+			
+			r->ResetQueries(true);
+			for(unsigned k = 0; k != r->numQueries; ++k){
+				this->AllocateId(&r->queries[k]);
+			}
+			for(unsigned k = 0; k != r->numQueries; ++k){
+				this->AddToSendList(&r->queries[k]);
 			}
-			r = std::move(i->second);
-			this->resolversMap.erase(i);
+		}catch(...){
+			this->CallCallback(this->RemoveResolver(r), HostNameResolver::ERROR);
+		}
+		return true;
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	void ShortenTimeout(dns::Resolver* r, std::uint32_t timeoutMillis)NOEXCEPT{
+		this->UpdateTicks();
+		if(r->timeoutTimer.deadline <= this->ticks + timeoutMillis){
+			return;//already timed out or will time out soon enough
 		}
+		this->SetTimeout(r, timeoutMillis);
+	}
+	
+	//NOTE: call to this function should be protected by dns::mutex
+	void RemoveAllResolvers(){
+		for(size_t i = 0; i != this->slots.size(); ++i){
+			if(!this->slots[i].isActive){
+				continue;
+			}
 
-		//the request is active, remove it from all the maps
+#if M_OS == M_OS_WINDOWS && defined(ERROR)
+#	undef ERROR
+#endif
 
-		//if the request was not sent yet
-		if(r->sendIter != this->sendList.end()){
-			this->sendList.erase(r->sendIter);
+			//OnCompleted_ts() does not throw any exceptions, so no worries about that.
+			this->CallCallback(this->RemoveResolver(&this->slots[i]), HostNameResolver::ERROR);
+		}
+	}
+	
+	
+	
+	//NOTE: call to this function should be protected by mutex.
+	void Resend(dns::Query* q)NOEXCEPT{
+		try{
+			if(!q->IsLinked()){
+				this->AddToSendList(q);
+			}
+		}catch(...){
+			//failed adding to sending list, report error
+			this->CallCallback(this->RemoveResolver(q->r), ting::net::HostNameResolver::ERROR);
+		}
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//Process reply received over UDP or over TCP.
+	void ProcessReply(ting::Buffer<const std::uint8_t> reply, const ting::net::IPAddress& from, bool overTCP){
+		if(reply.size() < 13){//at least there should be standard header and host name, otherwise ignore the reply
+			return;
+		}
+		
+		std::uint16_t id = ting::util::Deserialize16BE(reply.begin());
+		
+		dns::Query* q = this->idTable[id];
+		if(!q){
+			return;
+		}
+		ASSERT(id == q->id)
+		
+		if(!overTCP && q->tcp){
+			return;//query is being repeated over TCP
+		}
+		
+		//check by host name also
+		const std::uint8_t* p = reply.begin() + 12;//start of the host name
+		std::string host = dns::ParseHostNameFromDNSPacket(p, reply.begin(), reply.end());
+		
+		//check that reply is for current query, it can be a late reply to the previous query of the resolver
+		if(host != q->r->hostName || reply.end() - p < 2 || ting::util::Deserialize16BE(p) != q->recordType){
+			return;
+		}
+		
+		this->UnscheduleAttempt(q);
+		
+		bool isTruncated = false;
+		
+		if(!overTCP){
+			this->UpdateTicks();
+			this->UpdateRTT(q, from);
+			
+			std::uint16_t flags = ting::util::Deserialize16BE(reply.begin() + 2);
+			
+			if((flags & 0xf) == DFormatErrorCode && !q->noEDNS){
+				//name server does not support EDNS, repeat the query without OPT record, see RFC 6891
+				TRACE(<< "format error, trying without EDNS" << std::endl)
+				q->noEDNS = true;
+				this->Resend(q);
+				return;
+			}
+			
+			if((flags & DTruncatedFlag) != 0){
+				TRACE(<< "reply is truncated, trying over TCP" << std::endl)
+				if(this->StartTCP(q, from)){
+					return;
+				}
+				//no free connections, take what has fit into UDP reply
+				isTruncated = true;
+			}
+		}
+		
+		ParseResult res = this->ParseReplyFromDNS(q, reply);
+		
+		if(!isTruncated){
+			dns::AddToCache(q->r->hostName, q->recordType, res.result, res.records, res.ttl);
+		}
+		
+		if(res.result == ting::net::HostNameResolver::DNS_ERROR && q->numSent < this->MaxSends(q)){
+			//name server failed to answer, try next one
+			TRACE(<< "DNS error, trying next name server" << std::endl)
+			this->Resend(q);
+			return;
+		}
+		
+		if(
+				res.result == ting::net::HostNameResolver::NO_SUCH_HOST &&
+				q->recordType == D_DNSRecordAAAA &&
+				q->r->mode == ting::net::HostNameResolver::IPV6_OR_IPV4
+			)
+		{
+			//try getting record type A
+			TRACE(<< "no record AAAA found, trying to get record type A" << std::endl)
+			
+			q->recordType = D_DNSRecordA;
+			q->ResetAttempts();
+			this->Resend(q);
+			return;
+		}
+		
+		if(q->IsLinked()){
+			q->Unlink();
+		}
+		this->QueryDone(q, res.result, std::move(res.records));
+	}
+	
+	//NOTE: call to this function should be protected by mutex.
+	//Returns false if the query cannot be sent over TCP.
+	bool StartTCP(dns::Query* q, const ting::net::IPAddress& to)NOEXCEPT{
+		dns::TCPConnection* c = nullptr;
+		for(auto& t : this->tcpConnections){
+			if(!t.socket){
+				c = &t;
+				break;
+			}
+		}
+		if(!c){
+			return false;
+		}
+		
+		try{
+			c->buf.resize(2 + DMaxRequestSize);
+			size_t size = ComposeRequest(q, ting::Buffer<std::uint8_t>(&c->buf[2], DMaxRequestSize));
+			ting::util::Serialize16BE(std::uint16_t(size), &c->buf[0]);
+			c->buf.resize(2 + size);
+			c->numBytes = 0;
+			c->isSending = true;
+			
+			c->socket.Open(to, true);
+			this->waitSet.Add(c->socket, ting::Waitable::WRITE);
+		}catch(...){
+			c->socket.Close();
+			return false;
 		}
-
-		r->timeMap->erase(r->timeMapIter);
-
-		this->idMap.erase(r->idIter);
 		
-		return r;
+		c->q = q;
+		q->tcp = c;
+		return true;
 	}
 	
-private:
-	//NOTE: call to this function should be protected by dns::mutex
-	void RemoveAllResolvers(){
-		while(this->resolversMap.size() != 0){
-			std::unique_ptr<dns::Resolver> r = this->RemoveResolver(this->resolversMap.begin()->first);
-			ASSERT(r)
-
-#if M_OS == M_OS_WINDOWS && defined(ERROR)
-#	undef ERROR
-#endif
-
-			//OnCompleted_ts() does not throw any exceptions, so no worries about that.
-			this->CallCallback(r.operator->(), HostNameResolver::ERROR);
+	//NOTE: call to this function should be protected by mutex.
+	void CloseTCP(dns::TCPConnection& c)NOEXCEPT{
+		ASSERT(c.socket)
+		this->waitSet.Remove(c.socket);
+		c.socket.Close();
+		if(c.q){
+			c.q->tcp = nullptr;
+			c.q = nullptr;
 		}
 	}
 	
-	
-	void InitDNS(){
+	//NOTE: call to this function should be protected by mutex.
+	void ProcessTCP(dns::TCPConnection& c)NOEXCEPT{
+		if(!c.socket){
+			return;
+		}
+		
+		if(!c.q){
+			this->CloseTCP(c);//query was completed or canceled
+			return;
+		}
+		
+		dns::Query* q = c.q;
+		
+		bool failed = false;
+		bool received = false;
+		
 		try{
-#if M_OS == M_OS_WINDOWS
-			struct WinRegKey{
-				HKEY	key;
-			
-				WinRegKey(){
-					if(RegOpenKey(
-							HKEY_LOCAL_MACHINE,
-							"SYSTEM\\ControlSet001\\Services\\Tcpip\\Parameters\\Interfaces",
-							&this->key
-						) != ERROR_SUCCESS)
-					{
-						throw ting::Exc("InitDNS(): RegOpenKey() failed");
+			if(c.socket.ErrorCondition()){
+				failed = true;
+			}else if(c.isSending){
+				if(c.socket.CanWrite()){
+					c.numBytes += c.socket.Send(ting::Buffer<const std::uint8_t>(&c.buf[c.numBytes], c.buf.size() - c.numBytes));
+					if(c.numBytes == c.buf.size()){
+						//receive length of the reply first
+						c.isSending = false;
+						c.numBytes = 0;
+						c.buf.resize(2);
+						this->waitSet.Change(c.socket, ting::Waitable::READ);
 					}
 				}
-				
-				~WinRegKey(){
-					RegCloseKey(this->key);
-				}
-			} key;
-			
-			std::array<char, 256> subkey;//according to MSDN docs maximum key name length is 255 chars.
-			
-			for(unsigned i = 0; RegEnumKey(key.key, i, &*subkey.begin(), subkey.size()) == ERROR_SUCCESS; ++i){
-				HKEY hSub;
-				if(RegOpenKey(key.key, &*subkey.begin(), &hSub) != ERROR_SUCCESS){
-					continue;
-				}
-				
-				std::array<BYTE, 1024> value;
-				
-				DWORD len = value.size();
-				
-				if(RegQueryValueEx(hSub, "NameServer", 0, NULL, &*value.begin(), &len) != ERROR_SUCCESS){
-					TRACE(<< "NameServer reading failed " << std::endl)
+			}else if(c.socket.CanRead()){
+				size_t n = c.socket.Recv(ting::Buffer<std::uint8_t>(&c.buf[c.numBytes], c.buf.size() - c.numBytes));
+				if(n == 0){
+					failed = true;//connection closed by name server
 				}else{
-					try{
-						std::string str(reinterpret_cast<char*>(&*value.begin()));
-						size_t spaceIndex = str.find(' ');
-
-						std::string ip = str.substr(0, spaceIndex);
-						TRACE(<< "NameServer ip = " << ip << std::endl)
-				
-						this->dns = ting::net::IPAddress(ip.c_str(), 53);
-						RegCloseKey(hSub);
-						return;
-					}catch(...){}
-				}
-
-				len = value.size();
-				if(RegQueryValueEx(hSub, "DhcpNameServer", 0, NULL, &*value.begin(), &len) != ERROR_SUCCESS){
-					TRACE(<< "DhcpNameServer reading failed " << std::endl)
-					RegCloseKey(hSub);
-					continue;
-				}
-
-				try{
-					std::string str(reinterpret_cast<char*>(&*value.begin()));
-					size_t spaceIndex = str.find(' ');
-
-					std::string ip = str.substr(0, spaceIndex);
-					TRACE(<< "DhcpNameServer ip = " << ip << std::endl)
-				
-					this->dns = ting::net::IPAddress(ip.c_str(), 53);
-					RegCloseKey(hSub);
-					return;
-				}catch(...){}
-				RegCloseKey(hSub);
-			}
-
-#elif M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX || M_OS == M_OS_UNIX
-			ting::fs::FSFile f("/etc/resolv.conf");
-			
-			std::vector<std::uint8_t> buf = f.LoadWholeFileIntoMemory(0xfff);//4kb max
-			
-			for(std::uint8_t* p = &*buf.begin(); p != &*buf.end(); ++p){
-				std::uint8_t* start = p;
-				
-				while(p != &*buf.end() && *p != '\n'){
-					++p;
-				}
-				
-				ASSERT(p >= start)
-				std::string line(reinterpret_cast<const char*>(start), size_t(p - start));
-				if(p == &*buf.end()){
-					--p;
-				}
-				
-				const std::string ns("nameserver ");
-				
-				size_t nsStart = line.find(ns);
-				if(nsStart != 0){
-					continue;
+					c.numBytes += n;
+					if(c.numBytes == c.buf.size()){
+						if(c.buf.size() == 2){
+							size_t len = ting::util::Deserialize16BE(&c.buf[0]);
+							if(len == 0){
+								failed = true;
+							}else{
+								c.buf.resize(2 + len);
+							}
+						}else{
+							received = true;
+						}
+					}
 				}
-				
-				size_t ipStart = nsStart + ns.size();
-				
-				size_t ipEnd = line.find_first_not_of(":.0123456789", ipStart);//IPv6 address may contain ':'
-				
-				std::string ipstr = line.substr(ipStart, ipEnd - ipStart);
-				
-				TRACE(<< "dns ipstr = " << ipstr << std::endl)
-				
-				try{
-					this->dns = ting::net::IPAddress(ipstr.c_str(), 53);
-					return;
-				}catch(...){}
 			}
-#else
-			TRACE(<< "InitDNS(): don't know how to get DNS IP on this OS" << std::endl)
-#endif
 		}catch(...){
+			failed = true;
+		}
+		
+		if(!failed && !received){
+			return;
+		}
+		
+		this->CloseTCP(c);
+		
+		if(received){
+			//NOTE: buffer is not used by anything else until the next StartTCP() which can only be called from within the lookup thread
+			this->ProcessReply(ting::Buffer<const std::uint8_t>(&c.buf[2], c.buf.size() - 2), ting::net::IPAddress(), true);
+			return;
+		}
+		
+		TRACE(<< "DNS request over TCP failed" << std::endl)
+		if(q->numSent < this->MaxSends(q)){
+			this->Resend(q);
+		}else{
+			this->QueryDone(q, ting::net::HostNameResolver::DNS_ERROR, std::vector<HostNameResolver::Record>());
 		}
-		this->dns = ting::net::IPAddress(std::uint32_t(0), 0);
 	}
 	
-	
 	void Run(){
 		TRACE(<< "DNS lookup thread started" << std::endl)
 		
@@ -710,7 +2240,7 @@ private:
 		
 		this->InitDNS();
 		
-		TRACE(<< "this->dns.host = " << this->dns.host.ToString() << std::endl)
+		TRACE(<< "number of name servers = " << this->nameServers.size() << std::endl)
 		
 		{
 			std::lock_guard<decltype(dns::mutex)> mutexGuard(dns::mutex);//mutex is needed because socket opening may fail and we will have to set isExiting flag which should be protected by mutex
@@ -741,52 +2271,18 @@ private:
 				if(this->socket.CanRead()){
 					TRACE(<< "can read" << std::endl)
 					try{
-						std::array<std::uint8_t, 512> buf;//RFC 1035 limits DNS request UDP packet size to 512 bytes. So, no need to allocate bigger buffer.
+						std::array<std::uint8_t, DUDPPayloadSize> buf;//bigger replies are not sent by name server over UDP, since this size is advertised with EDNS
 						ting::net::IPAddress address;
-						size_t ret = this->socket.Recv(buf, address);
 						
-						ASSERT(ret != 0)
-						ASSERT(ret <= buf.size())
-						if(ret >= 13){//at least there should be standard header and host name, otherwise ignore received UDP packet
-							std::uint16_t id = ting::util::Deserialize16BE(&*buf.begin());
-							
-							T_IdIter i = this->idMap.find(id);
-							if(i != this->idMap.end()){
-								ASSERT(id == i->second->id)
-								
-								//check by host name also
-								const std::uint8_t* p = &*buf.begin() + 12;//start of the host name
-								std::string host = dns::ParseHostNameFromDNSPacket(p, &*buf.end());
-								
-								if(host == i->second->hostName){
-									ParseResult res = this->ParseReplyFromDNS(i->second, ting::Buffer<std::uint8_t>(&*buf.begin(), ret));
-									
-									if(res.result == ting::net::HostNameResolver::NO_SUCH_HOST && i->second->recordType == D_DNSRecordAAAA){
-										//try getting record type A
-										TRACE(<< "no record AAAA found, trying to get record type A" << std::endl)
-										
-										i->second->recordType = D_DNSRecordA;
-										
-										//add to send list
-										ASSERT(i->second->sendIter == this->sendList.end())
-										try{
-											this->sendList.push_back(i->second);
-											i->second->sendIter = --this->sendList.end();
-											if(this->sendList.size() == 1){//if need to switch to wait for writing mode
-												this->StartSending();
-											}
-										}catch(...){
-											//failed adding to sending list, report error
-											std::unique_ptr<dns::Resolver> r = this->RemoveResolver(i->second->hnr);
-											this->CallCallback(r.operator->(), ting::net::HostNameResolver::ERROR);
-										}										
-									}else{
-										std::unique_ptr<dns::Resolver> r = this->RemoveResolver(i->second->hnr);
-										//call callback
-										this->CallCallback(r.operator->(), res.result, res.host);
-									}
-								}
+						//read several replies at once, so that they do not accumulate in the socket buffer and get dropped under load
+						for(unsigned n = 0; n != DMaxRepliesPerIteration; ++n){
+							size_t ret = this->socket.Recv(buf, address);
+							if(ret == 0){
+								break;//no more replies
 							}
+							
+							ASSERT(ret <= buf.size())
+							this->ProcessReply(ting::Buffer<const std::uint8_t>(&*buf.begin(), ret), address, false);
 						}
 					}catch(ting::net::Exc&){
 						this->isExiting = true;
@@ -794,42 +2290,74 @@ private:
 						break;//exit thread
 					}
 				}
+				
+				for(auto& c : this->tcpConnections){
+					this->ProcessTCP(c);
+				}
 
 //				TRACE(<< "this->sendList.size() = " << (this->sendList.size()) << std::endl)
 //Workaround for strange bug on Win32 (reproduced on WinXP at least).
 //For some reason waiting for WRITE on UDP socket does not work. It hangs in the
 //Wait() method until timeout is hit. So, just try to send data to the socket without waiting for WRITE.
 #if M_OS == M_OS_WINDOWS
-				if(this->sendList.size() != 0)
+				if(this->sendList.IsLinked())
 #else
 				if(this->socket.CanWrite())
 #endif
 				{
 					TRACE(<< "can write" << std::endl)
 					//send request
-					ASSERT(this->sendList.size() > 0)
+					ASSERT(this->sendList.IsLinked())
 					
 					try{
-						while(this->sendList.size() != 0){
-							dns::Resolver* r = this->sendList.front();
-							if(r->dns.host.IPv4Host() == 0){
-								r->dns = this->dns;
+						while(this->sendList.IsLinked()){
+							//NOTE: mutex is unlocked while calling callbacks, so configuration can change during the loop
+							if(this->configVersion != dns::configVersion){
+								TRACE(<< "name servers configuration changed, reloading" << std::endl)
+								this->InitDNS();
+							}
+							
+							dns::Query* q = static_cast<dns::Query*>(this->sendList.next);
+							
+							if(q->checkCache){
+								q->checkCache = false;
+								dns::Cache::Value value;
+								if(dns::FindLocally(*q->r, q->recordType, value)){
+									q->Unlink();
+									
+									this->QueryDone(q, value.result, std::move(value.records));
+									continue;
+								}
 							}
+							
+							bool useConfiguredServers = q->r->dns.host.IPv4Host() == 0;
 
-							if(r->dns.host.IsValid()){
-								if(!this->SendRequestToDNS(r)){
+							if(useConfiguredServers ? this->nameServers.size() != 0 : q->r->dns.host.IsValid()){
+								unsigned server = useConfiguredServers ? this->ChooseNameServer(q) : DMaxNameServers;
+								
+								if(!this->SendRequestToDNS(q, useConfiguredServers ? this->nameServers[server].address : q->r->dns)){
 									TRACE(<< "request not sent" << std::endl)
 									break;//socket is not ready for sending, go out of requests sending loop.
 								}
 								TRACE(<< "request sent" << std::endl)
-								r->sendIter = this->sendList.end();//end() value will indicate that the request has already been sent
-								this->sendList.pop_front();
+								q->Unlink();//not linked query is the one which has already been sent
+								
+								this->UpdateTicks();
+								
+								++q->numSent;
+								q->lastServer = server;
+								if(useConfiguredServers){
+									q->sentTicks[server] = this->ticks;
+								}
+								
+								//schedule sending to the next name server in case this one does not reply in time
+								if(q->numSent < this->MaxSends(q)){
+									this->UnscheduleAttempt(q);
+									this->timers.Add(&q->attemptTimer, this->ticks + this->AttemptDelay(server));
+								}
 							}else{
-								std::unique_ptr<dns::Resolver> removedResolver = this->RemoveResolver(r->hnr);
-								ASSERT(removedResolver)
-
 								//Notify about error. OnCompleted_ts() does not throw any exceptions, so no worries about that.
-								this->CallCallback(removedResolver.operator->(), HostNameResolver::ERROR, 0);
+								this->CallCallback(this->RemoveResolver(q->r), HostNameResolver::ERROR);
 							}
 						}
 					}catch(ting::net::Exc& DEBUG_CODE(e)){
@@ -839,58 +2367,51 @@ private:
 						break;//exit thread
 					}
 					
-					if(this->sendList.size() == 0){
+					if(!this->sendList.IsLinked()){
 						//move socket to waiting for READ condition only
 						this->waitSet.Change(this->socket, ting::Waitable::READ);
 						TRACE(<< "socket wait mode changed to read only" << std::endl)
 					}
 				}
 				
-				std::uint32_t curTime = ting::timer::GetTicks();
-				{//check if time has warped around and it is necessary to swap time maps
-					bool isFirstHalf = curTime < (std::uint32_t(-1) / 2);
-					if(isFirstHalf && !this->lastTicksInFirstHalf){
-						//Time warped.
-						//Timeout all requests from first time map
-						while(this->timeMap1->size() != 0){
-							std::unique_ptr<dns::Resolver> r = this->RemoveResolver(this->timeMap1->begin()->second->hnr);
-							ASSERT(r)
-
-							//Notify about timeout. OnCompleted_ts() does not throw any exceptions, so no worries about that.
-							this->CallCallback(r.operator->(), HostNameResolver::TIMEOUT, 0);
-						}
-						
-						ASSERT(this->timeMap1->size() == 0)
-						std::swap(this->timeMap1, this->timeMap2);
-					}
-					this->lastTicksInFirstHalf = isFirstHalf;
-				}
+				this->UpdateTicks();
+				this->timers.Advance(this->ticks);
 				
-				while(this->timeMap1->size() != 0){
-					if(this->timeMap1->begin()->first > curTime){
-						break;
+				while(dns::Timer* t = this->timers.PopExpired()){
+					if(!t->q){
+						//timeout, addresses received so far are reported
+						this->Complete(t->r, true);
+						continue;
+					}
+					
+					//send next attempt for the query which was not replied in time
+					dns::Query* q = t->q;
+					
+					//name server did not reply in time, consider it slow
+					if(q->lastServer < this->nameServers.size()){
+						std::uint32_t& rtt = this->nameServers[q->lastServer].rtt;
+						rtt = std::min(2 * rtt, this->attemptTimeout);
 					}
 					
-					//timeout
-					std::unique_ptr<dns::Resolver> r = this->RemoveResolver(this->timeMap1->begin()->second->hnr);
-					ASSERT(r)
+					if(q->IsLinked()){
+						continue;//already in send list
+					}
 					
-					//Notify about timeout. OnCompleted_ts() does not throw any exceptions, so no worries about that.
-					this->CallCallback(r.operator->(), HostNameResolver::TIMEOUT, 0);
+					try{
+						this->AddToSendList(q);
+					}catch(...){
+						this->CallCallback(this->RemoveResolver(q->r), HostNameResolver::ERROR);
+					}
 				}
 				
-				if(this->resolversMap.size() == 0){
+				if(this->numActive == 0){
 					this->isExiting = true;
 					break;//exit thread
 				}
 				
-				ASSERT(this->timeMap1->size() > 0)
-				ASSERT(this->timeMap1->begin()->first > curTime)
-				
-//				TRACE(<< "DNS thread: curTime = " << curTime << std::endl)
-//				TRACE(<< "DNS thread: this->timeMap1->begin()->first = " << (this->timeMap1->begin()->first) << std::endl)
-				
-				timeout = this->timeMap1->begin()->first - curTime;
+				//NOTE: ticks could be updated from Resolve_ts() while callbacks were called
+				std::uint64_t nextTicks = this->timers.NextAdvanceTicks();
+				timeout = nextTicks > this->ticks ? std::uint32_t(std::min(nextTicks - this->ticks, std::uint64_t(std::uint32_t(-1)))) : 0;
 			}
 			
 			//Make sure that ting::GetTicks is called at least 4 times per full time warp around cycle.
@@ -900,7 +2421,7 @@ private:
 //For some reason waiting for WRITE on UDP socket does not work. It hangs in the
 //Wait() method until timeout is hit. So, just check every 100ms if it is OK to write to UDP socket.
 #if M_OS == M_OS_WINDOWS
-			if(this->sendList.size() > 0){
+			if(this->sendList.IsLinked()){
 				ting::util::ClampTop(timeout, std::uint32_t(100));
 			}
 #endif
@@ -919,6 +2440,15 @@ private:
 			}			
 		}//~while(!this->quitFlag)
 		
+		{
+			std::lock_guard<decltype(this->mutex)> mutexGuard(this->mutex);
+			for(auto& c : this->tcpConnections){
+				if(c.socket){
+					this->CloseTCP(c);
+				}
+			}
+		}
+		
 		this->waitSet.Remove(this->socket);
 		this->waitSet.Remove(this->queue);
 		TRACE(<< "DNS lookup thread stopped" << std::endl)
@@ -948,8 +2478,7 @@ HostNameResolver::~HostNameResolver(){
 	if(dns::thread){
 		std::lock_guard<decltype(dns::thread->mutex)> mutexGuard(dns::thread->mutex);
 		
-		dns::T_ResolversIter i = dns::thread->resolversMap.find(this);
-		if(i != dns::thread->resolversMap.end()){
+		if(dns::thread->FindResolver(this->slot, this)){
 			ASSERT_INFO_ALWAYS(false, "trying to destroy the HostNameResolver object while DNS lookup request is in progress, call HostNameResolver::Cancel_ts() first.")
 		}
 	}
@@ -958,7 +2487,7 @@ HostNameResolver::~HostNameResolver(){
 
 
 
-void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t timeoutMillis, const ting::net::IPAddress& dnsIP){
+void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t timeoutMillis, const ting::net::IPAddress& dnsIP, E_Mode mode){
 //	TRACE(<< "HostNameResolver::Resolve_ts(): enter" << std::endl)
 	
 	ASSERT(ting::net::Lib::IsCreated())
@@ -967,6 +2496,62 @@ void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t tim
 		throw DomainNameTooLongExc();
 	}
 	
+	bool ipv6Supported;
+	
+#if M_OS == M_OS_WINDOWS
+	//check OS version, if WinXP then use only record A, since ting does not support IPv6 on WinXP
+	{
+		OSVERSIONINFO osvi;
+		memset(&osvi, 0, sizeof(osvi));
+		osvi.dwOSVersionInfoSize = sizeof(osvi);
+
+		GetVersionEx(&osvi); //TODO: GetVersionEx() is deprecated, replace with VerifyVersionInfo()
+
+		ipv6Supported = osvi.dwMajorVersion > 5;
+	}
+#else
+	ipv6Supported = true;
+#endif
+	
+	std::shared_ptr<const dns::SearchList> searchList = dns::GetSearchList();
+	
+	if(dns::synchronousCacheHits){
+		dns::Resolver r;
+		r.Init(this, hostName, dnsIP, mode, ipv6Supported, false, searchList);
+		
+		bool allFound = true;
+		for(unsigned k = 0; k != r.numQueries; ++k){
+			dns::Query& q = r.queries[k];
+			dns::Cache::Value value;
+			if(!dns::FindLocally(r, q.recordType, value)){
+				allFound = false;
+				break;
+			}
+			q.isDone = true;
+			q.result = value.result;
+			q.records = std::move(value.records);
+		}
+		
+		std::vector<Record> records;
+		E_Result result = allFound ? dns::CombineResults(r, false, records) : ERROR;
+		
+		//if there are other names to try then the lookup continues asynchronously
+		if(allFound && (result != NO_SUCH_HOST || !r.NextName())){
+			{
+				std::lock_guard<decltype(dns::mutex)> mutexGuard(dns::mutex);
+				if(dns::thread){
+					std::lock_guard<decltype(dns::thread->mutex)> mutexGuard(dns::thread->mutex);
+					if(dns::thread->FindResolver(this->slot, this)){
+						throw AlreadyInProgressExc();
+					}
+				}
+			}
+			
+			this->OnCompletedWithRecords_ts(result, records);
+			return;
+		}
+	}
+	
 	std::lock_guard<decltype(dns::mutex)> mutexGuard(dns::mutex);
 	
 	bool needStartTheThread = false;
@@ -979,7 +2564,7 @@ void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t tim
 		std::lock_guard<decltype(dns::thread->mutex)> mutexGuard(dns::thread->mutex);
 		
 		//check if already in progress
-		if(dns::thread->resolversMap.find(this) != dns::thread->resolversMap.end()){
+		if(dns::thread->FindResolver(this->slot, this)){
 			throw AlreadyInProgressExc();
 		}
 
@@ -995,80 +2580,36 @@ void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t tim
 	
 	ASSERT(dns::thread)
 	
-	std::unique_ptr<dns::Resolver> r(new dns::Resolver());
-	r->hnr = this;
-	r->hostName = hostName;
-	r->dns = dnsIP;
-	
-#if M_OS == M_OS_WINDOWS
-	//check OS version, if WinXP then start from record A, since ting does not support IPv6 on WinXP
-	{
-		OSVERSIONINFO osvi;
-		memset(&osvi, 0, sizeof(osvi));
-		osvi.dwOSVersionInfoSize = sizeof(osvi);
-
-		GetVersionEx(&osvi); //TODO: GetVersionEx() is deprecated, replace with VerifyVersionInfo()
-
-		if(osvi.dwMajorVersion > 5){
-			r->recordType = D_DNSRecordAAAA;//start with IPv6 first
-		}else{
-			r->recordType = D_DNSRecordA;
-		}
-	}
-#else
-	r->recordType = D_DNSRecordAAAA;//start with IPv6 first
-#endif
-	
 	std::lock_guard<decltype(dns::thread->mutex)> mutexGuard2(dns::thread->mutex);
 	
-	//Find free ID, it will throw TooMuchRequestsExc if there are no free IDs
-	{
-		r->id = dns::thread->FindFreeId();
-		std::pair<dns::T_IdIter, bool> res =
-				dns::thread->idMap.insert(std::pair<std::uint16_t, dns::Resolver*>(r->id, r.operator->()));
-		ASSERT(res.second)
-		r->idIter = res.first;
-	}
+	dns::Resolver& r = dns::thread->AllocateSlot();
 	
-	//calculate time
-	std::uint32_t curTime = ting::timer::GetTicks();
-	{
-		std::uint32_t endTime = curTime + timeoutMillis;
-//		TRACE(<< "HostNameResolver::Resolve_ts(): curTime = " << curTime << std::endl)
-//		TRACE(<< "HostNameResolver::Resolve_ts(): endTime = " << endTime << std::endl)
-		if(endTime < curTime){//if warped around
-			r->timeMap = dns::thread->timeMap2;
-		}else{
-			r->timeMap = dns::thread->timeMap1;
+	//in case of error RemoveResolver() will undo everything
+	try{
+		r.Init(this, hostName, dnsIP, mode, ipv6Supported, !dns::synchronousCacheHits, std::move(searchList));
+		
+		//Find free IDs, it will throw TooMuchRequestsExc if there are no free IDs
+		for(unsigned k = 0; k != r.numQueries; ++k){
+			dns::thread->AllocateId(&r.queries[k]);
 		}
-		try{
-			r->timeMapIter = r->timeMap->insert(std::pair<std::uint32_t, dns::Resolver*>(endTime, r.operator->()));
-		}catch(...){
-			dns::thread->idMap.erase(r->idIter);
-			throw;
+		
+		dns::thread->UpdateTicks();
+		dns::thread->SetTimeout(&r, timeoutMillis);
+		
+		//add queries to send queue
+		bool wasSendListEmpty = !dns::thread->sendList.IsLinked();
+		for(unsigned k = 0; k != r.numQueries; ++k){
+			r.queries[k].LinkBefore(&dns::thread->sendList);
 		}
-	}
-	
-	//add resolver to send queue
-	try{
-		dns::thread->sendList.push_back(r.operator->());
-	}catch(...){
-		r->timeMap->erase(r->timeMapIter);
-		dns::thread->idMap.erase(r->idIter);
-		throw;
-	}
-	r->sendIter = --dns::thread->sendList.end();
-	
-	//insert the resolver to main resolvers map
-	try{
-		dns::thread->resolversMap[this] = std::move(r);
-	
+		
 		//If there was no send requests in the list, send the message to the thread to switch
 		//socket to wait for sending mode.
-		if(dns::thread->sendList.size() == 1){
-			std::unique_ptr<dns::LookupThread>& t = dns::thread;
+		if(wasSendListEmpty){
+			//NOTE: capture the thread object itself, not the dns::thread pointer, since by the time the message is
+			//      handled dns::thread may already point to the new thread object, not yet ready for that.
+			dns::LookupThread* t = dns::thread.get();
 			dns::thread->PushMessage(
-					[&t](){
+					[t](){
 						t->StartSending();
 					}
 				);
@@ -1076,46 +2617,69 @@ void HostNameResolver::Resolve_ts(const std::string& hostName, std::uint32_t tim
 
 		//Start the thread if we created the new one.
 		if(needStartTheThread){
-			dns::thread->lastTicksInFirstHalf = curTime < (std::uint32_t(-1) / 2);
 			dns::thread->Start();
 			dns::thread->isExiting = false;//thread has just started, clear the exiting flag
 			TRACE(<< "HostNameResolver::Resolve_ts(): thread started" << std::endl)
 		}
 	}catch(...){
-		dns::thread->resolversMap.erase(this);
-		dns::thread->sendList.pop_back();
-		r->timeMap->erase(r->timeMapIter);
-		dns::thread->idMap.erase(r->idIter);
+		dns::thread->RemoveResolver(&r);
 		throw;
 	}
+	
+	this->slot = r.slot;
+}
+
+
+
+void HostNameResolver::OnCompletedWithRecords_ts(E_Result result, const std::vector<Record>& records)NOEXCEPT{
+	this->OnCompleted_ts(result, records.size() == 0 ? IPAddress::Host(0, 0, 0, 0) : records.front().ip);
 }
 
 
 
 bool HostNameResolver::Cancel_ts()NOEXCEPT{
-	std::lock_guard<decltype(dns::mutex)> mutexGuard(dns::mutex);
-	
-	if(!dns::thread){
-		return false;
-	}
+	std::shared_ptr<std::mutex> completedMutex;
 	
-	std::lock_guard<decltype(dns::thread->mutex)> mutexGuard2(dns::thread->mutex);
-	
-	bool ret = bool(dns::thread->RemoveResolver(this));
-	
-	if(dns::thread->resolversMap.size() == 0){
-		dns::thread->PushPreallocatedQuitMessage();
+	{
+		std::lock_guard<decltype(dns::mutex)> mutexGuard(dns::mutex);
+		
+		if(!dns::thread){
+			return false;
+		}
+		
+		std::lock_guard<decltype(dns::thread->mutex)> mutexGuard2(dns::thread->mutex);
+		
+		bool ret = false;
+		if(dns::Resolver* r = dns::thread->FindResolver(this->slot, this)){
+			dns::thread->RemoveResolver(r);
+			ret = true;
+		}
+		
+		if(dns::thread->numActive == 0){
+			//The thread will exit upon the quit message, so mark it as exiting right away,
+			//otherwise the lookup started right after this would be added to the thread which is about to exit.
+			dns::thread->isExiting = true;
+			dns::thread->PushPreallocatedQuitMessage();
+		}
+		
+		if(ret){
+			return true;
+		}
+		
+		//Callback is called with the completedMutex locked, which is locked before the thread mutex is unlocked,
+		//so if the callback for this resolver is pending, the mutex is already locked at this point.
+		completedMutex = dns::thread->completedMutex;
 	}
 	
-	if(!ret){
-		//Make sure the callback has finished if it is in process of calling the callback.
-		//Because upon calling the callback the resolver object is already removed from all the lists and maps
-		//and if 'ret' is false then it is possible that the resolver is in process of calling the callback.
-		//To do that, lock and unlock the mutex.
-		std::lock_guard<decltype(dns::thread->completedMutex)> mutexGuard(dns::thread->completedMutex);
-	}
+	//Make sure the callback has finished if it is in process of calling the callback.
+	//Because upon calling the callback the resolver object is already removed from all the lists and maps
+	//and if 'ret' is false then it is possible that the resolver is in process of calling the callback.
+	//To do that, lock and unlock the mutex.
+	//NOTE: the mutex is locked after dns::mutex is released, because the callback may start
+	//      another lookup with Resolve_ts() which locks dns::mutex, that would be a deadlock.
+	std::lock_guard<std::mutex> mutexGuard(*completedMutex);
 	
-	return ret;
+	return false;
 }
 
 
@@ -1128,8 +2692,90 @@ void HostNameResolver::CleanUp(){
 		dns::thread->PushPreallocatedQuitMessage();
 		dns::thread->Join();
 
-		ASSERT_INFO(dns::thread->resolversMap.size() == 0, "There are active DNS requests upon Sockets library de-initialization, all active DNS requests must be canceled before that.")
+		ASSERT_INFO(dns::thread->numActive == 0, "There are active DNS requests upon Sockets library de-initialization, all active DNS requests must be canceled before that.")
 
 		dns::thread.reset();
 	}
 }
+
+
+
+//static
+HostNameResolver::CacheStats HostNameResolver::GetCacheStats_ts(){
+	return dns::Cache::Inst().Stats();
+}
+
+
+
+//static
+void HostNameResolver::ClearCache_ts(){
+	dns::Cache::Inst().Clear();
+}
+
+
+
+//static
+void HostNameResolver::AdvanceCacheClock_ts(std::uint64_t millis){
+	dns::Cache::Inst().AdvanceClock(millis);
+}
+
+
+
+//static
+void HostNameResolver::SetCacheTTLLimits_ts(std::uint32_t minSeconds, std::uint32_t maxSeconds){
+	dns::Cache::Inst().SetTTLLimits(minSeconds, maxSeconds);
+}
+
+
+
+//static
+void HostNameResolver::SetSynchronousCacheHits_ts(bool synchronous){
+	dns::synchronousCacheHits = synchronous;
+}
+
+
+
+//static
+void HostNameResolver::SetNameServers_ts(const std::vector<IPAddress>& servers, std::uint32_t attemptTimeoutMillis, unsigned attempts, bool rotate){
+	std::unique_ptr<dns::Config> c;
+	if(servers.size() != 0){
+		c = std::unique_ptr<dns::Config>(new dns::Config());
+		for(auto& s : servers){
+			if(c->nameServers.size() == dns::DMaxNameServers){
+				break;
+			}
+			c->nameServers.push_back(s);
+		}
+		c->attemptTimeout = attemptTimeoutMillis;
+		c->attempts = std::max(attempts, 1u);
+		c->rotate = rotate;
+	}
+	
+	std::lock_guard<decltype(dns::configMutex)> lock(dns::configMutex);
+	dns::userConfig = std::move(c);
+	++dns::configVersion;//running lookup thread will reload the configuration
+}
+
+
+
+//static
+void HostNameResolver::SetSearchDomains_ts(const std::vector<std::string>& domains, unsigned ndots){
+	std::shared_ptr<dns::SearchList> l;
+	if(domains.size() != 0){
+		l = std::make_shared<dns::SearchList>();
+		for(auto& d : domains){
+			l->AddDomain(d);
+		}
+		l->ndots = ndots;
+	}
+	
+	std::lock_guard<decltype(dns::configMutex)> lock(dns::configMutex);
+	dns::userSearchList = std::move(l);
+}
+
+
+
+//static
+void HostNameResolver::SetHostsFile_ts(const std::string& path){
+	dns::HostsFile::Inst().SetPath(path);
+}
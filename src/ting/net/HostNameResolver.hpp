@@ -32,6 +32,7 @@ THE SOFTWARE. */
 
 
 #include <string>
+#include <vector>
 
 #include "../types.hpp"
 
@@ -54,15 +55,24 @@ class Lib;
  * @brief Class for resolving IP-address of the host by its domain name.
  * This class allows asynchronous DNS lookup.
  * One has to derive his/her own class from this class to override the
- * OnCompleted_ts() method which will be called upon the DNS lookup operation has finished.
+ * OnCompleted_ts() or OnCompletedWithRecords_ts() method which will be called upon the DNS lookup operation has finished.
+ * Queries are sent over UDP with EDNS0 advertising bigger payload size, if the reply is still truncated
+ * the query is repeated over TCP.
+ * Before querying name servers the host name is looked up in the hosts file and in the DNS cache.
+ * Host names which are not fully qualified are tried with search domains appended, see SetSearchDomains_ts().
  */
 class HostNameResolver{
 	//no copying
 	HostNameResolver(const HostNameResolver&);
 	HostNameResolver& operator=(const HostNameResolver&);
 	
+	//index of the lookup in the table of the DNS lookup thread
+	std::uint32_t slot;
+	
 public:
-	inline HostNameResolver(){}
+	inline HostNameResolver() :
+			slot(std::uint32_t(-1))
+	{}
 	
 	virtual ~HostNameResolver();
 	
@@ -98,6 +108,25 @@ public:
 		{}
 	};
 	
+	/**
+	 * @brief Enumeration of address families to resolve.
+	 */
+	enum E_Mode{
+		/**
+		 * @brief Request IPv6 addresses, if there are none then request IPv4 addresses.
+		 */
+		IPV6_OR_IPV4,
+		
+		/**
+		 * @brief Request IPv6 and IPv4 addresses concurrently.
+		 * Addresses of both families are reported, interleaved starting from IPv6 address,
+		 * so that the connection can be attempted to addresses of both families in turn, as described in RFC 8305 (Happy Eyeballs).
+		 * After addresses of one family are received the addresses of the other family are waited for
+		 * at most 50 milliseconds (resolution delay).
+		 */
+		IPV6_AND_IPV4
+	};
+	
 	/**
 	 * @brief Start asynchronous IP-address resolving.
 	 * The method is thread-safe.
@@ -105,6 +134,7 @@ public:
      * @param timeoutMillis - timeout for waiting for DNS server response in milliseconds.
 	 * @param dnsIP - IP-address of the DNS to use for host name resolving. The default value is invalid IP-address
 	 *                in which case the DNS IP-address will be retrieved from underlying OS.
+	 * @param mode - address families to resolve.
 	 * @throw DomainNameTooLongExc when supplied for resolution domain name is too long.
 	 * @throw TooMuchRequestsExc when there are too much active DNS lookup requests are in progress, no resources for another one.
 	 * @throw AlreadyInProgressExc when DNS lookup operation served by this resolver object is already in progress.
@@ -112,7 +142,8 @@ public:
 	void Resolve_ts(
 			const std::string& hostName,
 			std::uint32_t timeoutMillis = 20000,
-			const ting::net::IPAddress& dnsIP = ting::net::IPAddress(ting::net::IPAddress::Host(0), 0)
+			const ting::net::IPAddress& dnsIP = ting::net::IPAddress(ting::net::IPAddress::Host(0), 0),
+			E_Mode mode = IPV6_OR_IPV4
 		);
 	
 	/**
@@ -163,15 +194,146 @@ public:
 		ERROR
 	};
 	
+	/**
+	 * @brief Resolved address.
+	 */
+	struct Record{
+		/**
+		 * @brief IP-address.
+		 */
+		IPAddress::Host ip;
+		
+		/**
+		 * @brief Time to live in seconds.
+		 * Time during which the address can be used without resolving the host name again.
+		 */
+		std::uint32_t ttl;
+	};
+	
 	/**
 	 * @brief callback method called upon DNS lookup operation has finished.
 	 * Note, that the method has to be thread-safe.
+	 * Override this method if only one IP-address is needed.
 	 * @param result - the result of DNS lookup operation.
 	 * @param ip - resolved IP-address. This value can later be used to create the
 	 *             ting::net::IPAddress object.
 	 */
-	virtual void OnCompleted_ts(E_Result result, IPAddress::Host ip)NOEXCEPT = 0;
+	virtual void OnCompleted_ts(E_Result result, IPAddress::Host ip)NOEXCEPT{}
 	
+	/**
+	 * @brief callback method called upon DNS lookup operation has finished.
+	 * Note, that the method has to be thread-safe.
+	 * Override this method to get all resolved IP-addresses. Default implementation
+	 * calls OnCompleted_ts() with the first address.
+	 * If lookup has timed out after some addresses were received, e.g. addresses of only one family in
+	 * IPV6_AND_IPV4 mode, then these addresses are reported with OK result.
+	 * @param result - the result of DNS lookup operation.
+	 * @param records - resolved IP-addresses, in the order they were received from DNS server. Empty if result is not OK.
+	 */
+	virtual void OnCompletedWithRecords_ts(E_Result result, const std::vector<Record>& records)NOEXCEPT;
+
+	/**
+	 * @brief DNS cache statistics.
+	 * Hits and misses are counted per lookup of a (host name, record type) pair.
+	 */
+	struct CacheStats{
+		size_t hits;
+		size_t misses;
+		size_t numEntries;
+	};
+
+	/**
+	 * @brief Get DNS cache statistics.
+	 * The method is thread-safe.
+	 * @return current statistics of the process-wide DNS cache.
+	 */
+	static CacheStats GetCacheStats_ts();
+
+	/**
+	 * @brief Remove all entries from the DNS cache.
+	 * The method is thread-safe.
+	 * Statistics counters are not reset.
+	 */
+	static void ClearCache_ts();
+
+	/**
+	 * @brief Advance the clock used for expiration of DNS cache entries.
+	 * Cached entries expire as if the given time has passed. Intended for testing.
+	 * The method is thread-safe.
+	 * @param millis - number of milliseconds to advance the clock by.
+	 */
+	static void AdvanceCacheClock_ts(std::uint64_t millis);
+
+	/**
+	 * @brief Set limits for time to live of DNS cache entries.
+	 * Successful answers are cached for the time given by TTL of the DNS records,
+	 * negative answers (no such host) are cached for the time given by SOA record of the reply
+	 * according to RFC 2308. These values are clamped to the given limits.
+	 * By default the limits are 0 and 86400 seconds (one day). Setting maximum to 0 disables caching.
+	 * The method is thread-safe.
+	 * @param minSeconds - minimum time to live in seconds.
+	 * @param maxSeconds - maximum time to live in seconds, values bigger than 2000000 are clamped to 2000000.
+	 */
+	static void SetCacheTTLLimits_ts(std::uint32_t minSeconds, std::uint32_t maxSeconds);
+
+	/**
+	 * @brief Set the way lookups served from DNS cache are completed.
+	 * By default, the OnCompleted_ts() is called from the DNS lookup thread for the cached results,
+	 * in the same way as for the results received from the network, only without sending any requests.
+	 * If synchronous completion is enabled, then the OnCompleted_ts() is called right from within the
+	 * Resolve_ts() method when the result is found in the DNS cache.
+	 * The method is thread-safe.
+	 * @param synchronous - whether to complete lookups served from cache synchronously.
+	 */
+	static void SetSynchronousCacheHits_ts(bool synchronous);
+
+	/**
+	 * @brief Set DNS servers to use.
+	 * By default, the DNS servers and options are taken from the OS configuration, e.g. from
+	 * 'nameserver' and 'options timeout:n attempts:n rotate' lines of /etc/resolv.conf on Linux.
+	 * This method overrides the OS configuration.
+	 * Up to 3 servers are used. The query is sent to the server with the smallest measured round trip time first,
+	 * if it does not reply within the time which depends on its round trip time, but does not exceed the attempt timeout,
+	 * the query is sent to the next server, while still waiting for reply from the previous one.
+	 * First valid reply is taken. Servers which do not reply in time are considered slow and are tried after others.
+	 * The method is thread-safe.
+	 * @param servers - DNS servers to use. If empty, the OS configuration is used.
+	 * @param attemptTimeoutMillis - maximal time to wait for reply from one server before trying the next one.
+	 * @param attempts - number of rounds of trying all servers.
+	 * @param rotate - if true, the first server to send query to is chosen in round-robin manner, to spread the load among servers.
+	 */
+	static void SetNameServers_ts(const std::vector<IPAddress>& servers, std::uint32_t attemptTimeoutMillis = 5000, unsigned attempts = 2, bool rotate = false);
+
+	/**
+	 * @brief Set search domains.
+	 * By default, the search domains are taken from 'search' or 'domain' and 'options ndots:n' lines of /etc/resolv.conf,
+	 * the file is re-read when it changes.
+	 * This method overrides the OS configuration.
+	 * The host name with less than 'ndots' dots is tried with each of the search domains appended first and then as is.
+	 * The host name with at least 'ndots' dots is tried as is first and then with search domains appended.
+	 * Next name is tried only if the name server reports that there is no such host, all tries are within the lookup timeout.
+	 * Host name with trailing dot is fully qualified and is tried only as is.
+	 * Search domains are only used when lookup is done via configured name servers, i.e. DNS IP-address is not given to Resolve_ts().
+	 * Up to 6 search domains are used.
+	 * The method is thread-safe.
+	 * @param domains - search domains. If empty, the OS configuration is used.
+	 * @param ndots - minimal number of dots in the host name to try it as is first.
+	 */
+	static void SetSearchDomains_ts(const std::vector<std::string>& domains, unsigned ndots = 1);
+
+	/**
+	 * @brief Set hosts file.
+	 * Host names are looked up in the hosts file before querying name servers, by default it is /etc/hosts,
+	 * on Windows it is %SystemRoot%\System32\drivers\etc\hosts.
+	 * The file is indexed in memory and is reloaded when its modification time or size changes,
+	 * it is checked for changes not more often than once per second.
+	 * If the host name is found in the file, then the name servers are not queried, the resolved records have zero TTL.
+	 * Hosts file is only used when lookup is done via configured name servers, i.e. DNS IP-address is not given to Resolve_ts().
+	 * The method is thread-safe.
+	 * @param path - path to the hosts file. If empty, the default hosts file is used.
+	 */
+	static void SetHostsFile_ts(const std::string& path);
+
 private:
 	friend class ting::net::Lib;
 	static void CleanUp();
@@ -22,21 +22,12 @@ THE SOFTWARE. */
 
 // Home page: http://ting.googlecode.com
 
-
-#include <sstream>
+#include <cstring>
+#include <array>
 
 #include "IPAddress.hpp"
 
 #include "../config.hpp"
-#include "../Buffer.hpp"
-
-#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
-#	include <arpa/inet.h>
-#elif M_OS == M_OS_WINDOWS
-#	include <Ws2tcpip.h>
-#else
-#	error "Unknown OS"
-#endif
 
 
 
@@ -58,10 +49,226 @@ bool IsIPv4String(const char* ip){
 	return false;
 }
 
+
+
+bool IsDecDigit(char c)NOEXCEPT{
+	return '0' <= c && c <= '9';
+}
+
+
+
+//returns -1 if not a hexadecimal digit
+int HexDigitValue(char c)NOEXCEPT{
+	if('0' <= c && c <= '9'){
+		return c - '0';
+	}
+	if('a' <= c && c <= 'f'){
+		return c - 'a' + 10;
+	}
+	if('A' <= c && c <= 'F'){
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+
+
+//Parse dotted decimal IPv4 address occupying whole range [p, end).
+bool ParseDottedDecimal(const char* p, const char* end, std::uint32_t& out)NOEXCEPT{
+	std::uint32_t ret = 0;
+	for(unsigned i = 0; i != 4; ++i){
+		if(i != 0){
+			if(p == end || *p != '.'){
+				return false;
+			}
+			++p;
+		}
+		
+		const char* start = p;
+		std::uint32_t v = 0;
+		for(; p != end && IsDecDigit(*p); ++p){
+			if(p - start == 3){
+				return false;
+			}
+			v = v * 10 + std::uint32_t(*p - '0');
+		}
+		
+		if(p == start || v > 0xff){
+			return false;
+		}
+		
+		//leading zeros are not allowed, same as with inet_pton()
+		if(*start == '0' && p - start != 1){
+			return false;
+		}
+		
+		ret = (ret << 8) | v;
+	}
+	
+	if(p != end){
+		return false;
+	}
+	
+	out = ret;
+	return true;
+}
+
+
+
+//Parse IPv6 address occupying whole range [p, end) into 8 16-bit numbers.
+bool ParseHexGroups(const char* p, const char* end, std::uint16_t (&groups)[8])NOEXCEPT{
+	unsigned n = 0;//number of parsed groups
+	bool hasGap = false;//whether there is "::"
+	unsigned gap = 0;//index of the group where "::" is
+	
+	if(p != end && *p == ':'){
+		if(end - p < 2 || p[1] != ':'){
+			return false;
+		}
+		hasGap = true;
+		p += 2;
+	}
+	
+	while(p != end){
+		const char* start = p;
+		std::uint32_t v = 0;
+		for(int d; p != end && (d = HexDigitValue(*p)) >= 0; ++p){
+			v = (v << 4) | std::uint32_t(d);
+		}
+		
+		if(p != end && *p == '.'){
+			//IPv4 address in place of last two groups
+			std::uint32_t ipv4;
+			if(n > 6 || !ParseDottedDecimal(start, end, ipv4)){
+				return false;
+			}
+			groups[n++] = std::uint16_t(ipv4 >> 16);
+			groups[n++] = std::uint16_t(ipv4 & 0xffff);
+			break;
+		}
+		
+		if(p == start || p - start > 4 || n == 8){
+			return false;
+		}
+		groups[n++] = std::uint16_t(v);
+		
+		if(p == end){
+			break;
+		}
+		
+		if(*p != ':'){
+			return false;
+		}
+		++p;
+		
+		if(p == end){
+			return false;//single trailing colon
+		}
+		
+		if(*p == ':'){
+			if(hasGap){
+				return false;//only one "::" is allowed
+			}
+			hasGap = true;
+			gap = n;
+			++p;
+		}
+	}
+	
+	if(!hasGap){
+		return n == 8;
+	}
+	
+	//"::" stands for at least one zero group
+	if(n == 8){
+		return false;
+	}
+	
+	//move groups which go after "::" to the end
+	unsigned numAfterGap = n - gap;
+	for(unsigned i = 0; i != numAfterGap; ++i){
+		groups[7 - i] = groups[n - 1 - i];
+	}
+	for(unsigned i = gap; i != 8 - numAfterGap; ++i){
+		groups[i] = 0;
+	}
+	
+	return true;
+}
+
+
+
+char* FormatDec(char* p, std::uint32_t v)NOEXCEPT{
+	ASSERT(v <= 0xff)
+	if(v >= 100){
+		*p++ = char('0' + v / 100);
+	}
+	if(v >= 10){
+		*p++ = char('0' + (v / 10) % 10);
+	}
+	*p++ = char('0' + v % 10);
+	return p;
+}
+
+
+
+char* FormatHex(char* p, std::uint32_t v)NOEXCEPT{
+	ASSERT(v <= 0xffff)
+	const char* digits = "0123456789abcdef";
+	
+	//skip leading zeros, but write at least one digit
+	unsigned shift = 12;
+	for(; shift != 0 && ((v >> shift) & 0xf) == 0; shift -= 4){}
+	
+	for(;; shift -= 4){
+		*p++ = digits[(v >> shift) & 0xf];
+		if(shift == 0){
+			break;
+		}
+	}
+	return p;
+}
+
 }//~namespace
 
 
 
+//static
+bool IPAddress::Host::TryParse(ting::Buffer<const char> str, Host& out)NOEXCEPT{
+	for(auto c : str){
+		if(c == ':'){
+			return Host::TryParseIPv6(str, out);
+		}
+	}
+	return Host::TryParseIPv4(str, out);
+}
+
+
+
+//static
+bool IPAddress::Host::TryParseIPv4(ting::Buffer<const char> str, Host& out)NOEXCEPT{
+	std::uint32_t h;
+	if(!ParseDottedDecimal(str.begin(), str.end(), h)){
+		return false;
+	}
+	out.Init(h);
+	return true;
+}
+
+
+
+//static
+bool IPAddress::Host::TryParseIPv6(ting::Buffer<const char> str, Host& out)NOEXCEPT{
+	std::uint16_t g[8];
+	if(!ParseHexGroups(str.begin(), str.end(), g)){
+		return false;
+	}
+	out.Init(g[0], g[1], g[2], g[3], g[4], g[5], g[6], g[7]);
+	return true;
+}
+
+
+
 //static
 IPAddress::Host IPAddress::Host::Parse(const char* ip){
 	if(IsIPv4String(ip)){
@@ -75,116 +282,22 @@ IPAddress::Host IPAddress::Host::Parse(const char* ip){
 
 //static
 IPAddress::Host IPAddress::Host::ParseIPv4(const char* ip){
-	sockaddr_in a;
-	
-#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
-	int res = inet_pton(
-			AF_INET,
-			ip,
-			&a.sin_addr
-		);
-	
-	if(res != 1){
-		throw BadIPHostFormatExc();
-	}
-
-#elif M_OS == M_OS_WINDOWS
-	INT len = sizeof(a);
-	INT res = WSAStringToAddress(
-			const_cast<char*>(ip), //NOTE: when compiling in MS Visual Studio, set "Use multi-byte character set" in project properties to avoid usage of wchar_t
-			AF_INET,
-			NULL,
-			reinterpret_cast<sockaddr*>(&a),
-			&len
-		);
-	if(res != 0){
+	Host ret;
+	if(!Host::TryParseIPv4(ting::Buffer<const char>(ip, strlen(ip)), ret)){
 		throw BadIPHostFormatExc();
 	}
-#else
-#	error "Unknown OS"
-#endif
-	
-	return Host(ntohl(a.sin_addr.s_addr));
+	return ret;
 }
 
 
 
 //static
 IPAddress::Host IPAddress::Host::ParseIPv6(const char* ip){
-#if M_OS == M_OS_WINDOWS
-	sockaddr_in6 aa;
-	in6_addr& a = aa.sin6_addr;
-#else
-	in6_addr a;
-#endif	
-		
-#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
-	int res = inet_pton(
-			AF_INET6,
-			ip,
-			&a
-		);
-	
-	if(res != 1){
-		throw BadIPHostFormatExc();
-	}
-
-#elif M_OS == M_OS_WINDOWS
-	INT len = sizeof(aa);
-	INT res = WSAStringToAddress(
-			const_cast<char*>(ip),
-			AF_INET6,
-			NULL,
-			reinterpret_cast<sockaddr*>(&aa),
-			&len
-		);
-	if(res != 0){
-		TRACE(<< "IPAddress::Host::ParseIPv6(): WSAStringToAddress() failed, error = " <<  WSAGetLastError()<< ". Maybe IPv6 protocol is not installed in the Windows system, WSAStringToAddress() only supports IPv6 if it is installed." << std::endl)
+	Host ret;
+	if(!Host::TryParseIPv6(ting::Buffer<const char>(ip, strlen(ip)), ret)){
 		throw BadIPHostFormatExc();
 	}
-#else
-#	error "Unknown OS"
-#endif
-
-#if M_OS == M_OS_MACOSX || M_OS == M_OS_WINDOWS || (M_OS == M_OS_LINUX && M_OS_NAME == M_OS_NAME_ANDROID)
-	return Host(
-			a.s6_addr[0],
-			a.s6_addr[1],
-			a.s6_addr[2],
-			a.s6_addr[3],
-			a.s6_addr[4],
-			a.s6_addr[5],
-			a.s6_addr[6],
-			a.s6_addr[7],
-			a.s6_addr[8],
-			a.s6_addr[9],
-			a.s6_addr[10],
-			a.s6_addr[11],
-			a.s6_addr[12],
-			a.s6_addr[13],
-			a.s6_addr[14],
-			a.s6_addr[15]
-		);
-#else
-	return Host(
-			a.__in6_u.__u6_addr8[0],
-			a.__in6_u.__u6_addr8[1],
-			a.__in6_u.__u6_addr8[2],
-			a.__in6_u.__u6_addr8[3],
-			a.__in6_u.__u6_addr8[4],
-			a.__in6_u.__u6_addr8[5],
-			a.__in6_u.__u6_addr8[6],
-			a.__in6_u.__u6_addr8[7],
-			a.__in6_u.__u6_addr8[8],
-			a.__in6_u.__u6_addr8[9],
-			a.__in6_u.__u6_addr8[10],
-			a.__in6_u.__u6_addr8[11],
-			a.__in6_u.__u6_addr8[12],
-			a.__in6_u.__u6_addr8[13],
-			a.__in6_u.__u6_addr8[14],
-			a.__in6_u.__u6_addr8[15]
-		);
-#endif
+	return ret;
 }
 
 
@@ -202,44 +315,32 @@ IPAddress::IPAddress(const char* ip){
 	}
 	
 	if(*ip == '['){//IPv6 with port
-		std::array<char, (4 * 6 + 6 + (3 * 4 + 3) + 1)> buf;
-		
 		++ip;
 		
-		char* dst;
-		for(dst = &*buf.begin(); *ip != ']'; ++dst, ++ip){
-			if(*ip == 0 || !ting::Buffer<char>(buf).Overlaps(dst + 1)){
+		const char* end = ip;
+		for(; *end != ']'; ++end){
+			if(*end == 0){
 				throw BadIPAddressFormatExc();
 			}
-			
-			*dst = *ip;
 		}
 		
-		ASSERT(ting::Buffer<char>(buf).Overlaps(dst))
-		*dst = 0;//null-terminate
-				
-		this->host = Host::ParseIPv6(&*buf.begin());
+		if(!Host::TryParseIPv6(ting::Buffer<const char>(ip, end - ip), this->host)){
+			throw Host::BadIPHostFormatExc();
+		}
 		
-		++ip;//move to port ':' separator
+		ip = end + 1;//move to port ':' separator
 	}else{
 		//IPv4 or IPv6 without port
 		
 		if(IsIPv4String(ip)){
-			std::array<char, (3 * 4 + 3 + 1)> buf;
+			const char* end = ip;
+			for(; *end != ':' && *end != 0; ++end){}
 			
-			char* dst;
-			for(dst = &*buf.begin(); *ip != ':' && *ip != 0; ++dst, ++ip){
-				if(!ting::Buffer<char>(buf).Overlaps(dst + 1)){
-					throw BadIPAddressFormatExc();
-				}
-
-				*dst = *ip;
+			if(!Host::TryParseIPv4(ting::Buffer<const char>(ip, end - ip), this->host)){
+				throw Host::BadIPHostFormatExc();
 			}
-
-			ASSERT(ting::Buffer<char>(buf).Overlaps(dst))
-			*dst = 0;//null-terminate
-
-			this->host = Host::ParseIPv4(&*buf.begin());
+			
+			ip = end;
 		}else{
 			//IPv6 without port
 			this->host = Host::ParseIPv6(ip);
@@ -262,27 +363,15 @@ IPAddress::IPAddress(const char* ip){
 	
 	++ip;
 	
-	//move to the end of port number, maximum 5 digits.
-	for(unsigned i = 0; '0' <= *ip && *ip <= '9' && i < 5; ++i, ++ip){
-	}
-	if('0' <= *ip && *ip <= '9'){//if still have one more digit
-//		TRACE(<< "still have one more digit" << std::endl)
-		throw ting::net::IPAddress::BadIPAddressFormatExc();
-	}
-	
-	--ip;
-	
+	//maximum 5 digits
 	std::uint32_t port = 0;
-	
-	for(unsigned i = 0; *ip != ':'; ++i, --ip){
-		std::uint32_t pow = 1;
-		for(unsigned j = 0; j < i; ++j){
-			pow *= 10;
+	unsigned numDigits = 0;
+	for(; IsDecDigit(*ip); ++ip, ++numDigits){
+		if(numDigits == 5){
+//			TRACE(<< "still have one more digit" << std::endl)
+			throw ting::net::IPAddress::BadIPAddressFormatExc();
 		}
-	
-		ASSERT('0' <= *ip && *ip <= '9')
-		
-		port += (*ip - '0') * pow;
+		port = port * 10 + std::uint32_t(*ip - '0');
 	}
 	
 	if(port > 0xffff){
@@ -295,27 +384,69 @@ IPAddress::IPAddress(const char* ip){
 
 
 
-std::string IPAddress::Host::ToString()const{
-	std::stringstream ss;
+size_t IPAddress::Host::Format(ting::Buffer<char> out)const NOEXCEPT{
+	std::array<char, DMaxStringLength> buf;
+	char* p = &*buf.begin();
+	
 	if(this->IsIPv4()){
 		for(unsigned i = 4;;){
 			--i;
-			ss << (((this->IPv4Host()) >> (8 * i)) & 0xff);
+			p = FormatDec(p, (this->IPv4Host() >> (8 * i)) & 0xff);
 			if(i == 0){
 				break;
 			}
-			ss << '.';
+			*p++ = '.';
 		}
 	}else{
-		ss << std::hex;
-		for(unsigned i = 8;;){
-			--i;
-			ss << ((this->host[(i * 2) / 4] >> (16 * (i % 2))) & 0xffff);
-			if(i == 0){
-				break;
+		std::uint32_t g[8];
+		for(unsigned i = 0; i != 8; ++i){
+			g[i] = (this->host[i / 2] >> (i % 2 == 0 ? 16 : 0)) & 0xffff;
+		}
+		
+		//find first longest run of zero groups, runs of one group are not compressed (RFC 5952)
+		unsigned gapStart = 8, gapLength = 1;
+		for(unsigned i = 0; i != 8;){
+			if(g[i] != 0){
+				++i;
+				continue;
+			}
+			unsigned j = i + 1;
+			for(; j != 8 && g[j] == 0; ++j){}
+			if(j - i > gapLength){
+				gapStart = i;
+				gapLength = j - i;
+			}
+			i = j;
+		}
+		
+		for(unsigned i = 0; i != 8;){
+			if(i == gapStart){
+				*p++ = ':';
+				*p++ = ':';
+				i += gapLength;
+				continue;
+			}
+			if(i != 0 && i != gapStart + gapLength){
+				*p++ = ':';
 			}
-			ss << ':';
+			p = FormatHex(p, g[i]);
+			++i;
 		}
 	}
-	return ss.str();
+	
+	size_t len = p - &*buf.begin();
+	ASSERT(len <= DMaxStringLength)
+	if(len > out.size()){
+		return 0;
+	}
+	memcpy(out.begin(), &*buf.begin(), len);
+	return len;
+}
+
+
+
+std::string IPAddress::Host::ToString()const{
+	std::array<char, DMaxStringLength> buf;
+	size_t len = this->Format(buf);
+	return std::string(&*buf.begin(), len);
 }
@@ -32,10 +32,12 @@ THE SOFTWARE. */
 
 
 #include <string>
+#include <functional>
 
 #include "Exc.hpp"
 
 #include "../types.hpp"
+#include "../Buffer.hpp"
 
 
 
@@ -240,6 +242,41 @@ public:
          */
 		static Host ParseIPv6(const char* ip);
 		
+		/**
+		 * @brief Parse host from string without throwing exceptions.
+		 * The whole string should be either IPv4 or IPv6 address.
+		 * Parsing does not allocate memory and does not use system calls, so it is suitable for parsing
+		 * large amounts of addresses, e.g. from logs.
+		 * @param str - string containing IP host address, not necessarily null-terminated.
+		 * @param out - Host object to put parsed address to, it is not changed if parsing fails.
+		 * @return true if the string contains well formed IP host address.
+		 * @return false otherwise.
+		 */
+		static bool TryParse(ting::Buffer<const char> str, Host& out)NOEXCEPT;
+		
+		/**
+		 * @brief Parse IPv4 host from string without throwing exceptions.
+		 * IPv4 address should consist of 4 decimal numbers separated by dots, leading zeros are not allowed,
+		 * same as accepted by inet_pton().
+		 * @param str - string containing IPv4 host address, not necessarily null-terminated.
+		 * @param out - Host object to put parsed address to, it is not changed if parsing fails.
+		 * @return true if the string contains well formed IPv4 host address.
+		 * @return false otherwise.
+		 */
+		static bool TryParseIPv4(ting::Buffer<const char> str, Host& out)NOEXCEPT;
+		
+		/**
+		 * @brief Parse IPv6 host from string without throwing exceptions.
+		 * IPv6 address should be in one of the forms described in RFC 4291 section 2.2,
+		 * i.e. 8 hexadecimal numbers separated by colons, with optional "::" in place of zero numbers
+		 * and optional IPv4 address in place of last 2 numbers.
+		 * @param str - string containing IPv6 host address, not necessarily null-terminated.
+		 * @param out - Host object to put parsed address to, it is not changed if parsing fails.
+		 * @return true if the string contains well formed IPv6 host address.
+		 * @return false otherwise.
+		 */
+		static bool TryParseIPv6(ting::Buffer<const char> str, Host& out)NOEXCEPT;
+		
 		/**
 		 * @brief Check if it is a IPv4 mapped to IPv6.
          * @return true if this Host object holds IPv4 address mapped to IPv6.
@@ -278,7 +315,7 @@ public:
          * @return true if two IP addresses are identical.
 		 * @return false otherwise.
          */
-		inline bool operator==(const Host& h){
+		inline bool operator==(const Host& h)const NOEXCEPT{
 			return (this->host[0] == h.host[0])
 					&& (this->host[1] == h.host[1])
 					&& (this->host[2] == h.host[2])
@@ -286,8 +323,64 @@ public:
 				;
 		}
 		
+		inline bool operator!=(const Host& h)const NOEXCEPT{
+			return !this->operator==(h);
+		}
+		
+		/**
+		 * @brief Compare two IP host addresses.
+		 * Addresses are ordered as 128 bit numbers, so all IPv4 mapped addresses go together.
+		 * @param h - IP host address to compare this IP host address to.
+		 * @return true if this address goes before the given one.
+		 * @return false otherwise.
+		 */
+		inline bool operator<(const Host& h)const NOEXCEPT{
+			for(unsigned i = 0; i != 4; ++i){
+				if(this->host[i] != h.host[i]){
+					return this->host[i] < h.host[i];
+				}
+			}
+			return false;
+		}
+		
+		/**
+		 * @brief Calculate hash value of the IP host address.
+		 * The quads are combined with a multiplication and the result is mixed with multiply-xorshift rounds,
+		 * so all bits of the address affect all bits of the hash value, including the lower ones used by hash tables.
+		 * Different IPv4 mapped addresses always have different hash values.
+		 * @param seed - value to combine with the address, e.g. port number.
+		 * @return 64 bit hash value.
+		 */
+		inline std::uint64_t Hash(std::uint64_t seed = 0)const NOEXCEPT{
+			std::uint64_t h = (((std::uint64_t(this->host[0]) << 32) | this->host[1]) ^ seed) * 0x9e3779b97f4a7c15ULL;
+			h ^= (std::uint64_t(this->host[2]) << 32) | this->host[3];
+			h ^= h >> 32;
+			h *= 0xd6e8feb86659fd93ULL;
+			h ^= h >> 32;
+			h *= 0xd6e8feb86659fd93ULL;
+			h ^= h >> 32;
+			return h;
+		}
+		
+		/**
+		 * @brief Maximal length of the string produced by Format().
+		 */
+		static const size_t DMaxStringLength = 39;
+		
+		/**
+		 * @brief Write text representation of this IP host address to the buffer.
+		 * IPv4 mapped to IPv6 addresses are written as IPv4 address, e.g. "127.0.0.1".
+		 * IPv6 addresses are written in canonical form described in RFC 5952, e.g. "2001:db8::1".
+		 * No memory is allocated, the string is not null-terminated.
+		 * @param out - buffer to write to.
+		 * @return number of characters written.
+		 * @return 0 if the buffer is too small, buffer of DMaxStringLength characters is always enough.
+		 */
+		size_t Format(ting::Buffer<char> out)const NOEXCEPT;
+		
 		/**
 		 * @brief Convert this IP host address to string.
+		 * See Format() for the format description.
          * @return String representing an IP host address.
          */
 		std::string ToString()const;
@@ -363,12 +456,57 @@ public:
 	 * @return true if hosts and ports of the two IP addresses are equal accordingly.
 	 * @return false otherwise.
 	 */
-	inline bool operator==(const IPAddress& ip){
+	inline bool operator==(const IPAddress& ip)const NOEXCEPT{
 		return (this->host == ip.host) && (this->port == ip.port);
 	}
+	
+	inline bool operator!=(const IPAddress& ip)const NOEXCEPT{
+		return !this->operator==(ip);
+	}
+	
+	/**
+	 * @brief Compare two IP addresses.
+	 * Addresses are ordered by host, addresses with same host are ordered by port.
+	 * @param ip - IP address to compare with.
+	 * @return true if this address goes before the given one.
+	 * @return false otherwise.
+	 */
+	inline bool operator<(const IPAddress& ip)const NOEXCEPT{
+		if(this->host != ip.host){
+			return this->host < ip.host;
+		}
+		return this->port < ip.port;
+	}
+	
+	/**
+	 * @brief Calculate hash value of the IP address.
+	 * See Host::Hash().
+	 * @return 64 bit hash value.
+	 */
+	inline std::uint64_t Hash()const NOEXCEPT{
+		return this->host.Hash(this->port);
+	}
 };//~class IPAddress
 
 
 
 }//~namespace
 }//~namespace
+
+
+
+namespace std{
+
+template <> struct hash<ting::net::IPAddress::Host>{
+	size_t operator()(const ting::net::IPAddress::Host& h)const NOEXCEPT{
+		return size_t(h.Hash());
+	}
+};
+
+template <> struct hash<ting::net::IPAddress>{
+	size_t operator()(const ting::net::IPAddress& ip)const NOEXCEPT{
+		return size_t(ip.Hash());
+	}
+};
+
+}//~namespace
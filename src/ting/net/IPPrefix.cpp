@@ -0,0 +1,138 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+#include <cstring>
+#include <array>
+
+#include "IPPrefix.hpp"
+
+
+
+using namespace ting::net;
+
+
+
+IPPrefix::IPPrefix(const IPAddress::Host& host, unsigned length)NOEXCEPT :
+		length(length)
+{
+	ASSERT(length <= 128)
+	
+	ToQuads(host, this->quads);
+	
+	for(unsigned i = 0; i != 4; ++i){
+		unsigned bits = length > i * 32 ? std::min(length - i * 32, 32u) : 0;
+		this->quads[i] &= bits == 0 ? 0 : (std::uint32_t(-1) << (32 - bits));
+	}
+}
+
+
+
+//static
+bool IPPrefix::TryParse(ting::Buffer<const char> str, IPPrefix& out)NOEXCEPT{
+	const char* slash = str.begin();
+	for(; slash != str.end() && *slash != '/'; ++slash){}
+	
+	IPAddress::Host h;
+	if(!IPAddress::Host::TryParse(ting::Buffer<const char>(str.begin(), slash - str.begin()), h)){
+		return false;
+	}
+	
+	//IPv4 address should be written in dotted decimal form to be treated as IPv4 prefix
+	bool isIPv4 = std::find(str.begin(), slash, ':') == slash;
+	unsigned maxLength = isIPv4 ? 32 : 128;
+	
+	unsigned length = maxLength;
+	
+	if(slash != str.end()){
+		const char* p = slash + 1;
+		if(p == str.end()){
+			return false;
+		}
+		
+		//leading zeros are not allowed
+		if(*p == '0' && str.end() - p != 1){
+			return false;
+		}
+		
+		length = 0;
+		for(; p != str.end(); ++p){
+			if(*p < '0' || '9' < *p){
+				return false;
+			}
+			length = length * 10 + unsigned(*p - '0');
+			if(length > maxLength){
+				return false;
+			}
+		}
+	}
+	
+	out = IPPrefix(h, isIPv4 ? DIPv4MappedLength + length : length);
+	return true;
+}
+
+
+
+//static
+IPPrefix IPPrefix::Parse(const char* str){
+	IPPrefix ret;
+	if(!IPPrefix::TryParse(ting::Buffer<const char>(str, strlen(str)), ret)){
+		throw BadIPPrefixFormatExc();
+	}
+	return ret;
+}
+
+
+
+size_t IPPrefix::Format(ting::Buffer<char> out)const NOEXCEPT{
+	std::array<char, DMaxStringLength> buf;
+	
+	size_t len = this->Address().Format(buf);
+	ASSERT(len != 0)
+	
+	unsigned l = this->IsIPv4() ? this->IPv4Length() : this->length;
+	
+	buf[len++] = '/';
+	if(l >= 100){
+		buf[len++] = char('0' + l / 100);
+	}
+	if(l >= 10){
+		buf[len++] = char('0' + (l / 10) % 10);
+	}
+	buf[len++] = char('0' + l % 10);
+	
+	ASSERT(len <= DMaxStringLength)
+	if(len > out.size()){
+		return 0;
+	}
+	memcpy(out.begin(), &*buf.begin(), len);
+	return len;
+}
+
+
+
+std::string IPPrefix::ToString()const{
+	std::array<char, DMaxStringLength> buf;
+	size_t len = this->Format(buf);
+	return std::string(&*buf.begin(), len);
+}
@@ -0,0 +1,593 @@
+/* The MIT License:
+
+Copyright (c) 2014 Ivan Gagis <igagis@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE. */
+
+// Home page: http://ting.googlecode.com
+
+
+
+/**
+ * @author Ivan Gagis <igagis@gmail.com>
+ */
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../config.hpp"
+#include "../debug.hpp"
+#include "../Buffer.hpp"
+
+#include "IPAddress.hpp"
+
+
+
+namespace ting{
+namespace net{
+
+
+
+template <class T> class IPPrefixTable;
+
+
+
+/**
+ * @brief IP network prefix.
+ * Prefix is a range of IP host addresses which have the same first Length() bits, e.g. "10.0.0.0/8" or "2001:db8::/32".
+ * As with IPAddress::Host, prefixes are IPv6, IPv4 prefixes are represented as prefixes of IPv4 mapped to IPv6
+ * addresses, i.e. the length of IPv4 prefix is its IPv4 length plus 96.
+ * The bits of the address beyond the prefix length are always zero.
+ */
+class IPPrefix{
+	template <class T> friend class IPPrefixTable;
+	
+	std::uint32_t quads[4];
+	unsigned length;
+	
+	static unsigned CountLeadingZeros(std::uint32_t x)NOEXCEPT{
+		ASSERT(x != 0)
+#if M_COMPILER == M_COMPILER_GCC
+		return unsigned(__builtin_clz(x));
+#else
+		unsigned ret = 0;
+		for(; (x & 0x80000000) == 0; x <<= 1){
+			++ret;
+		}
+		return ret;
+#endif
+	}
+	
+	//number of leading bits which are same in both addresses
+	static unsigned CommonLength(const std::uint32_t (&a)[4], const std::uint32_t (&b)[4])NOEXCEPT{
+		for(unsigned i = 0; i != 4; ++i){
+			if(std::uint32_t x = a[i] ^ b[i]){
+				return i * 32 + CountLeadingZeros(x);
+			}
+		}
+		return 128;
+	}
+	
+	static unsigned Bit(const std::uint32_t (&q)[4], unsigned i)NOEXCEPT{
+		ASSERT(i < 128)
+		return (q[i / 32] >> (31 - i % 32)) & 1;
+	}
+	
+	static void ToQuads(const IPAddress::Host& h, std::uint32_t (&q)[4])NOEXCEPT{
+		q[0] = h.Quad0();
+		q[1] = h.Quad1();
+		q[2] = h.Quad2();
+		q[3] = h.Quad3();
+	}
+	
+	bool Contains(const std::uint32_t (&q)[4])const NOEXCEPT{
+		return CommonLength(this->quads, q) >= this->length;
+	}
+	
+public:
+	/**
+	 * @brief Bad IP prefix format error.
+	 * This exception is thrown when trying to parse an IP prefix from string and
+	 * that string does not contain a valid IP prefix.
+	 */
+	class BadIPPrefixFormatExc : public IPAddress::BadIPAddressFormatExc{
+	public:
+		BadIPPrefixFormatExc(){}
+	};
+	
+	/**
+	 * @brief Length of the prefix of all IPv4 mapped to IPv6 addresses.
+	 */
+	static const unsigned DIPv4MappedLength = 96;
+	
+	/**
+	 * @brief Create prefix of zero length.
+	 * Zero length prefix contains all addresses.
+	 */
+	IPPrefix()NOEXCEPT :
+			quads{0, 0, 0, 0},
+			length(0)
+	{}
+	
+	/**
+	 * @brief Create prefix.
+	 * @param host - IP host address, bits beyond the prefix length are cleared.
+	 * @param length - prefix length in bits, from 0 to 128. For IPv4 prefixes add DIPv4MappedLength to the IPv4 length.
+	 */
+	IPPrefix(const IPAddress::Host& host, unsigned length)NOEXCEPT;
+	
+	/**
+	 * @brief Create IPv4 prefix.
+	 * @param host - IPv4 host address, bits beyond the prefix length are cleared.
+	 * @param length - IPv4 prefix length in bits, from 0 to 32.
+	 * @return IPv4 prefix.
+	 */
+	static IPPrefix IPv4(std::uint32_t host, unsigned length)NOEXCEPT{
+		ASSERT(length <= 32)
+		return IPPrefix(IPAddress::Host(host), DIPv4MappedLength + length);
+	}
+	
+	/**
+	 * @brief Get first address of the prefix.
+	 * @return IP host address with all bits beyond the prefix length set to zero.
+	 */
+	IPAddress::Host Address()const NOEXCEPT{
+		return IPAddress::Host(this->quads[0], this->quads[1], this->quads[2], this->quads[3]);
+	}
+	
+	/**
+	 * @brief Get prefix length.
+	 * @return prefix length in bits, from 0 to 128.
+	 */
+	unsigned Length()const NOEXCEPT{
+		return this->length;
+	}
+	
+	/**
+	 * @brief Check if it is a prefix of IPv4 mapped to IPv6 addresses.
+	 * @return true if all addresses of this prefix are IPv4 mapped to IPv6 addresses.
+	 * @return false otherwise.
+	 */
+	bool IsIPv4()const NOEXCEPT{
+		return this->length >= DIPv4MappedLength && this->Address().IsIPv4();
+	}
+	
+	/**
+	 * @brief Get IPv4 prefix length.
+	 * @return IPv4 prefix length if this is a prefix of IPv4 mapped to IPv6 addresses.
+	 * @return undefined value otherwise.
+	 */
+	unsigned IPv4Length()const NOEXCEPT{
+		return this->length - DIPv4MappedLength;
+	}
+	
+	/**
+	 * @brief Check if IP host address belongs to this prefix.
+	 * @param h - IP host address to check.
+	 * @return true if first Length() bits of the address are same as of this prefix.
+	 * @return false otherwise.
+	 */
+	bool Contains(const IPAddress::Host& h)const NOEXCEPT{
+		std::uint32_t q[4];
+		ToQuads(h, q);
+		return this->Contains(q);
+	}
+	
+	/**
+	 * @brief Check if other prefix is a sub-range of this prefix.
+	 * @param p - prefix to check.
+	 * @return true if all addresses of the given prefix belong to this prefix.
+	 * @return false otherwise.
+	 */
+	bool Contains(const IPPrefix& p)const NOEXCEPT{
+		return p.length >= this->length && this->Contains(p.quads);
+	}
+	
+	bool operator==(const IPPrefix& p)const NOEXCEPT{
+		return this->length == p.length
+				&& this->quads[0] == p.quads[0]
+				&& this->quads[1] == p.quads[1]
+				&& this->quads[2] == p.quads[2]
+				&& this->quads[3] == p.quads[3]
+			;
+	}
+	
+	bool operator!=(const IPPrefix& p)const NOEXCEPT{
+		return !this->operator==(p);
+	}
+	
+	/**
+	 * @brief Compare prefixes.
+	 * Prefixes are ordered by address, prefixes with same address are ordered by length.
+	 * In this order a prefix goes before all its sub-ranges.
+	 * @param p - prefix to compare to.
+	 * @return true if this prefix goes before the given one.
+	 */
+	bool operator<(const IPPrefix& p)const NOEXCEPT{
+		for(unsigned i = 0; i != 4; ++i){
+			if(this->quads[i] != p.quads[i]){
+				return this->quads[i] < p.quads[i];
+			}
+		}
+		return this->length < p.length;
+	}
+	
+	/**
+	 * @brief Parse prefix from string without throwing exceptions.
+	 * The string should be an IP host address, optionally followed by '/' and decimal prefix length,
+	 * e.g. "192.168.0.0/16" or "2001:db8::/32". For IPv4 address the length is IPv4 prefix length.
+	 * If there is no length then the prefix contains only the given address.
+	 * Bits of the address beyond the prefix length are ignored.
+	 * @param str - string containing the prefix, not necessarily null-terminated.
+	 * @param out - object to put parsed prefix to, it is not changed if parsing fails.
+	 * @return true if the string contains well formed prefix.
+	 * @return false otherwise.
+	 */
+	static bool TryParse(ting::Buffer<const char> str, IPPrefix& out)NOEXCEPT;
+	
+	/**
+	 * @brief Parse prefix from string.
+	 * See TryParse() for the format description.
+	 * @param str - null-terminated string containing the prefix.
+	 * @return parsed prefix.
+	 * @throw BadIPPrefixFormatExc if the string does not contain well formed prefix.
+	 */
+	static IPPrefix Parse(const char* str);
+	
+	/**
+	 * @brief Maximal length of the string produced by Format().
+	 */
+	static const size_t DMaxStringLength = IPAddress::Host::DMaxStringLength + 4;
+	
+	/**
+	 * @brief Write text representation of this prefix to the buffer.
+	 * The address is written as by IPAddress::Host::Format(), followed by '/' and the length.
+	 * For IPv4 prefixes the IPv4 length is written. The string is not null-terminated.
+	 * @param out - buffer to write to.
+	 * @return number of characters written.
+	 * @return 0 if the buffer is too small, buffer of DMaxStringLength characters is always enough.
+	 */
+	size_t Format(ting::Buffer<char> out)const NOEXCEPT;
+	
+	/**
+	 * @brief Convert this prefix to string.
+	 * See Format() for the format description.
+	 * @return String representing the prefix.
+	 */
+	std::string ToString()const;
+};
+
+
+
+/**
+ * @brief Longest prefix match table.
+ * Maps IP prefixes to values and finds the value of the longest prefix which contains given IP host address,
+ * e.g. for matching client addresses against access control lists or routes.
+ * The table is a path-compressed binary radix tree: every node has at most two children and
+ * nodes without value are only kept where the paths of the stored prefixes branch, also after removal of prefixes,
+ * so the tree has at most 2 * Size() + 1 nodes and lookup only visits the nodes where the paths branch or end.
+ * Nodes are stored in one array and refer to each other by index, this keeps the tree compact in memory.
+ * IPv4 and IPv6 prefixes can be mixed in one table.
+ * @param T - type of the values, should be default constructible and copyable.
+ */
+template <class T> class IPPrefixTable{
+	struct Node{
+		IPPrefix prefix;
+		
+		std::uint32_t children[2] = {0, 0};//0 if no child, the root node is never a child
+		
+		bool hasValue = false;
+		T value;
+	};
+	
+	//root node with zero length prefix is always present
+	std::vector<Node> nodes;
+	
+	size_t size;
+	
+	std::uint32_t AddNode(const IPPrefix& p){
+		this->nodes.push_back(Node());
+		this->nodes.back().prefix = p;
+		return std::uint32_t(this->nodes.size() - 1);
+	}
+	
+	//replaces child 'c' of the node 'n' with 'r'
+	void ReplaceChild(std::uint32_t n, std::uint32_t c, std::uint32_t r)NOEXCEPT{
+		std::uint32_t (&children)[2] = this->nodes[n].children;
+		ASSERT(children[0] == c || children[1] == c)
+		children[children[0] == c ? 0 : 1] = r;
+	}
+	
+	//Releases the node which is already unlinked from the tree, the last node is moved in its place.
+	void ReleaseNode(std::uint32_t n){
+		ASSERT(n != 0)
+		std::uint32_t last = std::uint32_t(this->nodes.size() - 1);
+		if(n != last){
+			//find parent of the last node to update its reference
+			const IPPrefix& lp = this->nodes[last].prefix;
+			std::uint32_t parent = 0;
+			for(;;){
+				std::uint32_t c = this->nodes[parent].children[IPPrefix::Bit(lp.quads, this->nodes[parent].prefix.length)];
+				ASSERT(c != 0)
+				if(c == last){
+					break;
+				}
+				parent = c;
+			}
+			this->ReplaceChild(parent, last, n);
+			this->nodes[n] = std::move(this->nodes[last]);
+		}
+		this->nodes.pop_back();
+	}
+	
+	//returns index of the node with exactly this prefix, std::uint32_t(-1) if not found
+	std::uint32_t FindNode(const IPPrefix& p)const NOEXCEPT{
+		std::uint32_t n = 0;
+		for(;;){
+			const Node& node = this->nodes[n];
+			if(node.prefix.length >= p.length){
+				return node.prefix == p ? n : std::uint32_t(-1);
+			}
+			n = node.children[IPPrefix::Bit(p.quads, node.prefix.length)];
+			if(n == 0 || !this->nodes[n].prefix.Contains(p)){
+				return std::uint32_t(-1);
+			}
+		}
+	}
+	
+public:
+	/**
+	 * @brief Create empty table.
+	 */
+	IPPrefixTable(){
+		this->Clear();
+	}
+	
+	/**
+	 * @brief Get number of prefixes in the table.
+	 * @return number of prefixes.
+	 */
+	size_t Size()const NOEXCEPT{
+		return this->size;
+	}
+	
+	/**
+	 * @brief Remove all prefixes from the table.
+	 */
+	void Clear(){
+		this->nodes.clear();
+		this->AddNode(IPPrefix());
+		this->size = 0;
+	}
+	
+	/**
+	 * @brief Add prefix to the table.
+	 * If the prefix is already in the table then its value is replaced.
+	 * @param p - prefix to add.
+	 * @param value - value to associate with the prefix.
+	 */
+	void Insert(const IPPrefix& p, const T& value){
+		std::uint32_t n = 0;
+		for(;;){
+			ASSERT(this->nodes[n].prefix.Contains(p))
+			
+			if(this->nodes[n].prefix.length == p.length){
+				//the prefix goes to existing node
+				break;
+			}
+			
+			unsigned b = IPPrefix::Bit(p.quads, this->nodes[n].prefix.length);
+			std::uint32_t c = this->nodes[n].children[b];
+			
+			if(c == 0){
+				std::uint32_t leaf = this->AddNode(p);
+				this->nodes[n].children[b] = leaf;
+				n = leaf;
+				break;
+			}
+			
+			IPPrefix cp = this->nodes[c].prefix;//copy, since adding nodes invalidates references
+			
+			if(cp.Contains(p)){
+				n = c;
+				continue;
+			}
+			
+			unsigned common = std::min(IPPrefix::CommonLength(p.quads, cp.quads), std::min(p.length, cp.length));
+			ASSERT(common < cp.length)
+			
+			if(common == p.length){
+				//new prefix contains the child, insert it between
+				unsigned cb = IPPrefix::Bit(cp.quads, p.length);
+				std::uint32_t middle = this->AddNode(p);
+				this->nodes[middle].children[cb] = c;
+				this->nodes[n].children[b] = middle;
+				n = middle;
+				break;
+			}
+			
+			//new prefix and the child diverge, add fork node with their common prefix
+			unsigned cb = IPPrefix::Bit(cp.quads, common);
+			std::uint32_t fork = this->AddNode(IPPrefix(cp.Address(), common));
+			std::uint32_t leaf = this->AddNode(p);
+			this->nodes[fork].children[cb] = c;
+			this->nodes[fork].children[1 - cb] = leaf;
+			this->nodes[n].children[b] = fork;
+			n = leaf;
+			break;
+		}
+		
+		Node& node = this->nodes[n];
+		if(!node.hasValue){
+			node.hasValue = true;
+			++this->size;
+		}
+		node.value = value;
+	}
+	
+	/**
+	 * @brief Remove prefix from the table.
+	 * Tree nodes which are not needed anymore are removed as well.
+	 * @param p - prefix to remove.
+	 * @return true if the prefix was in the table.
+	 * @return false otherwise.
+	 */
+	bool Remove(const IPPrefix& p){
+		//find the node along with its parent and grandparent, these may need to be removed as well
+		std::uint32_t grandParent = 0, parent = 0, n = 0;
+		for(;;){
+			const Node& node = this->nodes[n];
+			if(node.prefix.length >= p.length){
+				if(node.prefix != p){
+					return false;
+				}
+				break;
+			}
+			std::uint32_t c = node.children[IPPrefix::Bit(p.quads, node.prefix.length)];
+			if(c == 0 || !this->nodes[c].prefix.Contains(p)){
+				return false;
+			}
+			grandParent = parent;
+			parent = n;
+			n = c;
+		}
+		
+		{
+			Node& node = this->nodes[n];
+			if(!node.hasValue){
+				return false;
+			}
+			node.hasValue = false;
+			node.value = T();
+			--this->size;
+		}
+		
+		//root node is always present
+		if(n == 0){
+			return true;
+		}
+		
+		//Node without value is only needed if it has two children. If the node has no children, then
+		//its parent may become a node without value with single child, which is not needed as well.
+		std::uint32_t removed[2];
+		unsigned numRemoved = 0;
+		
+		const std::uint32_t (&children)[2] = this->nodes[n].children;
+		if(children[0] != 0 && children[1] != 0){
+			return true;
+		}else if(children[0] != 0 || children[1] != 0){
+			this->ReplaceChild(parent, n, children[0] != 0 ? children[0] : children[1]);
+			removed[numRemoved++] = n;
+		}else{
+			this->ReplaceChild(parent, n, 0);
+			removed[numRemoved++] = n;
+			
+			const Node& pn = this->nodes[parent];
+			if(parent != 0 && !pn.hasValue){
+				ASSERT((pn.children[0] == 0) != (pn.children[1] == 0))
+				this->ReplaceChild(grandParent, parent, pn.children[0] != 0 ? pn.children[0] : pn.children[1]);
+				removed[numRemoved++] = parent;
+			}
+		}
+		
+		//Release nodes starting from the one with greater index,
+		//so that moving the last node in place of the released one does not move the other one.
+		if(numRemoved == 2 && removed[0] < removed[1]){
+			std::swap(removed[0], removed[1]);
+		}
+		for(unsigned i = 0; i != numRemoved; ++i){
+			this->ReleaseNode(removed[i]);
+		}
+		
+		return true;
+	}
+	
+	/**
+	 * @brief Find value of exactly the given prefix.
+	 * @param p - prefix to find.
+	 * @return pointer to the value associated with the prefix.
+	 * @return nullptr if there is no such prefix in the table.
+	 */
+	const T* Find(const IPPrefix& p)const NOEXCEPT{
+		std::uint32_t n = this->FindNode(p);
+		if(n == std::uint32_t(-1) || !this->nodes[n].hasValue){
+			return nullptr;
+		}
+		return &this->nodes[n].value;
+	}
+	
+	T* Find(const IPPrefix& p)NOEXCEPT{
+		return const_cast<T*>(static_cast<const IPPrefixTable*>(this)->Find(p));
+	}
+	
+	/**
+	 * @brief Find value of the longest prefix containing the given address.
+	 * @param h - IP host address to look up.
+	 * @param matched - if not nullptr, the matched prefix is stored there.
+	 * @return pointer to the value associated with the longest prefix which contains the address.
+	 * @return nullptr if no prefix of the table contains the address.
+	 */
+	const T* Lookup(const IPAddress::Host& h, IPPrefix* matched = nullptr)const NOEXCEPT{
+		std::uint32_t q[4];
+		IPPrefix::ToQuads(h, q);
+		
+		const Node* best = nullptr;
+		
+		//root node contains all addresses, no need to check it
+		const Node* node = &this->nodes[0];
+		for(;;){
+			if(node->hasValue){
+				best = node;
+			}
+			if(node->prefix.length == 128){
+				break;
+			}
+			std::uint32_t c = node->children[IPPrefix::Bit(q, node->prefix.length)];
+			if(c == 0){
+				break;
+			}
+			node = &this->nodes[c];
+			if(!node->prefix.Contains(q)){
+				break;
+			}
+		}
+		
+		if(!best){
+			return nullptr;
+		}
+		if(matched){
+			*matched = best->prefix;
+		}
+		return &best->value;
+	}
+	
+	T* Lookup(const IPAddress::Host& h, IPPrefix* matched = nullptr)NOEXCEPT{
+		return const_cast<T*>(static_cast<const IPPrefixTable*>(this)->Lookup(h, matched));
+	}
+};
+
+
+
+}//~namespace
+}//~namespace
@@ -266,6 +266,44 @@ size_t TCPSocket::Recv(ting::Buffer<std::uint8_t> buf){
 
 
 
+size_t TCPSocket::Send(ting::RingBuffer& rb){
+	size_t ret = 0;
+	//readable region may consist of two spans if it wraps around the end of the buffer
+	for(unsigned i = 0; i != 2 && !rb.IsEmpty(); ++i){
+		auto span = rb.ReadableSpan();
+		size_t n = this->Send(span);
+		rb.Consume(n);
+		ret += n;
+		if(n != span.size()){
+			break;
+		}
+	}
+	return ret;
+}
+
+
+
+size_t TCPSocket::Recv(ting::RingBuffer& rb){
+	if(rb.IsFull()){
+		throw net::Exc("TCPSocket::Recv(): ring buffer is full");
+	}
+	
+	size_t ret = 0;
+	//writable region may consist of two spans if it wraps around the end of the buffer
+	for(unsigned i = 0; i != 2 && !rb.IsFull(); ++i){
+		auto span = rb.WritableSpan();
+		size_t n = this->Recv(span);
+		rb.Commit(n);
+		ret += n;
+		if(n != span.size()){
+			break;
+		}
+	}
+	return ret;
+}
+
+
+
 namespace{
 
 IPAddress CreateIPAddressFromSockaddrStorage(const sockaddr_storage& addr){
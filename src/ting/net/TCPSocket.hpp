@@ -31,6 +31,8 @@ THE SOFTWARE. */
 #pragma once
 
 
+#include "../RingBuffer.hpp"
+
 #include "Socket.hpp"
 #include "IPAddress.hpp"
 
@@ -114,6 +116,31 @@ public:
 	 */
 	size_t Recv(ting::Buffer<std::uint8_t> buf);
 
+
+
+	/**
+	 * @brief Send data from ring buffer.
+	 * Sends data from the readable region of the ring buffer and consumes the sent bytes.
+	 * Data is passed to the system directly from the ring buffer memory, without copying.
+	 * @param rb - ring buffer holding the data to send.
+	 * @return the number of bytes actually sent.
+	 */
+	size_t Send(ting::RingBuffer& rb);
+
+
+
+	/**
+	 * @brief Receive data into ring buffer.
+	 * Receives data directly into the writable region of the ring buffer and commits the received bytes.
+	 * See Recv(ting::Buffer<std::uint8_t>) for details on the return value.
+	 * The ring buffer must not be full, otherwise 0 returned from this method could not be
+	 * distinguished from connection closed by peer.
+	 * @param rb - ring buffer to receive data to.
+	 * @return the number of bytes received.
+	 * @throw ting::net::Exc - if the ring buffer is full.
+	 */
+	size_t Recv(ting::RingBuffer& rb);
+
 	
 	
 	/**
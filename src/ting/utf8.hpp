@@ -31,16 +31,144 @@ THE SOFTWARE. */
 
 #pragma once
 
+#include <cstring>
+#include <iterator>
+
+#include "config.hpp"
 #include "types.hpp"
 #include "Buffer.hpp"
 #include "util.hpp"
 
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) || (M_COMPILER == M_COMPILER_MSVC && (M_CPU == M_CPU_X86_64 || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#	include <emmintrin.h>
+#	define M_UTF8_SSE2
+#endif
+
 
 namespace ting{
 namespace utf8{
 
 
 
+/**
+ * @brief Unicode replacement character.
+ * Used in place of invalid utf-8 sequences.
+ */
+const std::uint32_t DReplacementChar = 0xfffd;
+
+
+namespace impl{
+
+//Decode one character with full validation according to RFC 3629.
+//Reads at most 'avail' bytes and never reads past the first byte which does not continue the sequence,
+//so it is safe to use on null-terminated strings. Returns pointer to the byte following the character.
+//If the sequence is invalid then isValid is set to false and the returned pointer is the end of the maximal
+//subpart of the invalid sequence, i.e. the longest prefix which could start a valid sequence, but at least 1 byte.
+inline const std::uint8_t* DecodeCharImpl(const std::uint8_t* p, size_t avail, std::uint32_t& out, bool& isValid)NOEXCEPT{
+	ASSERT(avail != 0)
+	std::uint8_t b = *p;
+	++p;
+	if(b < 0x80){
+		out = b;
+		isValid = true;
+		return p;
+	}
+	
+	isValid = false;
+	
+	unsigned numTrailing;
+	std::uint8_t lo = 0x80, hi = 0xbf;//allowed range of the second byte
+	std::uint32_t c;
+	if(b < 0xc2){//continuation byte or overlong 2-byte sequence
+		return p;
+	}else if(b < 0xe0){
+		numTrailing = 1;
+		c = b & 0x1f;
+	}else if(b < 0xf0){
+		numTrailing = 2;
+		c = b & 0x0f;
+		if(b == 0xe0){
+			lo = 0xa0;//overlong
+		}else if(b == 0xed){
+			hi = 0x9f;//surrogates
+		}
+	}else if(b < 0xf5){
+		numTrailing = 3;
+		c = b & 0x07;
+		if(b == 0xf0){
+			lo = 0x90;//overlong
+		}else if(b == 0xf4){
+			hi = 0x8f;//above U+10FFFF
+		}
+	}else{
+		return p;
+	}
+	
+	--avail;
+	for(unsigned i = 0; i != numTrailing; ++i, ++p){
+		if(i == avail){//truncated
+			return p;
+		}
+		std::uint8_t t = *p;
+		if(i == 0 ? (t < lo || hi < t) : ((t & 0xc0) != 0x80)){
+			return p;
+		}
+		c = (c << 6) | (t & 0x3f);
+	}
+	out = c;
+	isValid = true;
+	return p;
+}
+
+//Decode one character with full validation.
+//Returns pointer to the next character or nullptr if the sequence is invalid or truncated.
+inline const std::uint8_t* DecodeCharChecked(const std::uint8_t* p, const std::uint8_t* end, std::uint32_t& out)NOEXCEPT{
+	ASSERT(p < end)
+	bool isValid;
+	const std::uint8_t* ret = DecodeCharImpl(p, size_t(end - p), out, isValid);
+	return isValid ? ret : nullptr;
+}
+
+//Decode one character with full validation, each maximal subpart of invalid sequence is decoded as one DReplacementChar.
+//Returns pointer to the next character.
+inline const std::uint8_t* DecodeCharReplacing(const std::uint8_t* p, size_t avail, std::uint32_t& out)NOEXCEPT{
+	bool isValid;
+	const std::uint8_t* ret = DecodeCharImpl(p, avail, out, isValid);
+	if(!isValid){
+		out = DReplacementChar;
+	}
+	return ret;
+}
+
+//Returns number of leading ASCII bytes in the buffer, processed with SIMD where available.
+inline size_t AsciiPrefixLength(const std::uint8_t* p, const std::uint8_t* end)NOEXCEPT{
+	const std::uint8_t* begin = p;
+#if defined(__AVX2__)
+	for(; end - p >= 32; p += 32){
+		if(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))) != 0){
+			break;
+		}
+	}
+#endif
+#if defined(M_UTF8_SSE2)
+	for(; end - p >= 16; p += 16){
+		if(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) != 0){
+			break;
+		}
+	}
+#endif
+	for(; p != end && *p < 0x80; ++p){}
+	return size_t(p - begin);
+}
+
+}//~namespace
+
+
+
 /**
  * @brief Iterator to iterate through utf-8 encoded unicode characters.
  */
@@ -84,37 +212,14 @@ public:
 	 * @brief Prefix increment.
 	 * Move iterator to the next character in the string.
 	 * If iterator points to the end of the string before this operation then the result of this operation is undefined.
+	 * Invalid or truncated sequences are decoded as replacement character U+FFFD, one per maximal subpart
+	 * of the invalid sequence as recommended by the Unicode standard. The iterator never goes past the terminating null byte.
      * @return reference to this iterator object.
      */
 	Iterator& operator++()NOEXCEPT{
-		std::uint8_t b = *this->n;
-//		TRACE(<< "utf8::Iterator::operator++(): b = " << std::hex << unsigned(b) << std::endl)
-		++this->n;
-		if((b & 0x80) == 0){
-			this->c = std::uint32_t(b);
-			return *this;
-		}
-
-//		TRACE(<< "utf8::Iterator::operator++(): *n = " << std::hex << unsigned(*this->n) << std::endl)
-		
-		this->c = (*this->n) & 0x3f;
-//		TRACE(<< "utf8::Iterator::operator++(): initial c = " << std::hex << c << std::endl)
-
-		++this->n;
-
-		unsigned i = 2;
-		for(; (std::uint8_t(b << i) >> 7); ++i, ++this->n){
-//			TRACE(<< "utf8::Iterator::operator++(): std::uint8_t(b << i) = " << std::hex << unsigned(std::uint8_t(b << i)) << std::endl)
-//			TRACE(<< "utf8::Iterator::operator++(): ((b << i) >> 7) = " << std::hex << unsigned(std::uint8_t(b << i) >> 7) << std::endl)
-//			TRACE(<< "utf8::Iterator::operator++(): *n = " << std::hex << unsigned(*this->n) << std::endl)
-			this->c <<= 6;
-//			TRACE(<< "utf8::Iterator::operator++(): c = " << std::hex << c << std::endl)
-			this->c |= (*this->n) & 0x3f;
-//			TRACE(<< "utf8::Iterator::operator++(): c = " << std::hex << c << std::endl)
-		}
-		this->c |= (std::uint32_t(std::uint8_t(b << (i + 1)) >> (i + 1)) << (6 * (i - 1)));
-//		TRACE(<< "utf8::Iterator::operator++(): c = " << std::hex << c << std::endl)
-
+		//the decoder stops at the first byte which does not continue the sequence,
+		//so it never reads past the terminating null byte
+		this->n = impl::DecodeCharReplacing(this->n, 4, this->c);
 		return *this;
 	}
 
@@ -158,6 +263,292 @@ inline size_t FillBuffer(ting::Buffer<std::uint32_t> buf, Iterator& str){
 
 
 
+/**
+ * @brief Calculate number of characters in utf-8 encoded string.
+ * Returns exactly the number of characters produced by Decode(), including the replacement
+ * characters of invalid sequences.
+ * Runs of ASCII characters are counted using SIMD instructions where available.
+ * @param utf8 - utf-8 encoded string.
+ * @return Number of characters.
+ */
+inline size_t DecodedLength(ting::Buffer<const std::uint8_t> utf8)NOEXCEPT{
+	const std::uint8_t* p = utf8.begin();
+	size_t ret = 0;
+	while(p != utf8.end()){
+		size_t n = impl::AsciiPrefixLength(p, utf8.end());
+		p += n;
+		ret += n;
+		
+		for(std::uint32_t c; p != utf8.end() && *p >= 0x80; ++ret){
+			p = impl::DecodeCharReplacing(p, size_t(utf8.end() - p), c);
+		}
+	}
+	return ret;
+}
+
+
+
+/**
+ * @brief Decode utf-8 string to UTF-32.
+ * Decodes as many characters as fits into the output buffer.
+ * Invalid and truncated sequences are decoded as DReplacementChar, same as by Iterator.
+ * Runs of ASCII characters are decoded using SIMD instructions where available.
+ * @param utf8 - utf-8 encoded string.
+ * @param out - buffer to store decoded characters to.
+ * @return Number of characters stored to the output buffer.
+ */
+inline size_t Decode(ting::Buffer<const std::uint8_t> utf8, ting::Buffer<std::uint32_t> out)NOEXCEPT{
+	const std::uint8_t* p = utf8.begin();
+	std::uint32_t* o = out.begin();
+	
+	while(p != utf8.end() && o != out.end()){
+#if defined(__AVX2__)
+		if(utf8.end() - p >= 32 && out.end() - o >= 32){
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+			if(_mm256_movemask_epi8(v) == 0){
+				for(unsigned i = 0; i != 4; ++i){
+					_mm256_storeu_si256(
+							reinterpret_cast<__m256i*>(o + i * 8),
+							_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + i * 8)))
+						);
+				}
+				p += 32;
+				o += 32;
+				continue;
+			}
+		}
+#endif
+#if defined(M_UTF8_SSE2)
+		if(utf8.end() - p >= 16 && out.end() - o >= 16){
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			if(_mm_movemask_epi8(v) == 0){
+				const __m128i zero = _mm_setzero_si128();
+				__m128i lo = _mm_unpacklo_epi8(v, zero);
+				__m128i hi = _mm_unpackhi_epi8(v, zero);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi16(lo, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o + 4), _mm_unpackhi_epi16(lo, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o + 8), _mm_unpacklo_epi16(hi, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o + 12), _mm_unpackhi_epi16(hi, zero));
+				p += 16;
+				o += 16;
+				continue;
+			}
+		}
+#endif
+		//scalar decoding of a block which contains multi-byte sequences
+		const std::uint8_t* blockEnd = utf8.end() - p > 16 ? p + 16 : utf8.end();
+		for(; p < blockEnd && o != out.end(); ++o){
+			p = impl::DecodeCharReplacing(p, size_t(utf8.end() - p), *o);
+		}
+	}
+	
+	return size_t(o - out.begin());
+}
+
+
+
+/**
+ * @brief Validate utf-8 string.
+ * Checks that the string is well-formed utf-8 according to RFC 3629, i.e. there are no
+ * overlong sequences, surrogates, characters above U+10FFFF and truncated sequences.
+ * Runs of ASCII characters are skipped using SIMD instructions where available.
+ * @param utf8 - string to validate.
+ * @return Offset of the first byte of the first invalid sequence.
+ * @return utf8.size() if the string is valid.
+ */
+inline size_t Validate(ting::Buffer<const std::uint8_t> utf8)NOEXCEPT{
+	const std::uint8_t* p = utf8.begin();
+	while(p != utf8.end()){
+		p += impl::AsciiPrefixLength(p, utf8.end());
+		
+		//validate non-ASCII characters until next ASCII one
+		for(std::uint32_t c; p != utf8.end() && *p >= 0x80;){
+			const std::uint8_t* next = impl::DecodeCharChecked(p, utf8.end(), c);
+			if(!next){
+				return size_t(p - utf8.begin());
+			}
+			p = next;
+		}
+	}
+	return utf8.size();
+}
+
+
+
+/**
+ * @brief Result of transcoding.
+ */
+struct TranscodeResult{
+	/**
+	 * @brief Number of input elements consumed.
+	 * If error is true then this is the offset of the invalid input.
+	 */
+	size_t numRead;
+	
+	/**
+	 * @brief Number of output elements produced.
+	 */
+	size_t numWritten;
+	
+	/**
+	 * @brief Indicates that invalid input was encountered.
+	 * If false and numRead is less than input size, then the output buffer was too small.
+	 */
+	bool error;
+};
+
+
+
+/**
+ * @brief Convert utf-8 to UTF-16.
+ * Converts as many characters as fits into the output buffer, stops at the first invalid sequence.
+ * Characters outside of the basic multilingual plane are encoded as surrogate pairs.
+ * Runs of ASCII characters are converted using SIMD instructions where available.
+ * @param utf8 - utf-8 encoded input.
+ * @param out - buffer for UTF-16 output.
+ * @return Result of the conversion.
+ */
+inline TranscodeResult ToUTF16(ting::Buffer<const std::uint8_t> utf8, ting::Buffer<std::uint16_t> out)NOEXCEPT{
+	const std::uint8_t* p = utf8.begin();
+	std::uint16_t* o = out.begin();
+	
+	while(p != utf8.end()){
+#if defined(M_UTF8_SSE2)
+		if(utf8.end() - p >= 16 && out.end() - o >= 16){
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			if(_mm_movemask_epi8(v) == 0){
+				const __m128i zero = _mm_setzero_si128();
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o), _mm_unpacklo_epi8(v, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(o + 8), _mm_unpackhi_epi8(v, zero));
+				p += 16;
+				o += 16;
+				continue;
+			}
+		}
+#endif
+		std::uint32_t c;
+		const std::uint8_t* next = impl::DecodeCharChecked(p, utf8.end(), c);
+		if(!next){
+			return TranscodeResult{size_t(p - utf8.begin()), size_t(o - out.begin()), true};
+		}
+		
+		if(c < 0x10000){
+			if(o == out.end()){
+				break;
+			}
+			*o = std::uint16_t(c);
+			++o;
+		}else{
+			if(out.end() - o < 2){
+				break;
+			}
+			c -= 0x10000;
+			*o = std::uint16_t(0xd800 | (c >> 10));
+			++o;
+			*o = std::uint16_t(0xdc00 | (c & 0x3ff));
+			++o;
+		}
+		p = next;
+	}
+	return TranscodeResult{size_t(p - utf8.begin()), size_t(o - out.begin()), false};
+}
+
+
+
+/**
+ * @brief Convert UTF-32 to utf-8.
+ * Converts as many characters as fits into the output buffer, stops at the first invalid
+ * character, i.e. surrogate or value above U+10FFFF.
+ * Runs of ASCII characters are converted using SIMD instructions where available.
+ * @param utf32 - UTF-32 input.
+ * @param out - buffer for utf-8 output.
+ * @return Result of the conversion.
+ */
+inline TranscodeResult FromUTF32(ting::Buffer<const std::uint32_t> utf32, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	const std::uint32_t* p = utf32.begin();
+	std::uint8_t* o = out.begin();
+	
+	while(p != utf32.end()){
+#if defined(M_UTF8_SSE2)
+		if(utf32.end() - p >= 16 && out.end() - o >= 16){
+			__m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+			__m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+			__m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+			__m128i nonAscii = _mm_and_si128(
+					_mm_or_si128(_mm_or_si128(v0, v1), _mm_or_si128(v2, v3)),
+					_mm_set1_epi32(~0x7f)
+				);
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, _mm_setzero_si128())) == 0xffff){
+				//all values are less than 0x80, so saturating packs do not change them
+				_mm_storeu_si128(
+						reinterpret_cast<__m128i*>(o),
+						_mm_packus_epi16(_mm_packs_epi32(v0, v1), _mm_packs_epi32(v2, v3))
+					);
+				p += 16;
+				o += 16;
+				continue;
+			}
+		}
+#endif
+		std::uint32_t c = *p;
+		if(c < 0x80){
+			if(o == out.end()){
+				break;
+			}
+			*o = std::uint8_t(c);
+			++o;
+		}else if(c < 0x800){
+			if(out.end() - o < 2){
+				break;
+			}
+			o[0] = std::uint8_t(0xc0 | (c >> 6));
+			o[1] = std::uint8_t(0x80 | (c & 0x3f));
+			o += 2;
+		}else if(c < 0x10000){
+			if(c >= 0xd800 && c <= 0xdfff){
+				return TranscodeResult{size_t(p - utf32.begin()), size_t(o - out.begin()), true};
+			}
+			if(out.end() - o < 3){
+				break;
+			}
+			o[0] = std::uint8_t(0xe0 | (c >> 12));
+			o[1] = std::uint8_t(0x80 | ((c >> 6) & 0x3f));
+			o[2] = std::uint8_t(0x80 | (c & 0x3f));
+			o += 3;
+		}else if(c < 0x110000){
+			if(out.end() - o < 4){
+				break;
+			}
+			o[0] = std::uint8_t(0xf0 | (c >> 18));
+			o[1] = std::uint8_t(0x80 | ((c >> 12) & 0x3f));
+			o[2] = std::uint8_t(0x80 | ((c >> 6) & 0x3f));
+			o[3] = std::uint8_t(0x80 | (c & 0x3f));
+			o += 4;
+		}else{
+			return TranscodeResult{size_t(p - utf32.begin()), size_t(o - out.begin()), true};
+		}
+		++p;
+	}
+	return TranscodeResult{size_t(p - utf32.begin()), size_t(o - out.begin()), false};
+}
+
+
+
+/**
+ * @brief Convert utf-8 string to UTF-32.
+ * The output is allocated only once, its size is calculated with DecodedLength().
+ * @param utf8 - utf-8 encoded string.
+ * @return UTF-32 string.
+ */
+inline std::vector<std::uint32_t> ToUTF32(ting::Buffer<const std::uint8_t> utf8){
+	std::vector<std::uint32_t> ret(DecodedLength(utf8));
+	ret.resize(Decode(utf8, ret));
+	return ret;
+}
+
+
+
 //TODO: doxygen
 inline std::vector<std::uint32_t> ToUTF32(Iterator str){
 	std::vector<std::uint32_t> ret;
@@ -169,9 +560,17 @@ inline std::vector<std::uint32_t> ToUTF32(Iterator str){
 
 
 
-//TODO: doxygen
+/**
+ * @brief Convert null-terminated utf-8 string to UTF-32.
+ * Gives same result as ToUTF32(Iterator).
+ * @param str - null-terminated utf-8 encoded string.
+ * @return UTF-32 string.
+ */
 inline std::vector<std::uint32_t> ToUTF32(const char* str){
-	return ToUTF32(Iterator(str));
+	if(!str){
+		return std::vector<std::uint32_t>();
+	}
+	return ToUTF32(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(str), strlen(str)));
 }
 
 
@@ -183,5 +582,200 @@ inline std::vector<std::uint32_t> ToUTF32(const std::string& str){
 
 
 
+/**
+ * @brief Iterator over utf-8 characters in a memory span.
+ * Unlike Iterator, this one is bounded by explicit end of the span and does not treat
+ * zero character as end of string, so it can be used to iterate over strings with embedded null characters.
+ * Invalid sequences are decoded as DReplacementChar, one per maximal subpart of the invalid sequence, same as by Iterator.
+ * Iterator is obtained from Range.
+ */
+class SpanIterator{
+	friend class Range;
+	
+	const std::uint8_t* p;//current character
+	const std::uint8_t* n;//next character
+	const std::uint8_t* e;//end of span
+	std::uint32_t c;
+	
+	void Decode()NOEXCEPT{
+		if(this->p == this->e){
+			this->n = this->e;
+			this->c = 0;
+			return;
+		}
+		this->n = impl::DecodeCharReplacing(this->p, size_t(this->e - this->p), this->c);
+	}
+	
+	SpanIterator(const std::uint8_t* p, const std::uint8_t* end)NOEXCEPT :
+			p(p),
+			e(end)
+	{
+		this->Decode();
+	}
+	
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef std::uint32_t value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef const std::uint32_t* pointer;
+	typedef std::uint32_t reference;
+	
+	/**
+	 * @brief Get current unicode character.
+	 * @return unicode value of the character this iterator is currently pointing to.
+	 */
+	std::uint32_t Char()const NOEXCEPT{
+		ASSERT(this->p != this->e)
+		return this->c;
+	}
+	
+	/**
+	 * @brief Get current unicode character.
+	 * Returns value, not reference. Defined to allow using Range in range-based for loops.
+	 * @return unicode value of the character this iterator is currently pointing to.
+	 */
+	std::uint32_t operator*()const NOEXCEPT{
+		return this->Char();
+	}
+	
+	/**
+	 * @brief Get pointer to the first byte of the current character.
+	 * @return pointer to the first byte of the current character in the span.
+	 */
+	const std::uint8_t* Ptr()const NOEXCEPT{
+		return this->p;
+	}
+	
+	/**
+	 * @brief Get number of bytes occupied by the current character.
+	 * @return length of the current character utf-8 sequence.
+	 */
+	size_t CharSize()const NOEXCEPT{
+		return size_t(this->n - this->p);
+	}
+	
+	/**
+	 * @brief Prefix increment.
+	 * Move iterator to the next character in the span.
+	 * @return reference to this iterator object.
+	 */
+	SpanIterator& operator++()NOEXCEPT{
+		ASSERT(this->p != this->e)
+		this->p = this->n;
+		this->Decode();
+		return *this;
+	}
+	
+	SpanIterator operator++(int)NOEXCEPT{
+		SpanIterator ret(*this);
+		this->operator++();
+		return ret;
+	}
+	
+	bool operator==(const SpanIterator& i)const NOEXCEPT{
+		return this->p == i.p;
+	}
+	
+	bool operator!=(const SpanIterator& i)const NOEXCEPT{
+		return !this->operator==(i);
+	}
+};
+
+
+
+/**
+ * @brief Range of utf-8 characters in a memory span.
+ * Allows iterating over utf-8 characters of a memory buffer in place, without copying
+ * and without null-termination. Usage:
+ * @code
+ *	ting::Buffer<const std::uint8_t> buf = ...;//some part of a received data
+ *	for(std::uint32_t c : ting::utf8::Range(buf)){
+ *		...
+ *	}
+ * @endcode
+ */
+class Range{
+	ting::Buffer<const std::uint8_t> span;
+	
+public:
+	/**
+	 * @brief Constructor.
+	 * @param span - memory span holding utf-8 encoded string. The memory is not copied.
+	 */
+	Range(ting::Buffer<const std::uint8_t> span)NOEXCEPT :
+			span(span)
+	{}
+	
+	SpanIterator begin()const NOEXCEPT{
+		return SpanIterator(this->span.begin(), this->span.end());
+	}
+	
+	SpanIterator end()const NOEXCEPT{
+		return SpanIterator(this->span.end(), this->span.end());
+	}
+	
+	/**
+	 * @brief Get the underlying memory span.
+	 * @return memory span holding the string.
+	 */
+	ting::Buffer<const std::uint8_t> Span()const NOEXCEPT{
+		return this->span;
+	}
+	
+	/**
+	 * @brief Get number of characters in the range.
+	 * This is exactly the number of characters the iterator yields, including replacement characters
+	 * of invalid sequences. Iterator and DecodedLength() use the same decoder.
+	 * @return number of characters.
+	 */
+	size_t NumChars()const NOEXCEPT{
+		return DecodedLength(this->span);
+	}
+	
+	/**
+	 * @brief Get iterator to the character at given byte offset.
+	 * If the byte offset points into the middle of a multi-byte sequence then
+	 * the iterator to the beginning of that sequence is returned.
+	 * A continuation byte which is not covered by the sequence preceding it
+	 * is a separate replacement character, the iterator to it is returned.
+	 * I.e., the returned iterator is always one which iterating from begin() would reach.
+	 * @param byteOffset - offset in bytes from the beginning of the span.
+	 * @return iterator to the character containing the byte at given offset.
+	 * @return end() if offset is equal or greater than size of the span.
+	 */
+	SpanIterator At(size_t byteOffset)const NOEXCEPT{
+		if(byteOffset >= this->span.size()){
+			return this->end();
+		}
+		const std::uint8_t* t = this->span.begin() + byteOffset;
+		const std::uint8_t* p = t;
+		//step back over at most 3 continuation bytes
+		for(unsigned i = 0; i != 3 && p != this->span.begin() && ((*p) & 0xc0) == 0x80; ++i){
+			--p;
+		}
+		if(p != t){
+			//NOTE: the sequence starting at p may be shorter than the run of continuation bytes
+			//      or be interrupted, check that its decoded length covers the requested byte.
+			SpanIterator i(p, this->span.end());
+			if(i.n > t){
+				return i;
+			}
+		}
+		return SpanIterator(t, this->span.end());
+	}
+	
+	/**
+	 * @brief Get byte offset of the iterator.
+	 * @param i - iterator obtained from this range.
+	 * @return offset in bytes of the character pointed by the iterator from the beginning of the span.
+	 */
+	size_t ByteOffset(const SpanIterator& i)const NOEXCEPT{
+		ASSERT(this->span.begin() <= i.Ptr() && i.Ptr() <= this->span.end())
+		return size_t(i.Ptr() - this->span.begin());
+	}
+};
+
+
+
 }//~namespace
 }//~namespace
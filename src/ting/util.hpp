@@ -39,17 +39,29 @@ THE SOFTWARE. */
 
 #include <vector>
 #include <functional>
+#include <limits>
+#include <cstring>
 
 #include "debug.hpp"
 #include "types.hpp"
 #include "config.hpp"
+#include "Buffer.hpp"
 
+#if M_COMPILER == M_COMPILER_MSVC
+#	include <stdlib.h> //for _byteswap_*()
+#endif
 
+#if defined(__SSE2__) || (M_COMPILER == M_COMPILER_MSVC && (M_CPU == M_CPU_X86_64 || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+#	include <emmintrin.h>
+#	define M_UTIL_SSE2
+#endif
 
-#if M_COMPILER == M_COMPILER_MSVC
-#	define NOEXCEPT throw()
-#else
-#	define NOEXCEPT noexcept
+#if defined(__SSSE3__)
+#	include <tmmintrin.h>
+#endif
+
+#if defined(__BMI2__)
+#	include <immintrin.h>
 #endif
 
 
@@ -334,6 +346,772 @@ inline std::uint32_t Deserialize32BE(const std::uint8_t* buf)NOEXCEPT{
 
 
 
+/**
+ * @brief Reverse byte order of 16 bit value.
+ * @param v - value to reverse byte order of.
+ * @return value with reversed byte order.
+ */
+inline std::uint16_t ByteSwap16(std::uint16_t v)NOEXCEPT{
+#if M_COMPILER == M_COMPILER_MSVC
+	return _byteswap_ushort(v);
+#else
+	return std::uint16_t((v >> 8) | (v << 8));
+#endif
+}
+
+
+
+/**
+ * @brief Reverse byte order of 32 bit value.
+ * @param v - value to reverse byte order of.
+ * @return value with reversed byte order.
+ */
+inline std::uint32_t ByteSwap32(std::uint32_t v)NOEXCEPT{
+#if M_COMPILER == M_COMPILER_MSVC
+	return _byteswap_ulong(v);
+#elif M_COMPILER == M_COMPILER_GCC
+	return __builtin_bswap32(v);
+#else
+	return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+#endif
+}
+
+
+
+/**
+ * @brief Reverse byte order of 64 bit value.
+ * @param v - value to reverse byte order of.
+ * @return value with reversed byte order.
+ */
+inline std::uint64_t ByteSwap64(std::uint64_t v)NOEXCEPT{
+#if M_COMPILER == M_COMPILER_MSVC
+	return _byteswap_uint64(v);
+#elif M_COMPILER == M_COMPILER_GCC
+	return __builtin_bswap64(v);
+#else
+	return (std::uint64_t(ByteSwap32(std::uint32_t(v))) << 32) | ByteSwap32(std::uint32_t(v >> 32));
+#endif
+}
+
+
+
+/**
+ * @brief serialize 64 bit value, little-endian.
+ * Serialize 64 bit value, less significant byte first.
+ * @param value - the value.
+ * @param out_buf - pointer to the 8 byte buffer where the result will be placed.
+ */
+inline void Serialize64LE(std::uint64_t value, std::uint8_t* out_buf)NOEXCEPT{
+	Serialize32LE(std::uint32_t(value & 0xffffffff), out_buf);
+	Serialize32LE(std::uint32_t(value >> 32), out_buf + 4);
+}
+
+
+
+/**
+ * @brief de-serialize 64 bit value, little-endian.
+ * De-serialize 64 bit value from the sequence of bytes. Assume that less significant
+ * byte goes first in the input byte sequence.
+ * @param buf - pointer to buffer containing 8 bytes to convert from little-endian format.
+ * @return 64 bit unsigned integer converted from little-endian byte order to native byte order.
+ */
+inline std::uint64_t Deserialize64LE(const std::uint8_t* buf)NOEXCEPT{
+	return std::uint64_t(Deserialize32LE(buf)) | (std::uint64_t(Deserialize32LE(buf + 4)) << 32);
+}
+
+
+
+/**
+ * @brief serialize 64 bit value, big-endian.
+ * Serialize 64 bit value, most significant byte first.
+ * @param value - the value.
+ * @param out_buf - pointer to the 8 byte buffer where the result will be placed.
+ */
+inline void Serialize64BE(std::uint64_t value, std::uint8_t* out_buf)NOEXCEPT{
+	Serialize32BE(std::uint32_t(value >> 32), out_buf);
+	Serialize32BE(std::uint32_t(value & 0xffffffff), out_buf + 4);
+}
+
+
+
+/**
+ * @brief de-serialize 64 bit value, big-endian.
+ * De-serialize 64 bit value from the sequence of bytes. Assume that most significant
+ * byte goes first in the input byte sequence.
+ * @param buf - pointer to buffer containing 8 bytes to convert from big-endian format.
+ * @return 64 bit unsigned integer converted from big-endian byte order to native byte order.
+ */
+inline std::uint64_t Deserialize64BE(const std::uint8_t* buf)NOEXCEPT{
+	return (std::uint64_t(Deserialize32BE(buf)) << 32) | std::uint64_t(Deserialize32BE(buf + 4));
+}
+
+
+
+static_assert(sizeof(float) == sizeof(std::uint32_t) && std::numeric_limits<float>::is_iec559, "float is not IEEE-754 single precision");
+static_assert(sizeof(double) == sizeof(std::uint64_t) && std::numeric_limits<double>::is_iec559, "double is not IEEE-754 double precision");
+
+
+
+/**
+ * @brief serialize IEEE-754 single precision value, little-endian.
+ * @param value - the value.
+ * @param out_buf - pointer to the 4 byte buffer where the result will be placed.
+ */
+inline void SerializeFloatLE(float value, std::uint8_t* out_buf)NOEXCEPT{
+	std::uint32_t v;
+	memcpy(&v, &value, sizeof(v));
+	Serialize32LE(v, out_buf);
+}
+
+
+
+/**
+ * @brief serialize IEEE-754 single precision value, big-endian.
+ * @param value - the value.
+ * @param out_buf - pointer to the 4 byte buffer where the result will be placed.
+ */
+inline void SerializeFloatBE(float value, std::uint8_t* out_buf)NOEXCEPT{
+	std::uint32_t v;
+	memcpy(&v, &value, sizeof(v));
+	Serialize32BE(v, out_buf);
+}
+
+
+
+/**
+ * @brief de-serialize IEEE-754 single precision value, little-endian.
+ * @param buf - pointer to buffer containing 4 bytes of little-endian value.
+ * @return de-serialized value.
+ */
+inline float DeserializeFloatLE(const std::uint8_t* buf)NOEXCEPT{
+	std::uint32_t v = Deserialize32LE(buf);
+	float ret;
+	memcpy(&ret, &v, sizeof(ret));
+	return ret;
+}
+
+
+
+/**
+ * @brief de-serialize IEEE-754 single precision value, big-endian.
+ * @param buf - pointer to buffer containing 4 bytes of big-endian value.
+ * @return de-serialized value.
+ */
+inline float DeserializeFloatBE(const std::uint8_t* buf)NOEXCEPT{
+	std::uint32_t v = Deserialize32BE(buf);
+	float ret;
+	memcpy(&ret, &v, sizeof(ret));
+	return ret;
+}
+
+
+
+/**
+ * @brief serialize IEEE-754 double precision value, little-endian.
+ * @param value - the value.
+ * @param out_buf - pointer to the 8 byte buffer where the result will be placed.
+ */
+inline void SerializeDoubleLE(double value, std::uint8_t* out_buf)NOEXCEPT{
+	std::uint64_t v;
+	memcpy(&v, &value, sizeof(v));
+	Serialize64LE(v, out_buf);
+}
+
+
+
+/**
+ * @brief serialize IEEE-754 double precision value, big-endian.
+ * @param value - the value.
+ * @param out_buf - pointer to the 8 byte buffer where the result will be placed.
+ */
+inline void SerializeDoubleBE(double value, std::uint8_t* out_buf)NOEXCEPT{
+	std::uint64_t v;
+	memcpy(&v, &value, sizeof(v));
+	Serialize64BE(v, out_buf);
+}
+
+
+
+/**
+ * @brief de-serialize IEEE-754 double precision value, little-endian.
+ * @param buf - pointer to buffer containing 8 bytes of little-endian value.
+ * @return de-serialized value.
+ */
+inline double DeserializeDoubleLE(const std::uint8_t* buf)NOEXCEPT{
+	std::uint64_t v = Deserialize64LE(buf);
+	double ret;
+	memcpy(&ret, &v, sizeof(ret));
+	return ret;
+}
+
+
+
+/**
+ * @brief de-serialize IEEE-754 double precision value, big-endian.
+ * @param buf - pointer to buffer containing 8 bytes of big-endian value.
+ * @return de-serialized value.
+ */
+inline double DeserializeDoubleBE(const std::uint8_t* buf)NOEXCEPT{
+	std::uint64_t v = Deserialize64BE(buf);
+	double ret;
+	memcpy(&ret, &v, sizeof(ret));
+	return ret;
+}
+
+
+
+namespace impl{
+
+inline std::uint16_t ByteSwap(std::uint16_t v)NOEXCEPT{
+	return ByteSwap16(v);
+}
+
+inline std::uint32_t ByteSwap(std::uint32_t v)NOEXCEPT{
+	return ByteSwap32(v);
+}
+
+inline std::uint64_t ByteSwap(std::uint64_t v)NOEXCEPT{
+	return ByteSwap64(v);
+}
+
+//Copy array of T_Word values between native and given byte order representation.
+//The conversion is symmetric, so the same function is used for serialization and de-serialization.
+template <class T_Word, bool bigEndian> void ConvertByteOrder(const std::uint8_t* in, std::uint8_t* out, size_t numWords)NOEXCEPT{
+#if M_BYTE_ORDER == M_BYTE_ORDER_LITTLE_ENDIAN || M_BYTE_ORDER == M_BYTE_ORDER_BIG_ENDIAN
+	if(bigEndian == (M_BYTE_ORDER == M_BYTE_ORDER_BIG_ENDIAN)){
+		memcpy(out, in, numWords * sizeof(T_Word));
+		return;
+	}
+
+	const std::uint8_t* end = in + numWords * sizeof(T_Word);
+
+#	if defined(__SSSE3__)
+	{
+		const __m128i mask = sizeof(T_Word) == 2 ? _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14) :
+				sizeof(T_Word) == 4 ? _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12) :
+				_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		for(; end - in >= 16; in += 16, out += 16){
+			_mm_storeu_si128(
+					reinterpret_cast<__m128i*>(out),
+					_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), mask)
+				);
+		}
+	}
+#	endif
+
+	//this loop is recognized by compilers and vectorized when optimization is enabled
+	for(; in != end; in += sizeof(T_Word), out += sizeof(T_Word)){
+		T_Word v;
+		memcpy(&v, in, sizeof(v));
+		v = ByteSwap(v);
+		memcpy(out, &v, sizeof(v));
+	}
+#else
+	//unknown native byte order, convert word by word
+	for(size_t i = 0; i != numWords; ++i, in += sizeof(T_Word), out += sizeof(T_Word)){
+		T_Word v;
+		memcpy(&v, in, sizeof(v));
+		for(unsigned j = 0; j != sizeof(T_Word); ++j){
+			out[bigEndian ? sizeof(T_Word) - 1 - j : j] = std::uint8_t(v >> (8 * j));
+		}
+	}
+#endif
+}
+
+template <class T_Word, bool bigEndian> void SerializeArray(ting::Buffer<const T_Word> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	ASSERT(out.size() >= in.SizeInBytes())
+	ConvertByteOrder<T_Word, bigEndian>(reinterpret_cast<const std::uint8_t*>(in.begin()), out.begin(), in.size());
+}
+
+template <class T_Word, bool bigEndian> void DeserializeArray(ting::Buffer<const std::uint8_t> in, ting::Buffer<T_Word> out)NOEXCEPT{
+	ASSERT(in.size() >= out.SizeInBytes())
+#if M_BYTE_ORDER == M_BYTE_ORDER_LITTLE_ENDIAN || M_BYTE_ORDER == M_BYTE_ORDER_BIG_ENDIAN
+	ConvertByteOrder<T_Word, bigEndian>(in.begin(), reinterpret_cast<std::uint8_t*>(out.begin()), out.size());
+#else
+	for(size_t i = 0; i != out.size(); ++i){
+		T_Word v = 0;
+		for(unsigned j = 0; j != sizeof(T_Word); ++j){
+			v |= T_Word(in[i * sizeof(T_Word) + (bigEndian ? sizeof(T_Word) - 1 - j : j)]) << (8 * j);
+		}
+		out[i] = v;
+	}
+#endif
+}
+
+}//~namespace
+
+
+
+/**
+ * @brief serialize array of 16 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize16LE(ting::Buffer<const std::uint16_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint16_t, false>(in, out);
+}
+
+/**
+ * @brief serialize array of 16 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize16BE(ting::Buffer<const std::uint16_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint16_t, true>(in, out);
+}
+
+/**
+ * @brief serialize array of 32 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize32LE(ting::Buffer<const std::uint32_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint32_t, false>(in, out);
+}
+
+/**
+ * @brief serialize array of 32 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize32BE(ting::Buffer<const std::uint32_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint32_t, true>(in, out);
+}
+
+/**
+ * @brief serialize array of 64 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize64LE(ting::Buffer<const std::uint64_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint64_t, false>(in, out);
+}
+
+/**
+ * @brief serialize array of 64 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - values to serialize.
+ * @param out - buffer where the result will be placed, should be at least in.SizeInBytes() bytes.
+ */
+inline void Serialize64BE(ting::Buffer<const std::uint64_t> in, ting::Buffer<std::uint8_t> out)NOEXCEPT{
+	impl::SerializeArray<std::uint64_t, true>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 16 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize16LE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint16_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint16_t, false>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 16 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize16BE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint16_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint16_t, true>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 32 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize32LE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint32_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint32_t, false>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 32 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize32BE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint32_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint32_t, true>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 64 bit values, little-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize64LE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint64_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint64_t, false>(in, out);
+}
+
+/**
+ * @brief de-serialize array of 64 bit values, big-endian.
+ * Uses SIMD instructions where available.
+ * @param in - serialized data, should be at least out.SizeInBytes() bytes.
+ * @param out - buffer where the de-serialized values will be placed.
+ */
+inline void Deserialize64BE(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint64_t> out)NOEXCEPT{
+	impl::DeserializeArray<std::uint64_t, true>(in, out);
+}
+
+
+
+/**
+ * @brief Count set bits.
+ * @param v - value to count set bits in.
+ * @return number of bits set to 1 in the value.
+ */
+inline unsigned PopCount64(std::uint64_t v)NOEXCEPT{
+#if M_COMPILER == M_COMPILER_GCC
+	return unsigned(__builtin_popcountll(v));
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return unsigned((v * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+
+
+/**
+ * @brief Count trailing zero bits.
+ * @param v - value to count trailing zeros in, must not be 0.
+ * @return index of the least significant bit set to 1.
+ */
+inline unsigned CountTrailingZeros64(std::uint64_t v)NOEXCEPT{
+	ASSERT(v != 0)
+#if M_COMPILER == M_COMPILER_GCC
+	return unsigned(__builtin_ctzll(v));
+#else
+	unsigned ret = 0;
+	for(; (v & 0xff) == 0; v >>= 8){
+		ret += 8;
+	}
+	for(; (v & 1) == 0; v >>= 1){
+		++ret;
+	}
+	return ret;
+#endif
+}
+
+
+
+/**
+ * @brief Maximum size of LEB128 encoded 32 bit value.
+ */
+const size_t DMaxVarint32Size = 5;
+
+/**
+ * @brief Maximum size of LEB128 encoded 64 bit value.
+ */
+const size_t DMaxVarint64Size = 10;
+
+
+
+/**
+ * @brief Get encoded size of unsigned LEB128 varint.
+ * @param value - value to get the encoded size of.
+ * @return number of bytes needed to encode the value, from 1 to DMaxVarint64Size.
+ */
+inline size_t VarintSize(std::uint64_t value)NOEXCEPT{
+	size_t ret = 1;
+	for(; value >= 0x80; value >>= 7){
+		++ret;
+	}
+	return ret;
+}
+
+
+
+/**
+ * @brief serialize unsigned LEB128 varint.
+ * Serialize value by 7 bits per byte, less significant group first. Most significant
+ * bit of each byte, except the last one, is set.
+ * @param value - the value.
+ * @param out_buf - pointer to the buffer where the result will be placed,
+ *                  should be at least VarintSize(value) bytes.
+ * @return number of bytes written.
+ */
+inline size_t SerializeVarint(std::uint64_t value, std::uint8_t* out_buf)NOEXCEPT{
+	std::uint8_t* p = out_buf;
+	for(; value >= 0x80; value >>= 7, ++p){
+		*p = std::uint8_t(value | 0x80);
+	}
+	*p = std::uint8_t(value);
+	return size_t(p - out_buf) + 1;
+}
+
+
+
+/**
+ * @brief Map signed 32 bit value to unsigned one with zigzag encoding.
+ * Values with small magnitude are mapped to small unsigned values: 0 -> 0, -1 -> 1, 1 -> 2, -2 -> 3 etc.
+ * @param value - value to encode.
+ * @return zigzag encoded value.
+ */
+inline std::uint32_t ZigZagEncode32(std::int32_t value)NOEXCEPT{
+	return (std::uint32_t(value) << 1) ^ std::uint32_t(value >> 31);
+}
+
+/**
+ * @brief Decode zigzag encoded 32 bit value.
+ * @param value - zigzag encoded value.
+ * @return decoded signed value.
+ */
+inline std::int32_t ZigZagDecode32(std::uint32_t value)NOEXCEPT{
+	return std::int32_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/**
+ * @brief Map signed 64 bit value to unsigned one with zigzag encoding.
+ * @param value - value to encode.
+ * @return zigzag encoded value.
+ */
+inline std::uint64_t ZigZagEncode64(std::int64_t value)NOEXCEPT{
+	return (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+}
+
+/**
+ * @brief Decode zigzag encoded 64 bit value.
+ * @param value - zigzag encoded value.
+ * @return decoded signed value.
+ */
+inline std::int64_t ZigZagDecode64(std::uint64_t value)NOEXCEPT{
+	return std::int64_t((value >> 1) ^ (~(value & 1) + 1));
+}
+
+
+
+namespace impl{
+
+const size_t DVarintTruncated = 0;
+const size_t DVarintMalformed = size_t(-1);
+
+//Decode one varint with bounds checking.
+//Returns number of bytes consumed, DVarintTruncated or DVarintMalformed.
+template <class T> size_t DecodeVarint(const std::uint8_t* p, const std::uint8_t* end, T& out)NOEXCEPT{
+	const unsigned maxSize = (sizeof(T) * 8 + 6) / 7;
+	T v = 0;
+	for(unsigned i = 0; i != maxSize; ++i){
+		if(p + i == end){
+			return DVarintTruncated;
+		}
+		std::uint8_t b = p[i];
+		v |= T(b & 0x7f) << (7 * i);
+		if((b & 0x80) == 0){
+			if(i == maxSize - 1 && (b >> (sizeof(T) * 8 - 7 * i)) != 0){
+				return DVarintMalformed;//value does not fit into T
+			}
+			out = v;
+			return i + 1;
+		}
+	}
+	return DVarintMalformed;
+}
+
+//Decode one varint which is entirely within the 8 bytes starting at p.
+//Returns number of bytes consumed, DVarintMalformed or DVarintTruncated if varint is longer than 8 bytes.
+template <class T> size_t DecodeVarintFromWord(const std::uint8_t* p, T& out)NOEXCEPT{
+	std::uint64_t w = Deserialize64LE(p);
+
+	//find the terminating byte, i.e. the first one with most significant bit cleared
+	std::uint64_t stop = ~w & 0x8080808080808080ULL;
+	if(stop == 0){
+		return DVarintTruncated;
+	}
+	size_t len = CountTrailingZeros64(stop) / 8 + 1;
+
+	//keep only 7 bit payloads of the varint bytes
+	std::uint64_t x = w & (stop ^ (stop - 1)) & 0x7f7f7f7f7f7f7f7fULL;
+
+#if defined(__BMI2__)
+	std::uint64_t v = _pext_u64(x, 0x7f7f7f7f7f7f7f7fULL);
+#else
+	std::uint64_t v = (x & 0x7f)
+			| ((x >> 1) & (0x7fULL << 7))
+			| ((x >> 2) & (0x7fULL << 14))
+			| ((x >> 3) & (0x7fULL << 21))
+			| ((x >> 4) & (0x7fULL << 28))
+			| ((x >> 5) & (0x7fULL << 35))
+			| ((x >> 6) & (0x7fULL << 42))
+			| ((x >> 7) & (0x7fULL << 49));
+#endif
+
+	if(sizeof(T) < sizeof(std::uint64_t) && (len > (sizeof(T) * 8 + 6) / 7 || v > std::uint64_t(T(-1)))){
+		return DVarintMalformed;
+	}
+	out = T(v);
+	return len;
+}
+
+}//~namespace
+
+
+
+/**
+ * @brief de-serialize unsigned LEB128 varint of 32 bit value.
+ * @param buf - buffer holding serialized data.
+ * @param out - reference to variable where the decoded value will be stored.
+ * @return number of bytes consumed, 0 if varint is truncated or malformed.
+ */
+inline size_t DeserializeVarint32(ting::Buffer<const std::uint8_t> buf, std::uint32_t& out)NOEXCEPT{
+	size_t ret = impl::DecodeVarint(buf.begin(), buf.end(), out);
+	return ret == impl::DVarintMalformed ? 0 : ret;
+}
+
+
+
+/**
+ * @brief de-serialize unsigned LEB128 varint of 64 bit value.
+ * @param buf - buffer holding serialized data.
+ * @param out - reference to variable where the decoded value will be stored.
+ * @return number of bytes consumed, 0 if varint is truncated or malformed.
+ */
+inline size_t DeserializeVarint64(ting::Buffer<const std::uint8_t> buf, std::uint64_t& out)NOEXCEPT{
+	size_t ret = impl::DecodeVarint(buf.begin(), buf.end(), out);
+	return ret == impl::DVarintMalformed ? 0 : ret;
+}
+
+
+
+/**
+ * @brief Result of batch varint decoding.
+ */
+struct VarintDecodeResult{
+	size_t numRead;//number of bytes consumed from input
+	size_t numDecoded;//number of values written to output
+	bool error;//true if decoding stopped at malformed varint
+};
+
+
+
+namespace impl{
+
+template <class T> VarintDecodeResult DecodeVarints(ting::Buffer<const std::uint8_t> in, ting::Buffer<T> out)NOEXCEPT{
+	const std::uint8_t* p = in.begin();
+	const std::uint8_t* end = in.end();
+	T* o = out.begin();
+	T* oend = out.end();
+
+	bool error = false;
+
+	while(o != oend){
+#if defined(M_UTIL_SSE2)
+		if(end - p >= 16){
+			//each byte with most significant bit cleared terminates a varint, so
+			//a run of such bytes at the beginning is a run of one byte varints
+			unsigned m = unsigned(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))));
+			if(m == 0 && oend - o >= 16){
+				for(unsigned i = 0; i != 16; ++i){
+					o[i] = p[i];
+				}
+				p += 16;
+				o += 16;
+				continue;
+			}
+			if((m & 1) == 0){
+				size_t n = m == 0 ? 16 : CountTrailingZeros64(m);
+				if(n > size_t(oend - o)){
+					n = size_t(oend - o);
+				}
+				for(size_t i = 0; i != n; ++i){
+					o[i] = p[i];
+				}
+				p += n;
+				o += n;
+				continue;
+			}
+		}
+#endif
+		T v;
+		size_t len;
+		if(end - p >= 8){
+			len = DecodeVarintFromWord(p, v);
+			if(len == DVarintTruncated){
+				//longer than 8 bytes
+				len = DecodeVarint(p, end, v);
+			}
+		}else{
+			len = DecodeVarint(p, end, v);
+		}
+
+		if(len == DVarintTruncated){
+			break;
+		}
+		if(len == DVarintMalformed){
+			error = true;
+			break;
+		}
+		*o = v;
+		++o;
+		p += len;
+	}
+
+	VarintDecodeResult ret;
+	ret.numRead = size_t(p - in.begin());
+	ret.numDecoded = size_t(o - out.begin());
+	ret.error = error;
+	return ret;
+}
+
+}//~namespace
+
+
+
+/**
+ * @brief de-serialize array of unsigned LEB128 varints of 32 bit values.
+ * Decodes varints until output buffer is full, input is exhausted or malformed varint is encountered.
+ * Truncated varint at the end of input is not consumed and is not considered an error.
+ * Uses SIMD instructions to process runs of one byte varints and 64 bit word operations
+ * to decode multi-byte varints without per-byte branching.
+ * @param in - serialized data.
+ * @param out - buffer where the decoded values will be placed.
+ * @return decoding result.
+ */
+inline VarintDecodeResult DeserializeVarints32(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint32_t> out)NOEXCEPT{
+	return impl::DecodeVarints(in, out);
+}
+
+
+
+/**
+ * @brief de-serialize array of unsigned LEB128 varints of 64 bit values.
+ * See DeserializeVarints32() for details.
+ * @param in - serialized data.
+ * @param out - buffer where the decoded values will be placed.
+ * @return decoding result.
+ */
+inline VarintDecodeResult DeserializeVarints64(ting::Buffer<const std::uint8_t> in, ting::Buffer<std::uint64_t> out)NOEXCEPT{
+	return impl::DecodeVarints(in, out);
+}
+
+
+
+/**
+ * @brief Compile-time sequence of indices.
+ * Analogue of C++14 std::index_sequence.
+ */
+template <size_t... I> struct IndexSequence{};
+
+/**
+ * @brief Make compile-time sequence of indices from 0 to N - 1.
+ * Analogue of C++14 std::make_index_sequence.
+ */
+template <size_t N, size_t... I> struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, I...>{};
+
+template <size_t... I> struct MakeIndexSequence<0, I...> : IndexSequence<I...>{};
+
+
+
 template <typename T> struct remove_constptr{
 	typedef typename std::remove_const<typename std::remove_pointer<T>::type>::type type;
 };
@@ -0,0 +1,8 @@
+#include "main.hpp"
+
+
+int main(int argc, char *argv[]){
+	TestTingArchiveFile();
+
+	return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../src/ting/debug.hpp"
+
+#include "tests.hpp"
+
+
+inline void TestTingArchiveFile(){
+	TestReadStored::Run();
+	TestListDirContents::Run();
+	TestCompressedEntry::Run();
+
+	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
+}
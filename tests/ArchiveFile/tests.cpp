@@ -0,0 +1,115 @@
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/fs/ArchiveFile.hpp"
+
+#include "tests.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace TestReadStored{
+void Run(){
+	ting::fs::ArchiveFile f("test.zip", "hello.txt");
+	ASSERT_ALWAYS(!f.IsOpened())
+	ASSERT_ALWAYS(f.NumEntries() == 5)
+	ASSERT_ALWAYS(f.Exists())
+
+	{
+		ting::fs::File::Guard fileGuard(f);
+
+		std::array<std::uint8_t, 0x100> buf;
+		size_t res = f.Read(buf);
+		ASSERT_INFO_ALWAYS(res == 12, "res = " << res)
+		ASSERT_ALWAYS(memcmp(&*buf.begin(), "Hello world!", res) == 0)
+
+		ASSERT_ALWAYS(f.SeekBackward(6) == 6)
+		res = f.Read(ting::Buffer<std::uint8_t>(&*buf.begin(), 5));
+		ASSERT_ALWAYS(res == 5)
+		ASSERT_ALWAYS(memcmp(&*buf.begin(), "world", res) == 0)
+
+		ASSERT_ALWAYS(f.Data().size() == 12)
+	}
+
+	//spawned file shares the index
+	auto s = f.Spawn();
+	s->SetPath("dir/a.bin");
+	{
+		ting::fs::File::Guard fileGuard(*s);
+
+		s->SeekForward(0x101);
+
+		std::array<std::uint8_t, 2> buf;
+		ASSERT_ALWAYS(s->Read(buf) == buf.size())
+		ASSERT_ALWAYS(buf[0] == 1)
+		ASSERT_ALWAYS(buf[1] == 2)
+	}
+
+	{
+		auto d = s->LoadWholeFileIntoMemory();
+		ASSERT_ALWAYS(d.size() == 0x400)
+		for(size_t i = 0; i != d.size(); ++i){
+			ASSERT_ALWAYS(d[i] == std::uint8_t(i))
+		}
+	}
+
+	s->SetPath("nonexistent.txt");
+	ASSERT_ALWAYS(!s->Exists())
+
+	bool thrown = false;
+	try{
+		ting::fs::File::Guard fileGuard(*s);
+	}catch(ting::fs::File::Exc&){
+		thrown = true;
+	}
+	ASSERT_ALWAYS(thrown)
+}
+}//~namespace
+
+
+
+namespace TestListDirContents{
+void Run(){
+	ting::fs::ArchiveFile f("test.zip");
+
+	{
+		auto l = f.ListDirContents();
+		ASSERT_INFO_ALWAYS(l.size() == 3, "l.size() = " << l.size())
+		ASSERT_ALWAYS(l[0] == "dir/")
+		ASSERT_ALWAYS(l[1] == "hello.txt")
+		ASSERT_ALWAYS(l[2] == "packed.txt")
+	}
+
+	f.SetPath("dir/");
+	ASSERT_ALWAYS(f.Exists())
+	{
+		auto l = f.ListDirContents();
+		ASSERT_INFO_ALWAYS(l.size() == 2, "l.size() = " << l.size())
+		ASSERT_ALWAYS(l[0] == "a.bin")
+		ASSERT_ALWAYS(l[1] == "sub/")
+	}
+
+	f.SetPath("dir/sub/");
+	ASSERT_ALWAYS(f.Exists())
+	ASSERT_ALWAYS(f.ListDirContents().size() == 1)
+}
+}//~namespace
+
+
+
+namespace TestCompressedEntry{
+void Run(){
+	ting::fs::ArchiveFile f("test.zip", "packed.txt");
+	ASSERT_ALWAYS(f.Exists())
+
+	bool thrown = false;
+	try{
+		ting::fs::File::Guard fileGuard(f);
+	}catch(ting::fs::File::Exc&){
+		thrown = true;
+	}
+	ASSERT_ALWAYS(thrown)
+	ASSERT_ALWAYS(!f.IsOpened())
+}
+}//~namespace
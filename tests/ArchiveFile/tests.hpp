@@ -0,0 +1,14 @@
+#pragma once
+
+
+namespace TestReadStored{
+void Run();
+}//~namespace
+
+namespace TestListDirContents{
+void Run();
+}//~namespace
+
+namespace TestCompressedEntry{
+void Run();
+}//~namespace
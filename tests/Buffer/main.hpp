@@ -9,6 +9,7 @@ inline void TestTingBuffer(){
 	TestStaticBufferCopyConstructor::Run();
 	TestStaticBufferOperatorEquals::Run();
 	TestBufferConstCast::Run();
+	TestBufferStream::Run();
 
 	TRACE_ALWAYS(<<"[PASSED]"<<std::endl)
 }
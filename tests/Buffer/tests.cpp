@@ -1,4 +1,5 @@
 #include "../../src/ting/Buffer.hpp"
+#include "../../src/ting/BufferStream.hpp"
 
 #include "tests.hpp"
 
@@ -126,3 +127,92 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+namespace TestBufferStream{
+void Run(){
+	std::array<std::uint8_t, 64> buf;
+
+	ting::BufferWriter w(buf);
+	{
+		auto r = w.Reserve(7);
+		r.Put8(0xab);
+		r.Put16BE(0x0102);
+		r.Put32LE(0x03040506);
+		ASSERT_ALWAYS(r.NumLeft() == 0)
+	}
+	w.Put64BE(0x0102030405060708ULL);
+	w.PutDoubleLE(-0.5);
+	w.PutVarint(300);
+	w.PutBlob8(std::vector<std::uint8_t>{1, 2, 3});
+	w.PutBlobVarint(std::vector<std::uint8_t>{4, 5});
+
+	ASSERT_ALWAYS(buf[0] == 0xab)
+	ASSERT_ALWAYS(buf[1] == 0x01 && buf[2] == 0x02)
+	ASSERT_ALWAYS(buf[3] == 0x06 && buf[6] == 0x03)
+	ASSERT_ALWAYS(buf[23] == 0xac && buf[24] == 0x02)//varint 300
+	ASSERT_INFO_ALWAYS(w.NumWritten() == 7 + 8 + 8 + 2 + 4 + 3, "w.NumWritten() = " << w.NumWritten())
+	ASSERT_ALWAYS(w.NumWritten() + w.NumLeft() == buf.size())
+
+	ting::BufferReader rd(w.Written());
+	{
+		auto r = rd.Take(7);
+		ASSERT_ALWAYS(r.Get8() == 0xab)
+		ASSERT_ALWAYS(r.Get16BE() == 0x0102)
+		ASSERT_ALWAYS(r.Get32LE() == 0x03040506)
+	}
+	ASSERT_ALWAYS(rd.Get64BE() == 0x0102030405060708ULL)
+	ASSERT_ALWAYS(rd.GetDoubleLE() == -0.5)
+	ASSERT_ALWAYS(rd.GetVarint() == 300)
+	{
+		auto b = rd.GetBlob8();
+		ASSERT_ALWAYS(b.size() == 3 && b[0] == 1 && b[2] == 3)
+		ASSERT_ALWAYS(b.begin() == &buf[26])//no copy
+	}
+	{
+		auto b = rd.GetBlobVarint();
+		ASSERT_ALWAYS(b.size() == 2 && b[0] == 4 && b[1] == 5)
+	}
+	ASSERT_ALWAYS(rd.NumLeft() == 0)
+
+	//reading past the end throws
+	{
+		bool thrown = false;
+		try{
+			rd.Get8();
+		}catch(ting::BufferReader::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	//truncated varint throws
+	{
+		std::array<std::uint8_t, 2> b = {{0x80, 0x80}};
+		ting::BufferReader r(b);
+		bool thrown = false;
+		try{
+			r.GetVarint();
+		}catch(ting::BufferReader::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+	}
+
+	//writing past the end throws and does not advance
+	{
+		std::array<std::uint8_t, 3> b;
+		ting::BufferWriter wr(b);
+		wr.Put16LE(1);
+		bool thrown = false;
+		try{
+			wr.Put16LE(2);
+		}catch(ting::BufferWriter::Exc&){
+			thrown = true;
+		}
+		ASSERT_ALWAYS(thrown)
+		ASSERT_ALWAYS(wr.NumWritten() == 2)
+	}
+}
+}//~namespace
@@ -10,6 +10,8 @@ inline void TestTingFSFile(){
 	TestListDirContents::Run();
 	TestHomeDir::Run();
 	TestLoadWholeFileToMemory::Run();
+	TestBufferedWrite::Run();
+	TestCachedFile::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
 }
@@ -1,6 +1,7 @@
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/fs/FSFile.hpp"
 #include "../../src/ting/fs/RootDirFile.hpp"
+#include "../../src/ting/fs/CachedFile.hpp"
 
 #include "tests.hpp"
 
@@ -131,3 +132,110 @@ void Run(){
 	}
 }
 }//~namespace
+
+
+
+namespace TestBufferedWrite{
+void Run(){
+	const char* fileName = "buffered_write.tmp";
+	
+	ting::fs::FSFile f(fileName);
+	f.SetWriteBufferSize(16);
+	ASSERT_ALWAYS(f.WriteBufferSize() == 16)
+	
+	{
+		ting::fs::File::Guard fileGuard(f, ting::fs::File::E_Mode::CREATE);
+		
+		f.StartPeriodicSync(10);
+		
+		for(std::uint8_t i = 0; i != 100; ++i){
+			ASSERT_ALWAYS(f.Write(ting::Buffer<const std::uint8_t>(&i, 1)) == 1)
+		}
+		
+		//bigger than buffer, goes directly to the file
+		std::array<std::uint8_t, 40> big;
+		for(size_t i = 0; i != big.size(); ++i){
+			big[i] = std::uint8_t(100 + i);
+		}
+		ASSERT_ALWAYS(f.Write(big) == big.size())
+		
+		f.Sync();
+		
+		f.StopPeriodicSync();
+		
+		//unflushed data should be visible to reading through the same file
+		std::uint8_t b = 140;
+		f.Write(ting::Buffer<const std::uint8_t>(&b, 1));
+		f.Rewind();
+		std::array<std::uint8_t, 0x100> buf;
+		ASSERT_ALWAYS(f.Read(buf) == 141)
+		for(size_t i = 0; i != 141; ++i){
+			ASSERT_ALWAYS(buf[i] == i)
+		}
+		
+		//leave some data in the buffer, it should be written on close
+		f.Write(ting::Buffer<const std::uint8_t>(&b, 1));
+	}
+	
+	{
+		std::vector<std::uint8_t> r = f.LoadWholeFileIntoMemory();
+		ASSERT_INFO_ALWAYS(r.size() == 142, "r.size() = " << r.size())
+		ASSERT_ALWAYS(r[141] == 140)
+	}
+	
+	std::remove(fileName);
+}
+}//~namespace
+
+
+
+namespace TestCachedFile{
+void Run(){
+	ting::fs::CachedFile::ClearCache();
+	auto s0 = ting::fs::CachedFile::CacheStats();
+	
+	ting::fs::CachedFile f(ting::fs::FSFile::New("test.file.txt"));
+	
+	std::vector<std::uint8_t> r0 = f.LoadWholeFileIntoMemory();
+	ASSERT_ALWAYS(r0.size() == 66874)
+	
+	auto s1 = ting::fs::CachedFile::CacheStats();
+	ASSERT_ALWAYS(s1.misses == s0.misses + 1)
+	ASSERT_ALWAYS(s1.hits == s0.hits)
+	ASSERT_ALWAYS(s1.numEntries == 1)
+	ASSERT_ALWAYS(s1.numBytes == 66874)
+	
+	//second opening is served from cache
+	auto s = static_cast<ting::fs::File&>(f).Spawn();
+	s->SetPath("test.file.txt");
+	{
+		ting::fs::File::Guard fileGuard(*s);
+		
+		s->SeekForward(1000);
+		std::array<std::uint8_t, 10> buf;
+		ASSERT_ALWAYS(s->Read(buf) == buf.size())
+		ASSERT_ALWAYS(memcmp(&*buf.begin(), &r0[1000], buf.size()) == 0)
+		
+		ASSERT_ALWAYS(s->SeekBackward(5) == 5)
+		ASSERT_ALWAYS(s->Read(buf) == buf.size())
+		ASSERT_ALWAYS(memcmp(&*buf.begin(), &r0[1005], buf.size()) == 0)
+	}
+	
+	auto s2 = ting::fs::CachedFile::CacheStats();
+	ASSERT_ALWAYS(s2.hits == s1.hits + 1)
+	ASSERT_ALWAYS(s2.misses == s1.misses)
+	
+	//file bigger than budget is read through the base file
+	ting::fs::CachedFile::SetCacheBudget(1000);
+	auto s3 = ting::fs::CachedFile::CacheStats();
+	ASSERT_ALWAYS(s3.evictions == s2.evictions + 1)
+	ASSERT_ALWAYS(s3.numEntries == 0)
+	ASSERT_ALWAYS(s3.numBytes == 0)
+	
+	ASSERT_ALWAYS(f.LoadWholeFileIntoMemory() == r0)
+	ASSERT_ALWAYS(ting::fs::CachedFile::CacheStats().numEntries == 0)
+	
+	ting::fs::CachedFile::SetCacheBudget(64 * 1024 * 1024);
+	ting::fs::CachedFile::ClearCache();
+}
+}//~namespace
@@ -16,3 +16,11 @@ void Run();
 namespace TestLoadWholeFileToMemory{
 void Run();
 }//~namespace
+
+namespace TestBufferedWrite{
+void Run();
+}//~namespace
+
+namespace TestCachedFile{
+void Run();
+}//~namespace
@@ -0,0 +1,144 @@
+#include <chrono>
+
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/Flags.hpp"
+
+#include "tests.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace Benchmark{
+
+namespace{
+
+enum class Permission : std::uint16_t{
+	ENUM_SIZE = 500
+};
+
+//previous implementation of Flags which stores flags in bytes, for comparison
+template <class T_Enum> class ByteFlags{
+	std::uint8_t flags[size_t(T_Enum::ENUM_SIZE) / 8 + 1];
+
+public:
+	ByteFlags(){
+		memset(this->flags, 0, sizeof(this->flags));
+	}
+
+	size_t Size()const NOEXCEPT{
+		return size_t(T_Enum::ENUM_SIZE);
+	}
+
+	bool Get(size_t i)const NOEXCEPT{
+		return (this->flags[i / 8] & (1 << (i % 8))) != 0;
+	}
+
+	void Set(size_t i)NOEXCEPT{
+		this->flags[i / 8] |= (1 << (i % 8));
+	}
+
+	bool IsAllClear()const NOEXCEPT{
+		for(size_t i = 0; i != sizeof(this->flags) - 1; ++i){
+			if(this->flags[i] != 0){
+				return false;
+			}
+		}
+		for(size_t i = (this->Size() / 8) * 8; i != this->Size(); ++i){
+			if(this->Get(i)){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ByteFlags& Invert()NOEXCEPT{
+		for(size_t i = 0; i != sizeof(this->flags); ++i){
+			this->flags[i] = ~this->flags[i];
+		}
+		return *this;
+	}
+
+	ByteFlags& operator&=(const ByteFlags& f)NOEXCEPT{
+		for(size_t i = 0; i != sizeof(this->flags); ++i){
+			this->flags[i] &= f.flags[i];
+		}
+		return *this;
+	}
+
+	ByteFlags& operator|=(const ByteFlags& f)NOEXCEPT{
+		for(size_t i = 0; i != sizeof(this->flags); ++i){
+			this->flags[i] |= f.flags[i];
+		}
+		return *this;
+	}
+};
+
+//run function several times and return millions of calls per second
+template <class T_Func> double Measure(T_Func f){
+	const unsigned DNumIterations = 100000;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumIterations; ++i){
+		f();
+	}
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	return DNumIterations / sec.count() / 1000000;
+}
+
+}
+
+void Run(){
+	ting::Flags<Permission> granted, required;
+	ByteFlags<Permission> oldGranted, oldRequired;
+
+	for(unsigned i = 0; i < 500; i += 3){
+		granted.Set(Permission(i));
+		oldGranted.Set(i);
+	}
+	for(unsigned i = 0; i < 500; i += 9){
+		required.Set(Permission(i));
+		oldRequired.Set(i);
+	}
+
+	volatile unsigned sink = 0;
+
+	//permission check: all required flags are granted
+	double oldCheck = Measure([&](){
+		ByteFlags<Permission> missing = oldGranted;
+		missing.Invert() &= oldRequired;
+		sink = sink + missing.IsAllClear();
+	});
+	double newCheck = Measure([&](){
+		sink = sink + granted.IsAllSetOf(required);
+	});
+	ASSERT_ALWAYS(granted.IsAllSetOf(required))
+
+	double oldOr = Measure([&](){
+		oldRequired |= oldGranted;
+		sink = sink + oldRequired.Get(0);
+	});
+	double newOr = Measure([&](){
+		required |= granted;
+		sink = sink + required.Get(Permission(0));
+	});
+
+	double oldCount = Measure([&](){
+		unsigned n = 0;
+		for(size_t i = 0; i != oldGranted.Size(); ++i){
+			n += oldGranted.Get(i);
+		}
+		sink = sink + n;
+	});
+	double newCount = Measure([&](){
+		sink = sink + granted.NumSet();
+	});
+
+	TRACE_ALWAYS(<< "\tFlags of 500 items, millions of operations per second (byte storage / word storage):" << std::endl)
+	TRACE_ALWAYS(<< "\t\tpermission check: " << oldCheck << " / " << newCheck << std::endl)
+	TRACE_ALWAYS(<< "\t\tOR:               " << oldOr << " / " << newOr << std::endl)
+	TRACE_ALWAYS(<< "\t\tcount:            " << oldCount << " / " << newCount << std::endl)
+}
+
+}//~namespace
@@ -8,6 +8,9 @@
 
 inline void TestTingFlags(){
 	TestFlags::Run();
+	TestWordFlags::Run();
+	TestBitSet::Run();
+	Benchmark::Run();
 
 	TRACE_ALWAYS(<<"[PASSED]: Flags test"<<std::endl)
 }
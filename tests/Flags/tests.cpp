@@ -1,5 +1,6 @@
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/Flags.hpp"
+#include "../../src/ting/BitSet.hpp"
 
 #include "tests.hpp"
 
@@ -101,3 +102,180 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+namespace TestWordFlags{
+
+//enumeration spanning several storage words
+enum class BigEnum : std::uint16_t{
+	ENUM_SIZE = 300
+};
+
+BigEnum E(unsigned i){
+	return BigEnum(i);
+}
+
+void Run(){
+	//compile time construction
+	{
+		constexpr ting::Flags<TestFlags::TestEnum> fs(TestFlags::TestEnum::FIRST, TestFlags::TestEnum::THIRTY_NINETH);
+		ASSERT_ALWAYS(fs.Get(TestFlags::TestEnum::FIRST))
+		ASSERT_ALWAYS(fs.Get(TestFlags::TestEnum::THIRTY_NINETH))
+		ASSERT_ALWAYS(fs.NumSet() == 2)
+
+		constexpr ting::Flags<BigEnum> all(true);
+		ASSERT_ALWAYS(all.IsAllSet())
+		ASSERT_ALWAYS(all.NumSet() == 300)
+		ASSERT_ALWAYS((~all).IsAllClear())
+	}
+
+	ting::Flags<BigEnum> fs;
+	ASSERT_ALWAYS(fs.IsAllClear())
+	ASSERT_ALWAYS(fs.FindFirstSet() == fs.Size())
+
+	fs.Set(E(3)).Set(E(64)).Set(E(65)).Set(E(200)).Set(E(299));
+	ASSERT_ALWAYS(fs.NumSet() == 5)
+	ASSERT_ALWAYS(fs.FindFirstSet() == 3)
+	ASSERT_ALWAYS(fs.FindNextSet(4) == 64)
+	ASSERT_ALWAYS(fs.FindNextSet(65) == 65)
+	ASSERT_ALWAYS(fs.FindNextSet(66) == 200)
+	ASSERT_ALWAYS(fs.FindNextSet(201) == 299)
+	ASSERT_ALWAYS(fs.FindNextSet(300) == fs.Size())
+
+	{
+		std::vector<unsigned> visited;
+		fs.ForEachSet([&visited](BigEnum e){
+			visited.push_back(unsigned(e));
+		});
+		ASSERT_ALWAYS(visited.size() == 5)
+		ASSERT_ALWAYS(visited[0] == 3)
+		ASSERT_ALWAYS(visited[2] == 65)
+		ASSERT_ALWAYS(visited[4] == 299)
+	}
+
+	//inverting keeps unused bits of the last word cleared
+	{
+		ting::Flags<BigEnum> inv = ~fs;
+		ASSERT_ALWAYS(inv.NumSet() == 295)
+		ASSERT_ALWAYS(!inv.Get(E(299)))
+		inv |= fs;
+		ASSERT_ALWAYS(inv.IsAllSet())
+		ASSERT_ALWAYS(inv == ting::Flags<BigEnum>(true))
+		ASSERT_ALWAYS(inv != fs)
+	}
+
+	//permission check
+	{
+		ting::Flags<BigEnum> required(E(3), E(200));
+		ASSERT_ALWAYS(fs.IsAllSetOf(required))
+		required.Set(E(4));
+		ASSERT_ALWAYS(!fs.IsAllSetOf(required))
+		ASSERT_ALWAYS((fs & required).NumSet() == 2)
+		ASSERT_ALWAYS((fs ^ required).NumSet() == 4)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestBitSet{
+
+void Run(){
+	//basic operations on set with partially used last word
+	{
+		ting::BitSet bs(130);
+		ASSERT_ALWAYS(bs.Size() == 130)
+		ASSERT_ALWAYS(bs.IsAllClear())
+		ASSERT_ALWAYS(bs.FindNextSet() == bs.Size())
+		ASSERT_ALWAYS(bs.FindNextClear() == 0)
+
+		bs.Set(3).Set(64).Set(129);
+		ASSERT_ALWAYS(bs.Get(3) && bs.Get(64) && bs.Get(129))
+		ASSERT_ALWAYS(!bs.Get(4))
+		ASSERT_ALWAYS(bs.NumSet() == 3)
+		ASSERT_ALWAYS(bs.FindNextSet() == 3)
+		ASSERT_ALWAYS(bs.FindNextSet(4) == 64)
+		ASSERT_ALWAYS(bs.FindNextSet(65) == 129)
+		ASSERT_ALWAYS(bs.FindNextSet(130) == 130)
+
+		ASSERT_ALWAYS(bs.Rank(0) == 0)
+		ASSERT_ALWAYS(bs.Rank(4) == 1)
+		ASSERT_ALWAYS(bs.Rank(64) == 1)
+		ASSERT_ALWAYS(bs.Rank(65) == 2)
+		ASSERT_ALWAYS(bs.Rank(130) == 3)
+		ASSERT_ALWAYS(bs.Select(0) == 3)
+		ASSERT_ALWAYS(bs.Select(1) == 64)
+		ASSERT_ALWAYS(bs.Select(2) == 129)
+		ASSERT_ALWAYS(bs.Select(3) == 130)
+
+		size_t sum = 0;
+		bs.ForEachSet([&sum](size_t i){sum += i;});
+		ASSERT_ALWAYS(sum == 3 + 64 + 129)
+
+		bs.Invert();
+		ASSERT_ALWAYS(bs.NumSet() == 127)
+		ASSERT_ALWAYS(bs.FindNextClear() == 3)
+		ASSERT_ALWAYS(bs.FindNextClear(65) == 129)
+
+		bs.SetAllTo(true);
+		ASSERT_ALWAYS(bs.IsAllSet())
+		ASSERT_ALWAYS(bs.FindNextClear() == bs.Size())
+	}
+
+	//resize
+	{
+		ting::BitSet bs(10, true);
+		ASSERT_ALWAYS(bs.NumSet() == 10)
+		bs.Resize(100, true);
+		ASSERT_ALWAYS(bs.IsAllSet())
+		bs.Resize(70);
+		ASSERT_ALWAYS(bs.NumSet() == 70)
+		bs.Resize(200);
+		ASSERT_ALWAYS(bs.NumSet() == 70)
+		ASSERT_ALWAYS(bs.FindNextClear() == 70)
+	}
+
+	//whole set operations, compare against bit by bit result
+	{
+		const size_t DSize = 1000;
+		ting::BitSet a(DSize), b(DSize);
+		for(size_t i = 0; i != DSize; ++i){
+			a.SetTo(i, i % 3 == 0);
+			b.SetTo(i, i % 5 == 0);
+		}
+
+		ting::BitSet andSet = a & b;
+		ting::BitSet orSet = a | b;
+		ting::BitSet xorSet = a ^ b;
+		ting::BitSet andNotSet(a);
+		andNotSet.ClearAllOf(b);
+
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(andSet.Get(i) == (a.Get(i) && b.Get(i)))
+			ASSERT_ALWAYS(orSet.Get(i) == (a.Get(i) || b.Get(i)))
+			ASSERT_ALWAYS(xorSet.Get(i) == (a.Get(i) != b.Get(i)))
+			ASSERT_ALWAYS(andNotSet.Get(i) == (a.Get(i) && !b.Get(i)))
+		}
+
+		ASSERT_ALWAYS((~a ^ a).IsAllSet())
+		ASSERT_ALWAYS(a != b)
+		ASSERT_ALWAYS((a | b) == (b | a))
+	}
+
+	//ID allocation
+	{
+		ting::BitSet ids(0x10000);
+		for(size_t i = 0; i != ids.Size(); ++i){
+			size_t id = ids.FindNextClear();
+			ASSERT_ALWAYS(id == i)
+			ids.Set(id);
+		}
+		ASSERT_ALWAYS(ids.FindNextClear() == ids.Size())
+		ids.Clear(40000);
+		ASSERT_ALWAYS(ids.FindNextClear() == 40000)
+	}
+}
+
+}//~namespace
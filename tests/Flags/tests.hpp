@@ -4,3 +4,18 @@
 namespace TestFlags{
 void Run();
 }
+
+
+namespace TestWordFlags{
+void Run();
+}
+
+
+namespace TestBitSet{
+void Run();
+}
+
+
+namespace Benchmark{
+void Run();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "../../src/ting/debug.hpp"
+
+#include "tests.hpp"
+
+
+inline void TestTingFlatHashMap(){
+	TestBasicFlatHashMap::Run();
+	TestFlatHashMapCollisions::Run();
+	TestFlatHashMapRandomOperations::Run();
+
+	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
+}
@@ -0,0 +1,205 @@
+#include <string>
+#include <unordered_map>
+
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/FlatHashMap.hpp"
+
+#include "tests.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace TestBasicFlatHashMap{
+void Run(){
+	ting::FlatHashMap<int, std::string> m;
+	ASSERT_ALWAYS(m.IsEmpty())
+	ASSERT_ALWAYS(m.Capacity() == 0)
+	ASSERT_ALWAYS(!m.Find(1))
+	ASSERT_ALWAYS(!m.Remove(1))
+
+	ASSERT_ALWAYS(m.Insert(1, "one"))
+	ASSERT_ALWAYS(m.Insert(2, "two"))
+	ASSERT_ALWAYS(!m.Insert(1, "uno"))
+	ASSERT_ALWAYS(m.Size() == 2)
+	ASSERT_ALWAYS(*m.Find(1) == "uno")
+	ASSERT_ALWAYS(*m.Find(2) == "two")
+	ASSERT_ALWAYS(!m.Find(3))
+	ASSERT_ALWAYS(m.Contains(2))
+	ASSERT_ALWAYS(!m.Contains(3))
+
+	m[3] = "three";
+	m[3] += "!";
+	ASSERT_ALWAYS(m.Size() == 3)
+	ASSERT_ALWAYS(*m.Find(3) == "three!")
+	ASSERT_ALWAYS(m[4].empty())
+	ASSERT_ALWAYS(m.Size() == 4)
+
+	ASSERT_ALWAYS(m.Remove(4))
+	ASSERT_ALWAYS(!m.Remove(4))
+	ASSERT_ALWAYS(m.Size() == 3)
+
+	//grow
+	for(int i = 100; i != 1100; ++i){
+		m[i] = std::to_string(i);
+	}
+	ASSERT_ALWAYS(m.Size() == 1003)
+	ASSERT_ALWAYS(m.Capacity() >= 1003 + 1003 / 3)
+	ASSERT_ALWAYS((m.Capacity() & (m.Capacity() - 1)) == 0)
+	for(int i = 100; i != 1100; ++i){
+		ASSERT_ALWAYS(*m.Find(i) == std::to_string(i))
+	}
+	ASSERT_ALWAYS(*m.Find(1) == "uno")
+
+	//visit all
+	{
+		size_t n = 0;
+		int sum = 0;
+		m.ForEach([&n, &sum](const int& k, std::string& v){
+			++n;
+			sum += k;
+		});
+		ASSERT_ALWAYS(n == m.Size())
+		ASSERT_ALWAYS(sum == 1 + 2 + 3 + (100 + 1099) * 1000 / 2)
+	}
+
+	//remove odd keys
+	{
+		size_t n = m.RemoveIf([](const int& k, std::string& v){
+			return k % 2 != 0;
+		});
+		ASSERT_INFO_ALWAYS(n == 502, "n = " << n)
+		ASSERT_ALWAYS(m.Size() == 501)
+		for(int i = 100; i != 1100; ++i){
+			ASSERT_ALWAYS(m.Contains(i) == (i % 2 == 0))
+		}
+	}
+
+	size_t capacity = m.Capacity();
+	m.Clear();
+	ASSERT_ALWAYS(m.IsEmpty())
+	ASSERT_ALWAYS(m.Capacity() == capacity)
+	ASSERT_ALWAYS(!m.Find(100))
+
+	//reserve
+	ting::FlatHashMap<int, int> r(1000);
+	ASSERT_ALWAYS(r.Capacity() == 2048)
+	for(int i = 0; i != 1000; ++i){
+		r[i] = i;
+	}
+	ASSERT_ALWAYS(r.Capacity() == 2048)
+}
+}//~namespace
+
+
+
+namespace TestFlatHashMapCollisions{
+
+//all keys collide, so entries form one long probing chain
+struct BadHash{
+	size_t operator()(int k)const{
+		return k / 1000;
+	}
+};
+
+void Run(){
+	ting::FlatHashMap<int, int, BadHash> m;
+
+	for(int i = 0; i != 200; ++i){
+		m[i] = i;
+	}
+	//second group of colliding keys, interleaved with the first one in the table
+	for(int i = 1000; i != 1100; ++i){
+		m[i] = i;
+	}
+	ASSERT_ALWAYS(m.Size() == 300)
+
+	//removal in the middle of the chain should shift the rest back
+	for(int i = 0; i < 200; i += 3){
+		ASSERT_ALWAYS(m.Remove(i))
+	}
+	for(int i = 0; i != 200; ++i){
+		const int* v = m.Find(i);
+		if(i % 3 == 0){
+			ASSERT_ALWAYS(!v)
+		}else{
+			ASSERT_ALWAYS(v && *v == i)
+		}
+	}
+	for(int i = 1000; i != 1100; ++i){
+		ASSERT_ALWAYS(*m.Find(i) == i)
+	}
+
+	size_t n = m.RemoveIf([](const int& k, int& v){
+		return k % 2 == 0;
+	});
+	ASSERT_ALWAYS(n == 66 + 50)
+	ASSERT_ALWAYS(m.Size() == 300 - 67 - n)
+	m.ForEach([](const int& k, const int& v){
+		ASSERT_ALWAYS(k == v)
+		ASSERT_ALWAYS(k % 2 != 0)
+		ASSERT_ALWAYS(k >= 1000 || k % 3 != 0)
+	});
+}
+}//~namespace
+
+
+
+namespace TestFlatHashMapRandomOperations{
+void Run(){
+	ting::FlatHashMap<std::uint32_t, std::uint32_t> m;
+	std::unordered_map<std::uint32_t, std::uint32_t> reference;
+
+	std::uint32_t state = 2463534242u;
+	auto rnd = [&state](){
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	};
+
+	for(unsigned i = 0; i != 200000; ++i){
+		std::uint32_t k = rnd() % 5000;
+		switch(rnd() % 4){
+			case 0:
+			case 1:
+				ASSERT_ALWAYS(m.Insert(k, i) == (reference.find(k) == reference.end()))
+				reference[k] = i;
+				break;
+			case 2:
+				ASSERT_ALWAYS(m.Remove(k) == (reference.erase(k) != 0))
+				break;
+			default:
+				{
+					const std::uint32_t* v = m.Find(k);
+					auto j = reference.find(k);
+					ASSERT_ALWAYS((v != nullptr) == (j != reference.end()))
+					ASSERT_ALWAYS(!v || *v == j->second)
+				}
+				break;
+		}
+		ASSERT_ALWAYS(m.Size() == reference.size())
+
+		if(i % 50000 == 49999){
+			std::uint32_t threshold = i - 20000;
+			m.RemoveIf([threshold](const std::uint32_t& k, std::uint32_t& v){
+				return v < threshold;
+			});
+			for(auto j = reference.begin(); j != reference.end();){
+				if(j->second < threshold){
+					j = reference.erase(j);
+				}else{
+					++j;
+				}
+			}
+			ASSERT_ALWAYS(m.Size() == reference.size())
+		}
+	}
+
+	for(auto& e : reference){
+		ASSERT_ALWAYS(*m.Find(e.first) == e.second)
+	}
+}
+}//~namespace
@@ -0,0 +1,14 @@
+#pragma once
+
+
+namespace TestBasicFlatHashMap{
+void Run();
+}//~namespace
+
+namespace TestFlatHashMapCollisions{
+void Run();
+}//~namespace
+
+namespace TestFlatHashMapRandomOperations{
+void Run();
+}//~namespace
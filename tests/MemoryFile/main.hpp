@@ -7,6 +7,8 @@
 
 inline void TestTingMemoryFile(){
 	TestBasicMemoryFile::Run();
+	TestSharedData::Run();
+	TestConstData::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
 }
@@ -39,3 +39,92 @@ void Run(){
 	}
 }
 }//~namespace
+
+
+
+namespace TestSharedData{
+void Run(){
+	ting::fs::MemoryFile f(std::vector<std::uint8_t>({1, 2, 3, 4}));
+	ASSERT_ALWAYS(f.Size() == 4)
+	
+	auto s = f.Spawn();
+	
+	//both files share the same data
+	ASSERT_ALWAYS(f.SharedData() == dynamic_cast<ting::fs::MemoryFile&>(*s).SharedData())
+	
+	{
+		ting::fs::File::Guard fileGuard1(f, ting::fs::File::E_Mode::READ);
+		ting::fs::File::Guard fileGuard2(*s, ting::fs::File::E_Mode::WRITE);
+		
+		//independent cursors
+		std::array<std::uint8_t, 2> b;
+		f.Read(b);
+		ASSERT_ALWAYS(b[0] == 1)
+		ASSERT_ALWAYS(b[1] == 2)
+		
+		//write makes a private copy
+		std::uint8_t v = 10;
+		s->Write(ting::Buffer<const std::uint8_t>(&v, 1));
+		
+		ASSERT_ALWAYS(f.SharedData() != dynamic_cast<ting::fs::MemoryFile&>(*s).SharedData())
+		
+		f.Read(b);
+		ASSERT_ALWAYS(b[0] == 3)
+		ASSERT_ALWAYS(b[1] == 4)
+		
+		f.Rewind();
+		f.Read(b);
+		ASSERT_ALWAYS(b[0] == 1)
+	}
+	
+	std::vector<std::uint8_t> d = dynamic_cast<ting::fs::MemoryFile&>(*s).ResetData();
+	ASSERT_ALWAYS(d.size() == 4)
+	ASSERT_ALWAYS(d[0] == 10)
+	ASSERT_ALWAYS(d[1] == 2)
+	
+	//shared data is copied on reset and is not affected
+	auto sd = f.SharedData();
+	d = f.ResetData();
+	ASSERT_ALWAYS(f.Size() == 0)
+	ASSERT_ALWAYS(sd->size() == 4)
+	ASSERT_ALWAYS(d == *sd)
+}
+}//~namespace
+
+
+
+namespace TestConstData{
+void Run(){
+	//data passed in as const is never modified, even if the file is the only one referencing it
+	{
+		auto cd = std::make_shared<const std::vector<std::uint8_t>>(std::vector<std::uint8_t>({1, 2, 3}));
+		const std::vector<std::uint8_t>* p = cd.get();
+		
+		ting::fs::MemoryFile f(std::move(cd));
+		ASSERT_ALWAYS(f.SharedData().get() == p)
+		
+		{
+			ting::fs::File::Guard fileGuard(f, ting::fs::File::E_Mode::WRITE);
+			std::uint8_t v = 10;
+			f.Write(ting::Buffer<const std::uint8_t>(&v, 1));
+		}
+		ASSERT_ALWAYS(f.SharedData().get() != p)
+		ASSERT_ALWAYS((*f.SharedData())[0] == 10)
+	}
+	
+	//data given out with SharedData() is not modified by subsequent writes
+	{
+		ting::fs::MemoryFile f(std::vector<std::uint8_t>({1, 2, 3}));
+		auto sd = f.SharedData();
+		
+		{
+			ting::fs::File::Guard fileGuard(f, ting::fs::File::E_Mode::WRITE);
+			std::uint8_t v = 10;
+			f.Write(ting::Buffer<const std::uint8_t>(&v, 1));
+		}
+		ASSERT_ALWAYS((*sd)[0] == 1)
+		ASSERT_ALWAYS(f.Size() == 3)
+		ASSERT_ALWAYS((*f.SharedData())[0] == 10)
+	}
+}
+}//~namespace
@@ -4,3 +4,11 @@
 namespace TestBasicMemoryFile{
 void Run();
 }//~namespace
+
+namespace TestSharedData{
+void Run();
+}//~namespace
+
+namespace TestConstData{
+void Run();
+}//~namespace
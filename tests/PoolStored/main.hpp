@@ -7,6 +7,7 @@
 
 inline void TestTingPoolStored(){
 	BasicPoolStoredTest::Run();
+	TestIOBuffer::Run();
 	
 	TRACE_ALWAYS(<< "[PASSED]: PoolStored test" << std::endl)
 }
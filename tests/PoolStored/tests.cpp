@@ -1,8 +1,10 @@
 #include <deque>
 #include <memory>
+#include <thread>
 
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/PoolStored.hpp"
+#include "../../src/ting/IOBuffer.hpp"
 
 #include "tests.hpp"
 
@@ -51,3 +53,69 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+namespace TestIOBuffer{
+
+typedef ting::IOBuffer<256> T_Buffer;
+
+void Run(){
+	const std::uint8_t* blockPtr;
+	{
+		T_Buffer b = T_Buffer::New();
+		ASSERT_ALWAYS(b)
+		ASSERT_ALWAYS(b.UseCount() == 1)
+		ASSERT_ALWAYS(b.Size() == 0)
+		ASSERT_ALWAYS(b.Buf().size() == 256)
+
+		for(size_t i = 0; i != 10; ++i){
+			b.Buf()[i] = std::uint8_t(i);
+		}
+		b.SetSize(10);
+		blockPtr = b.View().begin();
+
+		T_Buffer c = b;
+		ASSERT_ALWAYS(b.UseCount() == 2)
+		ASSERT_ALWAYS(c.View().begin() == blockPtr)
+		ASSERT_ALWAYS(c.Size() == 10)
+
+		T_Buffer d = std::move(c);
+		ASSERT_ALWAYS(!c)
+		ASSERT_ALWAYS(d.UseCount() == 2)
+
+		d.Reset();
+		ASSERT_ALWAYS(b.UseCount() == 1)
+	}
+
+	//freed block is taken from per-thread cache
+	{
+		T_Buffer b = T_Buffer::New();
+		ASSERT_ALWAYS(b.View().begin() == blockPtr)
+		ASSERT_ALWAYS(b.Size() == 0)
+	}
+
+	//hand buffers over to other thread
+	{
+		std::vector<T_Buffer> bufs;
+		for(unsigned i = 0; i != 100; ++i){
+			bufs.push_back(T_Buffer::New());
+			bufs.back().Buf()[0] = std::uint8_t(i);
+			bufs.back().SetSize(1);
+		}
+
+		unsigned sum = 0;
+		std::thread t([&sum](std::vector<T_Buffer> bufs){
+			for(auto& b : bufs){
+				ASSERT_ALWAYS(b.UseCount() == 1)
+				sum += b.View()[0];
+			}
+			//last references are dropped in this thread, extra blocks go back to the pool on thread exit
+		}, std::move(bufs));
+		t.join();
+
+		ASSERT_INFO_ALWAYS(sum == 99 * 100 / 2, "sum = " << sum)
+	}
+}
+
+}//~namespace
@@ -3,3 +3,7 @@
 namespace BasicPoolStoredTest{
 void Run();
 }
+
+namespace TestIOBuffer{
+void Run();
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "../../src/ting/debug.hpp"
+
+#include "tests.hpp"
+
+
+inline void TestTingRingBuffer(){
+	TestBasicRingBuffer::Run();
+	TestMirroredRingBuffer::Run();
+
+	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
+}
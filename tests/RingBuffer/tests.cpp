@@ -0,0 +1,133 @@
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/RingBuffer.hpp"
+
+#include "tests.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace TestBasicRingBuffer{
+void Run(){
+	ting::RingBuffer rb(10);
+	ASSERT_ALWAYS(rb.Capacity() == 16)
+	ASSERT_ALWAYS(!rb.IsMirrored())
+	ASSERT_ALWAYS(rb.IsEmpty())
+	ASSERT_ALWAYS(rb.NumFree() == 16)
+
+	std::array<std::uint8_t, 12> data;
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i);
+	}
+
+	ASSERT_ALWAYS(rb.Write(data) == 12)
+	ASSERT_ALWAYS(rb.Size() == 12)
+
+	{
+		std::array<std::uint8_t, 8> out;
+		ASSERT_ALWAYS(rb.Read(out) == 8)
+		for(size_t i = 0; i != out.size(); ++i){
+			ASSERT_ALWAYS(out[i] == i)
+		}
+	}
+
+	//free space wraps around the end of the buffer
+	{
+		auto spans = rb.WritableSpans();
+		ASSERT_ALWAYS(spans[0].size() == 4)
+		ASSERT_ALWAYS(spans[1].size() == 8)
+		ASSERT_ALWAYS(rb.WritableSpan().begin() == spans[0].begin())
+	}
+
+	//only part of the data fits
+	ASSERT_ALWAYS(rb.Write(data) == 12)
+	ASSERT_ALWAYS(rb.IsFull())
+	ASSERT_ALWAYS(rb.Write(data) == 0)
+
+	//readable data wraps around the end of the buffer
+	{
+		auto spans = rb.ReadableSpans();
+		ASSERT_ALWAYS(spans[0].size() == 8)
+		ASSERT_ALWAYS(spans[1].size() == 8)
+		ASSERT_ALWAYS(spans[0][0] == 8)
+		ASSERT_ALWAYS(spans[0][4] == 0)
+		ASSERT_ALWAYS(spans[1][0] == 4)
+	}
+
+	//write directly into writable span and commit
+	rb.Consume(3);
+	{
+		auto span = rb.WritableSpan();
+		ASSERT_ALWAYS(span.size() == 3)
+		span[0] = 100;
+		rb.Commit(1);
+	}
+
+	{
+		std::array<std::uint8_t, 0x20> out;
+		size_t n = rb.Read(out);
+		ASSERT_INFO_ALWAYS(n == 14, "n = " << n)
+		ASSERT_ALWAYS(out[0] == 11)
+		ASSERT_ALWAYS(out[1] == 0)
+		ASSERT_ALWAYS(out[12] == 11)
+		ASSERT_ALWAYS(out[13] == 100)
+	}
+	ASSERT_ALWAYS(rb.IsEmpty())
+
+	rb.Write(data);
+	rb.Clear();
+	ASSERT_ALWAYS(rb.IsEmpty())
+	ASSERT_ALWAYS(rb.NumFree() == rb.Capacity())
+}
+}//~namespace
+
+
+
+namespace TestMirroredRingBuffer{
+void Run(){
+	ting::RingBuffer rb(100, true);
+
+#if M_OS == M_OS_LINUX
+	ASSERT_ALWAYS(rb.IsMirrored())
+#endif
+	if(!rb.IsMirrored()){
+		return;
+	}
+
+	ASSERT_INFO_ALWAYS(rb.Capacity() >= 4096, "rb.Capacity() = " << rb.Capacity())
+	ASSERT_ALWAYS((rb.Capacity() & (rb.Capacity() - 1)) == 0)
+
+	std::vector<std::uint8_t> data(rb.Capacity() - 10);
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i);
+	}
+
+	ASSERT_ALWAYS(rb.Write(data) == data.size())
+	rb.Consume(data.size() - 5);
+
+	//the writable region wraps around but is still contiguous
+	{
+		auto span = rb.WritableSpan();
+		ASSERT_ALWAYS(span.size() == rb.Capacity() - 5)
+		ASSERT_ALWAYS(rb.WritableSpans()[1].size() == 0)
+		for(size_t i = 0; i != 20; ++i){
+			span[i] = std::uint8_t(200 + i);
+		}
+		rb.Commit(20);
+	}
+
+	{
+		auto span = rb.ReadableSpan();
+		ASSERT_ALWAYS(span.size() == 25)
+		ASSERT_ALWAYS(rb.ReadableSpans()[1].size() == 0)
+		for(size_t i = 0; i != 5; ++i){
+			ASSERT_ALWAYS(span[i] == std::uint8_t(data.size() - 5 + i))
+		}
+		for(size_t i = 0; i != 20; ++i){
+			ASSERT_ALWAYS(span[5 + i] == 200 + i)
+		}
+	}
+}
+}//~namespace
@@ -0,0 +1,10 @@
+#pragma once
+
+
+namespace TestBasicRingBuffer{
+void Run();
+}//~namespace
+
+namespace TestMirroredRingBuffer{
+void Run();
+}//~namespace
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <vector>
+
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/Shared.hpp"
+#include "../../src/ting/Ref.hpp"
+
+#include "tests.hpp"
+
+
+
+namespace Benchmark{
+
+namespace{
+
+class SharedObj : public ting::Shared{
+public:
+	int a = 0;
+};
+
+template <bool thread_safe> class RefObj : public ting::RefCounted<thread_safe>{
+public:
+	int a = 0;
+};
+
+const unsigned DNumObjects = 1000;
+const unsigned DNumCopies = 100;
+
+//run function several times and return millions of operations per second
+template <class T_Func> double Measure(unsigned numOps, T_Func f){
+	const unsigned DNumIterations = 20;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumIterations; ++i){
+		f();
+	}
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	return double(numOps) * DNumIterations / 1000000 / sec.count();
+}
+
+//create objects, then copy and destroy the pointers
+template <class T_Ptr, class T_Make> double MeasurePointer(T_Make make){
+	volatile int sink = 0;
+	double create = Measure(DNumObjects, [&](){
+		std::vector<T_Ptr> v;
+		v.reserve(DNumObjects);
+		for(unsigned i = 0; i != DNumObjects; ++i){
+			v.push_back(make());
+		}
+		sink = sink + v.back()->a;
+	});
+	
+	std::vector<T_Ptr> objects;
+	for(unsigned i = 0; i != DNumObjects; ++i){
+		objects.push_back(make());
+	}
+	double copy = Measure(DNumObjects * DNumCopies, [&](){
+		for(unsigned j = 0; j != DNumCopies; ++j){
+			std::vector<T_Ptr> v(objects);
+			sink = sink + v.back()->a;
+		}
+	});
+	
+	TRACE_ALWAYS(<< create << " / " << copy << std::endl)
+	return copy;
+}
+
+}//~namespace
+
+
+
+void Run(){
+	TRACE_ALWAYS(<< "\tmillions of create+destroy / copy+destroy operations per second:" << std::endl)
+	
+	TRACE_ALWAYS(<< "\t\tting::New():               ")
+	MeasurePointer<std::shared_ptr<SharedObj>>([](){return ting::New<SharedObj>();});
+	
+	TRACE_ALWAYS(<< "\t\tstd::make_shared():        ")
+	MeasurePointer<std::shared_ptr<RefObj<false>>>([](){return std::make_shared<RefObj<false>>();});
+	
+	TRACE_ALWAYS(<< "\t\tting::MakeRef(), atomic:   ")
+	MeasurePointer<ting::Ref<RefObj<true>>>([](){return ting::MakeRef<RefObj<true>>();});
+	
+	TRACE_ALWAYS(<< "\t\tting::MakeRef(), plain:    ")
+	MeasurePointer<ting::Ref<RefObj<false>>>([](){return ting::MakeRef<RefObj<false>>();});
+}
+
+}//~namespace
@@ -5,6 +5,8 @@
 
 inline void TestTingShared(){
 	TestBasicTingShared::Run();
+	TestRef::Run();
+	Benchmark::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]: Shared test" << std::endl)
 }
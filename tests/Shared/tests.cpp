@@ -1,5 +1,7 @@
 #include "../../src/ting/debug.hpp"
 #include "../../src/ting/Shared.hpp"
+#include "../../src/ting/Ref.hpp"
+#include "../../src/ting/PoolStored.hpp"
 
 #include "tests.hpp"
 
@@ -37,3 +39,107 @@ void Run(){
 
 
 }//~namespace
+
+
+
+namespace TestRef{
+
+int numAlive = 0;
+
+class Base : public ting::RefCounted<>{
+public:
+	int a;
+	
+	Base(int a) : a(a){
+		++numAlive;
+	}
+	
+	~Base()NOEXCEPT{
+		--numAlive;
+	}
+	
+	ting::Ref<Base> GetRef(){
+		return ting::Ref<Base>(this);
+	}
+};
+
+class Derived : public Base{
+public:
+	Derived() : Base(13){}
+};
+
+class Pooled : public ting::RefCounted<false>, public ting::PoolStored<Pooled, 16>{
+public:
+	int b = 7;
+	
+	Pooled(){
+		++numAlive;
+	}
+	
+	~Pooled()NOEXCEPT{
+		--numAlive;
+	}
+};
+
+
+
+void Run(){
+	{
+		ting::Ref<Base> p1 = ting::MakeRef<Base>(4);
+		ASSERT_ALWAYS(p1->a == 4)
+		ASSERT_ALWAYS(p1->RefCount() == 1)
+		ASSERT_ALWAYS(numAlive == 1)
+		
+		ting::Ref<Base> p2 = p1->GetRef();
+		ASSERT_ALWAYS(p2 == p1)
+		ASSERT_ALWAYS(p1->RefCount() == 2)
+		
+		ting::Ref<Base> p3 = std::move(p2);
+		ASSERT_ALWAYS(!p2)
+		ASSERT_ALWAYS(p1->RefCount() == 2)
+		
+		p3.Reset();
+		ASSERT_ALWAYS(!p3)
+		ASSERT_ALWAYS(p1->RefCount() == 1)
+		ASSERT_ALWAYS(numAlive == 1)
+	}
+	ASSERT_ALWAYS(numAlive == 0)
+	
+	//conversions
+	{
+		ting::Ref<Base> b = ting::MakeRef<Derived>();
+		ASSERT_ALWAYS(b->a == 13)
+		ASSERT_ALWAYS(b.DynamicCast<Derived>())
+		
+		ting::Ref<const Base> cb = b;
+		ASSERT_ALWAYS(cb == b)
+		
+		//only implicit conversions are allowed
+		static_assert(std::is_convertible<ting::Ref<Derived>, ting::Ref<Base>>::value, "upcast should be allowed");
+		static_assert(!std::is_convertible<ting::Ref<Base>, ting::Ref<Derived>>::value, "downcast should not be allowed");
+		static_assert(!std::is_convertible<const ting::Ref<Base>&, ting::Ref<Derived>>::value, "downcast should not be allowed");
+		static_assert(!std::is_convertible<ting::Ref<const Base>, ting::Ref<Base>>::value, "removing const should not be allowed");
+		ASSERT_ALWAYS(b->RefCount() == 2)
+		
+		b = nullptr;
+		ASSERT_ALWAYS(numAlive == 1)
+	}
+	ASSERT_ALWAYS(numAlive == 0)
+	
+	//pool stored, non-thread-safe
+	{
+		std::vector<ting::Ref<Pooled>> v;
+		for(unsigned i = 0; i != 40; ++i){
+			v.push_back(ting::MakeRef<Pooled>());
+		}
+		ASSERT_ALWAYS(numAlive == 40)
+		auto copy = v;
+		ASSERT_ALWAYS(v[0]->RefCount() == 2)
+		v.clear();
+		ASSERT_ALWAYS(numAlive == 40)
+		ASSERT_ALWAYS(copy.back()->b == 7)
+	}
+	ASSERT_ALWAYS(numAlive == 0)
+}
+
+}//~namespace
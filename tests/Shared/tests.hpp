@@ -6,3 +6,14 @@ namespace TestBasicTingShared{
 void Run();
 }//~namespace
 
+
+
+
+namespace TestRef{
+void Run();
+}//~namespace
+
+
+namespace Benchmark{
+void Run();
+}//~namespace
@@ -1,11 +1,366 @@
 #include "dns.hpp"
 
 #include "../../src/ting/net/HostNameResolver.hpp"
+#include "../../src/ting/net/BatchResolver.hpp"
+#include "../../src/ting/fs/FSFile.hpp"
 #include "../../src/ting/mt/Thread.hpp"
 #include "../../src/ting/mt/Semaphore.hpp"
 
+#include "../../src/ting/net/UDPSocket.hpp"
+#include "../../src/ting/net/TCPServerSocket.hpp"
+#include "../../src/ting/mt/MsgThread.hpp"
+#include "../../src/ting/WaitSet.hpp"
+#include "../../src/ting/BufferStream.hpp"
+#include "../../src/ting/timer.hpp"
+
 #include <memory>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <cstdio>
+
+
+
+namespace{
+
+//Minimal DNS server answering A and AAAA queries for configured hosts, runs on loopback interface.
+//Host named "*" matches any name which is not configured explicitly.
+//Queries are accepted over UDP and over TCP on the same port.
+class StubDNSServer : public ting::mt::MsgThread{
+	ting::net::UDPSocket socket;
+	ting::net::TCPServerSocket tcpServer;
+	ting::WaitSet waitSet;
+	
+	struct HostRecords{
+		std::vector<ting::net::IPAddress::Host> addresses;
+		std::uint32_t ttl;
+		
+		//name of the host this name is an alias of, empty if not an alias
+		std::string alias;
+	};
+	
+	std::mutex mutex;
+	std::map<std::string, HostRecords> hosts;
+	
+	static void PutName(ting::BufferWriter& w, const std::string& name){
+		for(size_t pos = 0; pos < name.size();){
+			size_t dot = name.find('.', pos);
+			if(dot == std::string::npos){
+				dot = name.size();
+			}
+			w.PutBlob8(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(name.c_str() + pos), dot - pos));
+			pos = dot + 1;
+		}
+		w.Put8(0);
+	}
+	
+	//returns size of the reply, 0 if query is ignored
+	size_t ComposeReply(ting::Buffer<const std::uint8_t> query, ting::Buffer<std::uint8_t> out, bool overTCP){
+		if(query.size() < 12 + 1 + 4){
+			return 0;
+		}
+		
+		bool hasEDNS = ting::util::Deserialize16BE(query.begin() + 10) != 0;
+		if(hasEDNS){
+			++this->numEDNSQueries;
+		}
+		
+		//parse question
+		std::string name;
+		const std::uint8_t* p = query.begin() + 12;
+		for(; p != query.end() && *p != 0; p += *p + 1){
+			if(name.size() != 0){
+				name += '.';
+			}
+			name += std::string(reinterpret_cast<const char*>(p + 1), *p);
+		}
+		++p;
+		if(query.end() - p < 4){
+			return 0;
+		}
+		std::uint16_t type = ting::util::Deserialize16BE(p);
+		p += 4;
+		
+		ting::BufferWriter w(out);
+		
+		if(hasEDNS && this->rejectEDNS){
+			w.Put16BE(ting::util::Deserialize16BE(query.begin()));//ID
+			w.Put16BE(0x8181);//flags: response, recursion available, format error
+			w.Put16BE(1);//number of questions
+			w.Put16BE(0);
+			w.Put16BE(0);
+			w.Put16BE(0);
+			w.PutBytes(ting::Buffer<const std::uint8_t>(query.begin() + 12, size_t(p - query.begin()) - 12));
+			return w.NumWritten();
+		}
+		
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		
+		auto i = this->hosts.find(name);
+		if(i == this->hosts.end()){
+			i = this->hosts.find("*");
+		}
+		
+		//follow alias
+		auto target = i;
+		if(i != this->hosts.end() && i->second.alias.size() != 0){
+			target = this->hosts.find(i->second.alias);
+		}
+		
+		std::vector<ting::net::IPAddress::Host> answers;
+		if(target != this->hosts.end()){
+			for(auto& a : target->second.addresses){
+				if(a.IsIPv4() == (type == 1)){
+					answers.push_back(a);
+				}
+			}
+		}
+		
+		bool isTruncated = !overTCP && answers.size() > this->maxUDPAnswers;
+		if(isTruncated){
+			answers.resize(this->maxUDPAnswers);
+		}
+		
+		bool isAlias = target != i;
+		
+		w.Put16BE(ting::util::Deserialize16BE(query.begin()));//ID
+		w.Put16BE((i == this->hosts.end() ? 0x8183 : 0x8180) | (isTruncated ? 0x200 : 0));//flags: response, recursion available, truncation, response code
+		w.Put16BE(1);//number of questions
+		w.Put16BE(std::uint16_t(answers.size() + (isAlias ? 1 : 0)));
+		w.Put16BE(answers.size() == 0 ? 1 : 0);//number of authority records
+		w.Put16BE(0);//number of other records
+		w.PutBytes(ting::Buffer<const std::uint8_t>(query.begin() + 12, size_t(p - query.begin()) - 12));
+		
+		//offset of the name the addresses belong to
+		std::uint16_t nameOffset = 12;
+		
+		if(isAlias){
+			w.Put16BE(0xc00c);//pointer to the name in question
+			w.Put16BE(5);//CNAME
+			w.Put16BE(1);//class
+			w.Put32BE(i->second.ttl);
+			w.Put16BE(std::uint16_t(i->second.alias.size() + 2));
+			nameOffset = std::uint16_t(w.NumWritten());
+			PutName(w, i->second.alias);
+		}
+		
+		for(auto& a : answers){
+			w.Put16BE(0xc000 | nameOffset);//pointer to the name
+			w.Put16BE(type);
+			w.Put16BE(1);//class
+			w.Put32BE(target->second.ttl);
+			if(a.IsIPv4()){
+				w.Put16BE(4);
+				w.Put32BE(a.IPv4Host());
+			}else{
+				w.Put16BE(16);
+				w.Put32BE(a.Quad0());
+				w.Put32BE(a.Quad1());
+				w.Put32BE(a.Quad2());
+				w.Put32BE(a.Quad3());
+			}
+		}
+		
+		if(answers.size() == 0){
+			//SOA record
+			w.Put16BE(0xc00c);
+			w.Put16BE(6);
+			w.Put16BE(1);
+			w.Put32BE(this->negativeTTL);
+			w.Put16BE(2 + 20);
+			w.Put8(0);//primary name server, root
+			w.Put8(0);//responsible mailbox, root
+			w.Put32BE(1);//serial
+			w.Put32BE(3600);//refresh
+			w.Put32BE(600);//retry
+			w.Put32BE(86400);//expire
+			w.Put32BE(this->negativeTTL);//minimum
+		}
+		
+		return w.NumWritten();
+	}
+	
+	//serve one query over TCP connection, query and reply are prefixed with 2 byte length
+	void ServeTCP(ting::net::TCPSocket& conn){
+		ting::WaitSet ws(1);
+		ws.Add(conn, ting::Waitable::READ);
+		
+		std::vector<std::uint8_t> query(2);
+		for(size_t numReceived = 0; numReceived != query.size();){
+			if(ws.WaitWithTimeout(1000) == 0){
+				break;
+			}
+			size_t n = conn.Recv(ting::Buffer<std::uint8_t>(&query[numReceived], query.size() - numReceived));
+			if(n == 0){
+				break;
+			}
+			numReceived += n;
+			if(numReceived == 2 && query.size() == 2){
+				query.resize(2 + ting::util::Deserialize16BE(&query[0]));
+			}
+		}
+		ws.Remove(conn);
+		
+		if(query.size() == 2){
+			return;
+		}
+		++this->numTCPQueries;
+		
+		std::array<std::uint8_t, 4096> buf;
+		size_t size = this->ComposeReply(ting::Buffer<const std::uint8_t>(&query[2], query.size() - 2), ting::Buffer<std::uint8_t>(&buf[2], buf.size() - 2), true);
+		if(size == 0){
+			return;
+		}
+		ting::util::Serialize16BE(std::uint16_t(size), &buf[0]);
+		
+		for(size_t numSent = 0; numSent != size + 2;){
+			numSent += conn.Send(ting::Buffer<const std::uint8_t>(&buf[numSent], size + 2 - numSent));
+		}
+	}
+	
+public:
+	std::atomic<unsigned> numQueries;
+	std::atomic<unsigned> numEDNSQueries;
+	std::atomic<unsigned> numTCPQueries;
+	
+	//if true, the queries are counted, but not replied
+	std::atomic<bool> silent;
+	
+	std::uint32_t negativeTTL = 30;
+	
+	//UDP replies with more addresses are truncated
+	size_t maxUDPAnswers = size_t(-1);
+	
+	//if true, queries with OPT record are replied with format error, as by name server not supporting EDNS
+	bool rejectEDNS = false;
+	
+	StubDNSServer(std::uint16_t port = 13553) :
+			waitSet(3),
+			numQueries(0),
+			numEDNSQueries(0),
+			numTCPQueries(0),
+			silent(false)
+	{
+		this->socket.Open(port);
+		this->tcpServer.Open(port);
+	}
+	
+	~StubDNSServer()NOEXCEPT{
+		this->PushPreallocatedQuitMessage();
+		this->Join();
+	}
+	
+	ting::net::IPAddress Address(){
+		return ting::net::IPAddress("127.0.0.1", this->socket.GetLocalPort());
+	}
+	
+	void AddHost(const std::string& name, ting::net::IPAddress::Host address, std::uint32_t ttl = 300){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		auto& h = this->hosts[name];
+		h.addresses.push_back(address);
+		h.ttl = ttl;
+	}
+	
+	void AddAlias(const std::string& name, const std::string& target, std::uint32_t ttl = 300){
+		std::lock_guard<decltype(this->mutex)> lock(this->mutex);
+		auto& h = this->hosts[name];
+		h.alias = target;
+		h.ttl = ttl;
+	}
+	
+	void Run()override{
+		this->waitSet.Add(this->queue, ting::Waitable::READ);
+		this->waitSet.Add(this->socket, ting::Waitable::READ);
+		this->waitSet.Add(this->tcpServer, ting::Waitable::READ);
+		
+		while(!this->quitFlag){
+			this->waitSet.Wait();
+			
+			if(this->queue.CanRead()){
+				while(auto m = this->queue.PeekMsg()){
+					m();
+				}
+			}
+			
+			if(this->socket.CanRead()){
+				std::array<std::uint8_t, 512> buf;
+				ting::net::IPAddress from;
+				try{
+					size_t ret = this->socket.Recv(buf, from);
+					if(ret != 0){
+						++this->numQueries;
+						if(this->silent){
+							continue;
+						}
+						std::array<std::uint8_t, 4096> reply;
+						size_t size = this->ComposeReply(ting::Buffer<const std::uint8_t>(&*buf.begin(), ret), reply, false);
+						if(size != 0){
+							this->socket.Send(ting::Buffer<const std::uint8_t>(&*reply.begin(), size), from);
+						}
+					}
+				}catch(ting::net::Exc&){
+					//e.g. ICMP port unreachable for the reply sent to the client which has already closed its socket
+				}
+			}
+			
+			if(this->tcpServer.CanRead()){
+				ting::net::TCPSocket conn = this->tcpServer.Accept();
+				if(conn){
+					this->ServeTCP(conn);
+				}
+			}
+		}
+		
+		this->waitSet.Remove(this->tcpServer);
+		this->waitSet.Remove(this->socket);
+		this->waitSet.Remove(this->queue);
+	}
+};
+
+
+
+class SemaResolver : public ting::net::HostNameResolver{
+	ting::mt::Semaphore sema;
+	
+public:
+	E_Result result;
+	ting::net::IPAddress::Host ip;
+	
+	void OnCompleted_ts(E_Result result, ting::net::IPAddress::Host ip)NOEXCEPT override{
+		this->result = result;
+		this->ip = ip;
+		this->sema.Signal();
+	}
+	
+	bool Wait(std::uint32_t timeoutMillis){
+		return this->sema.Wait(timeoutMillis);
+	}
+};
+
+
+
+class RecordsResolver : public ting::net::HostNameResolver{
+	ting::mt::Semaphore sema;
+	
+public:
+	E_Result result;
+	std::vector<Record> records;
+	
+	void OnCompletedWithRecords_ts(E_Result result, const std::vector<Record>& records)NOEXCEPT override{
+		this->result = result;
+		this->records = records;
+		this->sema.Signal();
+	}
+	
+	bool Wait(std::uint32_t timeoutMillis){
+		return this->sema.Wait(timeoutMillis);
+	}
+};
+
+}//~namespace
 
 namespace TestSimpleDNSLookup{
 
@@ -191,3 +546,618 @@ void Run(){
 	ASSERT_ALWAYS(!r.called)
 }
 }//~namespace
+
+
+
+
+namespace TestDNSCache{
+
+void Run(){
+	StubDNSServer server;
+	server.AddHost("cached.test", ting::net::IPAddress::Host(0x0a000001), 300);
+	server.AddHost("short.test", ting::net::IPAddress::Host(0x0a000002), 1);
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	ting::net::HostNameResolver::SetCacheTTLLimits_ts(0, 86400);
+	
+	SemaResolver r;
+	
+	//first lookup goes to server: AAAA query answered with no data, then A query
+	r.Resolve_ts("cached.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000001)
+	ASSERT_INFO_ALWAYS(server.numQueries == 2, "server.numQueries = " << server.numQueries)
+	
+	//second lookup is served from cache, completed from lookup thread
+	auto stats = ting::net::HostNameResolver::GetCacheStats_ts();
+	r.Resolve_ts("cached.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000001)
+	ASSERT_ALWAYS(server.numQueries == 2)
+	ASSERT_ALWAYS(ting::net::HostNameResolver::GetCacheStats_ts().hits == stats.hits + 2)//negative AAAA and positive A
+	
+	//synchronous completion
+	ting::net::HostNameResolver::SetSynchronousCacheHits_ts(true);
+	r.Resolve_ts("cached.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(0))
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000001)
+	ting::net::HostNameResolver::SetSynchronousCacheHits_ts(false);
+	
+	//negative caching
+	r.Resolve_ts("nonexistent.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST)
+	unsigned numQueries = server.numQueries;
+	r.Resolve_ts("nonexistent.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST)
+	ASSERT_ALWAYS(server.numQueries == numQueries)
+	
+	//entry expires according to TTL
+	r.Resolve_ts("short.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000002)
+	numQueries = server.numQueries;
+	ting::mt::Thread::Sleep(1100);
+	r.Resolve_ts("short.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000002)
+	ASSERT_ALWAYS(server.numQueries == numQueries + 1)//only A record has expired, AAAA record is negative with TTL of 30 seconds
+	
+	//entry stays expired long after expiration, 30 days is more than half of 32-bit milliseconds range
+	r.Resolve_ts("cached.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	numQueries = server.numQueries;
+	ting::net::HostNameResolver::AdvanceCacheClock_ts(std::uint64_t(30) * 24 * 3600 * 1000);
+	r.Resolve_ts("cached.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000001)
+	ASSERT_INFO_ALWAYS(server.numQueries == numQueries + 2, "server.numQueries = " << server.numQueries)//both AAAA and A records have expired
+	
+	//minimal TTL clamp
+	ting::net::HostNameResolver::ClearCache_ts();
+	ting::net::HostNameResolver::SetCacheTTLLimits_ts(60, 86400);
+	r.Resolve_ts("short.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	numQueries = server.numQueries;
+	ting::mt::Thread::Sleep(1100);
+	r.Resolve_ts("short.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(server.numQueries == numQueries)
+	
+	ting::net::HostNameResolver::SetCacheTTLLimits_ts(0, 86400);
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+
+namespace TestDNSNameServers{
+
+void Run(){
+	StubDNSServer silentServer(13553);
+	silentServer.silent = true;
+	silentServer.Start();
+	
+	StubDNSServer server(13554);
+	server.AddHost("hedged.test", ting::net::IPAddress::Host(0x0a000003));
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	std::vector<ting::net::IPAddress> servers;
+	servers.push_back(silentServer.Address());
+	servers.push_back(server.Address());
+	ting::net::HostNameResolver::SetNameServers_ts(servers, 500, 2);
+	
+	SemaResolver r;
+	
+	//first server does not reply, query should be sent to second server before the attempt timeout of the first one is hit
+	std::uint32_t start = ting::timer::GetTicks();
+	r.Resolve_ts("hedged.test", 10000);
+	ASSERT_ALWAYS(r.Wait(4000))
+	std::uint32_t elapsed = ting::timer::GetTicks() - start;
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.ip.IPv4Host() == 0x0a000003)
+	ASSERT_INFO_ALWAYS(elapsed < 2000, "elapsed = " << elapsed)
+	ASSERT_ALWAYS(server.numQueries == 2)//AAAA and A
+	ASSERT_INFO_ALWAYS(silentServer.numQueries == 1, "silentServer.numQueries = " << silentServer.numQueries)//silent server is considered slow after first attempt
+	
+	ting::net::HostNameResolver::SetNameServers_ts(std::vector<ting::net::IPAddress>());
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+
+namespace TestDNSRecords{
+
+void Run(){
+	typedef ting::net::IPAddress::Host Host;
+	
+	StubDNSServer server;
+	server.AddHost("multi.test", Host(0x0a00000b), 300);
+	server.AddHost("multi.test", Host(0x0a00000c), 300);
+	server.AddHost("multi.test", Host(0x0a00000d), 300);
+	server.AddHost("dual.test", Host(0x20010db8, 0, 0, 1), 120);
+	server.AddHost("dual.test", Host(0x20010db8, 0, 0, 2), 120);
+	server.AddHost("dual.test", Host(0x0a000015), 120);
+	server.AddHost("dual.test", Host(0x0a000016), 120);
+	server.AddHost("v4only.test", Host(0x0a000020), 60);
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	RecordsResolver r;
+	
+	//all A records are reported
+	r.Resolve_ts("multi.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_INFO_ALWAYS(r.records.size() == 3, "r.records.size() = " << r.records.size())
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a00000b)
+	ASSERT_ALWAYS(r.records[1].ip.IPv4Host() == 0x0a00000c)
+	ASSERT_ALWAYS(r.records[2].ip.IPv4Host() == 0x0a00000d)
+	ASSERT_ALWAYS(r.records[0].ttl == 300)
+	
+	//both families, interleaved starting from IPv6
+	for(unsigned i = 0; i != 2; ++i){//second time from cache
+		unsigned numQueries = server.numQueries;
+		r.Resolve_ts("dual.test", 3000, server.Address(), ting::net::HostNameResolver::IPV6_AND_IPV4);
+		ASSERT_ALWAYS(r.Wait(4000))
+		ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+		ASSERT_INFO_ALWAYS(r.records.size() == 4, "r.records.size() = " << r.records.size())
+		ASSERT_ALWAYS(r.records[0].ip == Host(0x20010db8, 0, 0, 1))
+		ASSERT_ALWAYS(r.records[1].ip.IPv4Host() == 0x0a000015)
+		ASSERT_ALWAYS(r.records[2].ip == Host(0x20010db8, 0, 0, 2))
+		ASSERT_ALWAYS(r.records[3].ip.IPv4Host() == 0x0a000016)
+		for(auto& rec : r.records){
+			ASSERT_INFO_ALWAYS(rec.ttl != 0 && rec.ttl <= 120, "rec.ttl = " << rec.ttl)
+		}
+		ASSERT_ALWAYS(server.numQueries == numQueries + (i == 0 ? 2 : 0))
+	}
+	
+	//no IPv6 addresses
+	r.Resolve_ts("v4only.test", 3000, server.Address(), ting::net::HostNameResolver::IPV6_AND_IPV4);
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.records.size() == 1)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a000020)
+	
+	r.Resolve_ts("nonexistent.test", 3000, server.Address(), ting::net::HostNameResolver::IPV6_AND_IPV4);
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST)
+	ASSERT_ALWAYS(r.records.size() == 0)
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+
+
+namespace TestDNSLargeReplies{
+
+void Run(){
+	typedef ting::net::IPAddress::Host Host;
+	
+	StubDNSServer server;
+	for(unsigned i = 0; i != 40; ++i){
+		server.AddHost("big.test", Host(0x0a010000 + i), 300);
+	}
+	server.AddAlias("alias.test", "big.test", 60);
+	server.maxUDPAnswers = 5;
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	RecordsResolver r;
+	
+	//truncated UDP reply, query is repeated over TCP
+	r.Resolve_ts("big.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_INFO_ALWAYS(r.records.size() == 40, "r.records.size() = " << r.records.size())
+	for(unsigned i = 0; i != r.records.size(); ++i){
+		ASSERT_ALWAYS(r.records[i].ip.IPv4Host() == 0x0a010000 + i)
+	}
+	ASSERT_INFO_ALWAYS(server.numTCPQueries == 1, "server.numTCPQueries = " << server.numTCPQueries)
+	
+	//all UDP queries advertise bigger payload size with EDNS
+	ASSERT_INFO_ALWAYS(server.numEDNSQueries == server.numQueries + server.numTCPQueries, "server.numEDNSQueries = " << server.numEDNSQueries)
+	
+	//alias, names in the reply are compressed
+	r.Resolve_ts("alias.test", 3000, server.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_INFO_ALWAYS(r.records.size() == 40, "r.records.size() = " << r.records.size())
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a010000)
+	ASSERT_INFO_ALWAYS(r.records[0].ttl <= 60, "r.records[0].ttl = " << r.records[0].ttl)//TTL of the alias
+	ASSERT_ALWAYS(server.numTCPQueries == 2)
+	
+	//name server which does not support EDNS
+	StubDNSServer oldServer(13554);
+	oldServer.AddHost("old.test", Host(0x0a020001));
+	oldServer.rejectEDNS = true;
+	oldServer.Start();
+	
+	r.Resolve_ts("old.test", 3000, oldServer.Address());
+	ASSERT_ALWAYS(r.Wait(4000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.records.size() == 1)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a020001)
+	ASSERT_INFO_ALWAYS(oldServer.numQueries == 3, "oldServer.numQueries = " << oldServer.numQueries)//AAAA with EDNS, AAAA and A without EDNS
+	ASSERT_ALWAYS(oldServer.numEDNSQueries == 1)
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+namespace TestDNSHostsFile{
+
+void WriteFile(const char* fileName, const std::string& content){
+	ting::fs::FSFile f(fileName);
+	ting::fs::File::Guard fileGuard(f, ting::fs::File::E_Mode::CREATE);
+	f.Write(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(content.c_str()), content.size()));
+}
+
+void Run(){
+	typedef ting::net::IPAddress::Host Host;
+	
+	const char* hostsFileName = "hosts.tmp";
+	
+	WriteFile(
+			hostsFileName,
+			"# comment line\n"
+			"10.3.0.1\tlocal.test  Alias.Test # comment\n"
+			"2001:db8::3 dual.local.test\n"
+			"10.3.0.2 dual.local.test\n"
+			"bad.address ignored.test\n"
+		);
+	
+	StubDNSServer server;
+	server.AddHost("printer.lab.test", Host(0x0a030101));
+	server.AddHost("printer", Host(0x0a030102));
+	server.AddHost("www.example.test", Host(0x0a030103));
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	std::vector<ting::net::IPAddress> servers;
+	servers.push_back(server.Address());
+	ting::net::HostNameResolver::SetNameServers_ts(servers, 500, 2);
+	
+	ting::net::HostNameResolver::SetHostsFile_ts(hostsFileName);
+	
+	RecordsResolver r;
+	
+	//host names in hosts file are case insensitive
+	r.Resolve_ts("alias.test");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.records.size() == 1)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030001)
+	
+	r.Resolve_ts("dual.local.test", 2000, ting::net::IPAddress(Host(0), 0), ting::net::HostNameResolver::IPV6_AND_IPV4);
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.records.size() == 2)
+	ASSERT_ALWAYS(r.records[0].ip == Host(0x20010db8, 0, 0, 3))
+	ASSERT_ALWAYS(r.records[1].ip.IPv4Host() == 0x0a030002)
+	
+	//with synchronous completion the lookup thread is not involved
+	ting::net::HostNameResolver::SetSynchronousCacheHits_ts(true);
+	r.Resolve_ts("local.test");
+	ASSERT_ALWAYS(r.Wait(0))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030001)
+	ting::net::HostNameResolver::SetSynchronousCacheHits_ts(false);
+	
+	ASSERT_INFO_ALWAYS(server.numQueries == 0, "server.numQueries = " << server.numQueries)
+	
+	//hosts file is reloaded when it changes
+	WriteFile(hostsFileName, "10.3.0.9 local.test\n");
+	ting::mt::Thread::Sleep(1100);
+	
+	r.Resolve_ts("local.test");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030009)
+	
+	r.Resolve_ts("alias.test");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST, "r.result = " << r.result)
+	
+	std::vector<std::string> domains;
+	domains.push_back("corp.test");
+	domains.push_back("lab.test.");
+	ting::net::HostNameResolver::SetSearchDomains_ts(domains);
+	
+	//name without dots is tried with search domains first
+	r.Resolve_ts("printer");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_INFO_ALWAYS(r.result == ting::net::HostNameResolver::OK, "r.result = " << r.result)
+	ASSERT_ALWAYS(r.records.size() == 1)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030101)
+	
+	//name with enough dots is tried as is first
+	unsigned numQueries = server.numQueries;
+	r.Resolve_ts("www.example.test");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030103)
+	ASSERT_INFO_ALWAYS(server.numQueries - numQueries == 2, "queries = " << (server.numQueries - numQueries))//AAAA and A
+	
+	//fully qualified name is tried only as is
+	r.Resolve_ts("printer.");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::OK)
+	ASSERT_ALWAYS(r.records[0].ip.IPv4Host() == 0x0a030102)
+	
+	numQueries = server.numQueries;
+	r.Resolve_ts("absent.");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST)
+	ASSERT_ALWAYS(server.numQueries - numQueries == 2)
+	
+	//all names are tried
+	numQueries = server.numQueries;
+	r.Resolve_ts("missing");
+	ASSERT_ALWAYS(r.Wait(2000))
+	ASSERT_ALWAYS(r.result == ting::net::HostNameResolver::NO_SUCH_HOST)
+	ASSERT_INFO_ALWAYS(server.numQueries - numQueries == 6, "queries = " << (server.numQueries - numQueries))
+	
+	ting::net::HostNameResolver::SetSearchDomains_ts(std::vector<std::string>());
+	ting::net::HostNameResolver::SetHostsFile_ts(std::string());
+	ting::net::HostNameResolver::SetNameServers_ts(std::vector<ting::net::IPAddress>());
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	std::remove(hostsFileName);
+}
+
+}//~namespace
+
+
+
+namespace TestDNSBatch{
+
+void Run(){
+	StubDNSServer server;
+	server.AddHost("*", ting::net::IPAddress::Host(0x20010db8, 0, 0, 2));
+	server.Start();
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	std::vector<ting::net::IPAddress> servers;
+	servers.push_back(server.Address());
+	ting::net::HostNameResolver::SetNameServers_ts(servers, 200, 5);
+	
+	const unsigned numNames = 2000;
+	
+	std::vector<std::string> names;
+	for(unsigned i = 0; i != numNames; ++i){
+		std::stringstream ss;
+		ss << "host" << i << ".batch";
+		names.push_back(ss.str());
+	}
+	names.push_back(std::string(300, 'a'));//too long name
+	
+	{
+		ting::net::BatchResolver batch(names, 10000);
+		ASSERT_ALWAYS(batch.Size() == numNames + 1)
+		
+		//wait for completion via WaitSet
+		ting::WaitSet waitSet(1);
+		waitSet.Add(batch, ting::Waitable::READ);
+		ASSERT_ALWAYS(waitSet.WaitWithTimeout(20000) == 1)
+		ASSERT_ALWAYS(batch.CanRead())
+		waitSet.Remove(batch);
+		
+		ASSERT_ALWAYS(batch.Wait_ts(0))
+		ASSERT_ALWAYS(batch.NumCompleted_ts() == batch.Size())
+		
+		for(unsigned i = 0; i != numNames; ++i){
+			ASSERT_ALWAYS(batch.IsCompleted_ts(i))
+			ASSERT_INFO_ALWAYS(batch[i].result == ting::net::HostNameResolver::OK, "batch[" << i << "].result = " << batch[i].result)
+			ASSERT_ALWAYS(batch[i].records.size() == 1)
+			ting::net::IPAddress::Host ip = batch[i].records[0].ip;
+			ASSERT_ALWAYS(ip == ting::net::IPAddress::Host(0x20010db8, 0, 0, 2))
+		}
+		ASSERT_ALWAYS(batch[numNames].result == ting::net::HostNameResolver::ERROR)
+		ASSERT_ALWAYS(batch[numNames].records.size() == 0)
+	}
+	
+	//names are resolved from cache now
+	{
+		names.resize(10);
+		ting::net::BatchResolver batch(names);
+		ASSERT_ALWAYS(batch.Wait_ts(5000))
+		ASSERT_ALWAYS(batch[9].result == ting::net::HostNameResolver::OK)
+	}
+	
+	//empty batch is completed right away
+	{
+		ting::net::BatchResolver batch{std::vector<std::string>()};
+		ASSERT_ALWAYS(batch.CanRead())
+		ASSERT_ALWAYS(batch.Wait_ts(0))
+	}
+	
+	ting::net::HostNameResolver::ClearCache_ts();
+	
+	//destroying the batch cancels lookups in progress
+	{
+		StubDNSServer silentServer(13554);
+		silentServer.silent = true;
+		silentServer.Start();
+		
+		servers.clear();
+		servers.push_back(silentServer.Address());
+		ting::net::HostNameResolver::SetNameServers_ts(servers);
+		
+		names.resize(numNames);
+		ting::net::BatchResolver batch(names, 10000);
+		ASSERT_ALWAYS(!batch.Wait_ts(200))
+		ASSERT_ALWAYS(batch.NumCompleted_ts() == 0)
+	}
+	
+	ting::net::HostNameResolver::SetNameServers_ts(std::vector<ting::net::IPAddress>());
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+
+namespace TestDNSBatchConcurrentCancel{
+
+//Destroys batches while the lookups of the other thread's batch are being completed.
+//Completion callback of one batch starts further lookups while destructor of the other
+//batch cancels its lookups, this should not deadlock.
+class CancelThread : public ting::mt::Thread{
+public:
+	unsigned id;
+	
+	CancelThread(unsigned id) :
+			id(id)
+	{}
+	
+	void Run()override{
+		for(unsigned k = 0; k != 50; ++k){
+			std::vector<std::string> names;
+			for(unsigned i = 0; i != 500; ++i){
+				std::stringstream ss;
+				ss << "host" << i << ".it" << k << ".thread" << this->id << ".batch";
+				names.push_back(ss.str());
+			}
+			
+			ting::net::BatchResolver batch(names, 10000);
+			ting::mt::Thread::Sleep(k % 5);
+		}
+	}
+};
+
+
+
+void Run(){
+	StubDNSServer server;
+	server.AddHost("*", ting::net::IPAddress::Host(0x7f000001));
+	server.Start();
+	
+	std::vector<ting::net::IPAddress> servers;
+	servers.push_back(server.Address());
+	ting::net::HostNameResolver::SetNameServers_ts(servers, 200, 5);
+	
+	CancelThread t1(1), t2(2);
+	t1.Start();
+	t2.Start();
+	t1.Join();
+	t2.Join();
+	
+	ting::net::HostNameResolver::SetNameServers_ts(std::vector<ting::net::IPAddress>());
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
+
+
+
+namespace BenchmarkDNSLookup{
+
+const unsigned DNumLookups = 100000;
+//number of lookups in flight, UDP socket buffers of loopback interface overflow if there are too many
+const unsigned DNumResolvers = 100;
+
+struct Context{
+	std::atomic<unsigned> numStarted;
+	std::atomic<unsigned> numCompleted;
+	std::atomic<unsigned> numFailed;
+	ting::mt::Semaphore done;
+	
+	Context() :
+			numStarted(0),
+			numCompleted(0),
+			numFailed(0)
+	{}
+	
+	//returns false if all lookups are started
+	bool StartNext(ting::net::HostNameResolver& r){
+		unsigned n = this->numStarted++;
+		if(n >= DNumLookups){
+			return false;
+		}
+		std::stringstream ss;
+		ss << "host" << n << ".bench";
+		r.Resolve_ts(ss.str(), 10000);
+		return true;
+	}
+};
+
+class Resolver : public ting::net::HostNameResolver{
+	Context& c;
+public:
+	Resolver(Context& c) :
+			c(c)
+	{}
+	
+	void OnCompleted_ts(E_Result result, ting::net::IPAddress::Host ip)NOEXCEPT override{
+		if(result != OK){
+			++this->c.numFailed;
+		}
+		if(++this->c.numCompleted == DNumLookups){
+			this->c.done.Signal();
+			return;
+		}
+		try{
+			this->c.StartNext(*this);
+		}catch(...){
+			ASSERT_ALWAYS(false)
+		}
+	}
+};
+
+void Run(){
+	StubDNSServer server;
+	server.AddHost("*", ting::net::IPAddress::Host(0x20010db8, 0, 0, 1));
+	server.Start();
+	
+	//do not let the cache grow, every lookup goes to the server
+	ting::net::HostNameResolver::SetCacheTTLLimits_ts(0, 0);
+	
+	//short attempt timeout to quickly resend lost UDP packets
+	std::vector<ting::net::IPAddress> servers;
+	servers.push_back(server.Address());
+	ting::net::HostNameResolver::SetNameServers_ts(servers, 200, 5);
+	
+	Context c;
+	
+	std::vector<std::unique_ptr<Resolver>> resolvers;
+	for(unsigned i = 0; i != DNumResolvers; ++i){
+		resolvers.push_back(std::unique_ptr<Resolver>(new Resolver(c)));
+	}
+	
+	auto start = std::chrono::high_resolution_clock::now();
+	for(auto& r : resolvers){
+		c.StartNext(*r);
+	}
+	ASSERT_ALWAYS(c.done.Wait(60000))
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	
+	ASSERT_INFO_ALWAYS(c.numFailed == 0, "c.numFailed = " << c.numFailed)
+	
+	TRACE_ALWAYS(<< "\tDNS lookups against local stub server (" << DNumResolvers << " in flight): " << unsigned(DNumLookups / sec.count()) << " lookups per second" << std::endl)
+	
+	ting::net::HostNameResolver::SetNameServers_ts(std::vector<ting::net::IPAddress>());
+	ting::net::HostNameResolver::SetCacheTTLLimits_ts(0, 86400);
+	ting::net::HostNameResolver::ClearCache_ts();
+}
+
+}//~namespace
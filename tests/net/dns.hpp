@@ -14,4 +14,36 @@ namespace TestCancelDNSLookup{
 void Run();
 }
 
+namespace TestDNSCache{
+void Run();
+}
+
+namespace TestDNSNameServers{
+void Run();
+}
+
+namespace TestDNSRecords{
+void Run();
+}
+
+namespace TestDNSLargeReplies{
+void Run();
+}
+
+namespace TestDNSHostsFile{
+void Run();
+}
+
+namespace TestDNSBatch{
+void Run();
+}
+
+namespace TestDNSBatchConcurrentCancel{
+void Run();
+}
+
+namespace BenchmarkDNSLookup{
+void Run();
+}
+
 //TODO: test explicit dns server IP
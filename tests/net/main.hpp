@@ -10,12 +10,28 @@ inline void TestTingSocket(){
 	
 	BasicIPAddressTest::Run();
 	TestIPAddress::Run();
+	TestIPHostParseAndFormat::Run();
+	BenchmarkIPHostParseAndFormat::Run();
+	TestIPPrefix::Run();
+	BenchmarkIPPrefixTable::Run();
+	TestIPAddressHashing::Run();
+	BenchmarkConnectionTracking::Run();
 		
 	BasicClientServerTest::Run();
 	BasicUDPSocketsTest::Run();
 	TestUDPSocketWaitForWriting::Run();
 	SendDataContinuouslyWithWaitSet::Run();
 	SendDataContinuously::Run();
+	TestRingBufferSendRecv::Run();
+
+	TestDNSCache::Run();
+	TestDNSNameServers::Run();
+	TestDNSRecords::Run();
+	TestDNSLargeReplies::Run();
+	TestDNSHostsFile::Run();
+	TestDNSBatch::Run();
+	TestDNSBatchConcurrentCancel::Run();
+	BenchmarkDNSLookup::Run();
 
 	TestSimpleDNSLookup::Run();
 	TestRequestFromCallback::Run();
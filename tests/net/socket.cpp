@@ -4,10 +4,26 @@
 #include "../../src/ting/net/TCPSocket.hpp"
 #include "../../src/ting/net/TCPServerSocket.hpp"
 #include "../../src/ting/net/UDPSocket.hpp"
+#include "../../src/ting/net/IPPrefix.hpp"
 #include "../../src/ting/WaitSet.hpp"
 #include "../../src/ting/Buffer.hpp"
 #include "../../src/ting/config.hpp"
 #include "../../src/ting/util.hpp"
+#include "../../src/ting/FlatHashMap.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
+#include <sstream>
+#include <cstring>
+
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+#	include <arpa/inet.h>
+#endif
 
 #include "socket.hpp"
 
@@ -144,6 +160,20 @@ void Run(){
 		ASSERT_ALWAYS(data[1] == '1')
 		ASSERT_ALWAYS(data[2] == '2')
 		ASSERT_ALWAYS(data[3] == '4')
+		
+		//receiving to full ring buffer should not look like connection closed by peer
+		{
+			ting::RingBuffer rb(1);
+			rb.Commit(1);
+			ASSERT_ALWAYS(rb.IsFull())
+			bool thrown = false;
+			try{
+				sock.Recv(rb);
+			}catch(ting::net::Exc&){
+				thrown = true;
+			}
+			ASSERT_ALWAYS(thrown)
+		}
 	}catch(ting::net::Exc &e){
 		ASSERT_INFO_ALWAYS(false, "Network error: " << e.What())
 	}
@@ -418,6 +448,71 @@ void Run(){
 
 
 
+namespace TestRingBufferSendRecv{
+
+void Run(){
+	ting::net::TCPServerSocket serverSock;
+	serverSock.Open(13667);
+	
+	ting::net::TCPSocket sockS;
+	sockS.Open(ting::net::IPAddress("127.0.0.1", 13667));
+	
+	ting::net::TCPSocket sockR;
+	for(unsigned i = 0; i < 20 && !sockR; ++i){
+		ting::mt::Thread::Sleep(100);
+		sockR = serverSock.Accept();
+	}
+	ASSERT_ALWAYS(sockR)
+	
+	const size_t DDataSize = 3000;
+	
+	std::vector<std::uint8_t> data(DDataSize);
+	for(size_t i = 0; i != data.size(); ++i){
+		data[i] = std::uint8_t(i * 7 + i / 256);
+	}
+	
+	//non-mirrored buffers with read and write positions near the end, so that data wraps around
+	ting::RingBuffer sendRb(4096);
+	ting::RingBuffer recvRb(4096);
+	ASSERT_ALWAYS(!sendRb.IsMirrored() && !recvRb.IsMirrored())
+	sendRb.Commit(sendRb.Capacity() - 1000);
+	sendRb.Consume(sendRb.Capacity() - 1000);
+	recvRb.Commit(recvRb.Capacity() - 500);
+	recvRb.Consume(recvRb.Capacity() - 500);
+	
+	ASSERT_ALWAYS(sendRb.Write(ting::Buffer<const std::uint8_t>(&*data.begin(), data.size())) == data.size())
+	ASSERT_ALWAYS(sendRb.ReadableSpans()[0].size() == 1000)
+	ASSERT_ALWAYS(sendRb.ReadableSpans()[1].size() == DDataSize - 1000)
+	
+	ting::WaitSet ws(1);
+	ws.Add(sockR, ting::Waitable::READ);
+	
+	for(unsigned i = 0; i != 100 && (!sendRb.IsEmpty() || recvRb.Size() != DDataSize); ++i){
+		if(!sendRb.IsEmpty()){
+			sockS.Send(sendRb);
+		}
+		if(ws.WaitWithTimeout(100) != 0){
+			size_t n = sockR.Recv(recvRb);
+			ASSERT_ALWAYS(n != 0)//connection is not closed
+		}
+	}
+	
+	ws.Remove(sockR);
+	
+	ASSERT_ALWAYS(sendRb.IsEmpty())
+	ASSERT_INFO_ALWAYS(recvRb.Size() == DDataSize, "recvRb.Size() = " << recvRb.Size())
+	ASSERT_ALWAYS(recvRb.ReadableSpans()[0].size() == 500)
+	ASSERT_ALWAYS(recvRb.ReadableSpans()[1].size() == DDataSize - 500)
+	
+	std::vector<std::uint8_t> received(DDataSize);
+	ASSERT_ALWAYS(recvRb.Read(ting::Buffer<std::uint8_t>(&*received.begin(), received.size())) == DDataSize)
+	ASSERT_ALWAYS(received == data)
+}
+
+}//~namespace
+
+
+
 namespace BasicIPAddressTest{
 
 void Run(){
@@ -758,3 +853,710 @@ void Run(){
 }
 
 }//~namespace
+
+
+
+namespace TestIPHostParseAndFormat{
+
+bool TryParse(const char* str, ting::net::IPAddress::Host& out){
+	return ting::net::IPAddress::Host::TryParse(ting::Buffer<const char>(str, strlen(str)), out);
+}
+
+void Run(){
+	//valid addresses and their canonical text representation
+	struct{
+		const char* str;
+		std::uint32_t q0, q1, q2, q3;
+		const char* canonical;
+	} valid[] = {
+		{"127.0.0.1", 0, 0, 0xffff, 0x7f000001, "127.0.0.1"},
+		{"0.0.0.0", 0, 0, 0xffff, 0, "0.0.0.0"},
+		{"255.255.255.255", 0, 0, 0xffff, 0xffffffff, "255.255.255.255"},
+		{"10.0.100.9", 0, 0, 0xffff, 0x0a006409, "10.0.100.9"},
+		{"::", 0, 0, 0, 0, "::"},
+		{"::1", 0, 0, 0, 1, "::1"},
+		{"1::", 0x10000, 0, 0, 0, "1::"},
+		{"1002:3004:5006::7008:900a", 0x10023004, 0x50060000, 0, 0x7008900a, "1002:3004:5006::7008:900a"},
+		{"2001:DB8:0:0:0:0:0:1", 0x20010db8, 0, 0, 1, "2001:db8::1"},
+		{"2001:0db8:0000:0001:0000:0000:0000:0001", 0x20010db8, 1, 0, 1, "2001:db8:0:1::1"},
+		{"2001:db8:0:0:1:0:0:1", 0x20010db8, 0, 0x10000, 1, "2001:db8::1:0:0:1"},
+		{"2001:db8::1:0:0:0:1", 0x20010db8, 1, 0, 1, "2001:db8:0:1::1"},
+		{"2001:db8:0:1:1:1:1:1", 0x20010db8, 1, 0x10001, 0x10001, "2001:db8:0:1:1:1:1:1"},
+		{"ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff", 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"},
+		{"::ffff:127.0.0.1", 0, 0, 0xffff, 0x7f000001, "127.0.0.1"},
+		{"::FFFF:7f00:1", 0, 0, 0xffff, 0x7f000001, "127.0.0.1"},
+		{"64:ff9b::192.0.2.33", 0x0064ff9b, 0, 0, 0xc0000221, "64:ff9b::c000:221"},
+		{"1:2:3:4:5:6:1.2.3.4", 0x10002, 0x30004, 0x50006, 0x01020304, "1:2:3:4:5:6:102:304"}
+	};
+	
+	for(auto& v : valid){
+		ting::net::IPAddress::Host h;
+		ASSERT_INFO_ALWAYS(TryParse(v.str, h), v.str)
+		ASSERT_INFO_ALWAYS(h.Quad0() == v.q0 && h.Quad1() == v.q1 && h.Quad2() == v.q2 && h.Quad3() == v.q3, v.str)
+		
+		std::array<char, ting::net::IPAddress::Host::DMaxStringLength> buf;
+		size_t len = h.Format(buf);
+		ASSERT_INFO_ALWAYS(std::string(&*buf.begin(), len) == v.canonical, v.str << " formatted as " << std::string(&*buf.begin(), len))
+		ASSERT_ALWAYS(h.ToString() == v.canonical)
+		
+		//canonical form should parse back to the same address
+		ting::net::IPAddress::Host h2;
+		ASSERT_INFO_ALWAYS(TryParse(v.canonical, h2), v.canonical)
+		ASSERT_ALWAYS(h2 == h)
+		
+		//too small output buffer
+		ASSERT_ALWAYS(h.Format(ting::Buffer<char>(&*buf.begin(), len - 1)) == 0)
+	}
+	
+	const char* invalid[] = {
+		"",
+		"127.0.0",
+		"127.0.0.1.",
+		"127.0.0.1.1",
+		"127.0.0.256",
+		"127.0.0.01",
+		"127.0.0.0001",
+		"127..0.1",
+		".127.0.0.1",
+		"127.0.0.1 ",
+		"127.0.0.1:80",
+		"127.0.0.a",
+		":",
+		":::",
+		"1:2:3:4:5:6:7",
+		"1:2:3:4:5:6:7:8:9",
+		"1:2:3:4:5:6:7::8",
+		"1:2:3:4:5:6:7:8::",
+		"::1:2:3:4:5:6:7:8",
+		"1:2:3:4:5:6:7:8::1",
+		"1:2:3:4:5:6:1.2.3.4::",
+		"1:2:3:4::5:6:7:8",
+		"1::2::3",
+		":1::2",
+		"1::2:",
+		"1:",
+		"12345::",
+		"g::1",
+		"::1%eth0",
+		"[::1]",
+		"::ffff:1.2.3",
+		"::ffff:1.2.3.4:5",
+		"1:2:3:4:5:6:7:1.2.3.4",
+		"::ffff:01.2.3.4",
+		"::1a.2.3.4"
+	};
+	
+	for(auto str : invalid){
+		ting::net::IPAddress::Host h(0x01020304);
+		ASSERT_INFO_ALWAYS(!TryParse(str, h), str)
+		ASSERT_INFO_ALWAYS(h.IPv4Host() == 0x01020304, str)//should not be changed
+	}
+	
+	//not null-terminated input
+	{
+		const char str[] = "10.0.0.12345";
+		ting::net::IPAddress::Host h;
+		ASSERT_ALWAYS(ting::net::IPAddress::Host::TryParseIPv4(ting::Buffer<const char>(str, 9), h))
+		ASSERT_ALWAYS(h.IPv4Host() == 0x0a00000c)
+		ASSERT_ALWAYS(!ting::net::IPAddress::Host::TryParseIPv6(ting::Buffer<const char>(str, 9), h))
+	}
+	
+	//throwing variants
+	try{
+		ting::net::IPAddress::Host::ParseIPv4("1.2.3.256");
+		ASSERT_ALWAYS(false)
+	}catch(ting::net::IPAddress::Host::BadIPHostFormatExc&){}
+}
+
+}//~namespace
+
+
+
+namespace BenchmarkIPHostParseAndFormat{
+
+const unsigned DNumIterations = 200000;
+
+void Run(){
+	std::vector<std::string> strs;
+	for(unsigned i = 0; i != 100; ++i){
+		std::stringstream ss;
+		ss << "10." << (i * 7 % 256) << "." << (i * 13 % 256) << "." << i;
+		strs.push_back(ss.str());
+		
+		ss.str(std::string());
+		ss << std::hex << "2001:db8:" << (i * 131) << "::" << (i * 7919 % 0x10000) << ":1";
+		strs.push_back(ss.str());
+	}
+	
+	std::vector<ting::net::IPAddress::Host> hosts;
+	for(auto& s : strs){
+		hosts.push_back(ting::net::IPAddress::Host::Parse(s.c_str()));
+	}
+	
+	unsigned numIterations = DNumIterations / unsigned(strs.size());
+	
+	//hand-written parser
+	std::uint32_t sum = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned n = 0; n != numIterations; ++n){
+		for(auto& s : strs){
+			ting::net::IPAddress::Host h;
+			bool ok = ting::net::IPAddress::Host::TryParse(ting::Buffer<const char>(s.c_str(), s.size()), h);
+			sum += std::uint32_t(ok) + h.Quad3();
+		}
+	}
+	std::chrono::duration<double> parseSec = std::chrono::high_resolution_clock::now() - start;
+	
+	//hand-written formatter
+	start = std::chrono::high_resolution_clock::now();
+	for(unsigned n = 0; n != numIterations; ++n){
+		for(auto& h : hosts){
+			std::array<char, ting::net::IPAddress::Host::DMaxStringLength> buf;
+			sum += std::uint32_t(h.Format(buf)) + std::uint32_t(buf[0]);
+		}
+	}
+	std::chrono::duration<double> formatSec = std::chrono::high_resolution_clock::now() - start;
+	
+	double numOps = double(numIterations) * double(strs.size());
+	
+	TRACE_ALWAYS(<< "\tIP host TryParse(): " << unsigned(numOps / parseSec.count()) << " per second, Format(): " << unsigned(numOps / formatSec.count()) << " per second" << std::endl)
+	
+#if M_OS == M_OS_LINUX || M_OS == M_OS_MACOSX
+	//platform functions, as used by previous implementation
+	start = std::chrono::high_resolution_clock::now();
+	for(unsigned n = 0; n != numIterations; ++n){
+		for(auto& s : strs){
+			in6_addr a;
+			int res = inet_pton(s.find(':') == std::string::npos ? AF_INET : AF_INET6, s.c_str(), &a);
+			sum += std::uint32_t(res) + std::uint32_t(a.s6_addr[0]);
+		}
+	}
+	std::chrono::duration<double> ptonSec = std::chrono::high_resolution_clock::now() - start;
+	
+	start = std::chrono::high_resolution_clock::now();
+	for(unsigned n = 0; n != numIterations; ++n){
+		for(auto& h : hosts){
+			std::stringstream ss;
+			if(h.IsIPv4()){
+				ss << (h.IPv4Host() >> 24) << '.' << ((h.IPv4Host() >> 16) & 0xff) << '.' << ((h.IPv4Host() >> 8) & 0xff) << '.' << (h.IPv4Host() & 0xff);
+			}else{
+				ss << std::hex << (h.Quad0() >> 16) << ':' << (h.Quad0() & 0xffff) << ':' << (h.Quad1() >> 16) << ':' << (h.Quad1() & 0xffff)
+						<< ':' << (h.Quad2() >> 16) << ':' << (h.Quad2() & 0xffff) << ':' << (h.Quad3() >> 16) << ':' << (h.Quad3() & 0xffff);
+			}
+			sum += std::uint32_t(ss.str().size());
+		}
+	}
+	std::chrono::duration<double> ssSec = std::chrono::high_resolution_clock::now() - start;
+	
+	TRACE_ALWAYS(<< "\tIP host inet_pton(): " << unsigned(numOps / ptonSec.count()) << " per second, std::stringstream: " << unsigned(numOps / ssSec.count()) << " per second" << std::endl)
+#endif
+	
+	ASSERT_ALWAYS(sum != 0)
+}
+
+}//~namespace
+
+
+
+namespace TestIPPrefix{
+
+ting::net::IPPrefix Parse(const char* str){
+	return ting::net::IPPrefix::Parse(str);
+}
+
+ting::net::IPAddress::Host Host(const char* str){
+	return ting::net::IPAddress::Host::Parse(str);
+}
+
+void Run(){
+	//parsing and formatting
+	{
+		struct{
+			const char* str;
+			unsigned length;
+			const char* canonical;
+		} valid[] = {
+			{"10.0.0.0/8", 104, "10.0.0.0/8"},
+			{"10.1.2.3/8", 104, "10.0.0.0/8"},
+			{"192.168.1.1", 128, "192.168.1.1/32"},
+			{"0.0.0.0/0", 96, "0.0.0.0/0"},
+			{"172.16.0.0/12", 108, "172.16.0.0/12"},
+			{"::/0", 0, "::/0"},
+			{"2001:db8::/32", 32, "2001:db8::/32"},
+			{"2001:DB8:ffff::1/48", 48, "2001:db8:ffff::/48"},
+			{"::1", 128, "::1/128"},
+			{"::ffff:10.0.0.0/104", 104, "10.0.0.0/8"},
+			{"fe80::/10", 10, "fe80::/10"}
+		};
+		
+		for(auto& v : valid){
+			ting::net::IPPrefix p;
+			ASSERT_INFO_ALWAYS(ting::net::IPPrefix::TryParse(ting::Buffer<const char>(v.str, strlen(v.str)), p), v.str)
+			ASSERT_INFO_ALWAYS(p.Length() == v.length, v.str << " length = " << p.Length())
+			ASSERT_INFO_ALWAYS(p.ToString() == v.canonical, v.str << " formatted as " << p.ToString())
+			ASSERT_ALWAYS(Parse(v.canonical) == p)
+		}
+		
+		const char* invalid[] = {
+			"",
+			"/8",
+			"10.0.0.0/",
+			"10.0.0.0/33",
+			"10.0.0.0/08",
+			"10.0.0.0/8/8",
+			"10.0.0.0/a",
+			"10.0.0/8",
+			"2001:db8::/129",
+			"2001:db8::/-1",
+			"2001:db8:: /32"
+		};
+		
+		for(auto str : invalid){
+			ting::net::IPPrefix p = Parse("1.2.3.4");
+			ASSERT_INFO_ALWAYS(!ting::net::IPPrefix::TryParse(ting::Buffer<const char>(str, strlen(str)), p), str)
+			ASSERT_ALWAYS(p == Parse("1.2.3.4"))//should not be changed
+		}
+		
+		try{
+			Parse("10.0.0.0/33");
+			ASSERT_ALWAYS(false)
+		}catch(ting::net::IPAddress::BadIPAddressFormatExc&){}
+	}
+	
+	//IPv4
+	{
+		auto p = ting::net::IPPrefix::IPv4(0xc0a80101, 16);
+		ASSERT_ALWAYS(p == Parse("192.168.0.0/16"))
+		ASSERT_ALWAYS(p.IsIPv4())
+		ASSERT_ALWAYS(p.IPv4Length() == 16)
+		ASSERT_ALWAYS(p.Address().IPv4Host() == 0xc0a80000)
+		ASSERT_ALWAYS(!Parse("2001:db8::/32").IsIPv4())
+		ASSERT_ALWAYS(!Parse("::/95").IsIPv4())
+		ASSERT_ALWAYS(Parse("::ffff:0:0/96").IsIPv4())
+	}
+	
+	//containment
+	{
+		auto p = Parse("10.0.0.0/8");
+		ASSERT_ALWAYS(p.Contains(Host("10.0.0.0")))
+		ASSERT_ALWAYS(p.Contains(Host("10.255.255.255")))
+		ASSERT_ALWAYS(!p.Contains(Host("11.0.0.0")))
+		ASSERT_ALWAYS(!p.Contains(Host("9.255.255.255")))
+		ASSERT_ALWAYS(!p.Contains(Host("::a00:1")))
+		
+		ASSERT_ALWAYS(p.Contains(Parse("10.1.0.0/16")))
+		ASSERT_ALWAYS(p.Contains(p))
+		ASSERT_ALWAYS(!p.Contains(Parse("10.0.0.0/7")))
+		ASSERT_ALWAYS(!Parse("10.1.0.0/16").Contains(p))
+		
+		ASSERT_ALWAYS(Parse("::/0").Contains(Host("1.2.3.4")))
+		ASSERT_ALWAYS(Parse("::/0").Contains(Host("2001:db8::1")))
+		ASSERT_ALWAYS(Parse("0.0.0.0/0").Contains(Host("1.2.3.4")))
+		ASSERT_ALWAYS(!Parse("0.0.0.0/0").Contains(Host("2001:db8::1")))
+		
+		ASSERT_ALWAYS(Parse("2001:db8::/32").Contains(Host("2001:db8:ffff::1")))
+		ASSERT_ALWAYS(!Parse("2001:db8::/32").Contains(Host("2001:db9::1")))
+		ASSERT_ALWAYS(Parse("2001:db8::1/128").Contains(Host("2001:db8::1")))
+		ASSERT_ALWAYS(!Parse("2001:db8::1/128").Contains(Host("2001:db8::2")))
+	}
+	
+	//ordering
+	{
+		ASSERT_ALWAYS(Parse("10.0.0.0/8") < Parse("10.0.0.0/16"))
+		ASSERT_ALWAYS(Parse("10.0.0.0/16") < Parse("10.1.0.0/16"))
+		ASSERT_ALWAYS(!(Parse("10.0.0.0/8") < Parse("10.0.0.0/8")))
+		ASSERT_ALWAYS(Parse("::/0") < Parse("10.0.0.0/8"))
+		ASSERT_ALWAYS(Parse("10.0.0.0/8") != Parse("10.0.0.0/9"))
+	}
+	
+	//longest prefix match table
+	{
+		ting::net::IPPrefixTable<unsigned> t;
+		ASSERT_ALWAYS(t.Size() == 0)
+		ASSERT_ALWAYS(!t.Lookup(Host("1.2.3.4")))
+		
+		t.Insert(Parse("10.0.0.0/8"), 1);
+		t.Insert(Parse("10.1.0.0/16"), 2);
+		t.Insert(Parse("10.1.2.0/24"), 3);
+		t.Insert(Parse("10.1.3.0/24"), 4);
+		t.Insert(Parse("10.128.0.0/9"), 5);
+		t.Insert(Parse("192.168.1.1"), 6);
+		t.Insert(Parse("2001:db8::/32"), 7);
+		t.Insert(Parse("2001:db8:1::/48"), 8);
+		ASSERT_ALWAYS(t.Size() == 8)
+		
+		ting::net::IPPrefix m;
+		ASSERT_ALWAYS(*t.Lookup(Host("10.2.3.4"), &m) == 1 && m == Parse("10.0.0.0/8"))
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.4.4"), &m) == 2 && m == Parse("10.1.0.0/16"))
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.2.4")) == 3)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.3.255")) == 4)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.200.0.1")) == 5)
+		ASSERT_ALWAYS(*t.Lookup(Host("192.168.1.1")) == 6)
+		ASSERT_ALWAYS(!t.Lookup(Host("192.168.1.2")))
+		ASSERT_ALWAYS(!t.Lookup(Host("11.0.0.1")))
+		ASSERT_ALWAYS(*t.Lookup(Host("2001:db8:2::1")) == 7)
+		ASSERT_ALWAYS(*t.Lookup(Host("2001:db8:1::1")) == 8)
+		ASSERT_ALWAYS(!t.Lookup(Host("2001:db9::1")))
+		
+		//prefix containing existing ones is inserted in the middle of the path
+		t.Insert(Parse("10.1.0.0/23"), 9);
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.1.1")) == 9)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.2.1")) == 3)
+		
+		//default route
+		t.Insert(Parse("::/0"), 10);
+		ASSERT_ALWAYS(*t.Lookup(Host("11.0.0.1")) == 10)
+		ASSERT_ALWAYS(*t.Lookup(Host("2001:db9::1")) == 10)
+		
+		//replace value
+		t.Insert(Parse("10.1.0.0/16"), 20);
+		ASSERT_ALWAYS(t.Size() == 10)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.4.4")) == 20)
+		
+		//exact match
+		ASSERT_ALWAYS(*t.Find(Parse("10.1.0.0/16")) == 20)
+		ASSERT_ALWAYS(!t.Find(Parse("10.1.0.0/17")))
+		ASSERT_ALWAYS(!t.Find(Parse("10.0.0.0/7")))
+		
+		//modify value in place
+		++*t.Lookup(Host("10.1.4.4"));
+		ASSERT_ALWAYS(*t.Find(Parse("10.1.0.0/16")) == 21)
+		
+		//remove
+		ASSERT_ALWAYS(t.Remove(Parse("10.1.0.0/16")))
+		ASSERT_ALWAYS(!t.Remove(Parse("10.1.0.0/16")))
+		ASSERT_ALWAYS(t.Size() == 9)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.4.4")) == 1)
+		ASSERT_ALWAYS(*t.Lookup(Host("10.1.2.4")) == 3)
+		
+		t.Clear();
+		ASSERT_ALWAYS(t.Size() == 0)
+		ASSERT_ALWAYS(!t.Lookup(Host("10.1.4.4")))
+	}
+	
+	//random inserts and removals, lookups are checked against linear scan
+	{
+		std::uint32_t state = 2463534242u;
+		auto next = [&state](){
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		};
+		
+		ting::net::IPPrefixTable<unsigned> t;
+		std::map<ting::net::IPPrefix, unsigned> ref;
+		
+		for(unsigned i = 0; i != 20000; ++i){
+			//small address range, so that prefixes nest and repeat
+			ting::net::IPPrefix p = ting::net::IPPrefix::IPv4(0x0a000000 | ((next() & 0xff) << 8), 16 + next() % 17);
+			if(next() % 3 == 0){
+				ASSERT_ALWAYS(t.Remove(p) == (ref.erase(p) != 0))
+			}else{
+				t.Insert(p, i);
+				ref[p] = i;
+			}
+			ASSERT_ALWAYS(t.Size() == ref.size())
+			
+			ting::net::IPAddress::Host h(0x0a000000 | (next() & 0xffff));
+			const ting::net::IPPrefix* best = nullptr;
+			for(auto& e : ref){
+				if(e.first.Contains(h) && (!best || e.first.Length() > best->Length())){
+					best = &e.first;
+				}
+			}
+			
+			ting::net::IPPrefix m;
+			const unsigned* v = t.Lookup(h, &m);
+			if(!best){
+				ASSERT_ALWAYS(!v)
+			}else{
+				ASSERT_ALWAYS(v && *v == ref[*best] && m == *best)
+			}
+		}
+		
+		//remove everything
+		for(auto& e : ref){
+			ASSERT_ALWAYS(t.Remove(e.first))
+			ASSERT_ALWAYS(!t.Find(e.first))
+		}
+		ASSERT_ALWAYS(t.Size() == 0)
+		ASSERT_ALWAYS(!t.Lookup(Host("10.0.1.1")))
+	}
+}
+
+}//~namespace
+
+
+
+namespace BenchmarkIPPrefixTable{
+
+const unsigned DNumPrefixes = 50000;
+const unsigned DNumLookups = 1000000;
+
+//number of lookups to check against linear scan, which is slow
+const unsigned DNumLinearLookups = 2000;
+
+struct Random{
+	std::uint32_t state = 2463534242u;
+	
+	std::uint32_t Next(){
+		this->state ^= this->state << 13;
+		this->state ^= this->state >> 17;
+		this->state ^= this->state << 5;
+		return this->state;
+	}
+};
+
+void Run(){
+	Random rnd;
+	
+	//Half of prefixes are IPv4 with lengths from 8 to 32, half are IPv6 with lengths from 16 to 64 under 2000::/3.
+	//Addresses are taken from smaller ranges, so that prefixes nest and lookups mostly hit.
+	std::vector<ting::net::IPPrefix> prefixes;
+	for(unsigned i = 0; i != DNumPrefixes; ++i){
+		if(i % 2 == 0){
+			prefixes.push_back(ting::net::IPPrefix::IPv4(0x0a000000 | (rnd.Next() & 0x00ffffff), 8 + rnd.Next() % 25));
+		}else{
+			ting::net::IPAddress::Host h(0x20010000 | (rnd.Next() & 0xff), rnd.Next(), 0, 0);
+			prefixes.push_back(ting::net::IPPrefix(h, 16 + rnd.Next() % 49));
+		}
+	}
+	
+	std::vector<ting::net::IPAddress::Host> hosts;
+	for(unsigned i = 0; i != 4096; ++i){
+		if(i % 2 == 0){
+			hosts.push_back(ting::net::IPAddress::Host(0x0a000000 | (rnd.Next() & 0x00ffffff)));
+		}else{
+			hosts.push_back(ting::net::IPAddress::Host(0x20010000 | (rnd.Next() & 0xff), rnd.Next(), rnd.Next(), rnd.Next()));
+		}
+	}
+	
+	ting::net::IPPrefixTable<unsigned> table;
+	for(unsigned i = 0; i != prefixes.size(); ++i){
+		table.Insert(prefixes[i], i);
+	}
+	
+	//check against linear scan and measure it
+	unsigned numHits = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumLinearLookups; ++i){
+		auto& h = hosts[i % hosts.size()];
+		
+		const ting::net::IPPrefix* best = nullptr;
+		for(auto& p : prefixes){
+			if(p.Contains(h) && (!best || p.Length() > best->Length())){
+				best = &p;
+			}
+		}
+		
+		const unsigned* v = table.Lookup(h);
+		if(!best){
+			ASSERT_ALWAYS(!v)
+			continue;
+		}
+		++numHits;
+		ASSERT_INFO_ALWAYS(v, "h = " << h.ToString())
+		ASSERT_INFO_ALWAYS(prefixes[*v] == *best, "h = " << h.ToString() << " found " << prefixes[*v].ToString() << " expected " << best->ToString())
+	}
+	std::chrono::duration<double> linearSec = std::chrono::high_resolution_clock::now() - start;
+	ASSERT_ALWAYS(numHits != 0)
+	
+	unsigned sum = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumLookups; ++i){
+		if(const unsigned* v = table.Lookup(hosts[i % hosts.size()])){
+			sum += *v;
+		}
+	}
+	std::chrono::duration<double> tableSec = std::chrono::high_resolution_clock::now() - start;
+	ASSERT_ALWAYS(sum != 0)
+	
+	TRACE_ALWAYS(<< "\tlongest prefix match over " << table.Size() << " prefixes: IPPrefixTable " << unsigned(DNumLookups / tableSec.count()) << " lookups per second, linear scan " << unsigned(DNumLinearLookups / linearSec.count()) << " lookups per second" << std::endl)
+}
+
+}//~namespace
+
+
+
+namespace TestIPAddressHashing{
+
+void Run(){
+	typedef ting::net::IPAddress::Host Host;
+	typedef ting::net::IPAddress IPAddress;
+	
+	//const comparison
+	{
+		const Host a = Host::Parse("10.0.0.1");
+		const Host b = Host::Parse("::ffff:10.0.0.1");
+		const Host c = Host::Parse("10.0.0.2");
+		ASSERT_ALWAYS(a == b)
+		ASSERT_ALWAYS(a != c)
+		ASSERT_ALWAYS(a < c)
+		ASSERT_ALWAYS(!(c < a))
+		ASSERT_ALWAYS(!(a < b) && !(b < a))
+		ASSERT_ALWAYS(Host::Parse("::1") < a)
+		ASSERT_ALWAYS(a < Host::Parse("2001:db8::1"))
+		
+		const IPAddress ia(a, 80);
+		const IPAddress ib(b, 80);
+		const IPAddress ic(a, 81);
+		ASSERT_ALWAYS(ia == ib)
+		ASSERT_ALWAYS(ia != ic)
+		ASSERT_ALWAYS(ia < ic)
+		ASSERT_ALWAYS(IPAddress(a, 65535) < IPAddress(c, 0))
+	}
+	
+	//hash
+	{
+		std::hash<Host> hh;
+		std::hash<IPAddress> ha;
+		ASSERT_ALWAYS(hh(Host::Parse("10.0.0.1")) == hh(Host::Parse("::ffff:10.0.0.1")))
+		ASSERT_ALWAYS(ha(IPAddress("10.0.0.1:80")) == ha(IPAddress("[::ffff:10.0.0.1]:80")))
+		ASSERT_ALWAYS(ha(IPAddress("10.0.0.1:80")) != ha(IPAddress("10.0.0.1:81")))
+		
+		//IPv4 addresses differing in one bit should have different hash values, also in lower bits
+		std::unordered_set<size_t> hashes;
+		std::unordered_set<size_t> lowBits;
+		for(std::uint32_t i = 0; i != 32; ++i){
+			hashes.insert(hh(Host(std::uint32_t(1) << i)));
+			hashes.insert(hh(Host(0, 0, 0, std::uint32_t(1) << i)));
+			lowBits.insert(hh(Host(0x0a000000 + i)) & 0xff);
+		}
+		ASSERT_ALWAYS(hashes.size() == 64)
+		ASSERT_INFO_ALWAYS(lowBits.size() > 16, "lowBits.size() = " << lowBits.size())
+	}
+	
+	//use as keys of standard containers
+	{
+		std::unordered_map<IPAddress, unsigned> um;
+		std::map<IPAddress, unsigned> m;
+		std::set<Host> s;
+		for(unsigned i = 0; i != 100; ++i){
+			IPAddress ip(Host(0x0a000000 + i % 10), std::uint16_t(i / 10));
+			um[ip] = i;
+			m[ip] = i;
+			s.insert(ip.host);
+		}
+		ASSERT_ALWAYS(um.size() == 100)
+		ASSERT_ALWAYS(m.size() == 100)
+		ASSERT_ALWAYS(s.size() == 10)
+		ASSERT_ALWAYS(um[IPAddress("10.0.0.3:4")] == 43)
+		ASSERT_ALWAYS(m.begin()->first == IPAddress("10.0.0.0:0"))
+		ASSERT_ALWAYS(m.rbegin()->first == IPAddress("10.0.0.9:9"))
+	}
+	
+	//use as keys of ting::FlatHashMap
+	{
+		ting::FlatHashMap<IPAddress, unsigned> fm;
+		for(unsigned i = 0; i != 1000; ++i){
+			fm[IPAddress(Host(0x0a000000 + i), 443)] = i;
+			fm[IPAddress(Host(0x20010db8, 0, 0, i), 443)] = i + 1000;
+		}
+		ASSERT_ALWAYS(fm.Size() == 2000)
+		ASSERT_ALWAYS(*fm.Find(IPAddress("10.0.1.0:443")) == 256)
+		ASSERT_ALWAYS(*fm.Find(IPAddress("[2001:db8::100]:443")) == 1256)
+		ASSERT_ALWAYS(!fm.Find(IPAddress("10.0.1.0:444")))
+	}
+}
+
+}//~namespace
+
+
+
+namespace BenchmarkConnectionTracking{
+
+const unsigned DNumConnections = 200000;
+const unsigned DNumPackets = 2000000;
+
+//number of packets for the map keyed with strings, which is slow
+const unsigned DNumStringPackets = 200000;
+
+struct Connection{
+	std::uint64_t numBytes = 0;
+	std::uint32_t numPackets = 0;
+	std::uint32_t lastSeen = 0;
+};
+
+struct Random{
+	std::uint32_t state = 2463534242u;
+	
+	std::uint32_t Next(){
+		this->state ^= this->state << 13;
+		this->state ^= this->state >> 17;
+		this->state ^= this->state << 5;
+		return this->state;
+	}
+};
+
+//Every packet looks up the connection of its source address and updates the counters,
+//7 of 8 packets belong to known connections, the rest are new connections.
+template <class F> double Measure(const std::vector<ting::net::IPAddress>& clients, unsigned numPackets, F track){
+	Random rnd;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != numPackets; ++i){
+		std::uint32_t r = rnd.Next();
+		if((r & 7) == 0){
+			ting::net::IPAddress ip(ting::net::IPAddress::Host(0xc0000000 | (r >> 3)), std::uint16_t(r));
+			track(ip, i);
+		}else{
+			track(clients[r % clients.size()], i);
+		}
+	}
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	return numPackets / sec.count();
+}
+
+void Run(){
+	Random rnd;
+	std::vector<ting::net::IPAddress> clients;
+	for(unsigned i = 0; i != DNumConnections; ++i){
+		if(i % 4 == 0){
+			clients.push_back(ting::net::IPAddress(ting::net::IPAddress::Host(0x20010db8, rnd.Next(), rnd.Next(), rnd.Next()), std::uint16_t(rnd.Next())));
+		}else{
+			clients.push_back(ting::net::IPAddress(ting::net::IPAddress::Host(0x0a000000 | (rnd.Next() & 0xffffff)), std::uint16_t(rnd.Next())));
+		}
+	}
+	
+	ting::FlatHashMap<ting::net::IPAddress, Connection> flat(DNumConnections);
+	std::unordered_map<ting::net::IPAddress, Connection> um;
+	std::unordered_map<std::string, Connection> sm;
+	for(auto& c : clients){
+		flat[c];
+		um[c];
+		sm[c.host.ToString() + ":" + std::to_string(c.port)];
+	}
+	
+	double flatRate = Measure(clients, DNumPackets, [&flat](const ting::net::IPAddress& ip, std::uint32_t time){
+		Connection& c = flat[ip];
+		c.numBytes += 1400;
+		++c.numPackets;
+		c.lastSeen = time;
+	});
+	
+	double umRate = Measure(clients, DNumPackets, [&um](const ting::net::IPAddress& ip, std::uint32_t time){
+		Connection& c = um[ip];
+		c.numBytes += 1400;
+		++c.numPackets;
+		c.lastSeen = time;
+	});
+	
+	double smRate = Measure(clients, DNumStringPackets, [&sm](const ting::net::IPAddress& ip, std::uint32_t time){
+		Connection& c = sm[ip.host.ToString() + ":" + std::to_string(ip.port)];
+		c.numBytes += 1400;
+		++c.numPackets;
+		c.lastSeen = time;
+	});
+	
+	ASSERT_ALWAYS(flat.Size() == um.size())
+	
+	//expire connections which were not seen in the second half
+	size_t numExpired = flat.RemoveIf([](const ting::net::IPAddress& ip, Connection& c){
+		return c.lastSeen < DNumPackets / 2;
+	});
+	ASSERT_ALWAYS(numExpired != 0)
+	
+	TRACE_ALWAYS(<< "\tconnection tracking over " << um.size() << " connections: FlatHashMap " << unsigned(flatRate) << " packets per second, std::unordered_map " << unsigned(umRate) << " packets per second, std::unordered_map keyed with ToString() " << unsigned(smRate) << " packets per second" << std::endl)
+}
+
+}//~namespace
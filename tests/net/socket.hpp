@@ -28,6 +28,14 @@ void Run();
 
 
 
+namespace TestRingBufferSendRecv{
+
+void Run();
+
+}//~namespace
+
+
+
 namespace BasicIPAddressTest{
 
 void Run();
@@ -49,3 +57,51 @@ namespace TestUDPSocketWaitForWriting{
 void Run();
 
 }//~namespace
+
+
+
+namespace TestIPHostParseAndFormat{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace BenchmarkIPHostParseAndFormat{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestIPPrefix{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace BenchmarkIPPrefixTable{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace TestIPAddressHashing{
+
+void Run();
+
+}//~namespace
+
+
+
+namespace BenchmarkConnectionTracking{
+
+void Run();
+
+}//~namespace
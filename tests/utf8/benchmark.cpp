@@ -0,0 +1,94 @@
+#include <chrono>
+
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/utf8.hpp"
+
+#include "tests.hpp"
+
+
+using namespace ting;
+
+namespace ting_test{
+namespace strutf8{
+
+namespace Benchmark{
+
+namespace{
+
+//run function several times and return throughput in megabytes per second
+template <class T_Func> double Measure(size_t numBytes, T_Func f){
+	const unsigned DNumIterations = 20;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumIterations; ++i){
+		f();
+	}
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	return double(numBytes) * DNumIterations / (1024 * 1024) / sec.count();
+}
+
+}
+
+void Run(){
+	//mostly ASCII text with some multi-byte characters, like typical markup
+	std::vector<std::uint32_t> utf32;
+	for(unsigned i = 0; utf32.size() < 1024 * 1024; ++i){
+		for(unsigned j = 0; j != 60; ++j){
+			utf32.push_back(' ' + (i + j) % 90);
+		}
+		utf32.push_back(0x0411 + i % 32);
+		utf32.push_back(0x4e00 + i % 1000);
+		utf32.push_back(0x1f600 + i % 64);
+	}
+	
+	std::vector<std::uint8_t> utf8(utf32.size() * 4);
+	utf8.resize(utf8::FromUTF32(utf32, utf8).numWritten);
+	
+	std::vector<std::uint32_t> decoded(utf32.size());
+	std::vector<std::uint16_t> utf16(utf32.size() * 2);
+	std::vector<std::uint8_t> encoded(utf8.size());
+	
+	volatile size_t sink = 0;
+	
+	double validate = Measure(utf8.size(), [&](){
+		sink = sink + utf8::Validate(utf8);
+	});
+	
+	double decode = Measure(utf8.size(), [&](){
+		sink = sink + utf8::Decode(utf8, decoded);
+	});
+	
+	//Iterator reads null-terminated strings, so it needs a null-terminated copy of the data
+	std::vector<char> cstr(utf8.begin(), utf8.end());
+	cstr.push_back(0);
+	
+	double iterator = Measure(utf8.size(), [&](){
+		size_t i = 0;
+		for(utf8::Iterator it(&*cstr.begin()); !it.IsEnd(); ++it, ++i){
+			decoded[i] = it.Char();
+		}
+		sink = sink + i;
+	});
+	
+	double toUtf16 = Measure(utf8.size(), [&](){
+		sink = sink + utf8::ToUTF16(utf8, utf16).numWritten;
+	});
+	
+	double fromUtf32 = Measure(utf8.size(), [&](){
+		sink = sink + utf8::FromUTF32(utf32, encoded).numWritten;
+	});
+	
+	ASSERT_ALWAYS(decoded == utf32)
+	ASSERT_ALWAYS(encoded == utf8)
+	
+	TRACE_ALWAYS(<< "\tutf-8 throughput, MB/s of utf-8 data:" << std::endl)
+	TRACE_ALWAYS(<< "\t\tValidate:  " << validate << std::endl)
+	TRACE_ALWAYS(<< "\t\tDecode:    " << decode << std::endl)
+	TRACE_ALWAYS(<< "\t\tIterator:  " << iterator << std::endl)
+	TRACE_ALWAYS(<< "\t\tToUTF16:   " << toUtf16 << std::endl)
+	TRACE_ALWAYS(<< "\t\tFromUTF32: " << fromUtf32 << std::endl)
+}
+
+}//~namespace
+
+}//~namespace
+}//~namespace
@@ -8,6 +8,12 @@ namespace strutf8{
 
 inline void TestTingStrUTF8(){
 	TestSimple::Run();
+	TestBulkDecode::Run();
+	TestValidate::Run();
+	TestMalformed::Run();
+	TestRange::Run();
+	TestTranscode::Run();
+	Benchmark::Run();
 
 	TRACE_ALWAYS(<< "[PASSED]" << std::endl)
 }
@@ -2,6 +2,8 @@
 #include "../../src/ting/utf8.hpp"
 #include "../../src/ting/fs/FSFile.hpp"
 
+#include <algorithm>
+
 #include "tests.hpp"
 
 
@@ -42,5 +44,297 @@ void Run(){
 
 }//~namespace
 
+
+
+namespace TestBulkDecode{
+
+void Run(){
+	//build a string containing long ASCII runs mixed with multi-byte characters
+	std::string str;
+	for(unsigned i = 0; i != 100; ++i){
+		str += "Lorem ipsum dolor sit amet, consectetur adipiscing elit ";
+		str += "\xd0\x91\xd1\x86\xef\xba\xb6\xf0\xa0\x80\x8b";//0x0411, 0x0446, 0xfeb6, 0x2000b
+		for(unsigned j = 0; j != i % 19; ++j){
+			str += char('a' + j);
+		}
+	}
+	
+	std::vector<std::uint32_t> expected;
+	for(utf8::Iterator i(str.c_str()); i.IsNotEnd(); ++i){
+		expected.push_back(i.Char());
+	}
+	
+	ting::Buffer<const std::uint8_t> buf(reinterpret_cast<const std::uint8_t*>(str.c_str()), str.size());
+	
+	ASSERT_INFO_ALWAYS(utf8::DecodedLength(buf) == expected.size(), "DecodedLength = " << utf8::DecodedLength(buf) << " expected = " << expected.size())
+	
+	std::vector<std::uint32_t> res = utf8::ToUTF32(str);
+	ASSERT_ALWAYS(res == expected)
+	
+	//output buffer smaller than needed
+	{
+		std::vector<std::uint32_t> out(expected.size() / 2);
+		ASSERT_ALWAYS(utf8::Decode(buf, out) == out.size())
+		ASSERT_ALWAYS(std::equal(out.begin(), out.end(), expected.begin()))
+	}
+	
+	//truncated multi-byte sequence at the end is decoded as replacement character
+	{
+		std::string s = "ab\xf0\xa0\x80";
+		std::vector<std::uint32_t> out(10);
+		ASSERT_ALWAYS(utf8::Decode(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(s.c_str()), s.size()), out) == 3)
+		ASSERT_ALWAYS(out[0] == 'a')
+		ASSERT_ALWAYS(out[1] == 'b')
+		ASSERT_ALWAYS(out[2] == utf8::DReplacementChar)
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestValidate{
+
+size_t Validate(const std::string& s){
+	return utf8::Validate(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(s.data()), s.size()));
+}
+
+void Run(){
+	ASSERT_ALWAYS(Validate("") == 0)
+	ASSERT_ALWAYS(Validate("hello") == 5)
+	ASSERT_ALWAYS(Validate(std::string("he\0llo", 6)) == 6)
+	ASSERT_ALWAYS(Validate("a\xd0\x91\xd1\x86\xef\xba\xb6\xf0\xa0\x80\x8b") == 12)
+	ASSERT_ALWAYS(Validate("\xf4\x8f\xbf\xbf") == 4)//U+10FFFF
+	
+	ASSERT_ALWAYS(Validate("ab\x80") == 2)//stray continuation byte
+	ASSERT_ALWAYS(Validate("ab\xc0\xaf") == 2)//overlong
+	ASSERT_ALWAYS(Validate("ab\xe0\x80\xaf") == 2)//overlong
+	ASSERT_ALWAYS(Validate("ab\xf0\x80\x80\xaf") == 2)//overlong
+	ASSERT_ALWAYS(Validate("ab\xed\xa0\x80") == 2)//surrogate
+	ASSERT_ALWAYS(Validate("ab\xf4\x90\x80\x80") == 2)//above U+10FFFF
+	ASSERT_ALWAYS(Validate("ab\xf8\x88\x80\x80\x80") == 2)
+	ASSERT_ALWAYS(Validate("ab\xd0") == 2)//truncated
+	ASSERT_ALWAYS(Validate("ab\xd0z") == 2)
+	
+	//error after long ASCII run
+	{
+		std::string s(100, 'a');
+		s += "\xff";
+		ASSERT_ALWAYS(Validate(s) == 100)
+	}
+	
+	//iterator does not go past the end of truncated sequence
+	{
+		const char* s = "a\xe0\xa0";
+		utf8::Iterator i(s);
+		ASSERT_ALWAYS(i.Char() == 'a')
+		++i;
+		ASSERT_ALWAYS(i.Char() == utf8::DReplacementChar)
+		++i;
+		ASSERT_ALWAYS(i.IsEnd())
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestMalformed{
+
+void Check(const std::string& str, const std::vector<std::uint32_t>& expected){
+	ting::Buffer<const std::uint8_t> buf(reinterpret_cast<const std::uint8_t*>(str.c_str()), str.size());
+	
+	ASSERT_INFO_ALWAYS(utf8::DecodedLength(buf) == expected.size(), "DecodedLength = " << utf8::DecodedLength(buf) << " expected = " << expected.size())
+	ASSERT_ALWAYS(utf8::ToUTF32(buf) == expected)
+	ASSERT_ALWAYS(utf8::ToUTF32(str.c_str()) == expected)
+	ASSERT_ALWAYS(utf8::ToUTF32(utf8::Iterator(str.c_str())) == expected)
+	
+	std::vector<std::uint32_t> out(expected.size() + 1);
+	ASSERT_ALWAYS(utf8::Decode(buf, out) == expected.size())
+	ASSERT_ALWAYS(std::equal(expected.begin(), expected.end(), out.begin()))
+}
+
+void Run(){
+	const std::uint32_t R = utf8::DReplacementChar;
+	
+	//every maximal subpart of invalid sequence gives one replacement character
+	Check("\x80\x80" "ABC", {R, R, 'A', 'B', 'C'});
+	Check("\xe2\x82" "ABCD", {R, 'A', 'B', 'C', 'D'});
+	Check("a\xff" "b", {'a', R, 'b'});
+	Check("\xc0\xaf", {R, R});//overlong
+	Check("\xe0\x80\xaf", {R, R, R});//overlong
+	Check("\xed\xa0\x80", {R, R, R});//surrogate
+	Check("\xf4\x90\x80\x80", {R, R, R, R});//above U+10FFFF
+	Check("\xf0\x9f\x98" "x", {R, 'x'});//truncated
+	Check("\xf0\x9f\x98\x80", {0x1f600});
+	Check("\xf0\x9f\x98", {R});//truncated by the end of string
+	Check("\xe2\xe2\x82\xac", {R, 0x20ac});
+	
+	//invalid sequences between long ASCII runs, which are processed with SIMD
+	{
+		std::string s(40, 'a');
+		s += "\xe2\x82";
+		s += std::string(40, 'b');
+		s += "\x80";
+		
+		std::vector<std::uint32_t> expected(40, 'a');
+		expected.push_back(R);
+		expected.insert(expected.end(), 40, 'b');
+		expected.push_back(R);
+		
+		Check(s, expected);
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestRange{
+
+void Run(){
+	//string with embedded null and invalid byte, not null-terminated
+	const std::uint8_t data[] = {'a', 0xd0, 0x91, 0, 0xf0, 0xa0, 0x80, 0x8b, 0xff, 'z', 0xd0};
+	
+	utf8::Range r(ting::Buffer<const std::uint8_t>(data, sizeof(data) - 1));
+	
+	ASSERT_ALWAYS(r.NumChars() == 6)
+	
+	std::vector<std::uint32_t> chars;
+	for(std::uint32_t c : r){
+		chars.push_back(c);
+	}
+	ASSERT_ALWAYS(chars.size() == 6)
+	ASSERT_ALWAYS(chars[0] == 'a')
+	ASSERT_ALWAYS(chars[1] == 0x0411)
+	ASSERT_ALWAYS(chars[2] == 0)
+	ASSERT_ALWAYS(chars[3] == 0x2000b)
+	ASSERT_ALWAYS(chars[4] == utf8::DReplacementChar)
+	ASSERT_ALWAYS(chars[5] == 'z')
+	
+	//seeking by byte offset
+	{
+		auto i = r.At(6);//middle of 4 byte sequence
+		ASSERT_ALWAYS(r.ByteOffset(i) == 4)
+		ASSERT_ALWAYS(i.Char() == 0x2000b)
+		ASSERT_ALWAYS(i.CharSize() == 4)
+		++i;
+		ASSERT_ALWAYS(r.ByteOffset(i) == 8)
+		ASSERT_ALWAYS(r.At(100) == r.end())
+		ASSERT_ALWAYS(r.At(2).Char() == 0x0411)
+	}
+	
+	//seeking into malformed input gives the same iterators as iterating from the beginning
+	{
+		const char* strs[] = {"a\x80\x80\x80\x80", "\xe9\x80\x80\x80", "\xe2\x82" "A\x80", "\xf0\x9f\x98\x80\x80\x80\x80\x80", "\x80\xd0\x91\x91"};
+		for(auto str : strs){
+			utf8::Range mr(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(str), strlen(str)));
+			for(auto i = mr.begin(); i != mr.end(); ++i){
+				for(size_t b = mr.ByteOffset(i); b != mr.ByteOffset(i) + i.CharSize(); ++b){
+					ASSERT_INFO_ALWAYS(mr.At(b) == i, "str = " << str << " b = " << b << " At(b) = " << mr.ByteOffset(mr.At(b)))
+				}
+			}
+		}
+		
+		utf8::Range mr(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>("a\x80\x80\x80\x80"), 5));
+		ASSERT_ALWAYS(mr.ByteOffset(mr.At(4)) == 4)
+		ASSERT_ALWAYS(mr.At(4).Char() == utf8::DReplacementChar)
+		
+		utf8::Range er(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>("\xe9\x80\x80\x80"), 4));
+		ASSERT_ALWAYS(er.ByteOffset(er.At(1)) == 0)
+		ASSERT_ALWAYS(er.At(1).Char() == 0x9000)
+		ASSERT_ALWAYS(er.ByteOffset(er.At(3)) == 3)
+		ASSERT_ALWAYS(er.At(3).Char() == utf8::DReplacementChar)
+	}
+	
+	//truncated sequence at the end of the span
+	{
+		utf8::Range tr(ting::Buffer<const std::uint8_t>(data, sizeof(data)));
+		std::vector<std::uint32_t> c(tr.begin(), tr.end());
+		ASSERT_ALWAYS(c.size() == 7)
+		ASSERT_ALWAYS(c.back() == utf8::DReplacementChar)
+	}
+	
+	//number of characters is what the iterator yields, also for invalid input
+	{
+		const char* strs[] = {"\x80\x80" "ABC", "\xe2\x82" "ABCD", "\xed\xa0\x80", "\xf0\x9f\x98", "a\xff\xe2\xe2\x82\xac"};
+		for(auto str : strs){
+			utf8::Range ir(ting::Buffer<const std::uint8_t>(reinterpret_cast<const std::uint8_t*>(str), strlen(str)));
+			std::vector<std::uint32_t> c(ir.begin(), ir.end());
+			ASSERT_INFO_ALWAYS(ir.NumChars() == c.size(), "NumChars() = " << ir.NumChars() << " iterated = " << c.size())
+			ASSERT_ALWAYS(c == utf8::ToUTF32(str))
+		}
+	}
+}
+
+}//~namespace
+
+
+
+namespace TestTranscode{
+
+void Run(){
+	std::vector<std::uint32_t> utf32 = {'a', 0x0411, 0x0446, 0xfeb6, 0x2000b, 0x10ffff};
+	for(unsigned i = 0; i != 40; ++i){
+		utf32.push_back('0' + (i % 10));
+	}
+	utf32.push_back(0x7ff);
+	
+	//UTF-32 to utf-8
+	std::vector<std::uint8_t> utf8(utf32.size() * 4);
+	utf8::TranscodeResult r = utf8::FromUTF32(utf32, utf8);
+	ASSERT_ALWAYS(!r.error)
+	ASSERT_ALWAYS(r.numRead == utf32.size())
+	utf8.resize(r.numWritten);
+	ASSERT_ALWAYS(utf8::Validate(utf8) == utf8.size())
+	ASSERT_ALWAYS(utf8::ToUTF32(utf8) == utf32)
+	
+	//utf-8 to UTF-16
+	{
+		std::vector<std::uint16_t> utf16(utf32.size() * 2);
+		r = utf8::ToUTF16(utf8, utf16);
+		ASSERT_ALWAYS(!r.error)
+		ASSERT_ALWAYS(r.numRead == utf8.size())
+		ASSERT_INFO_ALWAYS(r.numWritten == utf32.size() + 2, "r.numWritten = " << r.numWritten)
+		ASSERT_ALWAYS(utf16[0] == 'a')
+		ASSERT_ALWAYS(utf16[1] == 0x0411)
+		ASSERT_ALWAYS(utf16[3] == 0xfeb6)
+		ASSERT_ALWAYS(utf16[4] == 0xd840)
+		ASSERT_ALWAYS(utf16[5] == 0xdc0b)
+		ASSERT_ALWAYS(utf16[6] == 0xdbff)
+		ASSERT_ALWAYS(utf16[7] == 0xdfff)
+		ASSERT_ALWAYS(utf16[8] == '0')
+		ASSERT_ALWAYS(utf16[r.numWritten - 1] == 0x7ff)
+	}
+	
+	//output buffer too small, surrogate pair is not split
+	{
+		std::array<std::uint16_t, 5> utf16;
+		r = utf8::ToUTF16(utf8, utf16);
+		ASSERT_ALWAYS(!r.error)
+		ASSERT_ALWAYS(r.numWritten == 4)
+		ASSERT_ALWAYS(r.numRead == 1 + 2 + 2 + 3)
+	}
+	
+	//invalid input
+	{
+		std::array<std::uint32_t, 3> bad = {{'a', 0xd800, 'b'}};
+		std::array<std::uint8_t, 10> out;
+		r = utf8::FromUTF32(bad, out);
+		ASSERT_ALWAYS(r.error)
+		ASSERT_ALWAYS(r.numRead == 1)
+		ASSERT_ALWAYS(r.numWritten == 1)
+	}
+	{
+		std::array<std::uint8_t, 3> bad = {{'a', 0xc0, 0x80}};
+		std::array<std::uint16_t, 10> out;
+		r = utf8::ToUTF16(bad, out);
+		ASSERT_ALWAYS(r.error)
+		ASSERT_ALWAYS(r.numRead == 1)
+	}
+}
+
+}//~namespace
+
 }//~namespace
 }//~namespace
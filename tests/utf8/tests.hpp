@@ -8,5 +8,29 @@ namespace TestSimple{
 void Run();
 }//~namespace
 
+namespace TestBulkDecode{
+void Run();
+}//~namespace
+
+namespace TestValidate{
+void Run();
+}//~namespace
+
+namespace TestMalformed{
+void Run();
+}//~namespace
+
+namespace TestRange{
+void Run();
+}//~namespace
+
+namespace TestTranscode{
+void Run();
+}//~namespace
+
+namespace Benchmark{
+void Run();
+}//~namespace
+
 }//~namespace
 }//~namespace
@@ -0,0 +1,143 @@
+#include <chrono>
+
+#include "../../src/ting/debug.hpp"
+#include "../../src/ting/util.hpp"
+
+#include "tests.hpp"
+
+
+
+using namespace ting;
+
+
+
+namespace Benchmark{
+
+namespace{
+
+//run function several times and return throughput in megabytes per second
+template <class T_Func> double Measure(size_t numBytes, T_Func f){
+	const unsigned DNumIterations = 20;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned i = 0; i != DNumIterations; ++i){
+		f();
+	}
+	std::chrono::duration<double> sec = std::chrono::high_resolution_clock::now() - start;
+	return double(numBytes) * DNumIterations / (1024 * 1024) / sec.count();
+}
+
+
+
+void RunSerialization(){
+	std::vector<std::uint32_t> values(1024 * 1024);
+	for(size_t i = 0; i != values.size(); ++i){
+		values[i] = std::uint32_t(i * 2654435761U);
+	}
+
+	std::vector<std::uint8_t> buf(values.size() * sizeof(std::uint32_t));
+	std::vector<std::uint32_t> decoded(values.size());
+
+	double scalarSerialize = Measure(buf.size(), [&](){
+		for(size_t i = 0; i != values.size(); ++i){
+			ting::util::Serialize32BE(values[i], &buf[i * 4]);
+		}
+	});
+
+	double bulkSerialize = Measure(buf.size(), [&](){
+		ting::util::Serialize32BE(values, buf);
+	});
+
+	double scalarDeserialize = Measure(buf.size(), [&](){
+		for(size_t i = 0; i != decoded.size(); ++i){
+			decoded[i] = ting::util::Deserialize32BE(&buf[i * 4]);
+		}
+	});
+
+	double bulkDeserialize = Measure(buf.size(), [&](){
+		ting::util::Deserialize32BE(buf, decoded);
+	});
+
+	ASSERT_ALWAYS(decoded == values)
+
+	TRACE_ALWAYS(<< "\t32 bit big-endian serialization throughput, MB/s:" << std::endl)
+	TRACE_ALWAYS(<< "\t\tSerialize scalar:   " << scalarSerialize << std::endl)
+	TRACE_ALWAYS(<< "\t\tSerialize bulk:     " << bulkSerialize << std::endl)
+	TRACE_ALWAYS(<< "\t\tDeserialize scalar: " << scalarDeserialize << std::endl)
+	TRACE_ALWAYS(<< "\t\tDeserialize bulk:   " << bulkDeserialize << std::endl)
+}
+
+
+
+//returns millions of values per second for scalar and batch decoding
+template <class T> std::pair<double, double> MeasureVarints(const std::vector<T>& values){
+	std::vector<std::uint8_t> buf(values.size() * ting::util::DMaxVarint64Size);
+	size_t size = 0;
+	for(auto v : values){
+		size += ting::util::SerializeVarint(v, &buf[size]);
+	}
+	buf.resize(size);
+
+	std::vector<T> decoded(values.size());
+
+	//Measure() returns megabytes per second, pass number of values instead of bytes to get values per second
+	double scalar = Measure(values.size(), [&](){
+		ting::Buffer<const std::uint8_t> in(buf);
+		for(size_t i = 0; i != decoded.size(); ++i){
+			std::uint64_t v;
+			size_t len = ting::util::DeserializeVarint64(in, v);
+			decoded[i] = T(v);
+			in = ting::Buffer<const std::uint8_t>(in.begin() + len, in.size() - len);
+		}
+	});
+	ASSERT_ALWAYS(decoded == values)
+
+	double batch = Measure(values.size(), [&](){
+		if(sizeof(T) == sizeof(std::uint32_t)){
+			ting::util::DeserializeVarints32(buf, ting::Buffer<std::uint32_t>(reinterpret_cast<std::uint32_t*>(&*decoded.begin()), decoded.size()));
+		}else{
+			ting::util::DeserializeVarints64(buf, ting::Buffer<std::uint64_t>(reinterpret_cast<std::uint64_t*>(&*decoded.begin()), decoded.size()));
+		}
+	});
+	ASSERT_ALWAYS(decoded == values)
+
+	const double DMega = 1000000.0 / (1024 * 1024);
+	return std::make_pair(scalar / DMega, batch / DMega);
+}
+
+
+
+void RunVarint(){
+	const size_t DNumValues = 1024 * 1024;
+
+	std::vector<std::uint32_t> small(DNumValues), mixed(DNumValues), large(DNumValues);
+	std::vector<std::uint64_t> large64(DNumValues);
+
+	std::uint64_t x = 1;
+	for(size_t i = 0; i != DNumValues; ++i){
+		x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+		small[i] = std::uint32_t(x >> 57);//7 bits, one byte varints
+		mixed[i] = std::uint32_t(x >> (64 - 7 * (1 + (x >> 20) % 3)));//1 to 3 byte varints
+		large[i] = std::uint32_t(x >> 32);//mostly 5 byte varints
+		large64[i] = x;//mostly 10 byte varints
+	}
+
+	auto s = MeasureVarints(small);
+	auto m = MeasureVarints(mixed);
+	auto l = MeasureVarints(large);
+	auto l64 = MeasureVarints(large64);
+
+	TRACE_ALWAYS(<< "\tvarint decoding, millions of values per second (scalar / batch):" << std::endl)
+	TRACE_ALWAYS(<< "\t\t1 byte:       " << s.first << " / " << s.second << std::endl)
+	TRACE_ALWAYS(<< "\t\t1-3 bytes:    " << m.first << " / " << m.second << std::endl)
+	TRACE_ALWAYS(<< "\t\t32 bit:       " << l.first << " / " << l.second << std::endl)
+	TRACE_ALWAYS(<< "\t\t64 bit:       " << l64.first << " / " << l64.second << std::endl)
+}
+
+}
+
+void Run(){
+	RunSerialization();
+	RunVarint();
+}
+
+}//~namespace
@@ -8,6 +8,10 @@
 inline void TestTingUtil(){
 	TestSerialization::Run();
 	TestScopeExit::Run();
+	TestWideSerialization::Run();
+	TestBulkSerialization::Run();
+	TestVarint::Run();
+	Benchmark::Run();
 	
 	TRACE_ALWAYS(<< "[PASSED]: utils test" << std::endl)
 }
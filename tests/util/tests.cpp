@@ -55,3 +55,258 @@ void Run(){
 	ASSERT_ALWAYS(flag)
 }
 }
+
+
+
+namespace TestWideSerialization{
+void Run(){
+	//64 bit
+	{
+		std::uint64_t v = 0x0102030405060708ULL;
+		std::array<std::uint8_t, sizeof(std::uint64_t)> buf;
+
+		ting::util::Serialize64LE(v, buf.begin());
+		for(unsigned i = 0; i != buf.size(); ++i){
+			ASSERT_ALWAYS(buf[i] == 8 - i)
+		}
+		ASSERT_ALWAYS(ting::util::Deserialize64LE(buf.begin()) == v)
+
+		ting::util::Serialize64BE(v, buf.begin());
+		for(unsigned i = 0; i != buf.size(); ++i){
+			ASSERT_ALWAYS(buf[i] == i + 1)
+		}
+		ASSERT_ALWAYS(ting::util::Deserialize64BE(buf.begin()) == v)
+	}
+
+	ASSERT_ALWAYS(ting::util::ByteSwap16(0x0102) == 0x0201)
+	ASSERT_ALWAYS(ting::util::ByteSwap32(0x01020304) == 0x04030201)
+	ASSERT_ALWAYS(ting::util::ByteSwap64(0x0102030405060708ULL) == 0x0807060504030201ULL)
+
+	//float and double
+	{
+		std::array<std::uint8_t, sizeof(double)> buf;
+
+		ting::util::SerializeFloatBE(1.0f, buf.begin());
+		ASSERT_ALWAYS(buf[0] == 0x3f && buf[1] == 0x80 && buf[2] == 0 && buf[3] == 0)
+		ASSERT_ALWAYS(ting::util::DeserializeFloatBE(buf.begin()) == 1.0f)
+
+		ting::util::SerializeFloatLE(-2.5f, buf.begin());
+		ASSERT_ALWAYS(ting::util::DeserializeFloatLE(buf.begin()) == -2.5f)
+
+		ting::util::SerializeDoubleBE(1.0, buf.begin());
+		ASSERT_ALWAYS(buf[0] == 0x3f && buf[1] == 0xf0)
+		ASSERT_ALWAYS(ting::util::DeserializeDoubleBE(buf.begin()) == 1.0)
+
+		ting::util::SerializeDoubleLE(3.14159, buf.begin());
+		ASSERT_ALWAYS(buf[7] == 0x40)
+		ASSERT_ALWAYS(ting::util::DeserializeDoubleLE(buf.begin()) == 3.14159)
+	}
+}
+}//~namespace
+
+
+
+namespace TestBulkSerialization{
+void Run(){
+	//use odd number of values to exercise the tail handling of SIMD loops
+	const size_t DSize = 37;
+
+	std::vector<std::uint16_t> in16(DSize);
+	std::vector<std::uint32_t> in32(DSize);
+	std::vector<std::uint64_t> in64(DSize);
+	for(size_t i = 0; i != DSize; ++i){
+		in16[i] = std::uint16_t(i * 0x0101 + 0x1234);
+		in32[i] = std::uint32_t(i * 0x01010101 + 0x12345678);
+		in64[i] = std::uint64_t(i) * 0x0101010101010101ULL + 0x123456789abcdef0ULL;
+	}
+
+	std::vector<std::uint8_t> buf(DSize * sizeof(std::uint64_t));
+
+	//16 bit
+	{
+		std::vector<std::uint16_t> out(DSize);
+
+		ting::util::Serialize16LE(in16, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(ting::util::Deserialize16LE(&buf[i * 2]) == in16[i])
+		}
+		ting::util::Deserialize16LE(buf, out);
+		ASSERT_ALWAYS(out == in16)
+
+		ting::util::Serialize16BE(in16, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(buf[i * 2] == std::uint8_t(in16[i] >> 8))
+			ASSERT_ALWAYS(buf[i * 2 + 1] == std::uint8_t(in16[i]))
+		}
+		ting::util::Deserialize16BE(buf, out);
+		ASSERT_ALWAYS(out == in16)
+	}
+
+	//32 bit
+	{
+		std::vector<std::uint32_t> out(DSize);
+
+		ting::util::Serialize32LE(in32, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(ting::util::Deserialize32LE(&buf[i * 4]) == in32[i])
+		}
+		ting::util::Deserialize32LE(buf, out);
+		ASSERT_ALWAYS(out == in32)
+
+		ting::util::Serialize32BE(in32, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(ting::util::Deserialize32BE(&buf[i * 4]) == in32[i])
+		}
+		ting::util::Deserialize32BE(buf, out);
+		ASSERT_ALWAYS(out == in32)
+	}
+
+	//64 bit
+	{
+		std::vector<std::uint64_t> out(DSize);
+
+		ting::util::Serialize64LE(in64, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(ting::util::Deserialize64LE(&buf[i * 8]) == in64[i])
+		}
+		ting::util::Deserialize64LE(buf, out);
+		ASSERT_ALWAYS(out == in64)
+
+		ting::util::Serialize64BE(in64, buf);
+		for(size_t i = 0; i != DSize; ++i){
+			ASSERT_ALWAYS(ting::util::Deserialize64BE(&buf[i * 8]) == in64[i])
+		}
+		ting::util::Deserialize64BE(buf, out);
+		ASSERT_ALWAYS(out == in64)
+	}
+}
+}//~namespace
+
+
+
+namespace TestVarint{
+void Run(){
+	//single value round trip
+	{
+		const std::uint64_t values[] = {0, 1, 0x7f, 0x80, 300, 0x3fff, 0x4000, 0xffffffff, 0x100000000ULL, std::uint64_t(-1)};
+		for(auto v : values){
+			std::array<std::uint8_t, ting::util::DMaxVarint64Size> buf;
+			size_t len = ting::util::SerializeVarint(v, buf.begin());
+			ASSERT_ALWAYS(len == ting::util::VarintSize(v))
+
+			std::uint64_t res;
+			ASSERT_ALWAYS(ting::util::DeserializeVarint64(ting::Buffer<const std::uint8_t>(buf.begin(), len), res) == len)
+			ASSERT_ALWAYS(res == v)
+
+			//truncated
+			ASSERT_ALWAYS(ting::util::DeserializeVarint64(ting::Buffer<const std::uint8_t>(buf.begin(), len - 1), res) == 0)
+
+			std::uint32_t res32;
+			size_t len32 = ting::util::DeserializeVarint32(ting::Buffer<const std::uint8_t>(buf.begin(), len), res32);
+			if(v <= 0xffffffff){
+				ASSERT_ALWAYS(len32 == len)
+				ASSERT_ALWAYS(res32 == v)
+			}else{
+				ASSERT_ALWAYS(len32 == 0)
+			}
+		}
+
+		ASSERT_ALWAYS(ting::util::VarintSize(std::uint64_t(-1)) == ting::util::DMaxVarint64Size)
+		ASSERT_ALWAYS(ting::util::VarintSize(std::uint32_t(-1)) == ting::util::DMaxVarint32Size)
+	}
+
+	//zigzag
+	{
+		ASSERT_ALWAYS(ting::util::ZigZagEncode32(0) == 0)
+		ASSERT_ALWAYS(ting::util::ZigZagEncode32(-1) == 1)
+		ASSERT_ALWAYS(ting::util::ZigZagEncode32(1) == 2)
+		ASSERT_ALWAYS(ting::util::ZigZagEncode32(-2) == 3)
+		ASSERT_ALWAYS(ting::util::ZigZagEncode32(std::numeric_limits<std::int32_t>::min()) == 0xffffffff)
+		ASSERT_ALWAYS(ting::util::ZigZagEncode64(std::numeric_limits<std::int64_t>::max()) == 0xfffffffffffffffeULL)
+
+		const std::int64_t values[] = {0, 1, -1, 63, -64, 1000000, -1000000, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max()};
+		for(auto v : values){
+			ASSERT_ALWAYS(ting::util::ZigZagDecode64(ting::util::ZigZagEncode64(v)) == v)
+			if(v >= std::numeric_limits<std::int32_t>::min() && v <= std::numeric_limits<std::int32_t>::max()){
+				ASSERT_ALWAYS(ting::util::ZigZagDecode32(ting::util::ZigZagEncode32(std::int32_t(v))) == v)
+			}
+		}
+	}
+
+	//batch decoding, mix of short runs of small values and long values
+	{
+		std::vector<std::uint64_t> values;
+		std::uint64_t x = 0x123456789abcdefULL;
+		for(unsigned i = 0; i != 1000; ++i){
+			x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+			switch((x >> 60) % 4){
+				case 0:
+					values.push_back((x >> 20) & 0x7f);
+					break;
+				case 1:
+					values.push_back((x >> 20) & 0x3fff);
+					break;
+				case 2:
+					values.push_back((x >> 20) & 0xffffffff);
+					break;
+				default:
+					values.push_back(x);
+					break;
+			}
+		}
+
+		std::vector<std::uint8_t> buf(values.size() * ting::util::DMaxVarint64Size);
+		size_t size = 0;
+		for(auto v : values){
+			size += ting::util::SerializeVarint(v, &buf[size]);
+		}
+		buf.resize(size);
+
+		std::vector<std::uint64_t> decoded(values.size());
+		auto res = ting::util::DeserializeVarints64(buf, decoded);
+		ASSERT_ALWAYS(!res.error)
+		ASSERT_ALWAYS(res.numRead == buf.size())
+		ASSERT_ALWAYS(res.numDecoded == values.size())
+		ASSERT_ALWAYS(decoded == values)
+
+		//truncated input, last varint is not consumed
+		res = ting::util::DeserializeVarints64(ting::Buffer<const std::uint8_t>(&*buf.begin(), buf.size() - 1), decoded);
+		ASSERT_ALWAYS(!res.error)
+		ASSERT_ALWAYS(res.numDecoded == values.size() - 1)
+		ASSERT_ALWAYS(res.numRead == buf.size() - ting::util::VarintSize(values.back()))
+
+		//small output buffer
+		res = ting::util::DeserializeVarints64(buf, ting::Buffer<std::uint64_t>(&*decoded.begin(), 10));
+		ASSERT_ALWAYS(res.numDecoded == 10)
+
+		//32 bit values do not fit, decoding stops with error at first 64 bit value
+		std::vector<std::uint32_t> decoded32(values.size());
+		res = ting::util::DeserializeVarints32(buf, decoded32);
+		ASSERT_ALWAYS(res.error)
+		ASSERT_ALWAYS(res.numDecoded < values.size())
+		ASSERT_ALWAYS(values[res.numDecoded] > 0xffffffff)
+		for(size_t i = 0; i != res.numDecoded; ++i){
+			ASSERT_ALWAYS(decoded32[i] == values[i])
+		}
+	}
+
+	//batch decoding of one byte values, exercising the SIMD path
+	{
+		std::vector<std::uint8_t> buf(100);
+		for(size_t i = 0; i != buf.size(); ++i){
+			buf[i] = std::uint8_t(i);
+		}
+		buf[50] = 0x81;
+
+		std::vector<std::uint32_t> decoded(buf.size());
+		auto res = ting::util::DeserializeVarints32(buf, decoded);
+		ASSERT_ALWAYS(!res.error)
+		ASSERT_INFO_ALWAYS(res.numDecoded == buf.size() - 1, "res.numDecoded = " << res.numDecoded)
+		for(size_t i = 0; i != 50; ++i){
+			ASSERT_ALWAYS(decoded[i] == i)
+		}
+		ASSERT_ALWAYS(decoded[50] == 1 + (51 << 7))
+		ASSERT_ALWAYS(decoded[51] == 52)
+	}
+}
+}//~namespace
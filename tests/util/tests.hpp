@@ -9,3 +9,23 @@ void Run();
 namespace TestScopeExit{
 void Run();
 }
+
+
+namespace TestWideSerialization{
+void Run();
+}
+
+
+namespace TestBulkSerialization{
+void Run();
+}
+
+
+namespace TestVarint{
+void Run();
+}
+
+
+namespace Benchmark{
+void Run();
+}